@@ -2,12 +2,20 @@
 
 layout (location = 0) in vec3 vPosition;
 
-uniform vec3 CameraPos;
+layout (std140) uniform PerFrame
+{
+  mat4 View;
+  mat4 Projection;
+  vec3 CamPos;
+  float Time;
+  vec2 Resolution;
+};
+
 uniform float Size;
 uniform float Rot;
 uniform vec3 Offset;
 uniform vec4 Color;
-uniform mat4 MVP;
+uniform mat4 ModelMatrix;
 uniform int Frame;
 uniform int Rows;
 uniform int Cols;
@@ -32,7 +40,7 @@ void main()
   float v = (vPosition.y + row) / Rows;
   uv = vec2(u, -v);
 
-  vec3 z = normalize(CameraPos - Offset);
+  vec3 z = normalize(CamPos - Offset);
   vec3 x = normalize(cross(vec3(0,1,0), z));
   vec3 y = normalize(cross(z, x));
   mat3 R = mat3(x, y, z);
@@ -43,5 +51,5 @@ void main()
   mat3 M = mat3(x, y, z);
 
   vec3 eyePos = M * R * Size * (vPosition - vec3(0.5, 0.5, 0.0)) + Offset;
-  gl_Position = MVP * vec4(eyePos, 1.0); 
+  gl_Position = Projection * View * ModelMatrix * vec4(eyePos, 1.0);
 }
@@ -5,13 +5,19 @@ in vec3 fPos;
 in vec3 fNormal;
 in vec3 vPos;
 
+layout (std140) uniform PerFrame
+{
+   mat4 View;
+   mat4 Projection;
+   vec3 CamPos;
+   float Time;
+   vec2 Resolution;
+};
+
 uniform samplerCube Cubemap;
 uniform sampler2D Image;
 uniform vec4 MaterialColor; 
-uniform mat4 ViewMatrix;
 uniform bool Skybox;
-uniform vec3 CamPos;
-uniform bool PoolBall;
 
 out vec4 FragColor;
 
@@ -20,7 +26,7 @@ void main()
 	vec3 I = normalize(fPos - CamPos);
    	vec3 ReflectDir = reflect(I, normalize(fNormal));
 	vec4 cubemapColor = texture(Cubemap, ReflectDir);
-	float relectionFactor = PoolBall? 0.5 : 0.2;
+	float relectionFactor = 0.2;
 	if (Skybox) FragColor = texture(Cubemap, fPos);
 	else FragColor = mix(MaterialColor * texture(Image, uv), cubemapColor, relectionFactor);
 }
@@ -4,9 +4,16 @@ layout (location = 0) in vec3 vPosition;
 layout (location = 1) in vec3 vNormal;
 layout (location = 2) in vec2 vTextureCoords;
 
-uniform mat4 MVP;
+layout (std140) uniform PerFrame
+{
+   mat4 View;
+   mat4 Projection;
+   vec3 CamPos;
+   float Time;
+   vec2 Resolution;
+};
+
 uniform mat4 ModelMatrix;
-uniform bool PoolBall;
 uniform bool EyeOfSauron;
 
 out vec2 uv;
@@ -16,18 +23,12 @@ out vec3 vPos;
 
 void main()
 {
-   fPos = vec3(ModelMatrix * vec4(vPosition, 1.0));
+   vec4 world = ModelMatrix * vec4(vPosition, 1.0);
+   fPos = vec3(world);
    fNormal = vec3(ModelMatrix * vec4(vNormal, 0.0));
-   gl_Position = MVP * vec4(vPosition, 1.0);
-   vPos = vec3(MVP * vec4(vPosition, 1.0));
-   if (PoolBall) {
-      // if (vTextureCoords.x > 0.5) {
-      //    uv = vec2(2 * vTextureCoords.x, vTextureCoords.y);
-      // } else {
-      //    uv = vec2(1, 0.5);
-      // }
-      uv = vec2(vTextureCoords.x, vTextureCoords.y);
-   } else if (EyeOfSauron) {
+   gl_Position = Projection * View * world;
+   vPos = vec3(gl_Position);
+   if (EyeOfSauron) {
       if (vTextureCoords.x > 0.5) {
          uv = vec2(2 * vTextureCoords.x, -vTextureCoords.y);
       } else {
@@ -1,7 +1,14 @@
 #version 400
 
-uniform float Time;
-uniform vec2 Resolution;
+layout (std140) uniform PerFrame
+{
+    mat4 View;
+    mat4 Projection;
+    vec3 CamPos;
+    float Time;
+    vec2 Resolution;
+};
+
 uniform vec3 BallPos;
 
 out vec4 fragColor;
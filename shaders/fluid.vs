@@ -2,9 +2,18 @@
 
 layout (location = 0) in vec3 vPosition;
 
-uniform mat4 MVP;
+layout (std140) uniform PerFrame
+{
+   mat4 View;
+   mat4 Projection;
+   vec3 CamPos;
+   float Time;
+   vec2 Resolution;
+};
+
+uniform mat4 ModelMatrix;
 
 void main()
 {
-   gl_Position = MVP * vec4(vPosition, 1.0);
+   gl_Position = Projection * View * ModelMatrix * vec4(vPosition, 1.0);
 }
@@ -0,0 +1,34 @@
+#version 430
+
+in vec3 fPos;
+in vec3 fNormal;
+flat in int fBall;
+
+layout (std140) uniform PerFrame
+{
+   mat4 View;
+   mat4 Projection;
+   vec3 CamPos;
+   float Time;
+   vec2 Resolution;
+};
+
+uniform samplerCube Cubemap;
+
+out vec4 FragColor;
+
+// one of eight ball colors, picked by ball index
+vec3 ballColor(int ball)
+{
+   const vec3 colors[8] = vec3[8](vec3(0.95, 0.8, 0.1), vec3(0.1, 0.2, 0.8), vec3(0.85, 0.1, 0.1),
+      vec3(0.4, 0.1, 0.6), vec3(0.95, 0.45, 0.1), vec3(0.1, 0.5, 0.2), vec3(0.5, 0.1, 0.1),
+      vec3(0.05, 0.05, 0.05));
+   return colors[ball % 8];
+}
+
+void main()
+{
+   vec3 I = normalize(fPos - CamPos);
+   vec3 reflectDir = reflect(I, normalize(fNormal));
+   FragColor = mix(vec4(ballColor(fBall), 1.0), texture(Cubemap, reflectDir), 0.5);
+}
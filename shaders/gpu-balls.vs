@@ -0,0 +1,41 @@
+#version 430
+
+// Draws the balls of GpuPhysics straight from its ball buffer, one instance
+// per ball, so that nothing is read back.
+
+layout (location = 0) in vec3 vPosition;
+layout (location = 1) in vec3 vNormal;
+
+struct Ball
+{
+   vec4 posSize;
+   vec4 velFlags;
+};
+
+layout (std430, binding = 0) readonly buffer Balls { Ball balls[]; };
+
+layout (std140) uniform PerFrame
+{
+   mat4 View;
+   mat4 Projection;
+   vec3 CamPos;
+   float Time;
+   vec2 Resolution;
+};
+// table space to world space
+uniform mat4 ModelMatrix;
+
+out vec3 fPos;
+out vec3 fNormal;
+flat out int fBall;
+
+void main()
+{
+   Ball b = balls[gl_InstanceID];
+   // sunk balls have no size and collapse to a point
+   vec4 world = ModelMatrix * vec4(b.posSize.xyz + b.posSize.w * vPosition, 1.0);
+   fPos = vec3(world);
+   fNormal = vec3(ModelMatrix * vec4(vNormal, 0.0));
+   fBall = gl_InstanceID;
+   gl_Position = Projection * View * world;
+}
@@ -0,0 +1,68 @@
+#version 430
+
+// Separates overlapping balls as Table::collisionDetection does, but every
+// ball at once: each ball sums the push and the exchange of normal velocity
+// with every ball it overlaps in the nine cells around it, reading the
+// state before the step and writing the state after it.
+
+layout (local_size_x = 256) in;
+
+struct Ball
+{
+   vec4 posSize;
+   vec4 velFlags;
+};
+
+layout (std430, binding = 0) readonly buffer Balls { Ball balls[]; };
+layout (std430, binding = 1) writeonly buffer NextBalls { Ball next[]; };
+layout (std430, binding = 2) readonly buffer CellCounts { uint cellCount[]; };
+layout (std430, binding = 3) readonly buffer CellStarts { uint cellStart[]; };
+layout (std430, binding = 4) readonly buffer Sorted { uint sorted[]; };
+layout (std430, binding = 5) readonly buffer Slots { uvec2 slot[]; };
+
+uniform uint NumBalls;
+uniform ivec2 GridSize;
+uniform float SphereRadius;
+// overlap let through, as the CPU lets through 1 but no more than a
+// sliver of a shrunk ball
+uniform float MinOverlap;
+
+const uint NoCell = 0xffffffffu;
+
+void main()
+{
+   uint i = gl_GlobalInvocationID.x;
+   if (i >= NumBalls) return;
+   Ball b = balls[i];
+   uint cell = slot[i].x;
+   if (cell == NoCell) {
+      next[i] = b;
+      return;
+   }
+
+   vec3 pos = b.posSize.xyz;
+   vec3 vel = b.velFlags.xyz;
+   vec3 push = vec3(0);
+   vec3 dv = vec3(0);
+   ivec2 c = ivec2(int(cell) % GridSize.x, int(cell) / GridSize.x);
+   for (int y = max(c.y - 1, 0); y <= min(c.y + 1, GridSize.y - 1); y++) {
+      for (int x = max(c.x - 1, 0); x <= min(c.x + 1, GridSize.x - 1); x++) {
+         uint other = uint(y * GridSize.x + x);
+         uint start = cellStart[other];
+         uint end = start + cellCount[other];
+         for (uint k = start; k < end; k++) {
+            uint j = sorted[k];
+            if (j == i) continue;
+            Ball o = balls[j];
+            vec3 d = pos - o.posSize.xyz;
+            float overlap = SphereRadius * (b.posSize.w + o.posSize.w) - length(d);
+            if (overlap <= MinOverlap) continue;
+            // normal between the balls as if both rested on the table
+            vec3 normal = normalize(vec3(d.xy, d.z - SphereRadius * (b.posSize.w - o.posSize.w)));
+            push += normal * overlap * 0.5;
+            dv += dot(o.velFlags.xyz - vel, normal) * normal;
+         }
+      }
+   }
+   next[i] = Ball(vec4(pos + push, b.posSize.w), vec4(vel + dv, b.velFlags.w));
+}
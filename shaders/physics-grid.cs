@@ -0,0 +1,39 @@
+#version 430
+
+// Counts the balls in each cell of the broadphase grid and gives each ball
+// its rank within its cell, the first half of a counting sort.
+
+layout (local_size_x = 256) in;
+
+struct Ball
+{
+   vec4 posSize;
+   // velocity, and the flags in the bits of w
+   vec4 velFlags;
+};
+
+layout (std430, binding = 0) readonly buffer Balls { Ball balls[]; };
+layout (std430, binding = 2) buffer CellCounts { uint cellCount[]; };
+// cell of each ball, or NoCell for balls out of play, and its rank there
+layout (std430, binding = 5) writeonly buffer Slots { uvec2 slot[]; };
+
+uniform uint NumBalls;
+uniform vec2 GridOrigin;
+uniform float CellSize;
+uniform ivec2 GridSize;
+
+const uint NoCell = 0xffffffffu;
+
+void main()
+{
+   uint i = gl_GlobalInvocationID.x;
+   if (i >= NumBalls) return;
+   Ball b = balls[i];
+   if (floatBitsToUint(b.velFlags.w) != 0u) {
+      slot[i] = uvec2(NoCell, 0u);
+      return;
+   }
+   ivec2 c = clamp(ivec2(floor((b.posSize.xy - GridOrigin) / CellSize)), ivec2(0), GridSize - 1);
+   uint cell = uint(c.y * GridSize.x + c.x);
+   slot[i] = uvec2(cell, atomicAdd(cellCount[cell], 1u));
+}
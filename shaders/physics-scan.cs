@@ -0,0 +1,41 @@
+#version 430
+
+// Turns the cell counts into the index of each cell's first ball, with a
+// single group: each thread sums a run of cells, the group scans the sums,
+// and each thread then writes the starts of its run.
+
+layout (local_size_x = 1024) in;
+
+layout (std430, binding = 2) readonly buffer CellCounts { uint cellCount[]; };
+layout (std430, binding = 3) writeonly buffer CellStarts { uint cellStart[]; };
+
+uniform uint NumCells;
+
+shared uint partial[1024];
+
+void main()
+{
+   uint t = gl_LocalInvocationID.x;
+   uint run = (NumCells + 1023u) / 1024u;
+   uint begin = min(t * run, NumCells);
+   uint end = min(begin + run, NumCells);
+   uint sum = 0u;
+   for (uint c = begin; c < end; c++) {
+      sum += cellCount[c];
+   }
+   partial[t] = sum;
+   barrier();
+
+   for (uint offset = 1u; offset < 1024u; offset <<= 1) {
+      uint add = t >= offset ? partial[t - offset] : 0u;
+      barrier();
+      partial[t] += add;
+      barrier();
+   }
+
+   uint start = partial[t] - sum;
+   for (uint c = begin; c < end; c++) {
+      cellStart[c] = start;
+      start += cellCount[c];
+   }
+}
@@ -0,0 +1,22 @@
+#version 430
+
+// Places each ball in play at its cell's start plus its rank, finishing the
+// counting sort.
+
+layout (local_size_x = 256) in;
+
+layout (std430, binding = 3) readonly buffer CellStarts { uint cellStart[]; };
+layout (std430, binding = 4) writeonly buffer Sorted { uint sorted[]; };
+layout (std430, binding = 5) readonly buffer Slots { uvec2 slot[]; };
+
+uniform uint NumBalls;
+
+const uint NoCell = 0xffffffffu;
+
+void main()
+{
+   uint i = gl_GlobalInvocationID.x;
+   if (i >= NumBalls) return;
+   uvec2 s = slot[i];
+   if (s.x != NoCell) sorted[cellStart[s.x] + s.y] = i;
+}
@@ -0,0 +1,75 @@
+#version 430
+
+// The rest of a fixed step for each ball in play, as in Table::fixedStep
+// without chaos: pockets, cushions, friction, then moving by vel * dt.
+// Sunk balls are flagged and hidden, and counted in Pocketed.
+
+layout (local_size_x = 256) in;
+
+struct Ball
+{
+   vec4 posSize;
+   vec4 velFlags;
+};
+
+layout (std430, binding = 0) writeonly buffer Balls { Ball balls[]; };
+layout (std430, binding = 1) readonly buffer NextBalls { Ball next[]; };
+layout (std430, binding = 6) buffer Stats { uint pocketed; };
+
+uniform uint NumBalls;
+uniform float Dt;
+uniform float Friction;
+uniform float SphereRadius;
+// half the length and width of the play area
+uniform vec2 Cushions;
+uniform vec2 Pockets[6];
+uniform int NumPockets;
+// distance at which a ball drops and at which it is pulled in
+uniform float SinkRadius;
+uniform float CaptureRadius;
+
+const uint Sunk = 1u;
+
+void main()
+{
+   uint i = gl_GlobalInvocationID.x;
+   if (i >= NumBalls) return;
+   Ball b = next[i];
+   if (floatBitsToUint(b.velFlags.w) != 0u) {
+      balls[i] = b;
+      return;
+   }
+   vec3 pos = b.posSize.xyz;
+   vec3 vel = b.velFlags.xyz;
+   float size = b.posSize.w;
+
+   bool captured = false;
+   for (int p = 0; p < NumPockets; p++) {
+      float dist = distance(Pockets[p], pos.xy);
+      if (dist < SinkRadius) {
+         atomicAdd(pocketed, 1u);
+         balls[i] = Ball(vec4(pos, 0.0), vec4(0.0, 0.0, 0.0, uintBitsToFloat(Sunk)));
+         return;
+      }
+      if (dist < CaptureRadius) {
+         vel = vec3(10.0 * (Pockets[p] - pos.xy), 0.0);
+         captured = true;
+         break;
+      }
+   }
+
+   if (!captured) {
+      float radius = SphereRadius * size;
+      if (pos.x - radius < -Cushions.x || pos.x + radius > Cushions.x) {
+         pos.x = clamp(pos.x, -Cushions.x + radius, Cushions.x - radius);
+         vel.x = -vel.x;
+      }
+      if (pos.y < -Cushions.y || pos.y > Cushions.y) {
+         pos.y = clamp(pos.y, -Cushions.y + radius, Cushions.y - radius);
+         vel.y = -vel.y;
+      }
+      vel *= Friction;
+   }
+   pos += vel * Dt;
+   balls[i] = Ball(vec4(pos, size), vec4(vel, b.velFlags.w));
+}
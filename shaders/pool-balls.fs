@@ -0,0 +1,27 @@
+#version 400
+
+in vec3 uv;
+in vec3 fPos;
+in vec3 fNormal;
+in vec4 fColor;
+
+layout (std140) uniform PerFrame
+{
+   mat4 View;
+   mat4 Projection;
+   vec3 CamPos;
+   float Time;
+   vec2 Resolution;
+};
+
+uniform samplerCube Cubemap;
+uniform sampler2DArray Images;
+
+out vec4 FragColor;
+
+void main()
+{
+   vec3 I = normalize(fPos - CamPos);
+   vec3 reflectDir = reflect(I, normalize(fNormal));
+   FragColor = mix(fColor * texture(Images, uv), texture(Cubemap, reflectDir), 0.5);
+}
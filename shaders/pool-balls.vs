@@ -0,0 +1,35 @@
+#version 400
+
+// Draws every pool ball in one call, one instance per ball, with the
+// transform, color and texture layer of each read from the instance buffer.
+
+layout (location = 0) in vec3 vPosition;
+layout (location = 1) in vec3 vNormal;
+layout (location = 2) in vec2 vTextureCoords;
+layout (location = 4) in mat4 iModel;
+layout (location = 8) in vec4 iColor;
+layout (location = 9) in float iLayer;
+
+layout (std140) uniform PerFrame
+{
+   mat4 View;
+   mat4 Projection;
+   vec3 CamPos;
+   float Time;
+   vec2 Resolution;
+};
+
+out vec3 uv;
+out vec3 fPos;
+out vec3 fNormal;
+out vec4 fColor;
+
+void main()
+{
+   vec4 world = iModel * vec4(vPosition, 1.0);
+   fPos = vec3(world);
+   fNormal = vec3(iModel * vec4(vNormal, 0.0));
+   fColor = iColor;
+   uv = vec3(vTextureCoords, iLayer);
+   gl_Position = Projection * View * world;
+}
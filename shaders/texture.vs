@@ -4,12 +4,21 @@ layout (location = 0) in vec3 vPositions;
 layout (location = 1) in vec3 vNormals;
 layout (location = 2) in vec2 vUVs;
 
-uniform mat4 MVP;
+layout (std140) uniform PerFrame
+{
+  mat4 View;
+  mat4 Projection;
+  vec3 CamPos;
+  float Time;
+  vec2 Resolution;
+};
+
+uniform mat4 ModelMatrix;
 
 out vec2 uv;
 
 void main()
 {
   uv = vUVs;
-  gl_Position = MVP * vec4(vPositions, 1.0);
+  gl_Position = Projection * View * ModelMatrix * vec4(vPositions, 1.0);
 }
@@ -0,0 +1,90 @@
+// Copyright 2020, Savvy Sine, Aline Normoyle
+
+// GLM only defines its SIMD helpers when intrinsics are forced, which also
+// changes how it declares its vector types, so this file includes none of
+// them and the rest of agl never sees the forced setting.
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLM_FORCE_SSE2
+#endif
+
+#include "agl/affine.h"
+#include <glm/detail/setup.hpp>
+#include <glm/simd/common.h>
+
+namespace agl {
+
+void affineIdentity(Affine& m) {
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 4; j++) {
+      m.rows[i][j] = i == j ? 1.0f : 0.0f;
+    }
+  }
+}
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+
+void affineMultiply(const Affine& a, const Affine& b, Affine& out) {
+  glm_vec4 b0 = _mm_load_ps(b.rows[0]);
+  glm_vec4 b1 = _mm_load_ps(b.rows[1]);
+  glm_vec4 b2 = _mm_load_ps(b.rows[2]);
+  glm_vec4 b3 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+  // each row of the product weighs the rows of b by a row of a
+  glm_vec4 rows[3];
+  for (int i = 0; i < 3; i++) {
+    glm_vec4 r = _mm_load_ps(a.rows[i]);
+    glm_vec4 c = glm_vec4_mul(_mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)), b3);
+    c = glm_vec4_fma(_mm_shuffle_ps(r, r, _MM_SHUFFLE(0, 0, 0, 0)), b0, c);
+    c = glm_vec4_fma(_mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 1, 1, 1)), b1, c);
+    c = glm_vec4_fma(_mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 2, 2, 2)), b2, c);
+    rows[i] = c;
+  }
+  for (int i = 0; i < 3; i++) {
+    _mm_store_ps(out.rows[i], rows[i]);
+  }
+}
+
+void affineScale(Affine& m, float x, float y, float z) {
+  glm_vec4 s = _mm_set_ps(1.0f, z, y, x);
+  for (int i = 0; i < 3; i++) {
+    _mm_store_ps(m.rows[i], glm_vec4_mul(_mm_load_ps(m.rows[i]), s));
+  }
+}
+
+#else
+
+void affineMultiply(const Affine& a, const Affine& b, Affine& out) {
+  float rows[3][4];
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 4; j++) {
+      rows[i][j] = a.rows[i][0] * b.rows[0][j] + a.rows[i][1] * b.rows[1][j] +
+          a.rows[i][2] * b.rows[2][j];
+    }
+    rows[i][3] += a.rows[i][3];
+  }
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 4; j++) {
+      out.rows[i][j] = rows[i][j];
+    }
+  }
+}
+
+void affineScale(Affine& m, float x, float y, float z) {
+  for (int i = 0; i < 3; i++) {
+    m.rows[i][0] *= x;
+    m.rows[i][1] *= y;
+    m.rows[i][2] *= z;
+  }
+}
+
+#endif
+
+void affineTranslate(Affine& m, float x, float y, float z) {
+  // only the last column moves
+  for (int i = 0; i < 3; i++) {
+    m.rows[i][3] += m.rows[i][0] * x + m.rows[i][1] * y + m.rows[i][2] * z;
+  }
+}
+
+}  // namespace agl
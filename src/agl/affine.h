@@ -0,0 +1,40 @@
+// Copyright 2020, Savvy Sine, Aline Normoyle
+
+#ifndef AGL_AFFINE_H_
+#define AGL_AFFINE_H_
+
+namespace agl {
+
+/**
+ * @brief An affine transform, stored as the top three rows of a 4x4 matrix
+ *
+ * The bottom row of an affine transform is always 0 0 0 1, so it takes 12
+ * floats and composing two takes 36 multiplies rather than 64. Where SSE2
+ * is available, the functions below compose with GLM's SIMD helpers.
+ */
+struct alignas(16) Affine {
+  float rows[3][4];
+};
+
+/**
+ * @brief Set m to the identity
+ */
+void affineIdentity(Affine& m);
+
+/**
+ * @brief Set out to a * b; out may be a or b
+ */
+void affineMultiply(const Affine& a, const Affine& b, Affine& out);
+
+/**
+ * @brief Set m to m * a scale by x, y and z
+ */
+void affineScale(Affine& m, float x, float y, float z);
+
+/**
+ * @brief Set m to m * a translation by x, y and z
+ */
+void affineTranslate(Affine& m, float x, float y, float z);
+
+}  // namespace agl
+#endif  // AGL_AFFINE_H_
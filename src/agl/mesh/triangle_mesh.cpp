@@ -103,9 +103,9 @@ void TriangleMesh::initBuffers(
   glBindVertexArray(0);
 }
 
-void TriangleMesh::render() const {
+bool TriangleMesh::bind() const {
   if (!_initialized) const_cast<TriangleMesh*>(this)->init();
-  if (_vao == 0) return;
+  if (_vao == 0) return false;
 
   glBindVertexArray(_vao);
 
@@ -118,9 +118,37 @@ void TriangleMesh::render() const {
       }
     }
   }
+  return true;
+}
 
+void TriangleMesh::render() const {
+  if (!bind()) return;
   glDrawElements(GL_TRIANGLES, _nIndices, GL_UNSIGNED_INT, 0);
   glBindVertexArray(0);
 }
 
+void TriangleMesh::renderInstanced(int count) const {
+  if (count <= 0 || !bind()) return;
+  glDrawElementsInstanced(GL_TRIANGLES, _nIndices, GL_UNSIGNED_INT, 0, count);
+  glBindVertexArray(0);
+}
+
+void TriangleMesh::setInstanceBuffer(GLuint buffer, GLuint firstLocation,
+    int numVec4s) {
+  if (!_initialized) init();
+  if (_vao == 0) return;
+
+  glBindVertexArray(_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  GLsizei stride = numVec4s * 4 * sizeof(GLfloat);
+  for (int k = 0; k < numVec4s; k++) {
+    glVertexAttribPointer(firstLocation + k, 4, GL_FLOAT, GL_FALSE, stride,
+        (const void*) (k * 4 * sizeof(GLfloat)));
+    glVertexAttribDivisor(firstLocation + k, 1);
+    glEnableVertexAttribArray(firstLocation + k);
+  }
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 }  //  namespace agl
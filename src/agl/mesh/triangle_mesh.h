@@ -24,6 +24,22 @@ class TriangleMesh : public Mesh {
    */ 
   virtual void render() const;
 
+  /**
+   * @brief Draw count copies of this mesh in one call
+   *
+   * The vertex shader tells the copies apart by gl_InstanceID.
+   */
+  void renderInstanced(int count) const;
+
+  /**
+   * @brief Read per-instance attributes from a buffer in renderInstanced
+   *
+   * Each instance takes numVec4s consecutive vec4s from the buffer, the k-th
+   * at attribute location firstLocation + k, so a mat4 takes four locations.
+   * Locations 0 to 3 hold the vertex attributes.
+   */
+  void setInstanceBuffer(GLuint buffer, GLuint firstLocation, int numVec4s);
+
  protected:
   GLuint _nIndices = 0;    // Number of triangle vertices
 
@@ -39,6 +55,10 @@ class TriangleMesh : public Mesh {
     std::vector<GLfloat>* normals,
     std::vector<GLfloat>* texCoords = nullptr,
     std::vector<GLfloat>* tangents = nullptr);
+
+ private:
+  // Initializes or updates the buffers as needed and binds the vertex array
+  bool bind() const;
 };
 
 }  // namespace agl
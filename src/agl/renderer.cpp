@@ -1,6 +1,8 @@
 // Copyright 2020, Savvy Sine, Aline Normoyle
 
 #include "agl/renderer.h"
+#include <cassert>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include "agl/image.h"
@@ -13,6 +15,7 @@
 #include "agl/mesh/torus.h"
 #include "agl/mesh/plane.h"
 #include "agl/mesh/skybox.h"
+#include "agl/mesh/triangle_mesh.h"
 #define FONTSTASH_IMPLEMENTATION
 #include "fontstash/fontstash.h"
 #define GLFONTSTASH_IMPLEMENTATION
@@ -30,6 +33,85 @@ using glm::quat;
 using std::string;
 using std::vector;
 
+// Sorts keys a byte at a time, least significant first, skipping the bytes
+// that are the same in every key
+static void radixSort(vector<uint64_t>& keys, vector<uint64_t>& scratch) {
+  uint64_t all = ~(uint64_t) 0;
+  uint64_t any = 0;
+  for (uint64_t key : keys) {
+    all &= key;
+    any |= key;
+  }
+  scratch.resize(keys.size());
+  for (int shift = 0; shift < 64; shift += 8) {
+    if ((((all ^ any) >> shift) & 0xff) == 0) continue;
+    int offsets[256] = {0};
+    for (uint64_t key : keys) offsets[(key >> shift) & 0xff]++;
+    int start = 0;
+    for (int i = 0; i < 256; i++) {
+      int count = offsets[i];
+      offsets[i] = start;
+      start += count;
+    }
+    for (uint64_t key : keys) scratch[offsets[(key >> shift) & 0xff]++] = key;
+    keys.swap(scratch);
+  }
+}
+
+// Affine is row major and glm column major
+static mat4 toMat4(const Affine& a) {
+  mat4 m(1.0f);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 4; j++) {
+      m[j][i] = a.rows[i][j];
+    }
+  }
+  return m;
+}
+
+static Affine toAffine(const mat4& m) {
+  Affine a;
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 4; j++) {
+      a.rows[i][j] = m[j][i];
+    }
+  }
+  return a;
+}
+
+static Affine toAffine(const mat3& r) {
+  Affine a;
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      a.rows[i][j] = r[j][i];
+    }
+    a.rows[i][3] = 0.0f;
+  }
+  return a;
+}
+
+static vec3 transformPoint(const Affine& a, const vec3& p) {
+  vec3 q;
+  for (int i = 0; i < 3; i++) {
+    q[i] = a.rows[i][0] * p.x + a.rows[i][1] * p.y + a.rows[i][2] * p.z +
+        a.rows[i][3];
+  }
+  return q;
+}
+
+static void applyUniform(GLint location, GLenum type, const float* v) {
+  switch (type) {
+    case GL_INT: glUniform1i(location, *(const GLint*) v); break;
+    case GL_UNSIGNED_INT: glUniform1ui(location, *(const GLuint*) v); break;
+    case GL_FLOAT: glUniform1f(location, v[0]); break;
+    case GL_FLOAT_VEC2: glUniform2f(location, v[0], v[1]); break;
+    case GL_FLOAT_VEC3: glUniform3f(location, v[0], v[1], v[2]); break;
+    case GL_FLOAT_VEC4: glUniform4f(location, v[0], v[1], v[2], v[3]); break;
+    case GL_FLOAT_MAT3: glUniformMatrix3fv(location, 1, GL_FALSE, v); break;
+    case GL_FLOAT_MAT4: glUniformMatrix4fv(location, 1, GL_FALSE, v); break;
+  }
+}
+
 int Renderer::PrimitiveSubdivision = 16;
 
 Renderer::Renderer() {
@@ -48,6 +130,22 @@ Renderer::Renderer() {
   _fs = NULL;
 
   _currentShader = 0;
+  _frameBuffer = 0;
+  _frameDirty = true;
+  _stateStats = StateStats{0, 0};
+  _lastStateStats = StateStats{0, 0};
+  invalidateState();
+  _depthTest = true;
+
+  _queuing = false;
+  _queuePass = 0;
+  _queueOrder = SORT_STATE;
+  _queueBindingCopy = -1;
+  _queueTexture = 0;
+  affineIdentity(_trs);
+  _stackDepth = 0;
+  _stackOverflow = 0;
+  _stackOverflows = 0;
   _initialized = false;
 }
 
@@ -82,11 +180,14 @@ void Renderer::cleanup() {
 
   glDeleteBuffers(3, mBBVboIds);
   glDeleteBuffers(2, mVboLineIds);
+  glDeleteBuffers(1, &_frameBuffer);
+  _frameBuffer = 0;
 
   for (auto it : _shaders) {
     delete it.second;
   }
   _shaders.clear();
+  _queueShaders.clear();
   _textures.clear();
   _initialized = false;
 }
@@ -102,15 +203,114 @@ vec3 Renderer::cameraPosition() const {
 
 
 void Renderer::setDepthTest(bool b) {
-  if (b) glEnable(GL_DEPTH_TEST);
-  else glDisable(GL_DEPTH_TEST);
+  _depthTest = b;
+  if (_queuing) return;
+  enable(GL_DEPTH_TEST, b);
+}
+
+void Renderer::invalidateState() {
+  _state.program = -1;
+  _state.depthTest = -1;
+  _state.blend = -1;
+  _state.blendEquation = -1;
+  _state.blendSrc = -1;
+  _state.blendDst = -1;
+  forgetTextures();
+}
+
+void Renderer::forgetTextures() {
+  _state.activeSlot = -1;
+  for (int i = 0; i < MAX_TEXTURE_SLOTS; i++) {
+    _state.targets[i] = -1;
+    _state.textures[i] = -1;
+  }
+}
+
+void Renderer::useProgram(Shader* shader) {
+  GLint program = shader != nullptr ? shader->getHandle() : 0;
+  if (program == _state.program) {
+    _stateStats.filtered++;
+    return;
+  }
+  if (shader != nullptr) shader->use();
+  else glUseProgram(0);
+  _state.program = program;
+  _stateStats.issued++;
+}
+
+void Renderer::enable(GLenum cap, bool on) {
+  // only GL_DEPTH_TEST and GL_BLEND are tracked
+  int& known = cap == GL_BLEND ? _state.blend : _state.depthTest;
+  if (known == (int) on) {
+    _stateStats.filtered++;
+    return;
+  }
+  if (on) glEnable(cap);
+  else glDisable(cap);
+  known = on;
+  _stateStats.issued++;
+}
+
+void Renderer::blendEquation(GLenum mode) {
+  if (_state.blendEquation == (GLint) mode) {
+    _stateStats.filtered++;
+    return;
+  }
+  glBlendEquation(mode);
+  _state.blendEquation = mode;
+  _stateStats.issued++;
+}
+
+void Renderer::blendFunc(GLenum src, GLenum dst) {
+  if (_state.blendSrc == (GLint) src && _state.blendDst == (GLint) dst) {
+    _stateStats.filtered++;
+    return;
+  }
+  glBlendFunc(src, dst);
+  _state.blendSrc = src;
+  _state.blendDst = dst;
+  _stateStats.issued++;
+}
+
+void Renderer::bindTexture(int slot, GLenum target, GLuint texId) {
+  bool tracked = slot >= 0 && slot < MAX_TEXTURE_SLOTS;
+  if (tracked && _state.targets[slot] == (GLint) target &&
+      _state.textures[slot] == (GLint) texId) {
+    // already bound, so neither the slot nor the binding needs to change
+    _stateStats.filtered += 2;
+    return;
+  }
+
+  if (slot == _state.activeSlot) {
+    _stateStats.filtered++;
+  } else {
+    glActiveTexture(GL_TEXTURE0 + slot);
+    _state.activeSlot = tracked ? slot : -1;
+    _stateStats.issued++;
+  }
+  glBindTexture(target, texId);
+  _stateStats.issued++;
+  if (tracked) {
+    _state.targets[slot] = target;
+    _state.textures[slot] = texId;
+  }
 }
 
 void Renderer::init() {
-  glEnable(GL_DEPTH_TEST);
+  invalidateState();
+  setDepthTest(true);
   glEnable(GL_CULL_FACE);
   glCullFace(GL_BACK);
 
+  static_assert(sizeof(FrameBlock) == 160, "FrameBlock must match std140");
+  _frame = FrameBlock();
+  glGenBuffers(1, &_frameBuffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, _frameBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlock), NULL, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, _frameBuffer);
+  _frameDirty = true;
+
   // setup default camera and projection
   float halfw = 1.0;
   float halfh = 1.0;
@@ -120,6 +320,7 @@ void Renderer::init() {
   initLines();
   initBillboards();
   initText();
+  forgetTextures();  // creating the font atlas binds it
   loadShader("cubemap", "../shaders/cubemap.vs", "../shaders/cubemap.fs");
   loadShader("unlit", "../shaders/unlit.vs", "../shaders/unlit.fs");
 
@@ -132,7 +333,10 @@ void Renderer::init() {
   _plane = new Plane(1.0, 1.0, 1.0, 1.0);
   _sphere = new Sphere(0.5f, PrimitiveSubdivision, PrimitiveSubdivision);
   _skybox = new SkyBox(1);
-  _trs = mat4(1.0);
+  affineIdentity(_trs);
+  _stackDepth = 0;
+  _stackOverflow = 0;
+  _stackOverflows = 0;
   _initialized = true;
 
   beginShader("unlit");  
@@ -243,71 +447,92 @@ void Renderer::initText() {
 }
 
 void Renderer::blendMode(BlendMode mode) {
+  _blendMode = mode;
+  if (_queuing) return;
+
   if (mode == ADD) {
-    _blendMode = ADD;
-    glEnable(GL_BLEND);
-    glBlendEquation(GL_FUNC_ADD);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);  // Additive blend
+    enable(GL_BLEND, true);
+    blendEquation(GL_FUNC_ADD);
+    blendFunc(GL_SRC_ALPHA, GL_ONE);  // Additive blend
   } 
   else if (mode == BLEND) {
-    _blendMode = BLEND;
-    glEnable(GL_BLEND);
-    glBlendEquation(GL_FUNC_ADD);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  // Alpha blend
+    enable(GL_BLEND, true);
+    blendEquation(GL_FUNC_ADD);
+    blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  // Alpha blend
   } 
   else if (mode == SUBTRACT) {
-    _blendMode = BLEND;
-    glEnable(GL_BLEND);
-    glBlendEquation(GL_FUNC_SUBTRACT);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);  
+    enable(GL_BLEND, true);
+    blendEquation(GL_FUNC_SUBTRACT);
+    blendFunc(GL_SRC_ALPHA, GL_ONE);  
   } 
   else if (mode == MULTIPLY) {
-    _blendMode = BLEND;
-    glEnable(GL_BLEND);
-    glBlendEquation(GL_FUNC_ADD);
-    glBlendFunc(GL_DST_COLOR, GL_ZERO);  
+    enable(GL_BLEND, true);
+    blendEquation(GL_FUNC_ADD);
+    blendFunc(GL_DST_COLOR, GL_ZERO);  
   } 
   else if (mode == DARKEST) {
-    _blendMode = BLEND;
-    glEnable(GL_BLEND);
-    glBlendEquation(GL_MIN);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);  
+    enable(GL_BLEND, true);
+    blendEquation(GL_MIN);
+    blendFunc(GL_SRC_ALPHA, GL_ONE);  
   } 
   else if (mode == LIGHTEST) {
-    _blendMode = BLEND;
-    glEnable(GL_BLEND);
-    glBlendEquation(GL_MAX);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);  
+    enable(GL_BLEND, true);
+    blendEquation(GL_MAX);
+    blendFunc(GL_SRC_ALPHA, GL_ONE);  
   } 
   else {
-    _blendMode = DEFAULT;
-    glDisable(GL_BLEND);
+    enable(GL_BLEND, false);
   }
 }
 
 void Renderer::perspective(float fovRadians,
     float aspect, float near, float far) {
   _projectionMatrix = glm::perspective(fovRadians, aspect, near, far);
+  _frame.projection = _projectionMatrix;
+  _frameDirty = true;
 }
 
 void Renderer::ortho(float minx, float maxx,
     float miny, float maxy, float minz, float maxz) {
   _projectionMatrix = glm::ortho(minx, maxx, miny, maxy, minz, maxz);
+  _frame.projection = _projectionMatrix;
+  _frameDirty = true;
 }
 
 void Renderer::lookAt(const vec3& lookfrom,
     const vec3& lookat, const vec3& up) {
   _lookfrom = lookfrom;
   _viewMatrix = glm::lookAt(lookfrom, lookat, up);
+  _frame.view = _viewMatrix;
+  _frame.camPos = lookfrom;
+  _frameDirty = true;
+}
+
+void Renderer::frameInfo(float time, const glm::vec2& resolution) {
+  _frame.time = time;
+  _frame.resolution = resolution;
+  _frameDirty = true;
+
+  _lastStateStats = _stateStats;
+  _stateStats = StateStats{0, 0};
+}
+
+void Renderer::updateFrameBlock() {
+  if (!_frameDirty || _frameBuffer == 0) return;
+  glBindBuffer(GL_UNIFORM_BUFFER, _frameBuffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameBlock), &_frame);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  _frameDirty = false;
 }
 
 void Renderer::texture(const std::string& uniformName,
     const std::string& textureName) {
   assert(_textures.count(textureName) != 0);
 
-  glActiveTexture(GL_TEXTURE0 + _textures[textureName].slot);
-  glBindTexture(GL_TEXTURE_2D, _textures[textureName].texId);
-  setUniform(uniformName, _textures[textureName].slot);
+  const Texture& tex = _textures[textureName];
+  if (_queuing) queueBinding(tex.slot, tex.target, tex.texId);
+  else bindTexture(tex.slot, tex.target, tex.texId);
+  setUniform(uniformName, tex.slot);
 }
 
 void Renderer::fontColor(const glm::vec4& c) {
@@ -334,6 +559,7 @@ float Renderer::textHeight() {
 }
 
 void Renderer::text(const std::string& text, float x, float y) {
+  assert(!_queuing);
   float viewport[4]; 
   glGetFloatv(GL_VIEWPORT, viewport);
 
@@ -348,6 +574,7 @@ void Renderer::text(const std::string& text, float x, float y) {
   fonsSetFont(_fs, _fontNormal);
   fonsSetColor(_fs, _fontColor);
   fonsDrawText(_fs, x, y, text.c_str(), NULL);
+  forgetTextures();  // fontstash binds its atlas behind our back
   //std::cout << viewport[2] << " " << viewport[3] << std::endl;
 
   endShader();
@@ -357,8 +584,9 @@ void Renderer::text(const std::string& text, float x, float y) {
 void Renderer::line(const glm::vec3& p1, const glm::vec3& p2,
     const glm::vec3& c1, const glm::vec3& c2) {
   assert(_initialized);
+  assert(!_queuing);
 
-  mat4 mvp = _projectionMatrix * _viewMatrix * _trs;
+  mat4 mvp = _projectionMatrix * _viewMatrix * modelMatrix();
   setUniform("MVP", mvp);
 
   GLfloat positions[6];
@@ -389,16 +617,13 @@ void Renderer::line(const glm::vec3& p1, const glm::vec3& p2,
 
 void Renderer::quad() {
   assert(_initialized);
+  if (_queuing) {
+    queueDraw(QUEUED_QUAD, transformPoint(_trs, vec3(0.5f, 0.5f, 0)));
+    return;
+  }
 
-  mat4 mv = _viewMatrix * _trs;
-  mat4 mvp = _projectionMatrix * mv;
-  mat3 nmv = transpose(inverse(mat3(vec3(mv[0]), vec3(mv[1]), vec3(mv[2]))));
-
-  setUniform("MVP", mvp);
-  setUniform("ModelViewMatrix", mv);
-  setUniform("NormalMatrix", nmv);
-  setUniform("ModelMatrix", _trs);
-  setUniform("HasUV", true);
+  updateFrameBlock();
+  setTransformUniforms(true);
 
   glBindVertexArray(mBBVaoId);
   glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -408,14 +633,26 @@ void Renderer::quad() {
 void Renderer::sprite(const glm::vec3& pos,
     const glm::vec4& color, float size, float rot) {
   assert(_initialized);
+  if (_queuing) {
+    QueuedDraw& draw = queueDraw(QUEUED_SPRITE, transformPoint(_trs, pos));
+    draw.pos = pos;
+    draw.color = color;
+    draw.size = size;
+    draw.rot = rot;
+    return;
+  }
 
-  mat4 mvp = _projectionMatrix * _viewMatrix * _trs;
-  setUniform("MVP", mvp);
-  setUniform("CameraPos", _lookfrom);
-  setUniform("Offset", pos);
-  setUniform("Color", color);
-  setUniform("Size", size);
-  setUniform("Rot", rot);
+  updateFrameBlock();
+  mat4 trs = modelMatrix();
+  mat4 mvp = _projectionMatrix * _viewMatrix * trs;
+  const StandardUniforms& u = _currentShader->standardUniforms();
+  u.mvp.set(mvp);
+  u.modelMatrix.set(trs);
+  u.cameraPos.set(_lookfrom);
+  u.offset.set(pos);
+  u.color.set(color);
+  u.size.set(size);
+  u.rot.set(rot);
 
   glBindVertexArray(mBBVaoId);
   glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -425,51 +662,98 @@ void Renderer::cubemap(const std::string& uniformName,
     const std::string& textureName) {
   assert(_textures.count(textureName) != 0);
 
-  glBindTexture(GL_TEXTURE_CUBE_MAP, _textures[textureName].texId);
-  setUniform(uniformName, _textures[textureName].slot);
+  const Texture& tex = _textures[textureName];
+  if (_queuing) queueBinding(tex.slot, GL_TEXTURE_CUBE_MAP, tex.texId);
+  else bindTexture(tex.slot, GL_TEXTURE_CUBE_MAP, tex.texId);
+  setUniform(uniformName, tex.slot);
 }
 
 void Renderer::skybox(float size) {
   assert(_initialized);
+  if (_queuing) {
+    // the skybox surrounds the camera, so it is always the farthest
+    QueuedDraw& draw = queueDraw(QUEUED_SKYBOX, _lookfrom + vec3(size));
+    draw.pos = vec3(size);
+    return;
+  }
 
+  updateFrameBlock();
   mat4 s = glm::scale(mat4(1.0f), vec3(size));
   mat4 mvp = _projectionMatrix * _viewMatrix * s;
-  setUniform("MVP", mvp);
+  const StandardUniforms& u = _currentShader->standardUniforms();
+  u.mvp.set(mvp);
+  u.modelMatrix.set(s);
   _skybox->render();
 }
 
 void Renderer::push() {
-  _stack.push_front(_trs);
+  assert(_stackDepth < MAX_STACK_DEPTH);
+  if (_stackDepth == MAX_STACK_DEPTH) {
+    // the matching pop is dropped as well, so that it does not take away
+    // the transform of the caller's parent
+    if (_stackOverflow == 0) {
+      std::cout << "ERROR: matrix stack overflow, deeper than " <<
+        MAX_STACK_DEPTH << " pushes\n";
+    }
+    _stackOverflow++;
+    _stackOverflows++;
+    return;
+  }
+  _stack[_stackDepth++] = _trs;
 }
 
 void Renderer::pop() {
-  if (_stack.size() == 0) return;
-  _trs = _stack.front();
-  _stack.pop_front();
+  if (_stackOverflow > 0) {
+    _stackOverflow--;
+    return;
+  }
+  if (_stackDepth == 0) {
+    std::cout << "ERROR: matrix stack underflow, pop() without push()\n";
+    return;
+  }
+  _trs = _stack[--_stackDepth];
 }
 
 void Renderer::identity() {
-  _trs = mat4(1.0);
+  affineIdentity(_trs);
+}
+
+mat4 Renderer::modelMatrix() const {
+  return toMat4(_trs);
 }
 
 void Renderer::scale(const vec3& xyz) {
-  _trs = _trs * glm::scale(mat4(1.0), xyz);
+  affineScale(_trs, xyz.x, xyz.y, xyz.z);
 }
 
 void Renderer::translate(const vec3& xyz) {
-  _trs = _trs * glm::translate(mat4(1.0), xyz);
+  affineTranslate(_trs, xyz.x, xyz.y, xyz.z);
 }
 
 void Renderer::rotate(float angleRad, const vec3& axis) {
-  _trs = _trs * glm::rotate(mat4(1.0), angleRad, axis);
+  rotate(glm::mat3_cast(glm::angleAxis(angleRad, normalize(axis))));
 }
 
 void Renderer::rotate(const quat& orientation) {
-  _trs = _trs * glm::mat4(orientation);
+  rotate(glm::mat3_cast(orientation));
+}
+
+void Renderer::rotate(const vec3& eulerAngles) {
+  // Rz * Ry * Rx, as glm::quat(eulerAngles) rotates
+  vec3 c = cos(eulerAngles);
+  vec3 s = sin(eulerAngles);
+  mat3 r(c.y * c.z, c.y * s.z, -s.y,
+      s.x * s.y * c.z - c.x * s.z, s.x * s.y * s.z + c.x * c.z, s.x * c.y,
+      c.x * s.y * c.z + s.x * s.z, c.x * s.y * s.z - s.x * c.z, c.x * c.y);
+  rotate(r);
+}
+
+void Renderer::rotate(const mat3& r) {
+  affineMultiply(_trs, toAffine(r), _trs);
 }
 
 void Renderer::transform(const glm::mat4& trs) {
-  _trs = _trs * trs;
+  affineMultiply(_trs, toAffine(trs), _trs);
 }
 
 void Renderer::teapot() {
@@ -505,19 +789,279 @@ void Renderer::sphere() {
 }
 
 void Renderer::mesh(const Mesh& mesh) {
+  drawMesh(mesh, 0);
+}
+
+void Renderer::mesh(const TriangleMesh& mesh, int instances) {
+  drawMesh(mesh, instances);
+}
+
+void Renderer::drawMesh(const Mesh& mesh, int instances) {
   assert(_initialized);
+  if (_queuing) {
+    QueuedDraw& draw = queueDraw(QUEUED_MESH, transformPoint(_trs, vec3(0)));
+    draw.mesh = &mesh;
+    draw.instances = instances;
+    return;
+  }
 
-  mat4 mv = _viewMatrix * _trs;
-  mat4 mvp = _projectionMatrix * mv;
-  mat3 nmv = transpose(inverse(mat3(vec3(mv[0]), vec3(mv[1]), vec3(mv[2]))));
+  updateFrameBlock();
+  setTransformUniforms(mesh.hasUV());
 
-  setUniform("MVP", mvp);
-  setUniform("ModelViewMatrix", mv);
-  setUniform("NormalMatrix", nmv);
-  setUniform("ModelMatrix", _trs);
-  setUniform("HasUV", mesh.hasUV());
+  if (instances > 0) {
+    static_cast<const TriangleMesh&>(mesh).renderInstanced(instances);
+  } else {
+    mesh.render();
+  }
+}
+
+void Renderer::beginQueue() {
+  assert(!_queuing);
+  _queuing = true;
+  _queuePass = 0;
+  _queueOrder = SORT_STATE;
+  _queueKeys.clear();
+  _queueDraws.clear();
+  _queueUniforms.clear();
+  _queueBindings.clear();
+  _queueBindingState.clear();
+  _queueBindingCopy = -1;
+  _queueTexture = 0;
+  for (auto& it : _queueShaders) {
+    it.second.current.clear();
+    it.second.base.clear();
+    it.second.copy = -1;
+    it.second.applied = -1;
+    it.second.appliedCount = -1;
+  }
+}
+
+void Renderer::queuePass(int pass, PassOrder order) {
+  assert(pass >= 0 && pass < 16);
+  _queuePass = pass;
+  _queueOrder = order;
+}
+
+Renderer::QueuedShader& Renderer::queuedShader(Shader* shader) {
+  auto it = _queueShaders.find(shader);
+  if (it == _queueShaders.end()) {
+    QueuedShader queued;
+    queued.id = (int) _queueShaders.size();
+    queued.copy = -1;
+    queued.applied = -1;
+    queued.appliedCount = -1;
+    it = _queueShaders.insert(std::make_pair(shader, queued)).first;
+  }
+  return it->second;
+}
+
+Renderer::QueuedDraw& Renderer::queueDraw(QueuedKind kind,
+    const glm::vec3& center) {
+  assert(_currentShader != nullptr);
+  assert(_queueDraws.size() < QUEUE_MAX_DRAWS);
+
+  // draws share their copy of the uniforms and bindings until they change
+  QueuedShader& shader = queuedShader(_currentShader);
+  if (shader.copy < 0) {
+    shader.copy = (int) _queueUniforms.size();
+    _queueUniforms.insert(_queueUniforms.end(),
+        shader.current.begin(), shader.current.end());
+  }
+  if (_queueBindingCopy < 0) {
+    _queueBindingCopy = (int) _queueBindings.size();
+    _queueBindings.insert(_queueBindings.end(),
+        _queueBindingState.begin(), _queueBindingState.end());
+  }
+
+  QueuedDraw draw;
+  draw.kind = kind;
+  draw.shader = _currentShader;
+  draw.mesh = nullptr;
+  draw.instances = 0;
+  draw.trs = _trs;
+  draw.pos = vec3(0);
+  draw.color = vec4(1);
+  draw.size = 0;
+  draw.rot = 0;
+  draw.blend = _blendMode;
+  draw.depthTest = _depthTest;
+  draw.firstUniform = shader.copy;
+  draw.numUniforms = (int) shader.current.size();
+  draw.firstBinding = _queueBindingCopy;
+  draw.numBindings = (int) _queueBindingState.size();
+
+  // a positive float orders the same as its bits
+  float distance = glm::length(center - _lookfrom);
+  uint32_t depth;
+  memcpy(&depth, &distance, sizeof(depth));
+  depth &= 0x7fffffff;
+
+  // pass:4 | blend:3 depth test off:1 | shader:8 | texture:10 | depth:22 |
+  // draw:16, or pass:4 | far to near:31 | draw:16, or pass:4 | draw:16
+  uint64_t key = (uint64_t) _queuePass << 60;
+  if (_queueOrder == SORT_STATE) {
+    key |= (uint64_t) _blendMode << 57;
+    key |= (uint64_t) !_depthTest << 56;
+    key |= (uint64_t) (shader.id & 0xff) << 48;
+    key |= (uint64_t) (_queueTexture & 0x3ff) << 38;
+    key |= (uint64_t) (depth >> 10) << 16;
+  } else if (_queueOrder == SORT_BACK_TO_FRONT) {
+    key |= (uint64_t) (0x7fffffff - depth) << 16;
+  }
+  _queueKeys.push_back(key | _queueDraws.size());
+  _queueDraws.push_back(draw);
+  return _queueDraws.back();
+}
+
+void Renderer::queueBinding(int slot, GLenum target, GLuint texId) {
+  _queueTexture = texId;
+  for (QueuedBinding& binding : _queueBindingState) {
+    if (binding.slot != slot || binding.target != target) continue;
+    if (binding.texId != texId) {
+      binding.texId = texId;
+      _queueBindingCopy = -1;
+    }
+    return;
+  }
+  _queueBindingState.push_back(QueuedBinding{slot, target, texId});
+  _queueBindingCopy = -1;
+}
+
+// the GL type a uniform of type T is queued as
+template <typename T> static GLenum queuedType();
+template <> GLenum queuedType<float>() { return GL_FLOAT; }
+template <> GLenum queuedType<int>() { return GL_INT; }
+template <> GLenum queuedType<bool>() { return GL_INT; }
+template <> GLenum queuedType<GLuint>() { return GL_UNSIGNED_INT; }
+template <> GLenum queuedType<vec2>() { return GL_FLOAT_VEC2; }
+template <> GLenum queuedType<vec3>() { return GL_FLOAT_VEC3; }
+template <> GLenum queuedType<vec4>() { return GL_FLOAT_VEC4; }
+template <> GLenum queuedType<mat3>() { return GL_FLOAT_MAT3; }
+template <> GLenum queuedType<mat4>() { return GL_FLOAT_MAT4; }
+
+template <typename T>
+static void queuedValue(float* bits, const T& value) {
+  memcpy(bits, &value, sizeof(T));
+}
+template <>
+void queuedValue<bool>(float* bits, const bool& value) {
+  GLint i = value;
+  memcpy(bits, &i, sizeof(i));
+}
+
+template <typename T>
+void Renderer::queueUniform(const Uniform<T>& handle, const T& value) {
+  static_assert(sizeof(T) <= sizeof(QueuedUniform::value),
+      "uniform too large to queue");
+  if (!handle.exists()) return;
+
+  QueuedUniform uniform = {};
+  uniform.location = handle.location();
+  uniform.type = queuedType<T>();
+  queuedValue(uniform.value, value);
+
+  QueuedShader& shader = queuedShader(_currentShader);
+  for (QueuedUniform& set : shader.current) {
+    if (set.location != uniform.location) continue;
+    if (memcmp(set.value, uniform.value, sizeof(uniform.value)) != 0) {
+      set = uniform;
+      shader.copy = -1;
+      handle.keep(value);
+    }
+    return;
+  }
+
+  // the draws recorded before this see the value from before the queue,
+  // which the shader kept; the shader keeps the last one queued from here,
+  // which is what it is left with once the queue is submitted
+  QueuedUniform base = uniform;
+  if (handle.value()) {
+    memcpy(base.value, handle.value(), sizeof(base.value));
+  }
+  handle.keep(value);
+  shader.current.push_back(uniform);
+  shader.base.push_back(base);
+  shader.copy = -1;
+}
+
+void Renderer::applyUniforms(const QueuedShader& shader,
+    const QueuedUniform* values, int count) {
+  for (int i = 0; i < (int) shader.current.size(); i++) {
+    const QueuedUniform& u = i < count ? values[i] : shader.base[i];
+    applyUniform(u.location, u.type, u.value);
+  }
+}
+
+void Renderer::submitQueue() {
+  assert(_queuing);
+  _queuing = false;
+  radixSort(_queueKeys, _queueScratch);
+
+  Shader* shader = _currentShader;
+  Affine trs = _trs;
+  BlendMode blend = _blendMode;
+  bool depthTest = _depthTest;
+  for (uint64_t key : _queueKeys) {
+    const QueuedDraw& draw = _queueDraws[key & (QUEUE_MAX_DRAWS - 1)];
+    _currentShader = draw.shader;
+    useProgram(draw.shader);
+    blendMode(draw.blend);
+    setDepthTest(draw.depthTest);
+    for (int i = 0; i < draw.numBindings; i++) {
+      const QueuedBinding& b = _queueBindings[draw.firstBinding + i];
+      bindTexture(b.slot, b.target, b.texId);
+    }
+    QueuedShader& queued = _queueShaders[draw.shader];
+    if (queued.applied != draw.firstUniform ||
+        queued.appliedCount != draw.numUniforms) {
+      applyUniforms(queued, _queueUniforms.data() + draw.firstUniform,
+          draw.numUniforms);
+      queued.applied = draw.firstUniform;
+      queued.appliedCount = draw.numUniforms;
+    }
+
+    _trs = draw.trs;
+    switch (draw.kind) {
+      case QUEUED_MESH: drawMesh(*draw.mesh, draw.instances); break;
+      case QUEUED_QUAD: quad(); break;
+      case QUEUED_SPRITE:
+        sprite(draw.pos, draw.color, draw.size, draw.rot);
+        break;
+      case QUEUED_SKYBOX: skybox(draw.pos.x); break;
+    }
+  }
 
-  mesh.render();
+  // leave the uniforms and bindings as the last ones recorded
+  for (auto& it : _queueShaders) {
+    QueuedShader& queued = it.second;
+    if (queued.current.empty()) continue;
+    if (queued.copy >= 0 && queued.applied == queued.copy &&
+        queued.appliedCount == (int) queued.current.size()) continue;
+    useProgram(it.first);
+    applyUniforms(queued, queued.current.data(), (int) queued.current.size());
+  }
+  for (const QueuedBinding& b : _queueBindingState) {
+    bindTexture(b.slot, b.target, b.texId);
+  }
+  _currentShader = shader;
+  useProgram(shader);
+  _trs = trs;
+  blendMode(blend);
+  setDepthTest(depthTest);
+}
+
+void Renderer::setTransformUniforms(bool hasUV) {
+  mat4 trs = modelMatrix();
+  mat4 mv = _viewMatrix * trs;
+  const StandardUniforms& u = _currentShader->standardUniforms();
+  u.mvp.set(_projectionMatrix * mv);
+  u.modelViewMatrix.set(mv);
+  // the inverse is the dearest part of a draw, and few shaders light
+  if (u.normalMatrix.exists()) {
+    u.normalMatrix.set(transpose(inverse(mat3(mv))));
+  }
+  u.modelMatrix.set(trs);
+  u.hasUV.set(hasUV);
 }
 
 void Renderer::cleanupShaders() {
@@ -531,7 +1075,9 @@ void Renderer::beginShader(const std::string& shaderName) {
 
   _shaderStack.push_front(_currentShader);
   _currentShader = _shaders[shaderName];
-  _currentShader->use();
+  if (_queuing) return;
+  useProgram(_currentShader);
+  updateFrameBlock();
 }
 
 void Renderer::endShader() {
@@ -539,75 +1085,87 @@ void Renderer::endShader() {
 
   _currentShader = _shaderStack.front();
   _shaderStack.pop_front();
-
-  if (_currentShader != nullptr) {
-    _currentShader->use();
-
-  } else {
-    glUseProgram(0);
-  }
+  if (_queuing) return;
+  useProgram(_currentShader);
 }
 
 void Renderer::setUniform(const std::string& name, float x, float y, float z) {
-  assert(_currentShader != nullptr);
-  _currentShader->setUniform(name.c_str(), x, y, z);
+  setUniform(name, vec3(x, y, z));
 }
 
 void Renderer::setUniform(const std::string& name,
     float x, float y, float z, float w) {
+  setUniform(name, vec4(x, y, z, w));
+}
+
+template <typename T>
+Uniform<T> Renderer::uniform(const std::string& name) {
   assert(_currentShader != nullptr);
-  _currentShader->setUniform(name.c_str(), glm::vec4(x, y, z, w));
+  return _currentShader->uniform<T>(name.c_str());
 }
 
-void Renderer::setUniform(const std::string& name, const glm::vec2 &v) {
+template <typename T>
+void Renderer::setUniform(const Uniform<T>& uniform, const T& value) {
   assert(_currentShader != nullptr);
-  _currentShader->setUniform(name.c_str(), v);
+  if (_queuing) queueUniform(uniform, value);
+  else uniform.set(value);
+}
+
+#define AGL_RENDERER_UNIFORM(T) \
+  template Uniform<T> Renderer::uniform<T>(const std::string&); \
+  template void Renderer::setUniform<T>(const Uniform<T>&, const T&);
+AGL_RENDERER_UNIFORM(float)
+AGL_RENDERER_UNIFORM(int)
+AGL_RENDERER_UNIFORM(bool)
+AGL_RENDERER_UNIFORM(GLuint)
+AGL_RENDERER_UNIFORM(glm::vec2)
+AGL_RENDERER_UNIFORM(glm::vec3)
+AGL_RENDERER_UNIFORM(glm::vec4)
+AGL_RENDERER_UNIFORM(glm::mat3)
+AGL_RENDERER_UNIFORM(glm::mat4)
+#undef AGL_RENDERER_UNIFORM
+
+void Renderer::setUniform(const std::string& name, const glm::vec2 &v) {
+  setUniform(uniform<vec2>(name), v);
 }
 
 void Renderer::setUniform(const std::string& name, const glm::vec3 &v) {
-  assert(_currentShader != nullptr);
-  _currentShader->setUniform(name.c_str(), v);
+  setUniform(uniform<vec3>(name), v);
 }
 
 void Renderer::setUniform(const std::string& name, const glm::vec4 &v) {
-  assert(_currentShader != nullptr);
-  _currentShader->setUniform(name.c_str(), v);
+  setUniform(uniform<vec4>(name), v);
 }
 
 void Renderer::setUniform(const std::string& name, const glm::mat4 &m) {
-  assert(_currentShader != nullptr);
-  _currentShader->setUniform(name.c_str(), m);
+  setUniform(uniform<mat4>(name), m);
 }
 
 void Renderer::setUniform(const std::string& name, const glm::mat3 &m) {
-  assert(_currentShader != nullptr);
-  _currentShader->setUniform(name.c_str(), m);
+  setUniform(uniform<mat3>(name), m);
 }
 
 void Renderer::setUniform(const std::string& name, 
   const std::vector<glm::mat4> &ms) {
   assert(_currentShader != nullptr);
+  assert(!_queuing);
   _currentShader->setUniform(name.c_str(), ms);
 }
 
 void Renderer::setUniform(const std::string& name, float val) {
-  assert(_currentShader != nullptr);
-  _currentShader->setUniform(name.c_str(), val);
+  setUniform(uniform<float>(name), val);
 }
 
 void Renderer::setUniform(const std::string& name, int val) {
-  assert(_currentShader != nullptr);
-  _currentShader->setUniform(name.c_str(), val);
+  setUniform(uniform<int>(name), val);
 }
 
 void Renderer::setUniform(const std::string& name, bool val) {
-  assert(_currentShader != nullptr);
-  _currentShader->setUniform(name.c_str(), val);
+  setUniform(uniform<bool>(name), val);
 }
 
 void Renderer::setUniform(const std::string& name, GLuint val) {
-  assert(_currentShader != nullptr);
-  _currentShader->setUniform(name.c_str(), val);
+  setUniform(uniform<GLuint>(name), val);
 }
 
 void Renderer::loadCubemap(const std::string& name,
@@ -639,19 +1197,16 @@ void Renderer::loadCubemap(const std::string& name,
   if (slot == GLFONS_FONT_TEXTURE_SLOT) {
     std::cout << "WARNING: slot " << slot << " conflicts with font texture\n";
   }
-  glEnable(GL_TEXTURE0 + slot);
-  glActiveTexture(GL_TEXTURE0 + slot);
-
   GLuint texId;
   if (_textures.count(name) == 0) {
     glGenTextures(1, &texId);
-    Texture tex{texId, slot};
+    Texture tex{texId, slot, GL_TEXTURE_CUBE_MAP};
     _textures[name] = tex;
 
   } else {
     texId = _textures[name].texId;
   }
-  glBindTexture(GL_TEXTURE_CUBE_MAP, texId);
+  bindTexture(slot, GL_TEXTURE_CUBE_MAP, texId);
 
   GLuint targets[] = {
     GL_TEXTURE_CUBE_MAP_POSITIVE_X,
@@ -687,20 +1242,17 @@ void Renderer::loadTexture(const std::string& name,
   if (slot == GLFONS_FONT_TEXTURE_SLOT) {
     std::cout << "WARNING: slot " << slot << " conflicts with font texture\n";
   }
-  glEnable(GL_TEXTURE0 + slot);
-  glActiveTexture(GL_TEXTURE0 + slot);
-
   GLuint texId;
   if (_textures.count(name) == 0) {
     glGenTextures(1, &texId);
-    _textures[name] = Texture{texId, slot};
+    _textures[name] = Texture{texId, slot, GL_TEXTURE_2D};
   } else {
     std::cout << "WARNING: texture already registered with name: " << 
         name << std::endl;
     texId = _textures[name].texId;
   }
 
-  glBindTexture(GL_TEXTURE_2D, texId);
+  bindTexture(slot, GL_TEXTURE_2D, texId);
   glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, image.width(), image.height());
   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width(), image.height(),
       GL_RGBA, GL_UNSIGNED_BYTE, image.data());
@@ -709,6 +1261,61 @@ void Renderer::loadTexture(const std::string& name,
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 }
 
+void Renderer::loadTextureArray(const std::string& name,
+    const std::vector<std::string>& fileNames, int slot) {
+  vector<Image> images(fileNames.size());
+  for (int i = 0; i < fileNames.size(); i++) {
+    images[i].load(fileNames[i]);
+  }
+  loadTextureArray(name, images, slot);
+}
+
+void Renderer::loadTextureArray(const std::string& name,
+    const std::vector<Image>& images, int slot) {
+  if (images.empty()) return;
+  if (slot == GLFONS_FONT_TEXTURE_SLOT) {
+    std::cout << "WARNING: slot " << slot << " conflicts with font texture\n";
+  }
+  GLuint texId;
+  if (_textures.count(name) == 0) {
+    glGenTextures(1, &texId);
+    _textures[name] = Texture{texId, slot, GL_TEXTURE_2D_ARRAY};
+  } else {
+    std::cout << "WARNING: texture already registered with name: " <<
+        name << std::endl;
+    texId = _textures[name].texId;
+  }
+
+  // the first image that loaded sets the size
+  int width = 0;
+  int height = 0;
+  for (int i = 0; i < images.size() && width == 0; i++) {
+    if (!images[i].data()) continue;
+    width = images[i].width();
+    height = images[i].height();
+  }
+  if (width == 0) {
+    std::cout << "WARNING: no images loaded for " << name << std::endl;
+    return;
+  }
+  bindTexture(slot, GL_TEXTURE_2D_ARRAY, texId);
+  glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, width, height,
+      (GLsizei) images.size());
+  for (int i = 0; i < images.size(); i++) {
+    if (!images[i].data()) continue;
+    if (images[i].width() != width || images[i].height() != height) {
+      std::cout << "WARNING: layer " << i << " of " << name <<
+          " differs in size from the others\n";
+      continue;
+    }
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1,
+        GL_RGBA, GL_UNSIGNED_BYTE, images[i].data());
+  }
+
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+}
+
 void Renderer::loadShader(const std::string& name,
     const std::string& vs, const std::string& fs) {
 
@@ -767,15 +1374,14 @@ void Renderer::loadRenderTexture(const std::string& name,
   // Create the texture object
   GLuint renderTex;
   glGenTextures(1, &renderTex);
-  glActiveTexture(GL_TEXTURE0 + slot);  // put in given slot!!
-  glBindTexture(GL_TEXTURE_2D, renderTex);
+  bindTexture(slot, GL_TEXTURE_2D, renderTex);  // put in given slot!!
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
       GL_UNSIGNED_BYTE, NULL);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
   // save texture as an available texture object with the same name
-  _textures[name] = Texture{renderTex, slot};
+  _textures[name] = Texture{renderTex, slot, GL_TEXTURE_2D};
 
   // Bind the texture to the FBO
   glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
@@ -7,8 +7,10 @@
 #include <list>
 #include <string>
 #include <map>
+#include <cstdint>
 #include "agl/agl.h"
 #include "agl/aglm.h"
+#include "agl/affine.h"
 #include "agl/image.h"
 #include "agl/mesh.h"
 
@@ -39,6 +41,25 @@ enum BlendMode {
   LIGHTEST
 };
 
+/**
+ * @brief How the draws in a pass of the render queue are ordered
+ *
+ * * *SORT_STATE* By blend mode, shader and texture, then front to back, for
+ *   opaque draws and for draws whose order does not matter, such as additive
+ *   ones without depth testing
+ * * *SORT_BACK_TO_FRONT* Far to near, for alpha blended draws
+ * * *SORT_NONE* In the order they were recorded
+ * @see Renderer::queuePass
+ */
+enum PassOrder {
+  SORT_STATE,
+  SORT_BACK_TO_FRONT,
+  SORT_NONE
+};
+
+class TriangleMesh;
+template <typename T> class Uniform;
+
 /**
  * @brief The Renderer class draws meshes to the screen using shaders
  */
@@ -163,7 +184,20 @@ class Renderer {
    */
   glm::mat4 viewMatrix() const { return _viewMatrix; }
 
-  glm::mat4 modelMatrix() const { return _trs; }
+  glm::mat4 modelMatrix() const;
+
+  /**
+   * @brief Set the time and resolution of the PerFrame uniform block
+   * @param time The time in seconds
+   * @param resolution The width and height of the screen in pixels
+   *
+   * Window calls this method at the start of each frame, which also starts
+   * counting the state calls of the frame for stateStats(). The view,
+   * projection and camera position in the block follow lookAt(),
+   * perspective() and ortho().
+   * @see FRAME_BLOCK_BINDING
+   */
+  void frameInfo(float time, const glm::vec2& resolution);
   ///@}
 
   /** @name Shaders
@@ -321,6 +355,22 @@ class Renderer {
    */
   void setUniform(const std::string& name, GLuint val);
 
+  /**
+   * @brief Look a uniform of the currently active shader up once, to set it
+   * many times with setUniform(const Uniform<T>&, const T&)
+   *
+   * T is one of float, int, bool, GLuint, vec2, vec3, vec4, mat3 or mat4.
+   */
+  template <typename T>
+  Uniform<T> uniform(const std::string& name);
+
+  /**
+   * @brief Set a uniform of the currently active shader, without looking it
+   * up by name
+   */
+  template <typename T>
+  void setUniform(const Uniform<T>& uniform, const T& value);
+
   /**
    * @brief Set a uniform sampler parameter in the currently active shader
    *
@@ -362,6 +412,23 @@ class Renderer {
    */
   void loadTexture(const std::string& name, const Image& img, int slot);
 
+  /**
+   * @brief Load images of the same size as the layers of one texture array
+   *
+   * Shaders sample it as a sampler2DArray, with the layer as the third
+   * texture coordinate, and texture() binds it like any other texture.
+   * Images that fail to load or differ in size from the first one that
+   * loaded leave their layer empty.
+   */
+  void loadTextureArray(const std::string& name,
+      const std::vector<std::string>& fileNames, int slot);
+
+  /**
+   * @brief Load a texture array from Images
+   */
+  void loadTextureArray(const std::string& name,
+      const std::vector<Image>& images, int slot);
+
   /**
    * @brief Load a cube map
    */
@@ -409,6 +476,15 @@ class Renderer {
    */
   void pop();
 
+  /**
+   * @brief Number of pushes dropped since init() because the stack was full
+   *
+   * The stack holds 32 matrices. A push past that is reported and dropped
+   * along with its matching pop, so draws nested that deep use the wrong
+   * transform but the levels above them keep theirs.
+   */
+  int stackOverflows() const { return _stackOverflows; }
+
   /**
    * @brief Clear the current transform
    *
@@ -462,12 +538,32 @@ class Renderer {
    */
   void rotate(const glm::quat& orientation);
 
+  /**
+   * @brief Rotates an object
+   * @param eulerAngles Angles in radians around the X, Y and Z axes
+   *
+   * Rotates the object around X, then Y, then Z, as the quaternion made from
+   * eulerAngles would.  Transformations are relative to the current
+   * position, size, and rotation of the object.
+   */
+  void rotate(const glm::vec3& eulerAngles);
+
+  /**
+   * @brief Rotates an object
+   * @param r A rotation matrix
+   *
+   * Rotates the object by r.  Transformations are relative to the current
+   * position, size, and rotation of the object.
+   */
+  void rotate(const glm::mat3& r);
+
   /**
    * @brief Transforms an object by the given matrix
    * @param trs The matrix transform
    *
    * Typically this matrix will be the product of translation * rotate * scale
-   * matrices. Transformations are relative to the current position, size, and
+   * matrices. It must be affine: its bottom row is taken to be 0 0 0 1.
+   * Transformations are relative to the current position, size, and
    * rotation of the object.
    * @verbinclude transform.cpp
    */
@@ -498,6 +594,32 @@ class Renderer {
    */
   void setDepthTest(bool b);
 
+  /**
+   * @brief Counts of the GL state calls made through the renderer in a frame
+   *
+   * *issued* calls reached GL. *filtered* calls were dropped because GL was
+   * already in the state they asked for: the program in use, the texture
+   * bound to a slot, depth testing and the blend mode.
+   */
+  struct StateStats {
+    int issued;
+    int filtered;
+  };
+
+  /**
+   * @brief Return the state call counts of the last finished frame
+   */
+  const StateStats& stateStats() const { return _lastStateStats; }
+
+  /**
+   * @brief Forget the GL state the renderer believes is set
+   *
+   * Call after using programs, binding textures or changing depth testing
+   * or blending with GL directly, so that the renderer issues its next
+   * calls for them again. Window calls this method after setup().
+   */
+  void invalidateState();
+
   /** @name Drawing
    */
   ///@{
@@ -638,12 +760,76 @@ class Renderer {
    *
    */
   void quad();
+
+  /**
+   * @brief Draws many instances of a mesh in one call
+   * @param m The mesh, with per instance attributes set up by
+   * TriangleMesh::setInstanceBuffer()
+   * @param instances The number of instances
+   */
+  void mesh(const TriangleMesh& m, int instances);
+  ///@}
+
+  /** @name Render queue
+   */
+  ///@{
+  /**
+   * @brief Record draws instead of drawing them
+   *
+   * Until submitQueue(), the draw methods record each draw together with
+   * the shader, texture bindings, uniforms, blend mode, depth test and
+   * transform it would have used, and beginShader(), texture(), setUniform()
+   * and the like only change what later draws record. line() and text()
+   * cannot be queued. The view and projection in place at submitQueue()
+   * apply to every draw.
+   *
+   * Usage
+   * ```
+   * beginQueue();
+   * queuePass(0, SORT_STATE);
+   * // draw opaque primitives
+   * queuePass(1, SORT_BACK_TO_FRONT);
+   * // draw alpha blended primitives
+   * submitQueue();
+   * ```
+   */
+  void beginQueue();
+
+  /**
+   * @brief Set the pass of the draws recorded next
+   * @param pass Passes are drawn in increasing order, from 0 to 15
+   * @param order How the draws within the pass are ordered
+   */
+  void queuePass(int pass, PassOrder order = SORT_STATE);
+
+  /**
+   * @brief Draw everything recorded since beginQueue()
+   *
+   * The draws are sorted by pass, and within a pass as it asks, and drawn
+   * in that order. Afterwards the shader, texture bindings, uniforms and
+   * blend mode are as if the draws had been made immediately.
+   */
+  void submitQueue();
   ///@}
 
  private:
   void initBillboards();
   void initLines();
   void initText();
+  // uploads the PerFrame block if anything in it changed
+  void updateFrameBlock();
+
+  void drawMesh(const Mesh& mesh, int instances);
+  // sets MVP, ModelViewMatrix, NormalMatrix, ModelMatrix and HasUV
+  void setTransformUniforms(bool hasUV);
+
+  // GL state calls that are dropped when _state says they change nothing
+  void useProgram(class Shader* shader);
+  void enable(GLenum cap, bool on);
+  void blendEquation(GLenum mode);
+  void blendFunc(GLenum src, GLenum dst);
+  void bindTexture(int slot, GLenum target, GLuint texId);
+  void forgetTextures();
 
  private:
   bool _initialized;
@@ -653,6 +839,7 @@ class Renderer {
   struct Texture {
     GLuint texId;
     int slot;
+    GLenum target;  // GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY or GL_TEXTURE_CUBE_MAP
   };
   std::map<std::string, Texture> _textures;
 
@@ -674,15 +861,113 @@ class Renderer {
   std::map<std::string, class Shader*> _shaders;
   std::list<Shader*> _shaderStack;
 
-  // matrix stack
-  std::list<glm::mat4> _stack;
-  glm::mat4 _trs;
+  // matrix stack, of affine transforms so that a push never allocates
+  static const int MAX_STACK_DEPTH = 32;
+  Affine _stack[MAX_STACK_DEPTH];
+  int _stackDepth;
+  // pushes dropped on a full stack whose pops have not come yet
+  int _stackOverflow;
+  int _stackOverflows;
+  Affine _trs;
 
   // perspective and view
   glm::mat4 _projectionMatrix;
   glm::mat4 _viewMatrix;
   glm::vec3 _lookfrom;
 
+  // the PerFrame uniform block, laid out as std140
+  struct FrameBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 camPos;
+    float time;
+    glm::vec2 resolution;
+    glm::vec2 padding;
+  };
+  FrameBlock _frame;
+  GLuint _frameBuffer;
+  bool _frameDirty;
+
+  // shadow copy of the GL state set through the renderer; -1 means not known
+  static const int MAX_TEXTURE_SLOTS = 32;
+  struct StateCache {
+    GLint program;
+    int depthTest;
+    int blend;
+    GLint blendEquation;
+    GLint blendSrc;
+    GLint blendDst;
+    int activeSlot;
+    GLint targets[MAX_TEXTURE_SLOTS];
+    GLint textures[MAX_TEXTURE_SLOTS];
+  };
+  StateCache _state;
+  StateStats _stateStats;
+  StateStats _lastStateStats;
+  bool _depthTest;
+
+  // render queue: every draw gets a sort key, whose low bits index its
+  // QueuedDraw, and copies of the uniforms and bindings it uses; all of
+  // them are cleared, but keep their memory, from frame to frame
+  static const int QUEUE_MAX_DRAWS = 1 << 16;
+  enum QueuedKind { QUEUED_MESH, QUEUED_QUAD, QUEUED_SPRITE, QUEUED_SKYBOX };
+  struct QueuedUniform {
+    GLint location;
+    GLenum type;  // GL_INT, GL_UNSIGNED_INT, or GL_FLOAT to GL_FLOAT_MAT4
+    float value[16];
+  };
+  struct QueuedBinding {
+    int slot;
+    GLenum target;
+    GLuint texId;
+  };
+  struct QueuedDraw {
+    QueuedKind kind;
+    class Shader* shader;
+    const Mesh* mesh;
+    int instances;   // 0 unless instanced
+    Affine trs;
+    glm::vec3 pos;   // sprite position, or skybox size in x
+    glm::vec4 color;
+    float size;
+    float rot;
+    BlendMode blend;
+    bool depthTest;
+    int firstUniform;
+    int numUniforms;
+    int firstBinding;
+    int numBindings;
+  };
+  // what a shader's uniforms are while recording
+  struct QueuedShader {
+    int id;
+    std::vector<QueuedUniform> current;  // in the order they were first set
+    std::vector<QueuedUniform> base;     // the same from before the queue
+    int copy;      // of current in _queueUniforms, -1 if it changed since
+    int applied;   // first and count of the copy last set while submitting
+    int appliedCount;
+  };
+  QueuedShader& queuedShader(class Shader* shader);
+  QueuedDraw& queueDraw(QueuedKind kind, const glm::vec3& center);
+  void queueBinding(int slot, GLenum target, GLuint texId);
+  template <typename T>
+  void queueUniform(const Uniform<T>& uniform, const T& value);
+  void applyUniforms(const QueuedShader& shader,
+      const QueuedUniform* values, int count);
+
+  bool _queuing;
+  int _queuePass;
+  PassOrder _queueOrder;
+  std::vector<uint64_t> _queueKeys;
+  std::vector<uint64_t> _queueScratch;
+  std::vector<QueuedDraw> _queueDraws;
+  std::vector<QueuedUniform> _queueUniforms;
+  std::vector<QueuedBinding> _queueBindings;
+  std::map<class Shader*, QueuedShader> _queueShaders;
+  std::vector<QueuedBinding> _queueBindingState;
+  int _queueBindingCopy;
+  GLuint _queueTexture;  // the texture bound last, for the sort key
+
   // default meshes
   class Cube* _cube;
   class Cylinder* _cone;
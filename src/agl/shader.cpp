@@ -187,12 +187,29 @@ void Shader::link() {
     throw GLSLProgramException(string("Program link failed:\n") + logString);
   } else {
     findUniformLocations();
+    standard.mvp = uniform<glm::mat4>("MVP");
+    standard.modelViewMatrix = uniform<glm::mat4>("ModelViewMatrix");
+    standard.normalMatrix = uniform<glm::mat3>("NormalMatrix");
+    standard.modelMatrix = uniform<glm::mat4>("ModelMatrix");
+    standard.hasUV = uniform<bool>("HasUV");
+    standard.cameraPos = uniform<glm::vec3>("CameraPos");
+    standard.offset = uniform<glm::vec3>("Offset");
+    standard.color = uniform<glm::vec4>("Color");
+    standard.size = uniform<float>("Size");
+    standard.rot = uniform<float>("Rot");
+
+    GLuint frameBlock = glGetUniformBlockIndex(handle, "PerFrame");
+    if (frameBlock != GL_INVALID_INDEX) {
+      glUniformBlockBinding(handle, frameBlock, FRAME_BLOCK_BINDING);
+    }
     linked = true;
   }
 }
 
 void Shader::findUniformLocations() {
   uniformLocations.clear();
+  // the type of each uniform that gets a value, in uniformValues order
+  std::vector<GLenum> types;
 
   GLint numUniforms = 0;
 #ifdef __APPLE__
@@ -210,7 +227,13 @@ void Shader::findUniformLocations() {
     GLsizei written;
     glGetActiveUniform(handle, i, maxLen, &written, &size, &type, name);
     GLint location = glGetUniformLocation(handle, name);
-    uniformLocations[name] = glGetUniformLocation(handle, name);
+    if (location < 0) continue;  // Skip uniforms in blocks
+    UniformEntry entry = {location, -1};
+    if (size == 1) {
+      entry.value = types.size() * 16;
+      types.push_back(type);
+    }
+    uniformLocations[name] = entry;
   }
   delete[] name;
 #else
@@ -218,21 +241,66 @@ void Shader::findUniformLocations() {
   glGetProgramInterfaceiv(handle, GL_UNIFORM,
     GL_ACTIVE_RESOURCES, &numUniforms);
 
-  GLenum properties[] = {GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_BLOCK_INDEX};
+  GLenum properties[] = {GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_BLOCK_INDEX,
+      GL_ARRAY_SIZE};
 
   for (GLint i = 0; i < numUniforms; ++i) {
-    GLint results[4];
+    GLint results[5];
     glGetProgramResourceiv(handle, GL_UNIFORM,
-        i, 4, properties, 4, NULL, results);
+        i, 5, properties, 5, NULL, results);
 
     if (results[3] != -1) continue;  // Skip uniforms in blocks
     GLint nameBufSize = results[0] + 1;
     char * name = new char[nameBufSize];
     glGetProgramResourceName(handle, GL_UNIFORM, i, nameBufSize, NULL, name);
-    uniformLocations[name] = results[2];
+    UniformEntry entry = {results[2], -1};
+    if (results[4] == 1) {
+      entry.value = types.size() * 16;
+      types.push_back(results[1]);
+    }
+    uniformLocations[name] = entry;
     delete [] name;
   }
 #endif
+  readUniformValues(types);
+}
+
+void Shader::readUniformValues(const std::vector<GLenum>& types) {
+  // Read what each uniform starts as once, here, so nothing has to ask the
+  // driver for it later
+  uniformValues.assign(types.size() * 16, 0.0f);
+  for (auto& pos : uniformLocations) {
+    const UniformEntry& entry = pos.second;
+    if (entry.value < 0) continue;
+
+    float* value = &uniformValues[entry.value];
+    switch (types[entry.value / 16]) {
+      case GL_FLOAT: case GL_FLOAT_VEC2: case GL_FLOAT_VEC3:
+      case GL_FLOAT_VEC4: case GL_FLOAT_MAT2: case GL_FLOAT_MAT3:
+      case GL_FLOAT_MAT4: case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT2x4:
+      case GL_FLOAT_MAT3x2: case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x2:
+      case GL_FLOAT_MAT4x3:
+        glGetUniformfv(handle, entry.location, value);
+        break;
+      case GL_UNSIGNED_INT: case GL_UNSIGNED_INT_VEC2:
+      case GL_UNSIGNED_INT_VEC3: case GL_UNSIGNED_INT_VEC4:
+        glGetUniformuiv(handle, entry.location,
+            reinterpret_cast<GLuint*>(value));
+        break;
+      case GL_DOUBLE: case GL_DOUBLE_VEC2: case GL_DOUBLE_VEC3:
+      case GL_DOUBLE_VEC4: case GL_DOUBLE_MAT2: case GL_DOUBLE_MAT3:
+      case GL_DOUBLE_MAT4: case GL_DOUBLE_MAT2x3: case GL_DOUBLE_MAT2x4:
+      case GL_DOUBLE_MAT3x2: case GL_DOUBLE_MAT3x4: case GL_DOUBLE_MAT4x2:
+      case GL_DOUBLE_MAT4x3:
+        // Nothing here sets doubles; they would not fit in sixteen floats
+        pos.second.value = -1;
+        break;
+      default:
+        // ints, bools and samplers
+        glGetUniformiv(handle, entry.location, reinterpret_cast<GLint*>(value));
+        break;
+    }
+  }
 }
 
 void Shader::use() {
@@ -259,57 +327,48 @@ void Shader::bindFragDataLocation(GLuint location, const char *name) {
 }
 
 void Shader::setUniform(const char *name, float x, float y, float z) {
-  GLint loc = getUniformLocation(name);
-  glUniform3f(loc, x, y, z);
+  uniform<glm::vec3>(name).set(glm::vec3(x, y, z));
 }
 
 void Shader::setUniform(const char *name, const glm::vec3 &v) {
-  this->setUniform(name, v.x, v.y, v.z);
+  uniform<glm::vec3>(name).set(v);
 }
 
 void Shader::setUniform(const char *name, const glm::vec4 &v) {
-  GLint loc = getUniformLocation(name);
-  glUniform4f(loc, v.x, v.y, v.z, v.w);
+  uniform<glm::vec4>(name).set(v);
 }
 
 void Shader::setUniform(const char *name, const glm::vec2 &v) {
-  GLint loc = getUniformLocation(name);
-  glUniform2f(loc, v.x, v.y);
+  uniform<glm::vec2>(name).set(v);
 }
 
 void Shader::setUniform(const char *name, const glm::mat4 &m) {
-  GLint loc = getUniformLocation(name);
-  glUniformMatrix4fv(loc, 1, GL_FALSE, &m[0][0]);
+  uniform<glm::mat4>(name).set(m);
 }
 
 void Shader::setUniform(const char *name, const std::vector<glm::mat4> &ms) {
-  GLint loc = getUniformLocation(name);
+  GLint loc = findUniform(name).location;
   glUniformMatrix4fv(loc, ms.size(), GL_FALSE, &ms[0][0][0]);
 }
 
 void Shader::setUniform(const char *name, const glm::mat3 &m) {
-  GLint loc = getUniformLocation(name);
-  glUniformMatrix3fv(loc, 1, GL_FALSE, &m[0][0]);
+  uniform<glm::mat3>(name).set(m);
 }
 
 void Shader::setUniform(const char *name, float val) {
-  GLint loc = getUniformLocation(name);
-  glUniform1f(loc, val);
+  uniform<float>(name).set(val);
 }
 
 void Shader::setUniform(const char *name, int val) {
-  GLint loc = getUniformLocation(name);
-  glUniform1i(loc, val);
+  uniform<int>(name).set(val);
 }
 
 void Shader::setUniform(const char *name, GLuint val) {
-  GLint loc = getUniformLocation(name);
-  glUniform1ui(loc, val);
+  uniform<GLuint>(name).set(val);
 }
 
 void Shader::setUniform(const char *name, bool val) {
-  int loc = getUniformLocation(name);
-  glUniform1i(loc, val);
+  uniform<bool>(name).set(val);
 }
 
 void Shader::printActiveUniforms() {
@@ -543,14 +602,16 @@ void Shader::validate() {
   }
 }
 
-int Shader::getUniformLocation(const char *name) {
+const Shader::UniformEntry& Shader::findUniform(const char *name) {
   auto pos = uniformLocations.find(name);
 
   if (pos == uniformLocations.end()) {
-    uniformLocations[name] = glGetUniformLocation(handle, name);
+    // Array elements and names the shader does not have; nothing is kept
+    UniformEntry entry = {glGetUniformLocation(handle, name), -1};
+    pos = uniformLocations.insert(std::make_pair(string(name), entry)).first;
   }
 
-  return uniformLocations[name];
+  return pos->second;
 }
 
 bool Shader::fileExists(const string &fileName) {
@@ -7,8 +7,10 @@
 #pragma warning(disable : 4290)
 #endif
 
+#include <cstring>
 #include <string>
 #include <map>
+#include <vector>
 #include <stdexcept>
 #include "agl/agl.h"
 #include "agl/aglm.h"
@@ -36,6 +38,126 @@ namespace GLSLShader {
   };
 }  // namespace GLSLShader
 
+/**
+ * @brief Binding point of the PerFrame uniform block
+ *
+ * Shaders that declare the block below share one buffer, which the Renderer
+ * fills once per frame instead of every shader taking these as uniforms.
+ * The layout is std140 and must match Renderer::FrameBlock.
+ * ```
+ * layout (std140) uniform PerFrame
+ * {
+ *    mat4 View;
+ *    mat4 Projection;
+ *    vec3 CamPos;
+ *    float Time;
+ *    vec2 Resolution;
+ * };
+ * ```
+ */
+static const GLuint FRAME_BLOCK_BINDING = 0;
+
+/**
+ * @brief A uniform of type T, with its location looked up once
+ *
+ * Setting it calls glUniform straight away, without the name lookup of
+ * Shader::setUniform, on the shader in use, which must be the shader it came
+ * from. Setting a uniform the shader does not have does nothing.
+ *
+ * The shader keeps what each of its uniforms outside a block was last set
+ * to, read once when it links, so that value() can be read back without a
+ * round trip to the driver. Bools are kept as ints.
+ */
+template <typename T>
+class Uniform {
+ public:
+  Uniform() : _location(-1), _value(nullptr) {}
+  Uniform(GLint location, float* value) : _location(location), _value(value) {}
+
+  bool exists() const { return _location >= 0; }
+  GLint location() const { return _location; }
+  // the value last set, sixteen floats' worth of bits, or null if not kept
+  const float* value() const { return _value; }
+  void set(const T& value) const;
+  // keep a value without setting it, for a set that comes later
+  void keep(const T& v) const {
+    if (_value) memcpy(_value, &v, sizeof(T));
+  }
+
+ private:
+  GLint _location;
+  float* _value;
+};
+
+template <> inline void Uniform<bool>::keep(const bool& v) const {
+  int i = v;
+  if (_value) memcpy(_value, &i, sizeof(i));
+}
+
+template <> inline void Uniform<float>::set(const float& v) const {
+  if (_location < 0) return;
+  keep(v);
+  glUniform1f(_location, v);
+}
+template <> inline void Uniform<int>::set(const int& v) const {
+  if (_location < 0) return;
+  keep(v);
+  glUniform1i(_location, v);
+}
+template <> inline void Uniform<bool>::set(const bool& v) const {
+  if (_location < 0) return;
+  keep(v);
+  glUniform1i(_location, v);
+}
+template <> inline void Uniform<GLuint>::set(const GLuint& v) const {
+  if (_location < 0) return;
+  keep(v);
+  glUniform1ui(_location, v);
+}
+template <> inline void Uniform<glm::vec2>::set(const glm::vec2& v) const {
+  if (_location < 0) return;
+  keep(v);
+  glUniform2f(_location, v.x, v.y);
+}
+template <> inline void Uniform<glm::vec3>::set(const glm::vec3& v) const {
+  if (_location < 0) return;
+  keep(v);
+  glUniform3f(_location, v.x, v.y, v.z);
+}
+template <> inline void Uniform<glm::vec4>::set(const glm::vec4& v) const {
+  if (_location < 0) return;
+  keep(v);
+  glUniform4f(_location, v.x, v.y, v.z, v.w);
+}
+template <> inline void Uniform<glm::mat3>::set(const glm::mat3& m) const {
+  if (_location < 0) return;
+  keep(m);
+  glUniformMatrix3fv(_location, 1, GL_FALSE, &m[0][0]);
+}
+template <> inline void Uniform<glm::mat4>::set(const glm::mat4& m) const {
+  if (_location < 0) return;
+  keep(m);
+  glUniformMatrix4fv(_location, 1, GL_FALSE, &m[0][0]);
+}
+
+/**
+ * @brief The uniforms the Renderer sets when it draws, found when the
+ * shader links
+ */
+struct StandardUniforms {
+  Uniform<glm::mat4> mvp;
+  Uniform<glm::mat4> modelViewMatrix;
+  Uniform<glm::mat3> normalMatrix;
+  Uniform<glm::mat4> modelMatrix;
+  Uniform<bool> hasUV;
+  // sprites
+  Uniform<glm::vec3> cameraPos;
+  Uniform<glm::vec3> offset;
+  Uniform<glm::vec4> color;
+  Uniform<float> size;
+  Uniform<float> rot;
+};
+
 class Shader {
  public:
   Shader();
@@ -68,6 +190,18 @@ class Shader {
 
   void findUniformLocations();
 
+  /**
+   * @brief Look a uniform up once, to set it many times
+   */
+  template <typename T>
+  Uniform<T> uniform(const char *name) {
+    const UniformEntry& entry = findUniform(name);
+    return Uniform<T>(entry.location,
+        entry.value < 0 ? nullptr : &uniformValues[entry.value]);
+  }
+
+  const StandardUniforms& standardUniforms() const { return standard; }
+
   void printActiveUniforms();
   void printActiveUniformBlocks();
   void printActiveAttribs();
@@ -77,9 +211,20 @@ class Shader {
  private:
   GLuint handle;
   bool linked;
-  std::map<std::string, int> uniformLocations;
-
-  GLint getUniformLocation(const char *name);
+  // a uniform's location and the index in uniformValues of its value, -1
+  // for uniforms in arrays or not in the shader
+  struct UniformEntry {
+    GLint location;
+    int value;
+  };
+  std::map<std::string, UniformEntry> uniformLocations;
+  // sixteen floats for each uniform entry with a value, sized at link and
+  // never again, so that handles can point into it
+  std::vector<float> uniformValues;
+  StandardUniforms standard;
+
+  const UniformEntry& findUniform(const char *name);
+  void readUniformValues(const std::vector<GLenum>& types);
   bool fileExists(const std::string &fileName);
   std::string getExtension(const std::string& fileName);
 
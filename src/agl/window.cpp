@@ -7,6 +7,7 @@
 
 namespace agl {
 
+using glm::vec2;
 using glm::vec3;
 using glm::vec4;
 using glm::mat3;
@@ -64,6 +65,7 @@ void Window::run() {
   if (!_window) return;  // window wasn't initialized
 
   setup();
+  renderer.invalidateState();  // setup() may have used GL directly
 
   while (!glfwWindowShouldClose(_window)) {
     float time = glfwGetTime();
@@ -73,6 +75,7 @@ void Window::run() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     renderer.identity();
+    renderer.frameInfo(_elapsedTime, vec2(width(), height()));
     draw();  // user function
     renderer.cleanupShaders();
 
@@ -0,0 +1,58 @@
+//--------------------------------------------------
+// Author: Keith Mburu
+// Date: 10/17/2026
+// Description: Textured dots drawn as one mesh
+//--------------------------------------------------
+
+#include "dotmesh.h"
+
+using namespace std;
+using namespace glm;
+
+namespace agl {
+
+   // corners of a dot in the order of its vertices
+   static const vec2 corners[4] = {vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(0.5, 0.5), vec2(-0.5, 0.5)};
+
+   DotMesh::DotMesh(int maxDots) : _maxDots(maxDots) {
+      setIsDynamic(true);
+   }
+
+   DotMesh::~DotMesh() {
+   }
+
+   void DotMesh::init() {
+      vector<GLuint> indices;
+      vector<GLfloat> positions(_maxDots * 4 * 3, 0.0f);
+      vector<GLfloat> normals;
+      vector<GLfloat> uvs;
+      for (int i = 0; i < _maxDots; i++) {
+         GLuint v = i * 4;
+         GLuint quad[6] = {v, v + 1, v + 2, v, v + 2, v + 3};
+         indices.insert(indices.end(), quad, quad + 6);
+         for (int k = 0; k < 4; k++) {
+            normals.push_back(0); normals.push_back(0); normals.push_back(1);
+            uvs.push_back(corners[k].x + 0.5f); uvs.push_back(corners[k].y + 0.5f);
+         }
+      }
+      initBuffers(&indices, &positions, &normals, &uvs);
+   }
+
+   int DotMesh::maxDots() const {
+      return _maxDots;
+   }
+
+   void DotMesh::setDot(int i, const vec3& pos, float size) {
+      if (!_initialized) init();
+      for (int k = 0; k < 4; k++) {
+         setVertexData(POSITION, i * 4 + k, vec4(pos + vec3(size * corners[k], 0), 1));
+      }
+   }
+
+   void DotMesh::hideFrom(int i) {
+      if (!_initialized) init();
+      for (; i < _maxDots; i++) {
+         setDot(i, vec3(0), 0);
+      }
+   }
+}
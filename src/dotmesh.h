@@ -0,0 +1,42 @@
+//--------------------------------------------------
+// Author: Keith Mburu
+// Date: 10/17/2026
+// Description: Textured dots drawn as one mesh
+//--------------------------------------------------
+
+#ifndef dotmesh_H_
+#define dotmesh_H_
+
+#include "agl/aglm.h"
+#include "agl/mesh/triangle_mesh.h"
+
+namespace agl {
+   // A fixed number of flat, square dots facing +z that are moved every frame
+   // and drawn with a single draw call. Dots that are not in use are
+   // collapsed to a point so that they draw nothing.
+   class DotMesh : public TriangleMesh
+   {
+   public:
+
+      DotMesh(int maxDots);
+
+      virtual ~DotMesh();
+
+      // Return the most dots this mesh can draw
+      int maxDots() const;
+
+      // Centre dot i on pos with the given width; a size of 0 hides it
+      void setDot(int i, const glm::vec3& pos, float size);
+
+      // Hide every dot from i onwards
+      void hideFrom(int i);
+
+   protected:
+      void init();
+
+   protected:
+      int _maxDots;
+   };
+}
+
+#endif
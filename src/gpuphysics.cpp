@@ -0,0 +1,242 @@
+/**
+ * @file gpuphysics.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the compute shader ball physics
+ */
+
+#include "gpuphysics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/constants.hpp>
+
+using namespace std;
+using namespace glm;
+
+poolsim::Table GpuPhysics::crowd(const poolsim::TableConfig& base, int numBalls, uint64_t seed)
+{
+  poolsim::TableConfig config = base;
+  config.numBalls = std::max(numBalls, 1);
+  config.geometry = nullptr;
+  config.seed = (uint32_t) seed;
+  vec2 cushions((config.tableLength - 75) / 2.0f, (config.tableWidth - 75) / 2.0f);
+  float spacing = sqrt(4 * cushions.x * cushions.y / config.numBalls);
+  int cols = std::max((int) (2 * cushions.x / spacing), 1);
+  int rows = (config.numBalls + cols - 1) / cols;
+  vec2 cell(2 * cushions.x / cols, 2 * cushions.y / rows);
+  float diameter = 0.6f * std::min(cell.x, cell.y);
+  config.ballDefaultSize = std::min(config.ballDefaultSize, diameter / (2 * config.sphereRadius));
+  poolsim::Table table(config);
+  table.setChaosEnabled(false);
+
+  poolsim::Pcg32 rng(seed, 1);
+  float maxSpeed = config.sphereRadius * config.ballDefaultSize / config.fixedDt;
+  poolsim::BallArrays& balls = table.balls();
+  for (int i = 0; i < config.numBalls; i++)
+  {
+    vec2 pos = -cushions + cell * vec2(i % cols + 0.5f, i / cols + 0.5f);
+    float angle = rng() * (two_pi<float>() / poolsim::Pcg32::max());
+    float speed = rng() * (maxSpeed / poolsim::Pcg32::max());
+    balls.setPos(i, vec3(pos, 0));
+    balls.setVel(i, vec3(speed * cos(angle), speed * sin(angle), 0));
+  }
+  return table;
+}
+
+#ifndef __APPLE__
+
+// threads in a group of the per-ball shaders
+static const int groupSize = 256;
+
+GpuPhysics::~GpuPhysics()
+{
+  if (_buffers[0]) glDeleteBuffers(NUM_BUFFERS, _buffers);
+}
+
+bool GpuPhysics::supported()
+{
+  GLint major = 0;
+  GLint minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  return major > 4 || (major == 4 && minor >= 3);
+}
+
+bool GpuPhysics::init(const poolsim::Table& table, const string& shaderDir)
+{
+  if (!supported()) return false;
+  agl::Shader* shaders[] = {&_grid, &_scan, &_scatter, &_collide, &_step};
+  const char* names[] = {"physics-grid.cs", "physics-scan.cs", "physics-scatter.cs", "physics-collide.cs",
+    "physics-step.cs"};
+  for (int s = 0; s < 5; s++)
+  {
+    if (shaders[s]->isLinked()) continue;
+    shaders[s]->compileShader(shaderDir + names[s], agl::GLSLShader::COMPUTE);
+    shaders[s]->link();
+  }
+
+  const poolsim::TableConfig& config = table.config();
+  _numBalls = table.numBalls();
+  _groups = (_numBalls + groupSize - 1) / groupSize;
+
+  // cells at least a ball wide, so that touching balls are in neighbouring
+  // cells, and about as many as there are balls
+  vec2 cushions((config.tableLength - 75) / 2.0f, (config.tableWidth - 75) / 2.0f);
+  float diameter = 2 * config.sphereRadius * config.ballDefaultSize;
+  float cellSize = std::max(diameter, sqrt(4 * cushions.x * cushions.y / _numBalls));
+  _gridSize = max(ivec2(ceil(2.0f * cushions / cellSize)), ivec2(1));
+  vec2 gridOrigin = -0.5f * cellSize * vec2(_gridSize);
+
+  if (!_buffers[0]) glGenBuffers(NUM_BUFFERS, _buffers);
+  size_t sizes[NUM_BUFFERS];
+  sizes[BALLS] = _numBalls * sizeof(Ball);
+  sizes[NEXT_BALLS] = _numBalls * sizeof(Ball);
+  sizes[CELL_COUNTS] = numCells() * sizeof(GLuint);
+  sizes[CELL_STARTS] = numCells() * sizeof(GLuint);
+  sizes[SORTED] = _numBalls * sizeof(GLuint);
+  sizes[SLOTS] = _numBalls * 2 * sizeof(GLuint);
+  sizes[STATS] = sizeof(GLuint);
+  for (int b = 0; b < NUM_BUFFERS; b++)
+  {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _buffers[b]);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizes[b], nullptr, GL_DYNAMIC_DRAW);
+  }
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  // nothing but the balls changes between steps
+  GLuint numBalls = (GLuint) _numBalls;
+  _grid.use();
+  _grid.setUniform("NumBalls", numBalls);
+  _grid.setUniform("GridOrigin", gridOrigin);
+  _grid.setUniform("CellSize", cellSize);
+  glUniform2i(glGetUniformLocation(_grid.getHandle(), "GridSize"), _gridSize.x, _gridSize.y);
+  _scan.use();
+  _scan.setUniform("NumCells", (GLuint) numCells());
+  _scatter.use();
+  _scatter.setUniform("NumBalls", numBalls);
+  _collide.use();
+  _collide.setUniform("NumBalls", numBalls);
+  _collide.setUniform("SphereRadius", config.sphereRadius);
+  _collide.setUniform("MinOverlap", std::min(1.0f, 0.04f * diameter));
+  glUniform2i(glGetUniformLocation(_collide.getHandle(), "GridSize"), _gridSize.x, _gridSize.y);
+  _step.use();
+  _step.setUniform("NumBalls", numBalls);
+  _step.setUniform("Dt", config.fixedDt);
+  _step.setUniform("Friction", poolsim::tableFriction);
+  _step.setUniform("SphereRadius", config.sphereRadius);
+  _step.setUniform("Cushions", cushions);
+  int numPockets = std::min((int) table.pockets().size(), 6);
+  for (int p = 0; p < numPockets; p++)
+  {
+    _step.setUniform(("Pockets[" + to_string(p) + "]").c_str(), vec2(table.pockets()[p]));
+  }
+  _step.setUniform("NumPockets", numPockets);
+  _step.setUniform("SinkRadius", config.viewVolumeSide / 150.0f);
+  _step.setUniform("CaptureRadius", config.viewVolumeSide / 50.0f);
+  glUseProgram(0);
+
+  load(table);
+  return true;
+}
+
+void GpuPhysics::load(const poolsim::Table& table)
+{
+  vector<Ball> balls(_numBalls);
+  for (int i = 0; i < _numBalls; i++)
+  {
+    uint32_t flags = table.balls().isFree(i) ? 0 : sunk;
+    float size = flags ? 0.0f : table.size(i);
+    float w;
+    memcpy(&w, &flags, sizeof(w));
+    balls[i].posSize = vec4(table.pos(i), size);
+    balls[i].velFlags = vec4(table.vel(i), w);
+  }
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, _buffers[BALLS]);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, _numBalls * sizeof(Ball), balls.data());
+  GLuint zero = 0;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, _buffers[STATS]);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuPhysics::bindBuffers() const
+{
+  for (int b = 0; b < NUM_BUFFERS; b++)
+  {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, b, _buffers[b]);
+  }
+}
+
+void GpuPhysics::step(int steps)
+{
+  if (!initialized() || steps <= 0) return;
+  bindBuffers();
+  for (int s = 0; s < steps; s++)
+  {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _buffers[CELL_COUNTS]);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    _grid.use();
+    glDispatchCompute(_groups, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    _scan.use();
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    _scatter.use();
+    glDispatchCompute(_groups, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    // collide writes the next state and step writes it back, so that the
+    // balls end up in the buffer that is drawn
+    _collide.use();
+    glDispatchCompute(_groups, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    _step.use();
+    glDispatchCompute(_groups, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  glUseProgram(0);
+}
+
+void GpuPhysics::bindBalls(GLuint binding) const
+{
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, _buffers[BALLS]);
+}
+
+void GpuPhysics::read(vector<Ball>& balls) const
+{
+  balls.resize(_numBalls);
+  if (!initialized()) return;
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, _buffers[BALLS]);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, _numBalls * sizeof(Ball), balls.data());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+uint32_t GpuPhysics::pocketed() const
+{
+  GLuint count = 0;
+  if (!initialized()) return count;
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, _buffers[STATS]);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(count), &count);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  return count;
+}
+
+#else
+
+// OpenGL 4.1 has no compute shaders, so there is nothing to run
+GpuPhysics::~GpuPhysics() {}
+bool GpuPhysics::supported() { return false; }
+bool GpuPhysics::init(const poolsim::Table&, const string&) { return false; }
+void GpuPhysics::load(const poolsim::Table&) {}
+void GpuPhysics::step(int) {}
+void GpuPhysics::bindBalls(GLuint) const {}
+void GpuPhysics::bindBuffers() const {}
+void GpuPhysics::read(vector<Ball>& balls) const { balls.clear(); }
+uint32_t GpuPhysics::pocketed() const { return 0; }
+
+#endif
@@ -0,0 +1,136 @@
+/**
+ * @file gpuphysics.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Fixed-step ball physics in compute shaders for very large ball counts
+ */
+
+#ifndef GPUPHYSICS_H_
+#define GPUPHYSICS_H_
+
+#include "agl/agl.h"
+#include "agl/shader.h"
+#include "poolsim/table.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Plays the fixed-step rules of a table on the GPU: every step counting
+ * sorts the balls into a grid, separates overlapping balls, then checks the
+ * pockets and cushions, applies friction and moves the balls, each in a
+ * compute shader over all balls at once (see shaders/physics-*.cs). The
+ * balls stay in a shader storage buffer that shaders/gpu-balls.vs draws
+ * from directly, so nothing is read back while playing.
+ *
+ * It knows no chaos, sleep or Glorb: a pocketed ball is flagged as sunk and
+ * drawn with no size. Cushions are the rectangle of a table without
+ * geometry, and pockets the circles around the table's pocket centers.
+ * Collisions are resolved for every ball from the state before the step,
+ * rather than pair by pair, and summed in whatever order the grid holds
+ * them, so runs do not repeat bit for bit.
+ *
+ * Needs compute shaders, which is OpenGL 4.3, so not macOS. Mesa's llvmpipe
+ * runs it without a GPU.
+ */
+class GpuPhysics
+{
+public:
+    /**
+    * A ball as the buffer holds it, in std430 layout.
+    */
+    struct Ball
+    {
+      // position, and the size the ball is drawn and collides at
+      glm::vec4 posSize;
+      // velocity, and the flags in the bits of w
+      glm::vec4 velFlags;
+    };
+    // flag of a pocketed ball
+    static const uint32_t sunk = 1;
+
+    GpuPhysics() {}
+    ~GpuPhysics();
+
+    /**
+    * Makes a table of many balls for the GPU to play: the balls are shrunk
+    * so that they cover about a third of the cloth, laid out on a grid, and
+    * sent off in random directions no faster than half a ball per step.
+    *
+    * @param base The table to take the size, pockets and solver from.
+    * @param numBalls The number of balls.
+    * @param seed Picks the velocities.
+    */
+    static poolsim::Table crowd(const poolsim::TableConfig& base, int numBalls, uint64_t seed);
+
+    /**
+    * Returns true if the current context runs compute shaders.
+    */
+    static bool supported();
+
+    /**
+    * Compiles the shaders, sizes the buffers and grid for the table and
+    * loads its balls. Throws GLSLProgramException if a shader does not
+    * compile, as agl::Shader does.
+    *
+    * @param table The table whose config, pockets and balls to play.
+    * @param shaderDir The directory that holds the physics-*.cs shaders.
+    * @return False if the context has no compute shaders.
+    */
+    bool init(const poolsim::Table& table, const std::string& shaderDir = "../shaders/");
+
+    bool initialized() const { return _numBalls > 0; }
+
+    /**
+    * Uploads the positions, velocities and sizes of the table's balls.
+    * Balls that are not free start out sunk.
+    */
+    void load(const poolsim::Table& table);
+
+    /**
+    * Runs fixed steps, without waiting for them to finish.
+    */
+    void step(int steps = 1);
+
+    int numBalls() const { return _numBalls; }
+    int numCells() const { return _gridSize.x * _gridSize.y; }
+
+    /**
+    * Binds the ball buffer for a shader that draws from it.
+    */
+    void bindBalls(GLuint binding = 0) const;
+
+    /**
+    * Reads the balls and the number pocketed back, waiting for the GPU,
+    * for checks and tests rather than for play.
+    */
+    void read(std::vector<Ball>& balls) const;
+    uint32_t pocketed() const;
+
+private:
+    enum Buffer
+    {
+      BALLS,
+      NEXT_BALLS,
+      CELL_COUNTS,
+      CELL_STARTS,
+      SORTED,
+      SLOTS,
+      STATS,
+      NUM_BUFFERS
+    };
+
+    void bindBuffers() const;
+
+    agl::Shader _grid;
+    agl::Shader _scan;
+    agl::Shader _scatter;
+    agl::Shader _collide;
+    agl::Shader _step;
+    GLuint _buffers[NUM_BUFFERS] = {};
+    int _numBalls = 0;
+    int _groups = 0;
+    glm::ivec2 _gridSize = glm::ivec2(0);
+};
+
+#endif  // GPUPHYSICS_H_
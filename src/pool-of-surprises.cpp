@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <ctime>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 using namespace std;
@@ -27,13 +28,8 @@ void Game::setup()
   loadShaders();
   loadMeshes();
 
-  createPoolBalls();
-  createPockets();
-
-  for (string effect : _chaosEffects)
-  {
-    _chaosStatus[effect] = false;
-  }
+  createTable();
+  createGpuBalls();
 
   vec4 x = vec4(1, 0, 0, 0);
   vec4 y = vec4(0, cos(-M_PI_2), -sin(-M_PI_2), 0);
@@ -61,10 +57,13 @@ void Game::setup()
 
 void Game::loadTextures()
 {
-  for (int i = 0; i < std::min(_numBalls, 16); i++)
+  // the balls are drawn in one call, each picking its layer of one array
+  vector<string> ballImages;
+  for (int i = 0; i < _numBallLayers; i++)
   {
-    renderer.loadTexture("Ball" + to_string(i + 1), "../textures/pool-balls/Ball" + to_string(i + 1) + ".jpg", 0);
+    ballImages.push_back("../textures/pool-balls/Ball" + to_string(i + 1) + ".jpg");
   }
+  renderer.loadTextureArray("pool-balls", ballImages, 0);
   renderer.loadTexture("trajectoryDot", "../textures/pool-balls/ParticleBokeh.png", 0);
   renderer.loadTexture("pool-table", "../textures/pool-table/PoolTable_poolTable_BaseColor.png", 0);
   renderer.loadTexture("cue-stick", "../textures/cue-stick/Cue_diff.png", 0);
@@ -90,6 +89,7 @@ void Game::loadShaders()
   renderer.loadShader("fluid", "../shaders/fluid.vs", "../shaders/fluid.fs");
   renderer.loadShader("billboard", "../shaders/billboard.vs", "../shaders/billboard.fs");
   renderer.loadShader("vignette-dissolve", "../shaders/vignette-dissolve.vs", "../shaders/vignette-dissolve.fs");
+  renderer.loadShader("pool-balls", "../shaders/pool-balls.vs", "../shaders/pool-balls.fs");
 }
 
 void Game::loadMeshes()
@@ -105,6 +105,10 @@ void Game::loadMeshes()
   _eyeMesh = PLYMesh("../models/eye.ply");
   _eyeScaleVector = scaleVector(_eyeMesh, "eye");
   _eyeCenterVector = centerVector(_eyeMesh, "eye");
+
+  // per-ball transform, color and layer, refilled every frame
+  glGenBuffers(1, &_ballInstanceBuffer);
+  _poolBallMesh.setInstanceBuffer(_ballInstanceBuffer, 4, sizeof(BallInstance) / sizeof(vec4));
 }
 
 vec3 Game::scaleVector(PLYMesh mesh, string meshName)
@@ -220,7 +224,9 @@ void Game::startGame() {
     x = width() / 2 - renderer.textWidth(message) * 0.5f;
     y = height() * 0.9 + renderer.textHeight() * 0.25f;
     renderer.text(message, x, y);
-    _glorbPos.y += 0.5 * sin(10 * _time);
+    vec3 glorbPos = _table.glorbPos();
+    glorbPos.y += 0.5 * sin(10 * _time);
+    _table.setGlorbPos(glorbPos);
   } else {
     _showLogo = true;
     _elevation -= (width() / 500) * (M_PI / 180);
@@ -240,190 +246,172 @@ void Game::startGame() {
   if (_elevation < M_PI_4 * 0.75) _startGame = false;
 }
 
-void Game::createPoolBalls()
+void Game::createTable()
 {
-  float k = (float) 3 / 1;
-  float a = (_tableWidth - 100) / 2;
-  for (int i = 0; i < _numBalls; i++)
-  {
-    Ball ball;
-    ball.id = i + 1;
-    float theta = ((float) i / _numBalls) * M_PI;
-    float r = a * cos(k * theta);
-    ball.pos.x = r * cos(theta);
-    ball.pos.y = r * sin(theta);
-    ball.vel = vec3(0);
-    ball.rot = vec3(0);
-    ball.color = vec4(1.0);
-    ball.size = _ballDefaultSize;
-    _balls.push_back(ball);
-  }
+  poolsim::TableConfig config;
+  config.viewVolumeSide = _viewVolumeSide;
+  config.tableLength = _tableLength;
+  config.tableWidth = _tableWidth;
+  config.sphereRadius = _sphereRadius;
+  config.ballDefaultSize = _ballDefaultSize;
+  config.glorbScale = _eyeScaleVector.x;
+  // a new run of chaos every game; a recording keeps the seed it was played with
+  config.seed = (uint32_t) time(nullptr);
+  // fast launches would tunnel through balls and cushions with fixed steps
+  config.solver = poolsim::SOLVER_EVENT;
+  // play on the cushions and pockets of the mesh that is drawn, falling back
+  // to the rectangle if it cannot be traced
+  config.geometry = poolsim::loadTableGeometry("../models/pool-table.ply", _viewVolumeSide);
+  if (!config.geometry) std::cout << "WARNING: Cannot trace ../models/pool-table.ply, using a rectangular table\n";
+  _table = poolsim::Table(config);
+  _ballColors.assign(_table.numBalls(), vec4(1.0));
+  if (!_recordPath.empty()) _recorder.start(_table);
 }
 
-void Game::createTrajectoryDots()
+void Game::createGpuBalls()
 {
-  for (int i = 0; i < 5; i++)
+  if (_numGpuBalls <= 0) return;
+  if (!GpuPhysics::supported())
   {
-    vec3 offset = (1.0f / (i + 1)) * _launchVel;
-    vec3 trajectoryDot = _balls[_activeBall].pos + offset;
-    _trajectoryDots.push_back(trajectoryDot);
+    std::cout << "WARNING: No compute shaders in this OpenGL context, playing without GPU balls\n";
+    return;
   }
+  renderer.loadShader("gpu-balls", "../shaders/gpu-balls.vs", "../shaders/gpu-balls.fs");
+  _gpuPhysics.init(GpuPhysics::crowd(_table.config(), _numGpuBalls, _table.config().seed));
 }
 
-void Game::updateTrajectoryDots()
+bool Game::mirror(const std::string& host, uint16_t port)
 {
-  for (int i = 0; i < 5; i++)
-  {
-    vec3 offset = (1.0f / (i + 1)) * _launchVel;
-    vec3 trajectoryDot = _balls[_activeBall].pos + offset;
-    _trajectoryDots[i] = trajectoryDot;
-  }
+  std::string error;
+  _mirroring = _mirror.connect(host, port, error);
+  if (!_mirroring) std::cout << "WARNING: Cannot mirror " << host << ": " << error << "\n";
+  return _mirroring;
 }
 
-void Game::createPockets()
+vec3 Game::ballPos(int i) const
 {
-  for (int i = 0; i < 6; i++)
-  {
-    vec3 pocket;
-    if ((i % 3) == 0) {
-      pocket.x =  -(_tableLength / 2) + 50;
-    } else if ((i % 3) == 1) {
-      pocket.x =  0;
-    } else {
-      pocket.x =  (_tableLength / 2) - 50;
-    }
-    pocket.y = (i < 3) ? (_tableWidth / 2) - 50 : -(_tableWidth / 2) + 50;
-    pocket.z = 0;
-    _pockets.push_back(pocket);
-  }
+  return _mirroring && i < _mirror.numBalls() ? _mirror.pos(i) : _table.renderPos(i);
 }
 
-void Game::updatePoolBalls()
+vec3 Game::ballRot(int i) const
 {
-  for (int i = 0; i < _numBalls; i++)
-  {
-    Ball ball = _balls[i];
-    if (ball.size == 2 * _ballDefaultSize) {
-      // floating up to glorb
-      float glorbRadius = _eyeScaleVector.x * _eyeDiameterModifier * 0.5;
-      if (length(_glorbPos - ball.pos) <= glorbRadius) {
-        ball.pos = vec3(0, 1000, 200);
-        ball.vel = vec3(0);
-        ball.size = 0;
-        _eyeDiameterModifier += 0.02;
-        _eyeColor = vec4(0, 1, 0, 0.5);
-        _numBallsSunk += 1;
-        if (_numBallsSunk == 16) _endGame = true;
-      }
-    } else {
-      bool sinking = pocketDetection(ball);
-      if (!sinking) {
-        bool collided = false;
-        for (int j = i + 1; j < _numBalls && !collided; j++)
-        {
-          collided = collisionDetection(i, j);
-        }
-        ball = _balls[i];
-        boundaryDetection(ball);
-        if (_chaosStatus["Tilt-a-Table"]) ball.vel += _tiltDir;
-        ball.vel *= _chaosStatus["Friction Affliction"] ? 0.75f : 0.95f;
-        // if not hovering, not enlarged or shrunk, and not floating up to glorb, null z-component
-        if (ball.pos.z < 40 && ball.size == _ballDefaultSize) {
-          ball.pos.z = 0;
-          ball.vel.z = 0;
-        }
-      }
-    }
-    vec3 dist = ball.vel * dt();
-    ball.pos += dist;
-    ball.rot += vec3(-dist.y, dist.x, 0) * float((M_PI * 2) / (M_PI * ball.size * _sphereRadius * 2));
-    _balls[i] = ball;
-  }
+  return _mirroring && i < _mirror.numBalls() ? _mirror.rot(i) : _table.renderRot(i);
 }
 
-bool Game::collisionDetection(int i, int j)
+float Game::ballSize(int i) const
 {
-  Ball ball1 = _balls[i];
-  Ball ball2 = _balls[j];
-  // if not floating up to glorb
-  if (ball2.size != 2 * _ballDefaultSize) {
-    float overlap = _sphereRadius * (ball1.size + ball2.size) - length(ball1.pos - ball2.pos);
-    if (overlap > 1)
-    {
-      vec3 ball1Pos = ball1.pos;
-      vec3 ball2Pos = ball2.pos;
-      ball1Pos.z -= _sphereRadius * (ball1.size - _ballDefaultSize);
-      ball2Pos.z -= _sphereRadius * (ball2.size - _ballDefaultSize);
-      vec3 normal = normalize(ball1Pos - ball2Pos);
-      ball1.pos += normal * overlap / 2.0f;
-      ball2.pos -= normal * overlap / 2.0f;
-      vec3 ball1NormalVel = dot(ball1.vel, normal) * normal;
-      vec3 ball2NormalVel = dot(ball2.vel, normal) * normal;
-      ball1.vel += ball2NormalVel - ball1NormalVel;
-      ball2.vel += ball1NormalVel - ball2NormalVel;
-      _balls[i] = ball1;
-      _balls[j] = ball2;
-      _result = _system->playSound(_collisionSound, 0, false, 0);
-	    ERRCHECK(_result);	
-      return true;
-    } else {
-      return false;
-    }
-  } else {
-    return false;
-  }
+  return _mirroring && i < _mirror.numBalls() ? _mirror.size(i) : _table.size(i);
+}
+
+bool Game::ballSinking(int i) const
+{
+  if (_mirroring && i < _mirror.numBalls()) return (_mirror.flags(i) & poolsim::BALL_SINKING) != 0;
+  return _table.isSinking(i);
+}
+
+void Game::launch(int i, const vec3& vel)
+{
+  if (_mirroring) _mirror.launch(i, vel);
+  else _table.launch(i, vel);
+}
+
+void Game::saveRecording()
+{
+  if (_recordPath.empty()) return;
+  _recorder.stop();
+  if (!_recorder.save(_recordPath)) std::cout << "WARNING: Cannot write recording " << _recordPath << "\n";
+}
+
+void Game::createTrajectoryDots()
+{
+  _trajectoryDots.hideFrom(0);
+  _preview.request(_table, _activeBall, _launchVel);
+}
+
+void Game::updateTrajectoryDots()
+{
+  _preview.request(_table, _activeBall, _launchVel);
 }
 
-void Game::boundaryDetection(Ball& ball)
+void Game::placeTrajectoryDots()
 {
-  float ballRadius = _sphereRadius * ball.size;
-  float xThresh = (_tableLength - 75) / 2.0f;
-  float ballLeft = ball.pos.x - ballRadius;
-  float ballRight = ball.pos.x + ballRadius;
-  if (ballLeft < -xThresh || ballRight > xThresh)
+  const vector<vec3>& points = _previewPath.points;
+  // the last dot marks where the first ball is struck
+  int maxDots = _trajectoryDots.maxDots() - 1;
+  int numDots = 0;
+  float untilNext = _trajectoryDotSpacing;
+  for (int i = 1; i < points.size() && numDots < maxDots; i++)
   {
-    if (ballLeft < -xThresh) ball.pos.x += -xThresh - ballLeft;
-    else if (ballRight > xThresh) ball.pos.x -= ballRight - xThresh;
-    ball.vel.x = _chaosStatus["Sticky Situation"] ? 0 : -ball.vel.x;
-    ball.vel.y = _chaosStatus["Sticky Situation"] ? 0 : ball.vel.y;
-    _result = _system->playSound(_boundarySound, 0, false, 0);
-	  ERRCHECK(_result);	
+    vec3 segment = points[i] - points[i - 1];
+    float segmentLength = length(segment);
+    float along = 0.0f;
+    while (segmentLength - along >= untilNext && numDots < maxDots)
+    {
+      along += untilNext;
+      untilNext = _trajectoryDotSpacing;
+      // dots shrink away from the ball as the old five did
+      float size = mix(9.0f, 4.0f, (float) numDots / maxDots);
+      _trajectoryDots.setDot(numDots++, points[i - 1] + segment * (along / segmentLength), size);
+    }
+    untilNext -= segmentLength - along;
   }
-  float yThresh = (_tableWidth - 75) / 2.0f;
-  float ballBottom = ball.pos.y - ballRadius;
-  float ballTop = ball.pos.y + ballRadius;
-  if (ball.pos.y < -yThresh || ball.pos.y > yThresh)
+  _trajectoryDots.hideFrom(numDots);
+  if (_previewPath.firstHit != -1)
   {
-    if (ballBottom < -yThresh) ball.pos.y += -yThresh - ballBottom;
-    else if (ballTop > yThresh) ball.pos.y -= ballTop - yThresh;
-    ball.vel.y = _chaosStatus["Sticky Situation"] ? 0 : -ball.vel.y;
-    ball.vel.x = _chaosStatus["Sticky Situation"] ? 0 : ball.vel.x;
-    _result = _system->playSound(_boundarySound, 0, false, 0);
-	  ERRCHECK(_result);
+    _trajectoryDots.setDot(maxDots, _previewPath.firstHitPos, _sphereRadius * _ballDefaultSize);
   }
 }
 
-bool Game::pocketDetection(Ball& ball)
+void Game::updatePoolBalls()
 {
-  for (int i = 0; i < 6; i++)
+  if (_mirroring)
   {
-    if (length(_pockets[i] - ball.pos) < _viewVolumeSide / 150)
-    {
-      _result = _system->playSound(_pocketSound, 0, false, 0);
-	    ERRCHECK(_result);		
-      _congratsMessage = congratsMessages[ball.id - 1];
-      _congratsStartTime = elapsedTime() + 1;
-      ball.vel = 0.5f * (_glorbPos - ball.pos);
-      ball.size *= 2;
-      return true;
-    }
-    else if (length(_pockets[i] - ball.pos) < _viewVolumeSide / 50)
-    {
-      ball.vel = 10.0f * (_pockets[i] - ball.pos);
-      return true;
-    }
+    // the server plays the table, with its own chaos and sounds
+    _mirror.poll();
+    _mirror.interpolate();
+    return;
+  }
+  _table.setChaosEnabled(_enableChaos && !_startGame && !_endGame);
+  if (_recorder.recording() && (_azimuth != _recordedAzimuth || _elevation != _recordedElevation))
+  {
+    _recorder.camera(_azimuth, _elevation);
+    _recordedAzimuth = _azimuth;
+    _recordedElevation = _elevation;
+  }
+  int steps = _table.advance(dt());
+  _gpuPhysics.step(steps);
+  // the compute shaders change the program in use behind the renderer
+  if (steps > 0 && _gpuPhysics.initialized()) renderer.invalidateState();
+  // a table at rest makes no sound until a shot or a new status effect, but
+  // the steps of this frame may have pocketed a ball before it came to rest
+  if (_table.atRest() && _table.events().none()) return;
+
+  const poolsim::TableEvents& events = _table.events();
+  if (events.collisions > 0) {
+    _result = _system->playSound(_collisionSound, 0, false, 0);
+    ERRCHECK(_result);
+  }
+  if (events.boundaryHits > 0) {
+    _result = _system->playSound(_boundarySound, 0, false, 0);
+    ERRCHECK(_result);
+  }
+  if (events.pocketed > 0) {
+    _result = _system->playSound(_pocketSound, 0, false, 0);
+    ERRCHECK(_result);
+    _congratsMessage = congratsMessages[(events.lastPocketedId - 1) % congratsMessages.size()];
+    _congratsStartTime = elapsedTime() + 1;
+  }
+  if (events.devoured > 0) {
+    _eyeColor = vec4(0, 1, 0, 0.5);
+    if (_table.allSunk()) _endGame = true;
+  }
+  if (events.chaosChanged) {
+    _chaosAnimStart = elapsedTime() + 1;
+    _chaosAnimation = true;
+    _result = _system->playSound(_explosionSound, 0, false, 0);
+    ERRCHECK(_result);
   }
-  return false;
+  _table.clearEvents();
 }
 
 void Game::endGame() {
@@ -440,7 +428,7 @@ void Game::endGame() {
       y = height() * 0.9 + renderer.textHeight() * 0.25f;
       renderer.text(message, x, y);
     } else if (timer < 11) {
-      _eyeDiameterModifier += (width() / 500) * 0.006;
+      _table.setEyeDiameterModifier(_table.eyeDiameterModifier() + (width() / 500) * 0.006);
       if (_mainMusic != NULL) {
         _backgroundChannel->setPaused(true);
         _backgroundChannel->stop();
@@ -474,11 +462,11 @@ int Game::launchDetection(int clickX, int clickY)
   float closestDist = 99999999;
   int closestDistIdx = -1;
   vec2 clickPos = vec2(clickX, clickY);
-  for (int i = 0; i < _numBalls; i++)
+  for (int i = 0; i < _table.numBalls(); i++)
   {
     // if not floating up to glorb
-    if (_balls[i].size != 2 * _ballDefaultSize) {
-      vec2 ballPos = worldToScreen(_balls[i].pos, false);
+    if (!ballSinking(i)) {
+      vec2 ballPos = worldToScreen(this->ballPos(i), false);
       float dist = length(ballPos - clickPos);
       if (dist < _ballDefaultSize)
       {
@@ -529,7 +517,7 @@ void Game::drawCueStick()
     renderer.push();
     renderer.translate(-_launchVel * 0.2f);
     renderer.translate(-_launchVel * (0.5f * _stickLength / length(_launchVel)));
-    renderer.translate(_balls[_activeBall].pos);
+    renderer.translate(ballPos(_activeBall));
     renderer.rotate(vec3(0, 0, atan2(_launchVel.y, _launchVel.x) - M_PI_2));
     renderer.scale(_stickScaleVector);
     renderer.rotate(vec3(0, M_PI_2, M_PI_2));
@@ -541,40 +529,52 @@ void Game::drawCueStick()
 
 void Game::drawPoolBalls()
 {
-  renderer.setUniform("PoolBall", true);
-  for (int i = 0; i < _numBalls; i++)
-  {
-    renderer.setUniform("MaterialColor", _balls[i].color);
-    renderer.texture("Image", "Ball" + to_string(i + 1));
-    renderer.push();
-    renderer.translate(_balls[i].pos);
-    renderer.rotate(_balls[i].rot);
-    renderer.rotate(vec3(0, 0, -M_PI_2));
-    renderer.scale(vec3(_balls[i].size));
-    renderer.sphere();
-    renderer.pop();
-  }
-  renderer.setUniform("PoolBall", false);
+  int n = _table.numBalls();
+  if (n == 0) return;
+  _ballInstances.resize(n);
+  mat4 tableToWorld = renderer.modelMatrix();
+  mat4 textureTurn = glm::rotate(mat4(1.0f), (float) -M_PI_2, vec3(0, 0, 1));
+  for (int i = 0; i < n; i++)
+  {
+    BallInstance& b = _ballInstances[i];
+    b.model = glm::translate(tableToWorld, ballPos(i)) * mat4(quat(ballRot(i))) * textureTurn;
+    b.model = glm::scale(b.model, vec3(ballSize(i)));
+    b.color = _ballColors[i];
+    b.layer = vec4((float) (i % _numBallLayers), 0, 0, 0);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, _ballInstanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, n * sizeof(BallInstance), _ballInstances.data(), GL_STREAM_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  renderer.beginShader("pool-balls");
+  renderer.cubemap("Cubemap", "shanghai-bund");
+  renderer.texture("Images", "pool-balls");
+  renderer.mesh(_poolBallMesh, n);
+  renderer.endShader();
+}
+
+void Game::drawGpuBalls()
+{
+  if (!_gpuPhysics.initialized()) return;
+  renderer.beginShader("gpu-balls");
+  renderer.setUniform("ModelMatrix", renderer.modelMatrix());
+  renderer.cubemap("Cubemap", "shanghai-bund");
+  _gpuPhysics.bindBalls(0);
+  renderer.mesh(_gpuBallMesh, _gpuPhysics.numBalls());
+  renderer.endShader();
 }
 
 void Game::drawTrajectoryDots()
 {
   if (_launching)
   {
+    if (_preview.poll(_previewPath)) placeTrajectoryDots();
     renderer.setDepthTest(false);
     renderer.blendMode(agl::ADD);
     renderer.beginShader("texture");
     renderer.setUniform("Color", vec4(1));
     renderer.texture("Image", "trajectoryDot");
-    for (int i = 0; i < _trajectoryDots.size(); i++)
-    {
-      renderer.push();
-      renderer.translate(_trajectoryDots[i]);
-      renderer.scale(vec3(5 + (4 - i)));
-      renderer.translate(vec3(-0.5, -0.5, 0));
-      renderer.quad();
-      renderer.pop();
-    }
+    renderer.mesh(_trajectoryDots);
     renderer.endShader();
     renderer.setDepthTest(true);
     renderer.blendMode(agl::DEFAULT);
@@ -587,21 +587,22 @@ void Game::drawEye()
   renderer.setUniform("EyeOfSauron", true);
   renderer.texture("Image", "eye");
   renderer.push();
-  renderer.translate(_glorbPos);
+  vec3 glorbPos = _table.glorbPos();
+  renderer.translate(glorbPos);
   vec3 lookPos;
   // face camera or active ball
-  if (_startGame || _activeBall == -1 || (!_launching && length(_balls[_activeBall].vel) < 5) || _orbiting || _endGame) {
+  if (_startGame || _activeBall == -1 || (!_launching && length(_table.vel(_activeBall)) < 5) || _orbiting || _endGame) {
     lookPos = vec3(_camPos.x, -_camPos.z, _camPos.y);
   } else {
-    lookPos = _balls[_activeBall].pos;
+    lookPos = ballPos(_activeBall);
   }
-  vec3 z = normalize(lookPos - _glorbPos);
+  vec3 z = normalize(lookPos - glorbPos);
   vec3 x = normalize(cross(_up, z));
   vec3 y = normalize(cross(z, x));
   mat3 R = mat3(x, y, z);
   renderer.rotate(R);
   renderer.rotate(vec3(0, -M_PI_2, 0));
-  renderer.scale(vec3(_eyeDiameterModifier));
+  renderer.scale(vec3(_table.eyeDiameterModifier()));
   renderer.scale(_eyeScaleVector);
   renderer.translate(_eyeCenterVector);
   renderer.mesh(_eyeMesh);
@@ -611,120 +612,12 @@ void Game::drawEye()
 
 void Game::chaos()
 {
-  if (_chaosStatus["Hover Havoc"])
-  {
-    for (int i = 0; i < _numBalls; i++)
-    {
-      // if floating but not going up to glorb
-      if (_balls[i].pos.z >= 40 && _balls[i].size != 2 * _ballDefaultSize)
-      {
-        _balls[i].pos.z = 50.0f + 10 * sin(elapsedTime());
-      }
-    }
-  }
-
-  int newEffectThresh = 150;
-  int frame = int(_time * 30);
-  if (frame % newEffectThresh == 0 && !_startGame && !_endGame)
-  {
-    _chaosAnimStart = elapsedTime() + 1;
-    _chaosAnimation = true;
-    _result = _system->playSound(_explosionSound, 0, false, 0);
-	  ERRCHECK(_result);
-    string effect = _chaosEffects[rand() % _chaosEffects.size()];
-    while (effect == _chaosEffect) {
-      effect = _chaosEffects[rand() % _chaosEffects.size()];
-    } 
-    for (auto it = _chaosStatus.begin(); it != _chaosStatus.end(); it++)
-    {
-      if (it->first == effect)
-      {
-        if (it->second == false)
-        {
-          _chaosStatus[it->first] = true;
-          _chaosEffect = effect;
-          if (effect == "Hover Havoc")
-          {
-            gravityChaos();
-          }
-          else if (effect == "Biggie Smalls")
-          {
-            sizeChaos();
-          } else if (effect == "Tilt-a-Table")
-          {
-            _tiltDir = float(pow(-1, rand())) * vec3(1, 0, 0);
-          }
-        }
-      }
-      else
-      {
-        if (it->second == true)
-        {
-          _chaosStatus[it->first] = false;
-          if (it->first == "Hover Havoc")
-          {
-            resetGravity();
-          }
-          else if (it->first == "Biggie Smalls")
-          {
-            resetSize();
-          }
-        }
-      }
-    }
-  }
   if (elapsedTime() - _chaosAnimStart > 2)
   {
     _chaosAnimation = false;
   }
 }
 
-void Game::gravityChaos()
-{
-  for (int i = 0; i < _numBalls; i++)
-  {
-    // if not floating up to glorb
-    if (rand() % 4 == 0 && _balls[i].size != 2 * _ballDefaultSize)
-    {
-      _balls[i].pos.z = 50.0f + 10 * sin(elapsedTime());
-    }
-  }
-}
-
-void Game::resetGravity()
-{
-  for (int i = 0; i < _numBalls; i++)
-  {
-    _balls[i].pos.z = 0;
-  }
-}
-
-void Game::sizeChaos()
-{
-  for (int i = 0; i < _numBalls; i++)
-  {
-    if (rand() % 4 == 0)
-    {
-      // if not floating up to glorb
-      if (_balls[i].size != 2 * _ballDefaultSize) {
-        float prevSize = _balls[i].size;
-        (rand() % 2)? _balls[i].size *= 3 : _balls[i].size /= 2; 
-        _balls[i].pos.z += _sphereRadius * (_balls[i].size - prevSize);
-      }
-    }
-  }
-}
-
-void Game::resetSize()
-{
-  for (int i = 0; i < _numBalls; i++)
-  {
-    float prevSize = _balls[i].size;
-    _balls[i].size = _ballDefaultSize;
-    _balls[i].pos.z += _sphereRadius * (_balls[i].size - prevSize);
-  }
-}
-
 void Game::drawChaosTransition() {
   renderer.setDepthTest(false);
   renderer.blendMode(agl::ADD);
@@ -780,13 +673,11 @@ void Game::drawFluid() {
   renderer.setDepthTest(false);
   renderer.blendMode(agl::ADD);
   renderer.beginShader("fluid");
-  renderer.setUniform("Resolution", vec2(width(), height()));
-  renderer.setUniform("Time", elapsedTime());
   vec3 ballPos;
   if (_activeBall == -1) {
     ballPos = vec3(worldToScreen(vec3(0), true), 1);
   } else {
-    ballPos = vec3(worldToScreen(_balls[_activeBall].pos, true), 1);
+    ballPos = vec3(worldToScreen(this->ballPos(_activeBall), true), 1);
   }
   renderer.setUniform("BallPos", ballPos);
   renderer.push();
@@ -835,8 +726,8 @@ void Game::mouseMotion(int x, int y, int dx, int dy)
       if (_launching)
       {
         _activeBall = closestDistIdx;
-        _balls[_activeBall].vel = vec3(0);
-        _balls[_activeBall].color /= 2.0f;
+        _table.setVel(_activeBall, vec3(0));
+        _ballColors[_activeBall] /= 2.0f;
         vec4 launchVel = vec4(-dx, dy, 0, 0);
         launchVel = glm::rotate(mat4(1.0), _azimuth, vec3(0, 0, 1)) * launchVel;
         _launchVel = vec3(launchVel);
@@ -893,20 +784,14 @@ void Game::mouseUp(int button, int mods)
     _leftClick = false;
     if (_launching)
     {
-      if (_chaosStatus["Get Gaslit"])
-      {
-        _balls[_activeBall].vel = vec3(_launchVel.x, -_launchVel.y, _launchVel.z);
-      }
-      else
-      {
-        _balls[_activeBall].vel = _launchVel;
-      }
+      launch(_activeBall, _launchVel);
       _result = _system->playSound(_launchSound, 0, false, 0);
 		  ERRCHECK(_result);	
-      _balls[_activeBall].color *= 2.0f;
+      _ballColors[_activeBall] *= 2.0f;
       _launching = false;
       _launchVel = vec3(0);
-      _trajectoryDots.clear();
+      _preview.cancel();
+      _trajectoryDots.hideFrom(0);
     }
     else if (_orbiting)
     {
@@ -939,10 +824,8 @@ void Game::keyUp(int key, int mods)
 {
   if (key == GLFW_KEY_R)
   {
-    for (int i = 0; i < _numBalls; i++)
-    {
-      _balls[i].vel = vec3(0);
-    }
+    if (_mirroring) _mirror.stopAll();
+    else _table.stopAll();
   } else if (key == GLFW_KEY_E) {
     _congratsStartTime = elapsedTime();
     _endGame = true;
@@ -957,6 +840,16 @@ void Game::keyUp(int key, int mods)
     ERRCHECK(_result);
     _result = _backgroundChannel->setPaused(false); 
 	  ERRCHECK(_result);
+  } else if (key == GLFW_KEY_C && !_launching && !_mirroring) {
+    // the computer takes a shot, searching for as long as a few frames last
+    poolsim::OpponentShot shot = _opponent.chooseShot(_table);
+    if (shot.ball != -1)
+    {
+      _activeBall = shot.ball;
+      _table.launch(shot.ball, shot.vel);
+      _result = _system->playSound(_launchSound, 0, false, 0);
+      ERRCHECK(_result);
+    }
   } else if (key == GLFW_KEY_X) {
      screenshot("../demo/screenshot-" + std::to_string(rand() % 10000) + ".png");
   } 
@@ -988,26 +881,34 @@ void Game::draw()
 
   renderer.beginShader("cubemap");
 
-  renderer.setUniform("ModelMatrix", renderer.modelMatrix());
-  renderer.setUniform("ViewMatrix", renderer.viewMatrix());
-  renderer.setUniform("CamPos", _camPos);
-
+  // the effects drawn without depth testing show over what was drawn before
+  // them and under what comes after, so they split the scene into passes
+  renderer.beginQueue();
+  renderer.queuePass(0);
   drawSkybox("shanghai-bund");
   renderer.push();
   renderer.rotate(vec3(-M_PI_2, 0, 0));
+  renderer.queuePass(1);
   if (_chaosAnimation) drawChaosTransition();
+  renderer.queuePass(2);
   drawPoolTable();
+  renderer.queuePass(3);
   drawFluid();
+  renderer.queuePass(4);
   drawCueStick();
   updatePoolBalls();
   drawPoolBalls();
+  drawGpuBalls();
+  renderer.queuePass(5, agl::SORT_NONE);
   drawTrajectoryDots();
   if (_showLogo) drawLogo();
+  renderer.queuePass(6);
   drawEye();
+  renderer.submitQueue();
   if (_enableChaos) chaos();
   if (_endGame) endGame();
   if (_startGame) startGame();
-  else _glorbPos.y = 0;
+  else _table.setGlorbPos(vec3(_table.glorbPos().x, 0, _table.glorbPos().z));
   if (_endGame) endGame();
   if (elapsedTime() - _congratsStartTime < 5)
   {
@@ -1015,24 +916,29 @@ void Game::draw()
     float x = width() / 2 - renderer.textWidth(_congratsMessage) * 0.5f;
     float y = height() * 0.94 + renderer.textHeight() * 0.25f;
     renderer.text(_congratsMessage, x, y);
-    _glorbPos.z += 0.5 * sin(10 * _time);
+    vec3 glorbPos = _table.glorbPos();
+    glorbPos.z += 0.5 * sin(10 * _time);
+    _table.setGlorbPos(glorbPos);
   } else {
-    _glorbPos.z = 200;
+    vec3 glorbPos = _table.glorbPos();
+    glorbPos.z = 200;
+    _table.setGlorbPos(glorbPos);
   }
   if (!_startGame && !_endGame) {
-    if (_chaosEffect == "Plain Jane") {
+    int effect = _mirroring ? _mirror.chaosEffect() : _table.chaosEffectId();
+    if (effect == poolsim::CHAOS_PLAIN_JANE) {
       renderer.fontColor(vec4(0, 1, 0, 1));
     } else {
       renderer.fontColor(vec4(1, 0, 0, 1));
     }
     renderer.fontSize(width() / 15);
-    string message = "Status Effect: " + _chaosEffect;
+    string message = "Status Effect: " + poolsim::Table::chaosEffects()[effect];
     float x = width() / 2 - renderer.textWidth(message) * 0.5f;
     float y = height() * 0.85 + renderer.textHeight() * 0.25f;
     renderer.text(message, x, y);
     renderer.fontColor(vec4(0.98, 0.94, 0.82, 1));
 
-    message = "Balls Devoured: " + to_string(_numBallsSunk);
+    message = "Balls Devoured: " + to_string(_mirroring ? _mirror.numBallsSunk() : _table.numBallsSunk());
     renderer.fontSize(width() / 20);
     x = width() * 0.97 - renderer.textWidth(message);
     y = height() / 10 + renderer.textHeight() * 0.25f;
@@ -1041,6 +947,13 @@ void Game::draw()
   renderer.pop();
   
   renderer.endShader();
+
+  if (_printGlStats && elapsedTime() - _glStatsTime >= 1)
+  {
+    const agl::Renderer::StateStats& stats = renderer.stateStats();
+    std::cout << "GL state calls last frame: " << stats.issued << " issued, " << stats.filtered << " filtered\n";
+    _glStatsTime = elapsedTime();
+  }
 	
   _system->update();
 }
@@ -1048,6 +961,26 @@ void Game::draw()
 int main(int argc, char **argv)
 {
   Game game;
+  for (int a = 1; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--record") == 0 && a + 1 < argc) game.recordTo(argv[++a]);
+    else if (strcmp(argv[a], "--gpu-balls") == 0 && a + 1 < argc) game.playGpuBalls(atoi(argv[++a]));
+    else if (strcmp(argv[a], "--gl-stats") == 0) game.printGlStats();
+    else if (strcmp(argv[a], "--mirror") == 0 && a + 1 < argc)
+    {
+      // host, or host:port
+      string host = argv[++a];
+      uint16_t port = poolsim::netDefaultPort;
+      size_t colon = host.find(':');
+      if (colon != string::npos)
+      {
+        port = (uint16_t) atoi(host.c_str() + colon + 1);
+        host = host.substr(0, colon);
+      }
+      game.mirror(host, port);
+    }
+  }
   game.run();
+  game.saveRecording();
   return 0;
 }
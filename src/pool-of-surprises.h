@@ -7,6 +7,15 @@
 
 #include "agl/window.h"
 #include "plymesh.h"
+#include "dotmesh.h"
+#include "gpuphysics.h"
+#include "agl/mesh/sphere.h"
+#include "poolsim/opponent.h"
+#include "poolsim/preview.h"
+#include "poolsim/recording.h"
+#include "poolsim/table.h"
+#include "poolsim/tablegeometry.h"
+#include "poolsim/tableserver.h"
 #include "fmod_errors.h"
 #include "fmod.hpp"
 #include <string>
@@ -17,16 +26,6 @@ using namespace std;
 using namespace glm;
 using namespace agl;
 
-struct Ball
-{
-  int id;
-  vec3 pos;
-  vec3 vel;
-  vec3 rot;
-  vec4 color;
-  float size;
-};
-
 class Game : public Window
 {
 public:
@@ -98,48 +97,74 @@ public:
     void startGame();
 
     /**
-    * Initializes the pool balls, their positions, velocities, etc.
+    * Creates the simulated table, sized to fit the loaded table mesh.
     */
-    void createPoolBalls();
+    void createTable();
 
     /**
-    * Initializes dots that visualize active ball trajectory.
+    * Records the game to a file, from when the table is created until
+    * saveRecording() is called, for poolsim-cli replay.
+    *
+    * @param path The file to write.
     */
-    void createTrajectoryDots();
+    void recordTo(const std::string& path) { _recordPath = path; }
 
     /**
-    * Initializes the "pockets" in the pool table and their positions.
+    * Plays a crowd of extra balls on the GPU alongside the game, if the
+    * context runs compute shaders.
+    *
+    * @param numBalls The number of balls, none for the game alone.
     */
-    void createPockets();
+    void playGpuBalls(int numBalls) { _numGpuBalls = numBalls; }
 
     /**
-    * Updates the positions,velocities, etc. of the pool balls.
+    * Prints how many GL state calls the renderer issued and filtered in a
+    * frame, once a second.
     */
-    void updatePoolBalls();
+    void printGlStats() { _printGlStats = true; }
 
     /**
-    * Detects if two balls have collided.
-    *
-    * @param i The index of the first ball.
-    * @param j The index of the second ball.
-    * @return True if there is a collision, false otherwise.
+    * Sets up the GPU balls asked for, or warns that they cannot run.
     */
-    bool collisionDetection(int i, int j);
+    void createGpuBalls();
 
     /**
-    * Detects if a ball has hit the boundary of the pool table and changes its * velocity accordingly.
+    * Draws the table a poolsim-cli server plays instead of playing one, as
+    * a kiosk would. Shots and stops are sent to the server.
     *
-    * @param ball The ball to check for a collision.
+    * @return False if the server cannot be reached.
     */
-    void boundaryDetection(Ball& ball);
+    bool mirror(const std::string& host, uint16_t port);
 
     /**
-    * Detects if a ball is sufficiently close to a pocket and executes the *appropriate game actions.
-    *
-    * @param ball The ball to check.
-    * @return True if the ball is sunk, false otherwise.
+    * Where a ball is drawn, from the local table or the mirrored one.
+    */
+    vec3 ballPos(int i) const;
+    vec3 ballRot(int i) const;
+    float ballSize(int i) const;
+    bool ballSinking(int i) const;
+
+    /**
+    * Launches a ball on the table being played, locally or on the server.
+    */
+    void launch(int i, const vec3& vel);
+
+    /**
+    * Writes the recording, if one was asked for.
+    */
+    void saveRecording();
+
+    /**
+    * Starts predicting the active ball's trajectory, hiding the dots of the
+    * previous aim until the first prediction is ready.
+    */
+    void createTrajectoryDots();
+
+    /**
+    * Advances the table simulation by the frame time and reacts to what
+    * happened on it (sounds, messages, end of game).
     */
-    bool pocketDetection(Ball& ball);
+    void updatePoolBalls();
 
     /**
     * Runs the end-of-game sequence.
@@ -180,44 +205,38 @@ public:
     void drawPoolBalls();
 
     /**
-    * Draws the trajectory dots for trajectory estimation.
+    * Draws the GPU balls straight from their buffer, in one call.
     */
-    void drawTrajectoryDots();
+    void drawGpuBalls();
 
     /**
-    * Updates the trajectory dots with new velocity.
+    * Draws the trajectory dots for trajectory estimation, picking up a new
+    * prediction first if one is ready.
     */
-    void updateTrajectoryDots();
-
-    /**
-    * Draws the Eye of Sauron, rotating it to face the user of the active ball
-    */
-    void drawEye();
-
-    /**
-    * Randomly changes the physics of the game.
-    */
-    void chaos();
+    void drawTrajectoryDots();
 
     /**
-    * Causes a random subset of balls to hover over the table.
+    * Asks for a new trajectory prediction after the launch velocity changed.
+    * The dots keep showing the previous prediction until it is ready.
     */
-    void gravityChaos();
+    void updateTrajectoryDots();
 
     /**
-    * Resets the positions of the floating balls.
+    * Spaces the dots evenly along the predicted path and marks where the
+    * active ball first strikes another ball.
     */
-    void resetGravity();
+    void placeTrajectoryDots();
 
     /**
-    * Causes a random subset of balls to either grow or shrink.
+    * Draws the Eye of Sauron, rotating it to face the user of the active ball
     */
-    void sizeChaos();
+    void drawEye();
 
     /**
-    * Resets the sizes of the balls.
+    * Lets the table randomly change the physics of the game and times the
+    * transition animation.
     */
-    void resetSize();
+    void chaos();
 
     /**
     * Draws the explosion animation when the game physics change.
@@ -328,14 +347,44 @@ protected:
     float _elevation = M_PI_2 - 0.017;
     float _orbiting = false;
 
-    std::vector<Ball> _balls;
-    int _numBalls = 16;
-    int _numBallsSunk = 0;
+    poolsim::Table _table;
+    poolsim::InputRecorder _recorder;
+    std::string _recordPath;
+    // camera last written to the recording
+    float _recordedAzimuth = -1;
+    float _recordedElevation = -1;
+    std::vector<vec4> _ballColors;
+
+    // what the pool-balls shader reads for each ball, as six vec4s
+    struct BallInstance
+    {
+      mat4 model;
+      vec4 color;
+      // layer of the ball's texture in x, the rest padding
+      vec4 layer;
+    };
+    std::vector<BallInstance> _ballInstances;
+    GLuint _ballInstanceBuffer = 0;
+    agl::Sphere _poolBallMesh{0.5f, 16, 16};
+    int _numBallLayers = 16;
+    poolsim::TableMirror _mirror;
+    bool _mirroring = false;
+    int _numGpuBalls = 0;
+    GpuPhysics _gpuPhysics;
+    agl::Sphere _gpuBallMesh{0.5f, 12, 12};
+    bool _printGlStats = false;
+    float _glStatsTime = 0;
 
     bool _leftClick = false;
     bool _launching = false;
-    std::vector<vec3> _trajectoryDots;
-    std::vector<vec3> _pockets;
+    // runs the real physics on a copy of the table off the main thread
+    poolsim::TrajectoryPreview _preview;
+    // plays out candidate shots for the computer's turn on every core
+    poolsim::ThreadPool _opponentPool;
+    poolsim::Opponent _opponent{_opponentPool};
+    poolsim::TrajectoryPath _previewPath;
+    DotMesh _trajectoryDots{64};
+    float _trajectoryDotSpacing = 15.0f;
     int _activeBall = -1;
     vec3 _launchVel = vec3(0);
 
@@ -352,18 +401,12 @@ protected:
     vec3 _eyeScaleVector;
     vec3 _eyeCenterVector;
     int _eyeDiameter;
-    float _eyeDiameterModifier = 0.25;
     vec4 _eyeColor = vec4(1);
-    vec3 _glorbPos = vec3(0, 0, 200);
 
-    vector<string> _chaosEffects = {"Plain Jane", "Sticky Situation", "Hover Havoc", "Biggie Smalls", "Friction Affliction", "Tilt-a-Table", "Get Gaslit"};
-    map<string, bool> _chaosStatus;
-    string _chaosEffect = "Plain Jane";
     float _time = 0.0f;
     bool _enableChaos = true;
     bool _chaosAnimation = false;
     float _chaosAnimStart = 9999;
-    vec3 _tiltDir;
 
     float _congratsStartTime = -9999;
     string _congratsMessage;
@@ -0,0 +1,365 @@
+/**
+ * @file poolsim-bench.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Microbenchmarks of the phases of a step, written as JSON so that
+ * runs can be compared
+ */
+
+#include "poolsim/kernels.h"
+#include "poolsim/table.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace glm;
+
+#ifndef POOLSIM_BUILD_TYPE
+#define POOLSIM_BUILD_TYPE ""
+#endif
+
+/**
+ * A table whose fixed step can be run one phase at a time, in the same way
+ * Table::fixedStepWith runs it.
+ */
+class BenchTable : public poolsim::Table
+{
+public:
+    BenchTable(const poolsim::TableConfig& config) : Table(config) {}
+
+    void integration()
+    {
+      poolsim::kernels().integrate(_balls, _config.numBalls, _config.fixedDt, 1.0f / _config.sphereRadius);
+    }
+
+    void broadphase()
+    {
+      _broadphase.update(_balls, _config.sphereRadius);
+      _broadphase.pairs();
+    }
+
+    /**
+    * The narrowphase over the pairs the last broadphase() found.
+    */
+    void collisionDetection()
+    {
+      const vector<pair<int, int> >& pairs = _broadphase.pairs();
+      for (int p = 0; p < (int) pairs.size(); p++)
+      {
+        int i = pairs[p].first;
+        int j = pairs[p].second;
+        if (!_balls.isFree(i)) continue;
+        if (_balls.flags[i] & _balls.flags[j] & poolsim::BALL_SLEEPING) continue;
+        Table::collisionDetection(i, j);
+      }
+    }
+
+    void boundaryDetection()
+    {
+      typedef void (BenchTable::*Pass)();
+      static const Pass passes[poolsim::numStepVariants] = {
+        &BenchTable::boundaryWith<poolsim::stepVariantSet(0)>, &BenchTable::boundaryWith<poolsim::stepVariantSet(1)>,
+        &BenchTable::boundaryWith<poolsim::stepVariantSet(2)>, &BenchTable::boundaryWith<poolsim::stepVariantSet(3)>,
+        &BenchTable::boundaryWith<poolsim::stepVariantSet(4)>, &BenchTable::boundaryWith<poolsim::stepVariantSet(5)>,
+        &BenchTable::boundaryWith<poolsim::stepVariantSet(6)>, &BenchTable::boundaryWith<poolsim::stepVariantSet(7)>
+      };
+      (this->*passes[poolsim::stepVariant(_chaosActive)])();
+    }
+
+    void pocketDetection()
+    {
+      for (int i = 0; i < _config.numBalls; i++)
+      {
+        _balls.flags[i] &= ~poolsim::BALL_CAPTURED;
+        if (isDevoured(i) || isSleeping(i)) continue;
+        if (isSinking(i)) glorbDetection(i);
+        else Table::pocketDetection(i);
+      }
+    }
+
+    /**
+    * Keeps the balls as they are now, for restore() to put them back
+    * before every repetition.
+    */
+    void save() { _saved = _balls; }
+    void restore() { _balls = _saved; }
+
+private:
+    template <poolsim::ChaosSet Active>
+    void boundaryWith()
+    {
+      for (int i = 0; i < _config.numBalls; i++)
+      {
+        if (_balls.isAwake(i)) Table::boundaryDetection<Active>(i);
+      }
+    }
+
+    poolsim::BallArrays _saved;
+};
+
+struct BenchResult
+{
+  string name;
+  int balls;
+  string effect;
+  int tables;
+  int repetitions;
+  // median and fastest of the repetitions
+  double nsPerBallStep;
+  double minNsPerBallStep;
+};
+
+typedef void (BenchTable::*Phase)();
+
+/**
+ * Makes copies of a table of n balls scattered at random over a table scaled
+ * so that each ball has as much room as in the 16 ball game, all moving,
+ * with the given effect on for good.
+ */
+static vector<BenchTable> scatteredTables(int n, int copies, poolsim::ChaosEffect effect)
+{
+  poolsim::TableConfig config;
+  float scale = sqrt(std::max(1.0f, n / 16.0f));
+  config.numBalls = n;
+  config.tableLength = (int) (config.tableLength * scale);
+  config.tableWidth = (int) (config.tableWidth * scale);
+  BenchTable table(config);
+  table.setChaosEnabled(false);
+
+  mt19937 rng(n);
+  float radius = config.sphereRadius * config.ballDefaultSize;
+  float xMax = (config.tableLength - 75) / 2.0f - radius;
+  float yMax = (config.tableWidth - 75) / 2.0f - radius;
+  uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  poolsim::BallArrays& balls = table.balls();
+  for (int i = 0; i < n; i++)
+  {
+    balls.setPos(i, vec3(xMax * unit(rng), yMax * unit(rng), 0));
+    balls.setVel(i, vec3(300 * unit(rng), 300 * unit(rng), 0));
+  }
+  table.setChaosEffect(effect);
+  // one step for the effect to take hold, hovering balls rising and so on
+  table.step();
+  table.save();
+  return vector<BenchTable>(copies, table);
+}
+
+/**
+ * Times a phase over every table, restoring the tables before each
+ * repetition so that every repetition does the same work.
+ */
+static BenchResult runPhase(const char* name, Phase phase, Phase setup, vector<BenchTable>& tables, int repetitions,
+  poolsim::ChaosEffect effect)
+{
+  vector<double> times;
+  for (int r = 0; r < repetitions; r++)
+  {
+    for (BenchTable& table : tables)
+    {
+      table.restore();
+      if (setup) (table.*setup)();
+    }
+    auto start = chrono::steady_clock::now();
+    for (BenchTable& table : tables)
+    {
+      (table.*phase)();
+    }
+    times.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+  }
+  sort(times.begin(), times.end());
+
+  BenchResult result;
+  result.name = name;
+  result.balls = tables[0].numBalls();
+  result.effect = poolsim::Table::chaosEffects()[effect];
+  result.tables = (int) tables.size();
+  result.repetitions = repetitions;
+  double ballSteps = (double) result.balls * result.tables;
+  result.nsPerBallStep = times[times.size() / 2] / ballSteps;
+  result.minNsPerBallStep = times[0] / ballSteps;
+  return result;
+}
+
+static void writeJson(FILE* file, const vector<BenchResult>& results)
+{
+  fprintf(file, "{\n");
+  fprintf(file, "  \"context\": {\"kernels\": \"%s\", \"build_type\": \"%s\"},\n", poolsim::kernels().name,
+    POOLSIM_BUILD_TYPE);
+  fprintf(file, "  \"benchmarks\": [\n");
+  for (size_t r = 0; r < results.size(); r++)
+  {
+    const BenchResult& b = results[r];
+    // one benchmark per line, which readBaseline relies on
+    fprintf(file, "    {\"name\": \"%s\", \"balls\": %d, \"effect\": \"%s\", \"tables\": %d, \"repetitions\": %d, "
+      "\"ns_per_ball_step\": %.4f, \"min_ns_per_ball_step\": %.4f}%s\n", b.name.c_str(), b.balls, b.effect.c_str(),
+      b.tables, b.repetitions, b.nsPerBallStep, b.minNsPerBallStep, r + 1 < results.size() ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+}
+
+static string resultKey(const string& name, int balls, const string& effect)
+{
+  return name + "/" + to_string(balls) + "/" + effect;
+}
+
+/**
+ * Reads the median times of a JSON file this program wrote earlier.
+ */
+static bool readBaseline(const char* path, map<string, double>& baseline)
+{
+  FILE* file = fopen(path, "r");
+  if (!file) return false;
+  char line[1024];
+  while (fgets(line, sizeof(line), file))
+  {
+    char name[128];
+    char effect[128];
+    int balls;
+    int tables;
+    int repetitions;
+    double ns;
+    if (sscanf(line, " {\"name\": \"%127[^\"]\", \"balls\": %d, \"effect\": \"%127[^\"]\", \"tables\": %d, "
+      "\"repetitions\": %d, \"ns_per_ball_step\": %lf", name, &balls, effect, &tables, &repetitions, &ns) == 6)
+    {
+      baseline[resultKey(name, balls, effect)] = ns;
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+static vector<int> parseList(const char* text)
+{
+  vector<int> values;
+  for (const char* p = text; *p; )
+  {
+    values.push_back(atoi(p));
+    const char* comma = strchr(p, ',');
+    if (!comma) break;
+    p = comma + 1;
+  }
+  return values;
+}
+
+static void usage()
+{
+  printf("usage: poolsim-bench [options]\n");
+  printf("  --balls N,N,...     ball counts, 16,64,256,1024,4096,16384,100000 unless given\n");
+  printf("  --effect NAME|all   chaos effect to time under, \"%s\" unless given\n", poolsim::Table::plainJane.c_str());
+  printf("  --work N            ball steps to time each benchmark for, 2000000 unless given\n");
+  printf("  --json FILE         write the results as JSON\n");
+  printf("  --baseline FILE     compare with the JSON of an earlier run\n");
+}
+
+int main(int argc, char** argv)
+{
+  vector<int> sizes = {16, 64, 256, 1024, 4096, 16384, 100000};
+  vector<poolsim::ChaosEffect> effects = {poolsim::CHAOS_PLAIN_JANE};
+  double work = 2e6;
+  const char* jsonPath = nullptr;
+  const char* baselinePath = nullptr;
+  for (int a = 1; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--balls") == 0 && a + 1 < argc) sizes = parseList(argv[++a]);
+    else if (strcmp(argv[a], "--work") == 0 && a + 1 < argc) work = atof(argv[++a]);
+    else if (strcmp(argv[a], "--json") == 0 && a + 1 < argc) jsonPath = argv[++a];
+    else if (strcmp(argv[a], "--baseline") == 0 && a + 1 < argc) baselinePath = argv[++a];
+    else if (strcmp(argv[a], "--effect") == 0 && a + 1 < argc)
+    {
+      string name = argv[++a];
+      effects.clear();
+      for (int e = 0; e < poolsim::NUM_CHAOS_EFFECTS; e++)
+      {
+        if (name == "all" || name == poolsim::Table::chaosEffects()[e]) effects.push_back((poolsim::ChaosEffect) e);
+      }
+      if (effects.empty())
+      {
+        fprintf(stderr, "no chaos effect named %s\n", name.c_str());
+        return 1;
+      }
+    }
+    else
+    {
+      usage();
+      return strcmp(argv[a], "--help") == 0 ? 0 : 1;
+    }
+  }
+
+  map<string, double> baseline;
+  if (baselinePath && !readBaseline(baselinePath, baseline))
+  {
+    fprintf(stderr, "could not read %s\n", baselinePath);
+    return 1;
+  }
+  string buildType = POOLSIM_BUILD_TYPE;
+  if (buildType.empty() || buildType == "Debug")
+  {
+    fprintf(stderr, "warning: timing an unoptimized build, configure with -DCMAKE_BUILD_TYPE=Release\n");
+  }
+
+  struct PhaseInfo
+  {
+    const char* name;
+    Phase phase;
+    Phase setup;
+  };
+  const PhaseInfo phases[] = {
+    {"integration", &BenchTable::integration, nullptr},
+    {"broadphase", &BenchTable::broadphase, nullptr},
+    {"collisionDetection", &BenchTable::collisionDetection, &BenchTable::broadphase},
+    {"boundaryDetection", &BenchTable::boundaryDetection, nullptr},
+    {"pocketDetection", &BenchTable::pocketDetection, nullptr},
+    {"step", &BenchTable::step, nullptr}
+  };
+
+  printf("kernels %s\n", poolsim::kernels().name);
+  printf("%-20s %8s %-20s %8s %14s %10s\n", "benchmark", "balls", "effect", "tables", "ns/ball/step",
+    baseline.empty() ? "min" : "vs base");
+  vector<BenchResult> results;
+  for (poolsim::ChaosEffect effect : effects)
+  {
+    for (int n : sizes)
+    {
+      if (n < 1) continue;
+      // small tables are timed many at a time, so that the clock is not
+      // read more often than there is work between
+      int copies = std::max(1, 16384 / n);
+      int repetitions = std::max(3, (int) (work / ((double) n * copies)));
+      vector<BenchTable> tables = scatteredTables(n, copies, effect);
+      for (const PhaseInfo& p : phases)
+      {
+        BenchResult r = runPhase(p.name, p.phase, p.setup, tables, repetitions, effect);
+        results.push_back(r);
+        auto base = baseline.find(resultKey(r.name, r.balls, r.effect));
+        char compare[32];
+        if (base != baseline.end()) snprintf(compare, sizeof(compare), "%9.2fx", r.nsPerBallStep / base->second);
+        else if (baseline.empty()) snprintf(compare, sizeof(compare), "%10.3f", r.minNsPerBallStep);
+        else snprintf(compare, sizeof(compare), "%10s", "-");
+        printf("%-20s %8d %-20s %8d %14.3f %s\n", r.name.c_str(), r.balls, r.effect.c_str(), r.tables,
+          r.nsPerBallStep, compare);
+        fflush(stdout);
+      }
+    }
+  }
+
+  if (jsonPath)
+  {
+    FILE* file = fopen(jsonPath, "w");
+    if (!file)
+    {
+      fprintf(stderr, "could not write %s\n", jsonPath);
+      return 1;
+    }
+    writeJson(file, results);
+    fclose(file);
+  }
+  return 0;
+}
@@ -0,0 +1,1065 @@
+/**
+ * @file poolsim-cli.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Command line tools for the headless poolsim library
+ */
+
+#include "poolsim/batch.h"
+#include "poolsim/kernels.h"
+#include "poolsim/lanes.h"
+#include "poolsim/opponent.h"
+#include "poolsim/recording.h"
+#include "poolsim/table.h"
+#include "poolsim/tablegeometry.h"
+#include "poolsim/tableserver.h"
+#include "poolsim/vecenv.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace glm;
+
+/**
+ * Scatters n balls at random over a table scaled so that each ball has as
+ * much room as in the 16 ball game, then reports how many pairs the
+ * broadphase hands to the narrowphase per step, against the n(n-1)/2 pairs
+ * the all-pairs loop would test.
+ */
+static int broadphaseCommand(int argc, char** argv)
+{
+  int steps = 100;
+  for (int a = 0; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--steps") == 0 && a + 1 < argc) steps = atoi(argv[++a]);
+  }
+
+  printf("%8s %14s %16s %10s %12s\n", "balls", "pairs/step", "all pairs", "ratio", "us/step");
+  const int sizes[] = {16, 64, 256, 1024, 4096, 16384, 100000};
+  for (int n : sizes)
+  {
+    poolsim::TableConfig config;
+    float scale = sqrt(std::max(1.0f, n / 16.0f));
+    config.numBalls = n;
+    config.tableLength = (int) (config.tableLength * scale);
+    config.tableWidth = (int) (config.tableWidth * scale);
+    poolsim::Table table(config);
+
+    mt19937 rng(n);
+    float radius = config.sphereRadius * config.ballDefaultSize;
+    float xMax = (config.tableLength - 75) / 2.0f - radius;
+    float yMax = (config.tableWidth - 75) / 2.0f - radius;
+    uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    poolsim::BallArrays& balls = table.balls();
+    for (int i = 0; i < n; i++)
+    {
+      balls.setPos(i, vec3(xMax * unit(rng), yMax * unit(rng), 0));
+      balls.setVel(i, vec3(300 * unit(rng), 300 * unit(rng), 0));
+    }
+
+    long pairTests = 0;
+    auto start = chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++)
+    {
+      table.step();
+      pairTests += table.pairTests();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    double perStep = (double) pairTests / steps;
+    double allPairs = 0.5 * n * (n - 1.0);
+    printf("%8d %14.1f %16.0f %10.2e %12.1f\n", n, perStep, allPairs, perStep / allPairs, 1e6 * seconds / steps);
+  }
+  return 0;
+}
+
+/**
+ * Plays the same random shots with the fixed-step, the event, the
+ * fixed-point and the sequential-impulse solver, letting each shot run until the table is at rest, and
+ * reports the time per shot and how many balls each solver pocketed.
+ */
+static int shotsCommand(int argc, char** argv)
+{
+  int shots = 1000;
+  float speed = 2000.0f;
+  shared_ptr<const poolsim::TableGeometry> geometry;
+  for (int a = 0; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--shots") == 0 && a + 1 < argc) shots = atoi(argv[++a]);
+    else if (strcmp(argv[a], "--speed") == 0 && a + 1 < argc) speed = (float) atof(argv[++a]);
+    else if (strcmp(argv[a], "--model") == 0 && a + 1 < argc)
+    {
+      geometry = poolsim::loadTableGeometry(argv[++a], poolsim::TableConfig().viewVolumeSide);
+      if (!geometry)
+      {
+        fprintf(stderr, "could not trace %s\n", argv[a]);
+        return 1;
+      }
+    }
+  }
+
+  printf("%8s %12s %12s %10s %10s\n", "solver", "us/shot", "sim s/shot", "pocketed", "hits");
+  const poolsim::SolverMode modes[] = {poolsim::SOLVER_FIXED_STEP, poolsim::SOLVER_EVENT, poolsim::SOLVER_FIXED_POINT,
+    poolsim::SOLVER_SEQUENTIAL_IMPULSE};
+  const char* names[] = {"fixed", "event", "integer", "impulse"};
+  for (poolsim::SolverMode mode : modes)
+  {
+    poolsim::TableConfig config;
+    config.solver = mode;
+    config.geometry = geometry;
+    poolsim::Table table(config);
+    mt19937 rng(1);
+    uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    uniform_int_distribution<int> ball(0, config.numBalls - 1);
+
+    double simulated = 0;
+    long pocketed = 0;
+    long hits = 0;
+    auto start = chrono::steady_clock::now();
+    for (int s = 0; s < shots; s++)
+    {
+      table.reset();
+      float a = angle(rng);
+      table.launch(ball(rng), speed * vec3(cos(a), sin(a), 0));
+      simulated += table.settle();
+      pocketed += table.events().pocketed;
+      hits += table.events().collisions;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%8s %12.1f %12.2f %10.2f %10.1f\n", names[mode],
+      1e6 * seconds / shots, simulated / shots, (double) pocketed / shots, (double) hits / shots);
+  }
+  return 0;
+}
+
+/**
+ * Simulates a batch of independent tables on a thread pool and reports the
+ * throughput, along with a hash of every table's end state that must not
+ * change with the number of threads.
+ */
+static int batchCommand(int argc, char** argv)
+{
+  poolsim::BatchConfig config;
+  config.table.solver = poolsim::SOLVER_EVENT;
+  int threads = 0;
+  for (int a = 0; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--tables") == 0 && a + 1 < argc) config.numTables = atoi(argv[++a]);
+    else if (strcmp(argv[a], "--shots") == 0 && a + 1 < argc) config.shotsPerTable = atoi(argv[++a]);
+    else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) threads = atoi(argv[++a]);
+    else if (strcmp(argv[a], "--seed") == 0 && a + 1 < argc) config.seed = (uint32_t) strtoul(argv[++a], NULL, 10);
+    else if (strcmp(argv[a], "--fixed") == 0) config.table.solver = poolsim::SOLVER_FIXED_STEP;
+    else if (strcmp(argv[a], "--fixed-point") == 0) config.table.solver = poolsim::SOLVER_FIXED_POINT;
+    else if (strcmp(argv[a], "--impulse") == 0) config.table.solver = poolsim::SOLVER_SEQUENTIAL_IMPULSE;
+    else if (strcmp(argv[a], "--lanes") == 0) config.lanes = true;
+    else if (strcmp(argv[a], "--model") == 0 && a + 1 < argc)
+    {
+      config.table.geometry = poolsim::loadTableGeometry(argv[++a], config.table.viewVolumeSide);
+      if (!config.table.geometry)
+      {
+        fprintf(stderr, "could not trace %s\n", argv[a]);
+        return 1;
+      }
+    }
+  }
+  if (config.lanes) config.table.solver = poolsim::SOLVER_FIXED_STEP;
+
+  poolsim::ThreadPool pool(threads);
+  poolsim::BatchRunner runner(config, pool);
+  vector<poolsim::TableResult> results;
+  auto start = chrono::steady_clock::now();
+  runner.run(results);
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  long shots = 0;
+  long pocketed = 0;
+  uint64_t hash = 14695981039346656037ull;
+  for (const poolsim::TableResult& result : results)
+  {
+    shots += result.shots;
+    pocketed += result.pocketed;
+    hash = (hash ^ result.stateHash) * 1099511628211ull;
+  }
+  printf("threads     %d\n", pool.numThreads());
+  if (config.lanes) printf("lanes       %s x%d\n", poolsim::laneKernel().name, poolsim::laneKernel().width);
+  printf("tables      %d\n", config.numTables);
+  printf("shots       %ld\n", shots);
+  printf("pocketed    %ld\n", pocketed);
+  printf("seconds     %.3f\n", seconds);
+  printf("tables/sec  %.0f\n", config.numTables / seconds);
+  printf("shots/sec   %.0f\n", shots / seconds);
+  printf("state hash  %016llx\n", (unsigned long long) hash);
+  return 0;
+}
+
+/**
+ * Traces the cushions and pockets of a table mesh, once from scratch and
+ * once through the cache, and reports what was found.
+ */
+static int geometryCommand(int argc, char** argv)
+{
+  string model = "models/pool-table.ply";
+  for (int a = 0; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--model") == 0 && a + 1 < argc) model = argv[++a];
+  }
+  int viewVolumeSide = poolsim::TableConfig().viewVolumeSide;
+
+  auto start = chrono::steady_clock::now();
+  shared_ptr<const poolsim::TableGeometry> traced = poolsim::traceTableGeometry(model, viewVolumeSide);
+  double traceSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  if (!traced)
+  {
+    fprintf(stderr, "could not trace %s\n", model.c_str());
+    return 1;
+  }
+  // the first load may have to write the cache, the second must read it
+  poolsim::loadTableGeometry(model, viewVolumeSide);
+  start = chrono::steady_clock::now();
+  shared_ptr<const poolsim::TableGeometry> cached = poolsim::loadTableGeometry(model, viewVolumeSide);
+  double cacheSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  printf("triangles   %d\n", traced->meshTriangles);
+  printf("tested      %d\n", traced->trianglesTested);
+  printf("cushions    %d edges\n", traced->cushions.count);
+  printf("cloth       %.1f x %.1f\n", 2 * traced->playExtent.x, 2 * traced->playExtent.y);
+  for (const poolsim::PocketShape& pocket : traced->pockets)
+  {
+    printf("pocket      (%7.1f, %7.1f) radius %4.1f mouth %4.1f\n", pocket.center.x, pocket.center.y,
+      pocket.radius, distance(pocket.jawA, pocket.jawB));
+  }
+  printf("trace ms    %.2f\n", 1e3 * traceSeconds);
+  printf("cache ms    %.2f%s\n", 1e3 * cacheSeconds, cached && cached->fromCache ? "" : " (not cached)");
+  return 0;
+}
+
+/**
+ * Records a scripted session the way the game plays one, with chaos on, a
+ * launch whenever the table comes to rest and the camera turning every
+ * frame.
+ */
+static int recordCommand(int argc, char** argv)
+{
+  if (argc < 1)
+  {
+    fprintf(stderr, "record needs a file to write\n");
+    return 1;
+  }
+  string path = argv[0];
+  int shots = 20;
+  int interval = 600;
+  poolsim::TableConfig config;
+  config.solver = poolsim::SOLVER_EVENT;
+  for (int a = 1; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--shots") == 0 && a + 1 < argc) shots = atoi(argv[++a]);
+    else if (strcmp(argv[a], "--seed") == 0 && a + 1 < argc) config.seed = (uint32_t) strtoul(argv[++a], NULL, 10);
+    else if (strcmp(argv[a], "--interval") == 0 && a + 1 < argc) interval = std::max(1, atoi(argv[++a]));
+    else if (strcmp(argv[a], "--fixed") == 0) config.solver = poolsim::SOLVER_FIXED_STEP;
+    else if (strcmp(argv[a], "--fixed-point") == 0) config.solver = poolsim::SOLVER_FIXED_POINT;
+    else if (strcmp(argv[a], "--impulse") == 0) config.solver = poolsim::SOLVER_SEQUENTIAL_IMPULSE;
+    else if (strcmp(argv[a], "--model") == 0 && a + 1 < argc)
+    {
+      config.geometry = poolsim::loadTableGeometry(argv[++a], config.viewVolumeSide);
+      if (!config.geometry)
+      {
+        fprintf(stderr, "could not trace %s\n", argv[a]);
+        return 1;
+      }
+    }
+  }
+
+  poolsim::Table table(config);
+  poolsim::InputRecorder recorder(interval);
+  recorder.start(table);
+  table.setChaosEnabled(true);
+  mt19937 rng(config.seed);
+  uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  uniform_int_distribution<int> ball(0, config.numBalls - 1);
+  float azimuth = 3.14159265f;
+  for (int s = 0; s < shots && !table.allSunk(); s++)
+  {
+    int i = ball(rng);
+    while (table.isDevoured(i) || table.isSinking(i)) i = ball(rng);
+    table.launch(i, vec3(1500 * unit(rng), 1500 * unit(rng), 0));
+    // frames as uneven as a real one, until the table rests or 20 seconds pass
+    for (int frame = 0; frame < 1200 && !table.atRest(); frame++)
+    {
+      azimuth += 0.01f * unit(rng);
+      recorder.camera(azimuth, 1.0f);
+      table.advance((1.0f + 0.2f * unit(rng)) / 60.0f);
+    }
+  }
+  recorder.stop();
+  if (!recorder.save(path))
+  {
+    fprintf(stderr, "could not write %s\n", path.c_str());
+    return 1;
+  }
+
+  size_t keyframeBytes = 0;
+  for (const poolsim::Keyframe& keyframe : recorder.keyframes())
+  {
+    keyframeBytes += keyframe.state.size();
+  }
+  printf("steps       %ld (%.1f s of play)\n", recorder.steps(), recorder.steps() * config.fixedDt);
+  printf("inputs      %zu bytes\n", recorder.inputBytes());
+  printf("keyframes   %zu, %zu bytes\n", recorder.keyframes().size(), keyframeBytes);
+  printf("state hash  %016llx\n", (unsigned long long) table.stateHash());
+  return 0;
+}
+
+/**
+ * Replays a recording as fast as it will go and checks it against the
+ * hashes it was recorded with, optionally seeking partway in first.
+ */
+static int replayCommand(int argc, char** argv)
+{
+  if (argc < 1)
+  {
+    fprintf(stderr, "replay needs a file to read\n");
+    return 1;
+  }
+  long seekStep = -1;
+  for (int a = 1; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--seek") == 0 && a + 1 < argc) seekStep = atol(argv[++a]);
+  }
+
+  poolsim::Replayer replayer;
+  string error;
+  if (!replayer.load(argv[0], error))
+  {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  float fixedDt = replayer.table().config().fixedDt;
+  printf("steps       %ld (%.1f s of play)\n", replayer.steps(), replayer.steps() * fixedDt);
+  printf("keyframes   %zu\n", replayer.keyframes().size());
+  if (seekStep >= 0)
+  {
+    auto start = chrono::steady_clock::now();
+    replayer.seek(seekStep);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("seek        step %ld in %.3f ms\n", replayer.position(), 1e3 * seconds);
+  }
+
+  long from = replayer.position();
+  auto start = chrono::steady_clock::now();
+  bool matched = replayer.run();
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  long played = replayer.steps() - from;
+  printf("replayed    %ld steps in %.3f s, %.0fx real time\n", played, seconds,
+    seconds > 0 ? played * fixedDt / seconds : 0.0);
+  printf("state hash  %016llx %s\n", (unsigned long long) replayer.table().stateHash(),
+    matched ? "matches" : "DOES NOT MATCH");
+  if (replayer.mismatches() > 0) printf("mismatches  %d\n", replayer.mismatches());
+  return matched ? 0 : 1;
+}
+
+/**
+ * Times snapshots and restores of a table partway through a shot, and
+ * checks that a table rolled back to a snapshot plays out exactly as it did
+ * the first time.
+ */
+static int snapshotCommand(int argc, char** argv)
+{
+  int count = 100000;
+  poolsim::TableConfig config;
+  config.solver = poolsim::SOLVER_EVENT;
+  for (int a = 0; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--count") == 0 && a + 1 < argc) count = std::max(1, atoi(argv[++a]));
+  }
+
+  poolsim::Table table(config);
+  table.setChaosEnabled(true);
+  table.launch(0, vec3(1500, 400, 0));
+  for (int s = 0; s < 30; s++)
+  {
+    table.step();
+  }
+  vector<char> buffer(table.snapshotSize());
+
+  auto start = chrono::steady_clock::now();
+  for (int c = 0; c < count; c++)
+  {
+    table.snapshot(buffer.data(), buffer.size());
+  }
+  double saveSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  start = chrono::steady_clock::now();
+  for (int c = 0; c < count; c++)
+  {
+    table.restore(buffer.data(), buffer.size());
+  }
+  double restoreSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  // play past a status effect change, roll back and play again
+  int steps = (int) (2 * config.chaosPeriod / config.fixedDt);
+  for (int s = 0; s < steps; s++)
+  {
+    table.step();
+  }
+  uint64_t first = table.stateHash();
+  bool restored = table.restore(buffer.data(), buffer.size());
+  for (int s = 0; s < steps; s++)
+  {
+    table.step();
+  }
+  bool matched = restored && table.stateHash() == first;
+
+  printf("bytes       %zu\n", buffer.size());
+  printf("saves/sec   %.0f\n", count / saveSeconds);
+  printf("restores/s  %.0f\n", count / restoreSeconds);
+  printf("rollback    %s\n", matched ? "replays identically" : "DIVERGED");
+  return matched ? 0 : 1;
+}
+
+/**
+ * Lets the computer opponent play turns on its own under one chaos effect
+ * and reports how many candidate shots it plays out per second, which is
+ * what sizes the hardware for a given time budget.
+ */
+static int opponentCommand(int argc, char** argv)
+{
+  poolsim::OpponentConfig config;
+  poolsim::TableConfig tableConfig;
+  tableConfig.solver = poolsim::SOLVER_EVENT;
+  int turns = 5;
+  int threads = 0;
+  string effect = poolsim::Table::plainJane;
+  for (int a = 0; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--turns") == 0 && a + 1 < argc) turns = atoi(argv[++a]);
+    else if (strcmp(argv[a], "--budget") == 0 && a + 1 < argc) config.timeBudget = (float) atof(argv[++a]) / 1000.0f;
+    else if (strcmp(argv[a], "--candidates") == 0 && a + 1 < argc) config.candidatesPerBall = std::max(1, atoi(argv[++a]));
+    else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) threads = atoi(argv[++a]);
+    else if (strcmp(argv[a], "--effect") == 0 && a + 1 < argc) effect = argv[++a];
+    else if (strcmp(argv[a], "--fixed") == 0) tableConfig.solver = poolsim::SOLVER_FIXED_STEP;
+    else if (strcmp(argv[a], "--fixed-point") == 0) tableConfig.solver = poolsim::SOLVER_FIXED_POINT;
+    else if (strcmp(argv[a], "--impulse") == 0) tableConfig.solver = poolsim::SOLVER_SEQUENTIAL_IMPULSE;
+    else if (strcmp(argv[a], "--model") == 0 && a + 1 < argc)
+    {
+      tableConfig.geometry = poolsim::loadTableGeometry(argv[++a], tableConfig.viewVolumeSide);
+      if (!tableConfig.geometry)
+      {
+        fprintf(stderr, "could not trace %s\n", argv[a]);
+        return 1;
+      }
+    }
+  }
+
+  poolsim::Table table(tableConfig);
+  table.setChaosEffect(effect);
+  poolsim::ThreadPool pool(threads);
+  poolsim::Opponent opponent(pool, config);
+  printf("threads     %d\n", pool.numThreads());
+  printf("effect      %s\n", table.chaosEffect().c_str());
+  printf("%6s %6s %8s %10s %10s %12s %10s\n", "turn", "ball", "speed", "expected", "pocketed", "candidates", "shots/s");
+  long candidates = 0;
+  double seconds = 0;
+  int pocketed = 0;
+  for (int t = 0; t < turns && !table.allSunk(); t++)
+  {
+    poolsim::OpponentShot shot = opponent.chooseShot(table);
+    candidates += shot.candidates;
+    seconds += shot.seconds;
+    table.clearEvents();
+    table.launch(shot.ball, shot.vel);
+    table.settle(config.maxShotTime);
+    pocketed += table.events().pocketed;
+    printf("%6d %6d %8.0f %10d %10d %12d %10.0f\n", t + 1, shot.ball, length(shot.vel), shot.pocketed,
+      table.events().pocketed, shot.candidates, shot.shotsPerSecond());
+  }
+  printf("pocketed    %d\n", pocketed);
+  printf("shots/sec   %.0f\n", seconds > 0 ? candidates / seconds : 0.0);
+  return 0;
+}
+
+/**
+ * Largest overlap between two balls on the table.
+ */
+static float maxOverlap(const poolsim::Table& table)
+{
+  float radius = table.config().sphereRadius;
+  float overlap = 0;
+  for (int i = 0; i < table.numBalls(); i++)
+  {
+    for (int j = i + 1; j < table.numBalls(); j++)
+    {
+      overlap = std::max(overlap, radius * (table.size(i) + table.size(j)) - distance(table.pos(i), table.pos(j)));
+    }
+  }
+  return overlap;
+}
+
+static float kineticEnergy(const poolsim::Table& table)
+{
+  float energy = 0;
+  for (int i = 0; i < table.numBalls(); i++)
+  {
+    energy += 0.5f * dot(table.vel(i), table.vel(i));
+  }
+  return energy;
+}
+
+/**
+ * Puts the balls of a table at the given places, at rest, on a table with
+ * chaos and sleep off so that nothing but the contacts moves them.
+ */
+static void placeBalls(poolsim::Table& table, const vector<vec2>& places)
+{
+  table.setChaosEnabled(false);
+  poolsim::BallArrays& balls = table.balls();
+  for (int i = 0; i < (int) places.size(); i++)
+  {
+    balls.setPos(i, vec3(places[i], 0));
+    balls.setVel(i, vec3(0));
+  }
+}
+
+/**
+ * Centers of a hexagonal group of balls with the given number of rings
+ * around the middle one, spaced apart by a ball diameter less the squeeze.
+ */
+static void hexGroup(vector<vec2>& places, vec2 center, int rings, float spacing)
+{
+  for (int q = -rings; q <= rings; q++)
+  {
+    for (int r = std::max(-rings, -q - rings); r <= std::min(rings, -q + rings); r++)
+    {
+      places.push_back(center + spacing * vec2(q + 0.5f * r, 0.8660254f * r));
+    }
+  }
+}
+
+/**
+ * Compares the fixed-step solver, which separates one pair of touching balls
+ * at a time, with the sequential-impulse solver on packed groups of balls:
+ * a squeezed group left to settle, a break into a tight rack, and many
+ * small groups spread over the threads, whose state hash must not change
+ * with the number of threads.
+ */
+static int contactsCommand(int argc, char** argv)
+{
+  int steps = 120;
+  int groups = 256;
+  int threads = 0;
+  float squeeze = 3.0f;
+  for (int a = 0; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--steps") == 0 && a + 1 < argc) steps = std::max(1, atoi(argv[++a]));
+    else if (strcmp(argv[a], "--groups") == 0 && a + 1 < argc) groups = std::max(1, atoi(argv[++a]));
+    else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) threads = atoi(argv[++a]);
+    else if (strcmp(argv[a], "--squeeze") == 0 && a + 1 < argc) squeeze = (float) atof(argv[++a]);
+  }
+
+  const poolsim::SolverMode modes[] = {poolsim::SOLVER_FIXED_STEP, poolsim::SOLVER_SEQUENTIAL_IMPULSE};
+  const char* names[] = {"fixed", "impulse"};
+  poolsim::TableConfig base;
+  base.sleepTime = -1;
+  float diameter = 2 * base.sphereRadius * base.ballDefaultSize;
+
+  // 37 balls squeezed together, which should push apart without a sound
+  // and stay where they end up
+  printf("%8s %12s %12s %12s\n", "pile", "overlap", "spread", "collisions");
+  for (int m = 0; m < 2; m++)
+  {
+    vector<vec2> places;
+    hexGroup(places, vec2(0), 3, diameter - squeeze);
+    poolsim::TableConfig config = base;
+    config.solver = modes[m];
+    config.numBalls = (int) places.size();
+    poolsim::Table table(config);
+    placeBalls(table, places);
+    for (int s = 0; s < steps; s++)
+    {
+      table.step();
+    }
+    float spread = 0;
+    for (int i = 0; i < table.numBalls(); i++)
+    {
+      spread += distance(vec2(table.pos(i)), places[i]);
+    }
+    printf("%8s %12.2f %12.2f %12d\n", names[m], maxOverlap(table), spread / table.numBalls(),
+      table.events().collisions);
+  }
+
+  // the cue ball into a rack of 15 touching balls, with the energy left
+  // after a few steps against what friction alone would have left
+  int breakSteps = 20;
+  printf("\n%8s %12s %12s %12s\n", "break", "energy", "friction", "overlap");
+  for (int m = 0; m < 2; m++)
+  {
+    vector<vec2> places;
+    places.push_back(vec2(-200, 0));
+    for (int row = 0; row < 5; row++)
+    {
+      for (int b = 0; b <= row; b++)
+      {
+        places.push_back(vec2(0.8660254f * diameter * row, diameter * (b - 0.5f * row)));
+      }
+    }
+    poolsim::TableConfig config = base;
+    config.solver = modes[m];
+    config.numBalls = (int) places.size();
+    config.tableLength = 2000;
+    config.tableWidth = 1200;
+    poolsim::Table table(config);
+    placeBalls(table, places);
+    table.launch(0, vec3(2000, 0, 0));
+    float before = kineticEnergy(table);
+    float overlap = 0;
+    for (int s = 0; s < breakSteps; s++)
+    {
+      table.step();
+      overlap = std::max(overlap, maxOverlap(table));
+    }
+    printf("%8s %12.3f %12.3f %12.2f\n", names[m], kineticEnergy(table) / before,
+      pow(poolsim::tableFriction, 2.0f * breakSteps), overlap);
+  }
+
+  // groups of 7 squeezed balls on a grid, each group its own island
+  int side = (int) ceil(sqrt((float) groups));
+  float cell = 4 * diameter;
+  vector<vec2> places;
+  for (int g = 0; g < groups; g++)
+  {
+    vec2 center = cell * (vec2(g % side, g / side) - 0.5f * (side - 1.0f));
+    hexGroup(places, center, 1, diameter - squeeze);
+  }
+  poolsim::TableConfig config = base;
+  config.solver = poolsim::SOLVER_SEQUENTIAL_IMPULSE;
+  config.numBalls = (int) places.size();
+  // room for the grid well inside the pockets
+  config.tableLength = config.tableWidth = (int) (cell * side) + 400;
+  poolsim::ThreadPool pool(threads);
+  printf("\n%8s %12s %12s %12s %18s\n", "threads", "islands", "contacts", "us/step", "state hash");
+  uint64_t hashes[2];
+  for (int run = 0; run < 2; run++)
+  {
+    poolsim::Table table(config);
+    placeBalls(table, places);
+    if (run == 1) table.setThreadPool(&pool);
+    table.step();
+    int islands = table.contactSolver().numIslands();
+    int contacts = table.contactSolver().numContacts();
+    auto start = chrono::steady_clock::now();
+    for (int s = 1; s < steps; s++)
+    {
+      table.step();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    hashes[run] = table.stateHash();
+    printf("%8d %12d %12d %12.1f   %016llx\n", run == 0 ? 1 : pool.numThreads(), islands, contacts,
+      1e6 * seconds / (steps - 1), (unsigned long long) hashes[run]);
+  }
+  bool matched = hashes[0] == hashes[1];
+  printf("threads     %s\n", matched ? "match" : "DIVERGED");
+  return matched ? 0 : 1;
+}
+
+/**
+ * Checks that the batch draws of every kernel set and a jump ahead match
+ * drawing one at a time, and reports the draws per second of each.
+ */
+static int randomCommand(int argc, char** argv)
+{
+  int count = 1 << 20;
+  int rounds = 64;
+  for (int a = 0; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--count") == 0 && a + 1 < argc) count = std::max(1, atoi(argv[++a]));
+    else if (strcmp(argv[a], "--rounds") == 0 && a + 1 < argc) rounds = std::max(1, atoi(argv[++a]));
+  }
+
+  poolsim::Pcg32 one(42, 7);
+  vector<uint32_t> expected(count);
+  auto start = chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int k = 0; k < count; k++)
+    {
+      expected[k] = one();
+    }
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  printf("%8s %14s %10s\n", "draws", "millions/s", "matches");
+  printf("%8s %14.0f %10s\n", "single", 1e-6 * count * rounds / seconds, "-");
+
+  bool matched = true;
+  const poolsim::KernelSet* sets[] = {&poolsim::scalarKernels(), poolsim::sseKernels(),
+    poolsim::cpuHasAvx2() ? poolsim::avx2Kernels() : nullptr};
+  vector<uint32_t> drawn(count);
+  for (const poolsim::KernelSet* set : sets)
+  {
+    if (!set) continue;
+    poolsim::Pcg32 batch(42, 7);
+    uint64_t state = batch.state();
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+    {
+      state = set->pcgFill(state, batch.increment(), drawn.data(), count);
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    bool same = drawn == expected && state == one.state();
+    matched = matched && same;
+    printf("%8s %14.0f %10s\n", set->name, 1e-6 * count * rounds / seconds, same ? "yes" : "NO");
+  }
+
+  poolsim::Pcg32 jumped(42, 7);
+  jumped.advance((uint64_t) count * rounds);
+  bool jumpMatched = jumped == one;
+  printf("advance     %s\n", jumpMatched ? "matches" : "DIVERGED");
+  return matched && jumpMatched ? 0 : 1;
+}
+
+/**
+ * Plays one table headless at its fixed step rate and mirrors it to every
+ * client that says hello, reporting once a second.
+ */
+static int serveCommand(int argc, char** argv)
+{
+  uint16_t port = poolsim::netDefaultPort;
+  double seconds = 1e9;
+  int sendInterval = 2;
+  poolsim::TableConfig config;
+  config.solver = poolsim::SOLVER_EVENT;
+  bool chaos = false;
+  for (int a = 0; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--port") == 0 && a + 1 < argc) port = (uint16_t) atoi(argv[++a]);
+    else if (strcmp(argv[a], "--seconds") == 0 && a + 1 < argc) seconds = atof(argv[++a]);
+    else if (strcmp(argv[a], "--send-every") == 0 && a + 1 < argc) sendInterval = std::max(1, atoi(argv[++a]));
+    else if (strcmp(argv[a], "--seed") == 0 && a + 1 < argc) config.seed = (uint32_t) strtoul(argv[++a], NULL, 10);
+    else if (strcmp(argv[a], "--chaos") == 0) chaos = true;
+    else if (strcmp(argv[a], "--fixed") == 0) config.solver = poolsim::SOLVER_FIXED_STEP;
+    else if (strcmp(argv[a], "--fixed-point") == 0) config.solver = poolsim::SOLVER_FIXED_POINT;
+    else if (strcmp(argv[a], "--impulse") == 0) config.solver = poolsim::SOLVER_SEQUENTIAL_IMPULSE;
+    else if (strcmp(argv[a], "--model") == 0 && a + 1 < argc)
+    {
+      config.geometry = poolsim::loadTableGeometry(argv[++a], config.viewVolumeSide);
+      if (!config.geometry)
+      {
+        fprintf(stderr, "could not trace %s\n", argv[a]);
+        return 1;
+      }
+    }
+  }
+
+  poolsim::TableServer server(config, sendInterval);
+  server.table().setChaosEnabled(chaos);
+  string error;
+  if (!server.open(port, error))
+  {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  printf("serving on port %d, a snapshot every %d ticks\n", server.port(), sendInterval);
+  printf("%8s %8s %12s %12s %12s %12s\n", "seconds", "mirrors", "bytes/tick", "full/tick", "jitter ms", "max ms");
+  poolsim::ServerStats last;
+  for (int second = 1; second <= seconds; second++)
+  {
+    server.run(1.0);
+    const poolsim::ServerStats& stats = server.stats();
+    long ticks = stats.ticks - last.ticks;
+    printf("%8d %8d %12.1f %12.1f %12.3f %12.3f\n", second, server.numMirrors(),
+      (double) (stats.bytesSent - last.bytesSent) / ticks, (double) (stats.fullBytes - last.fullBytes) / ticks,
+      1e3 * (stats.jitterSum - last.jitterSum) / ticks, 1e3 * stats.maxJitter);
+    fflush(stdout);
+    last = stats;
+  }
+  return 0;
+}
+
+/**
+ * Follows a server as a kiosk would, interpolating its table, and reports
+ * what arrives once a second. With --launch it also takes a random shot
+ * every few seconds.
+ */
+static int mirrorCommand(int argc, char** argv)
+{
+  string host = "127.0.0.1";
+  uint16_t port = poolsim::netDefaultPort;
+  double seconds = 10;
+  double delay = 0.1;
+  bool launch = false;
+  for (int a = 0; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--host") == 0 && a + 1 < argc) host = argv[++a];
+    else if (strcmp(argv[a], "--port") == 0 && a + 1 < argc) port = (uint16_t) atoi(argv[++a]);
+    else if (strcmp(argv[a], "--seconds") == 0 && a + 1 < argc) seconds = atof(argv[++a]);
+    else if (strcmp(argv[a], "--delay") == 0 && a + 1 < argc) delay = atof(argv[++a]);
+    else if (strcmp(argv[a], "--launch") == 0) launch = true;
+  }
+
+  poolsim::TableMirror mirror(delay);
+  string error;
+  if (!mirror.connect(host, port, error))
+  {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  mt19937 rng(1);
+  uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  printf("%8s %10s %10s %10s %10s %12s\n", "seconds", "snapshots", "bytes", "lost", "tick", "sunk");
+  auto start = chrono::steady_clock::now();
+  long lastReceived = 0;
+  uint64_t lastBytes = 0;
+  double nextLaunch = 0;
+  for (int second = 1; second <= seconds; second++)
+  {
+    while (chrono::steady_clock::now() - start < chrono::seconds(second))
+    {
+      mirror.poll();
+      mirror.interpolate();
+      double now = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+      if (launch && mirror.connected() && now >= nextLaunch)
+      {
+        mirror.launch(rng() % mirror.numBalls(), vec3(1500 * unit(rng), 1500 * unit(rng), 0));
+        nextLaunch = now + 3;
+      }
+      this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    printf("%8d %10ld %10llu %10ld %10.1f %12d\n", second, mirror.received() - lastReceived,
+      (unsigned long long) (mirror.bytesReceived() - lastBytes), mirror.undecodable(), mirror.renderTick(),
+      mirror.numBallsSunk());
+    fflush(stdout);
+    lastReceived = mirror.received();
+    lastBytes = mirror.bytesReceived();
+  }
+  mirror.disconnect();
+  return mirror.connected() ? 0 : 1;
+}
+
+/**
+ * Runs a server and several mirrors over loopback in one process, taking a
+ * shot every two seconds, and checks that every snapshot a mirror decodes
+ * is exactly the one the server sent, optionally dropping some of them on
+ * the way. Reports the bytes per tick against full snapshots and the tick
+ * jitter.
+ */
+static int netsyncCommand(int argc, char** argv)
+{
+  int numMirrors = 3;
+  double seconds = 6;
+  int sendInterval = 2;
+  float loss = 0;
+  for (int a = 0; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--mirrors") == 0 && a + 1 < argc) numMirrors = std::max(1, atoi(argv[++a]));
+    else if (strcmp(argv[a], "--seconds") == 0 && a + 1 < argc) seconds = atof(argv[++a]);
+    else if (strcmp(argv[a], "--send-every") == 0 && a + 1 < argc) sendInterval = std::max(1, atoi(argv[++a]));
+    else if (strcmp(argv[a], "--loss") == 0 && a + 1 < argc) loss = (float) atof(argv[++a]);
+  }
+
+  poolsim::TableConfig config;
+  config.solver = poolsim::SOLVER_EVENT;
+  poolsim::TableServer server(config, sendInterval);
+  string error;
+  if (!server.open(0, error))
+  {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  vector<unique_ptr<poolsim::TableMirror> > mirrors;
+  for (int m = 0; m < numMirrors; m++)
+  {
+    mirrors.emplace_back(new poolsim::TableMirror());
+    if (!mirrors[m]->connect("127.0.0.1", server.port(), error))
+    {
+      fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+    if (loss > 0) mirrors[m]->simulateLoss(loss, m + 1);
+  }
+
+  mt19937 rng(config.seed);
+  uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  vector<long> mismatches(numMirrors, 0);
+  vector<double> lag(numMirrors, 0);
+  vector<long> lagSamples(numMirrors, 0);
+  double dt = config.fixedDt;
+  auto start = chrono::steady_clock::now();
+  for (long k = 0; k * dt < seconds; k++)
+  {
+    this_thread::sleep_until(start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(k * dt)));
+    server.tick();
+    if (k % 120 == 30 && mirrors[0]->connected())
+    {
+      mirrors[0]->launch(rng() % config.numBalls, vec3(1500 * unit(rng), 1500 * unit(rng), 0));
+    }
+    for (int m = 0; m < numMirrors; m++)
+    {
+      if (mirrors[m]->poll() == 0) continue;
+      const poolsim::NetSnapshot* decoded = mirrors[m]->latest();
+      const poolsim::NetSnapshot* sent = server.sent(decoded->tick);
+      if (!sent || !(*sent == *decoded)) mismatches[m]++;
+      mirrors[m]->interpolate();
+      lag[m] += server.tickCount() - mirrors[m]->renderTick();
+      lagSamples[m]++;
+    }
+  }
+
+  const poolsim::ServerStats& stats = server.stats();
+  printf("ticks       %ld, %ld snapshots, %ld launches\n", stats.ticks, stats.snapshots, stats.launches);
+  printf("bytes/tick  %.1f per mirror, %.1f without deltas\n", (double) stats.bytesSent / stats.ticks / numMirrors,
+    (double) stats.fullBytes / stats.ticks / numMirrors);
+  printf("jitter      %.3f ms mean, %.3f ms max\n", 1e3 * stats.jitterSum / std::max(stats.ticks - 1, 1L),
+    1e3 * stats.maxJitter);
+  printf("\n%8s %10s %12s %12s %12s\n", "mirror", "decoded", "undecodable", "mismatches", "delay ms");
+  bool ok = true;
+  for (int m = 0; m < numMirrors; m++)
+  {
+    printf("%8d %10ld %12ld %12ld %12.1f\n", m, mirrors[m]->received(), mirrors[m]->undecodable(), mismatches[m],
+      1e3 * dt * lag[m] / std::max(lagSamples[m], 1L));
+    ok = ok && mirrors[m]->received() > 0 && mismatches[m] == 0;
+    mirrors[m]->disconnect();
+  }
+  printf("snapshots   %s\n", ok ? "match" : "DIVERGED");
+  return ok ? 0 : 1;
+}
+
+/**
+ * Steps the vectorized environment with random actions, once on the calling
+ * thread and once on the pool, and reports the environment steps per second
+ * of each and whether they saw the same observations and rewards.
+ */
+static int envCommand(int argc, char** argv)
+{
+  poolsim::EnvConfig config;
+  config.numEnvs = 256;
+  int iterations = 200;
+  int threads = 0;
+  for (int a = 0; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--envs") == 0 && a + 1 < argc) config.numEnvs = std::max(1, atoi(argv[++a]));
+    else if (strcmp(argv[a], "--iterations") == 0 && a + 1 < argc) iterations = std::max(1, atoi(argv[++a]));
+    else if (strcmp(argv[a], "--steps-per-action") == 0 && a + 1 < argc) config.stepsPerAction = std::max(0, atoi(argv[++a]));
+    else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) threads = atoi(argv[++a]);
+    else if (strcmp(argv[a], "--seed") == 0 && a + 1 < argc) config.seed = (uint32_t) strtoul(argv[++a], NULL, 10);
+  }
+
+  poolsim::ThreadPool pool(threads);
+  int n = config.numEnvs;
+  printf("%8s %8s %14s %10s %10s %18s\n", "threads", "envs", "env steps/s", "reward", "episodes", "checksum");
+  uint64_t checksums[2];
+  for (int run = 0; run < 2; run++)
+  {
+    poolsim::VecEnv env(config, run == 0 ? nullptr : &pool);
+    vector<float> observations((size_t) n * env.observationSize());
+    vector<float> actions((size_t) n * poolsim::VecEnv::actionSize);
+    vector<float> rewards(n);
+    vector<uint8_t> dones(n);
+    env.reset(observations.data());
+    mt19937 rng(config.seed);
+    uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    double seconds = 0;
+    double reward = 0;
+    long episodes = 0;
+    uint64_t checksum = 0xcbf29ce484222325ull;
+    for (int it = 0; it < iterations; it++)
+    {
+      // a shot every few actions, as an agent that waits for the balls would
+      for (int e = 0; e < n; e++)
+      {
+        float* action = &actions[(size_t) e * poolsim::VecEnv::actionSize];
+        action[0] = it % 8 == 0 ? (float) (rng() % config.table.numBalls) : -1.0f;
+        action[1] = unit(rng);
+        action[2] = unit(rng);
+        action[3] = 0.5f + 0.5f * unit(rng);
+      }
+      auto start = chrono::steady_clock::now();
+      env.step(actions.data(), observations.data(), rewards.data(), dones.data());
+      seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+      for (int e = 0; e < n; e++)
+      {
+        reward += rewards[e];
+        episodes += dones[e] != poolsim::ENV_RUNNING;
+      }
+      // FNV-1a over the raw bytes of what the agent saw
+      const uint8_t* bytes = (const uint8_t*) observations.data();
+      for (size_t b = 0; b < observations.size() * sizeof(float); b++)
+      {
+        checksum = (checksum ^ bytes[b]) * 0x100000001b3ull;
+      }
+    }
+    checksums[run] = checksum;
+    printf("%8d %8d %14.0f %10.0f %10ld   %016llx\n", run == 0 ? 1 : pool.numThreads(), n,
+      (double) n * iterations / seconds, reward, episodes, (unsigned long long) checksum);
+  }
+  bool matched = checksums[0] == checksums[1];
+  printf("threads     %s\n", matched ? "match" : "DIVERGED");
+  return matched ? 0 : 1;
+}
+
+static void usage()
+{
+  printf("usage: poolsim-cli <command> [options]\n\n");
+  printf("commands:\n");
+  printf("  broadphase [--steps N]            pair tests per step for 16 to 100k balls\n");
+  printf("  shots [--shots N] [--speed V] [--model PLY]\n");
+  printf("                                    time to resolve a shot with each solver\n");
+  printf("  batch [--tables N] [--shots N] [--threads N] [--seed S] [--fixed] [--fixed-point]\n");
+  printf("        [--impulse] [--lanes] [--model PLY]\n");
+  printf("                                    simulate independent tables on every core\n");
+  printf("  geometry [--model PLY]            trace the cushions and pockets of a table mesh\n");
+  printf("  record FILE [--shots N] [--seed S] [--interval N] [--fixed] [--fixed-point]\n");
+  printf("              [--impulse] [--model PLY]\n");
+  printf("                                    record a scripted session with a keyframe every N steps\n");
+  printf("  replay FILE [--seek STEP]         replay a recording and check its state hashes\n");
+  printf("  snapshot [--count N]              time table snapshots and check a rollback\n");
+  printf("  opponent [--turns N] [--budget MS] [--candidates N] [--threads N] [--effect NAME]\n");
+  printf("           [--fixed] [--fixed-point] [--impulse] [--model PLY]\n");
+  printf("                                    let the computer opponent play and time its search\n");
+  printf("  contacts [--steps N] [--groups N] [--threads N] [--squeeze D]\n");
+  printf("                                    compare the solvers on packed groups of balls\n");
+  printf("  random [--count N] [--rounds N]   check and time the batch random draws\n");
+  printf("  env [--envs N] [--iterations N] [--steps-per-action N] [--threads N] [--seed S]\n");
+  printf("                                    time the vectorized environment with random actions\n");
+  printf("  serve [--port P] [--seconds S] [--send-every N] [--seed S] [--chaos] [--fixed]\n");
+  printf("        [--fixed-point] [--impulse] [--model PLY]\n");
+  printf("                                    play a table headless for mirrors over UDP\n");
+  printf("  mirror [--host H] [--port P] [--seconds S] [--delay S] [--launch]\n");
+  printf("                                    follow a served table and report what arrives\n");
+  printf("  netsync [--mirrors N] [--seconds S] [--send-every N] [--loss F]\n");
+  printf("                                    check a server and mirrors over loopback\n");
+  printf("\n--fixed steps in floats and --fixed-point in integers, which repeat bit for bit on\n");
+  printf("any machine, and --impulse resolves touching balls together; the default is the\n");
+  printf("event solver\n");
+  printf("--model plays on the cushions and pockets traced from the mesh\n");
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    usage();
+    return 1;
+  }
+  string command = argv[1];
+  if (command == "broadphase") return broadphaseCommand(argc - 2, argv + 2);
+  if (command == "shots") return shotsCommand(argc - 2, argv + 2);
+  if (command == "batch") return batchCommand(argc - 2, argv + 2);
+  if (command == "geometry") return geometryCommand(argc - 2, argv + 2);
+  if (command == "record") return recordCommand(argc - 2, argv + 2);
+  if (command == "replay") return replayCommand(argc - 2, argv + 2);
+  if (command == "snapshot") return snapshotCommand(argc - 2, argv + 2);
+  if (command == "opponent") return opponentCommand(argc - 2, argv + 2);
+  if (command == "contacts") return contactsCommand(argc - 2, argv + 2);
+  if (command == "random") return randomCommand(argc - 2, argv + 2);
+  if (command == "env") return envCommand(argc - 2, argv + 2);
+  if (command == "serve") return serveCommand(argc - 2, argv + 2);
+  if (command == "mirror") return mirrorCommand(argc - 2, argv + 2);
+  if (command == "netsync") return netsyncCommand(argc - 2, argv + 2);
+  usage();
+  return 1;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file poolsim-env.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the C interface to the vectorized environment
+ */
+
+#include "poolsim-env.h"
+#include "poolsim/vecenv.h"
+#include <memory>
+
+struct poolsim_env
+{
+  std::unique_ptr<poolsim::ThreadPool> pool;
+  std::unique_ptr<poolsim::VecEnv> env;
+};
+
+poolsim_env* poolsim_env_create(int num_envs, uint32_t seed, int steps_per_action, int threads)
+{
+  if (num_envs <= 0) return nullptr;
+  poolsim::EnvConfig config;
+  config.numEnvs = num_envs;
+  config.seed = seed;
+  config.stepsPerAction = steps_per_action < 0 ? 0 : steps_per_action;
+  poolsim_env* env = new poolsim_env;
+  if (threads != 1) env->pool.reset(new poolsim::ThreadPool(threads));
+  env->env.reset(new poolsim::VecEnv(config, env->pool.get()));
+  return env;
+}
+
+void poolsim_env_destroy(poolsim_env* env)
+{
+  delete env;
+}
+
+int poolsim_env_num_envs(const poolsim_env* env)
+{
+  return env->env->numEnvs();
+}
+
+int poolsim_env_num_balls(const poolsim_env* env)
+{
+  return env->env->config().table.numBalls;
+}
+
+int poolsim_env_action_size(const poolsim_env*)
+{
+  return poolsim::VecEnv::actionSize;
+}
+
+int poolsim_env_observation_size(const poolsim_env* env)
+{
+  return env->env->observationSize();
+}
+
+void poolsim_env_set_rewards(poolsim_env* env, float pocket, float devour)
+{
+  env->env->setRewards(pocket, devour);
+}
+
+void poolsim_env_reset(poolsim_env* env, float* observations)
+{
+  env->env->reset(observations);
+}
+
+void poolsim_env_step(poolsim_env* env, const float* actions, float* observations, float* rewards, uint8_t* dones)
+{
+  env->env->step(actions, observations, rewards, dones);
+}
@@ -0,0 +1,75 @@
+/**
+ * @file poolsim-env.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief C interface to the vectorized environment, for Python and other
+ * languages that load libpoolsim-env
+ *
+ * Every array is owned by the caller and written in place; see
+ * poolsim::VecEnv for what the actions and observations hold.
+ */
+
+#ifndef POOLSIM_ENV_H_
+#define POOLSIM_ENV_H_
+
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(POOLSIM_ENV_BUILD)
+#define POOLSIM_ENV_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define POOLSIM_ENV_API __declspec(dllimport)
+#else
+#define POOLSIM_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct poolsim_env poolsim_env;
+
+/**
+ * Creates num_envs tables of the default size.
+ *
+ * @param steps_per_action Fixed steps an action lasts, 0 to play each shot
+ *   until the table rests.
+ * @param threads Threads to share the tables over, 0 for one per hardware
+ *   thread, 1 to run on the calling thread alone.
+ * @return NULL if num_envs is not positive.
+ */
+POOLSIM_ENV_API poolsim_env* poolsim_env_create(int num_envs, uint32_t seed, int steps_per_action, int threads);
+POOLSIM_ENV_API void poolsim_env_destroy(poolsim_env* env);
+
+POOLSIM_ENV_API int poolsim_env_num_envs(const poolsim_env* env);
+POOLSIM_ENV_API int poolsim_env_num_balls(const poolsim_env* env);
+POOLSIM_ENV_API int poolsim_env_action_size(const poolsim_env* env);
+POOLSIM_ENV_API int poolsim_env_observation_size(const poolsim_env* env);
+
+/**
+ * Weights of the pocket and devour events in the reward, 1 and 0 unless set.
+ */
+POOLSIM_ENV_API void poolsim_env_set_rewards(poolsim_env* env, float pocket, float devour);
+
+/**
+ * Starts a new episode on every table.
+ *
+ * @param observations num_envs * observation_size floats.
+ */
+POOLSIM_ENV_API void poolsim_env_reset(poolsim_env* env, float* observations);
+
+/**
+ * Plays one action on every table; tables whose episode ends start the next.
+ *
+ * @param actions num_envs * action_size floats.
+ * @param observations num_envs * observation_size floats.
+ * @param rewards num_envs floats.
+ * @param dones num_envs bytes: 0 running, 1 every ball sunk, 2 cut short.
+ */
+POOLSIM_ENV_API void poolsim_env_step(poolsim_env* env, const float* actions, float* observations, float* rewards,
+  uint8_t* dones);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // POOLSIM_ENV_H_
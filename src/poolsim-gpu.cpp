@@ -0,0 +1,179 @@
+/**
+ * @file poolsim-gpu.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Times the compute shader ball physics and checks what it leaves
+ *
+ * Runs a crowd of balls on the GPU in a hidden window, then reads them back
+ * and checks that none is lost, outside the cushions or badly overlapping,
+ * and sets the mean speed and pocketed count beside the same crowd played
+ * by the CPU's fixed steps. Without a GPU, Mesa's llvmpipe runs it:
+ *
+ *   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./poolsim-gpu --balls 16384
+ */
+
+#include "gpuphysics.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+using namespace glm;
+
+/**
+ * Greatest overlap between two balls in play, found by sweeping the balls
+ * sorted along x.
+ */
+static float maxOverlap(const vector<GpuPhysics::Ball>& balls, float sphereRadius)
+{
+  vector<int> order;
+  float maxSize = 0;
+  for (int i = 0; i < (int) balls.size(); i++)
+  {
+    if (balls[i].posSize.w <= 0) continue;
+    order.push_back(i);
+    maxSize = std::max(maxSize, balls[i].posSize.w);
+  }
+  sort(order.begin(), order.end(), [&](int a, int b) { return balls[a].posSize.x < balls[b].posSize.x; });
+  float overlap = 0;
+  for (int a = 0; a < (int) order.size(); a++)
+  {
+    const vec4& p = balls[order[a]].posSize;
+    for (int b = a + 1; b < (int) order.size(); b++)
+    {
+      const vec4& q = balls[order[b]].posSize;
+      if (q.x - p.x > 2 * sphereRadius * maxSize) break;
+      overlap = std::max(overlap, sphereRadius * (p.w + q.w) - distance(vec3(p), vec3(q)));
+    }
+  }
+  return overlap;
+}
+
+int main(int argc, char** argv)
+{
+  int numBalls = 16384;
+  int steps = 120;
+  uint64_t seed = 1;
+  string shaderDir = "../shaders/";
+  for (int a = 1; a < argc; a++)
+  {
+    if (strcmp(argv[a], "--balls") == 0 && a + 1 < argc) numBalls = atoi(argv[++a]);
+    else if (strcmp(argv[a], "--steps") == 0 && a + 1 < argc) steps = atoi(argv[++a]);
+    else if (strcmp(argv[a], "--seed") == 0 && a + 1 < argc) seed = strtoull(argv[++a], nullptr, 10);
+    else if (strcmp(argv[a], "--shaders") == 0 && a + 1 < argc) shaderDir = argv[++a];
+    else
+    {
+      fprintf(stderr, "usage: poolsim-gpu [--balls n] [--steps n] [--seed n] [--shaders dir]\n");
+      return 1;
+    }
+  }
+
+  if (!glfwInit())
+  {
+    fprintf(stderr, "ERROR: Cannot initialize GLFW\n");
+    return 1;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  GLFWwindow* window = glfwCreateWindow(64, 64, "poolsim-gpu", 0, 0);
+  if (!window)
+  {
+    fprintf(stderr, "ERROR: Cannot create an OpenGL 4.3 context\n");
+    glfwTerminate();
+    return 1;
+  }
+  glfwMakeContextCurrent(window);
+#ifndef __APPLE__
+  glewExperimental = GL_TRUE;
+  if (glewInit() != GLEW_OK)
+  {
+    fprintf(stderr, "ERROR: Cannot initialize GLEW\n");
+    return 1;
+  }
+#endif
+  printf("renderer: %s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+  poolsim::TableConfig base;
+  poolsim::Table table = GpuPhysics::crowd(base, numBalls, seed);
+  int failures = 0;
+  {
+    GpuPhysics gpu;
+    if (!gpu.init(table, shaderDir))
+    {
+      fprintf(stderr, "ERROR: This context has no compute shaders\n");
+      return 1;
+    }
+    printf("%d balls of size %.2f, %d cells\n", gpu.numBalls(), table.config().ballDefaultSize, gpu.numCells());
+
+    // one step first, so that the timing leaves out shader and buffer setup
+    gpu.step();
+    glFinish();
+    auto start = chrono::steady_clock::now();
+    gpu.step(steps - 1);
+    glFinish();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("gpu: %d steps in %.3f s, %.1f us/step, %.1f Mballs/s\n", steps, seconds,
+      1e6 * seconds / std::max(steps - 1, 1), 1e-6 * numBalls * std::max(steps - 1, 1) / seconds);
+
+    vector<GpuPhysics::Ball> balls;
+    gpu.read(balls);
+    uint32_t pocketed = gpu.pocketed();
+    const poolsim::TableConfig& config = table.config();
+    vec2 cushions((config.tableLength - 75) / 2.0f, (config.tableWidth - 75) / 2.0f);
+    float radius = config.sphereRadius * config.ballDefaultSize;
+    int sunk = 0;
+    int invalid = 0;
+    int outside = 0;
+    float speed = 0;
+    for (const GpuPhysics::Ball& b : balls)
+    {
+      uint32_t flags;
+      memcpy(&flags, &b.velFlags.w, sizeof(flags));
+      if (flags & GpuPhysics::sunk)
+      {
+        sunk++;
+        continue;
+      }
+      if (any(isnan(b.posSize)) || any(isinf(b.posSize)) || any(isnan(b.velFlags)) || any(isinf(b.velFlags))) invalid++;
+      // a ball may sit past a cushion by what it moves in a step
+      else if (any(greaterThan(abs(vec2(b.posSize)), cushions + radius))) outside++;
+      speed += length(vec3(b.velFlags));
+    }
+    speed /= std::max(numBalls - sunk, 1);
+    float overlap = maxOverlap(balls, config.sphereRadius);
+    printf("gpu: mean speed %.3f, %u pocketed, max overlap %.2f of a radius %.2f\n", speed, pocketed, overlap, radius);
+
+    if (invalid > 0) printf("FAIL: %d balls are not finite\n", invalid);
+    if (outside > 0) printf("FAIL: %d balls are outside the cushions\n", outside);
+    if ((int) pocketed != sunk) printf("FAIL: %u pocketed, but %d balls are flagged sunk\n", pocketed, sunk);
+    if (overlap > radius) printf("FAIL: balls overlap by more than a radius\n");
+    failures = (invalid > 0) + (outside > 0) + ((int) pocketed != sunk) + (overlap > radius);
+  }
+
+  auto start = chrono::steady_clock::now();
+  for (int s = 0; s < steps; s++)
+  {
+    table.step();
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  float speed = 0;
+  int inPlay = 0;
+  for (int i = 0; i < table.numBalls(); i++)
+  {
+    if (!table.balls().isFree(i)) continue;
+    speed += length(table.vel(i));
+    inPlay++;
+  }
+  speed /= std::max(inPlay, 1);
+  printf("cpu: %d steps in %.3f s, %.1f us/step, mean speed %.3f, %d pocketed\n", steps, seconds,
+    1e6 * seconds / std::max(steps, 1), speed, table.numBalls() - inPlay);
+
+  glfwDestroyWindow(window);
+  glfwTerminate();
+  return failures > 0 ? 1 : 0;
+}
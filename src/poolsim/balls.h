@@ -0,0 +1,97 @@
+/**
+ * @file balls.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Structure-of-arrays storage for the balls on a table
+ */
+
+#ifndef POOLSIM_BALLS_H_
+#define POOLSIM_BALLS_H_
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace poolsim {
+
+enum BallFlag : uint32_t
+{
+  // pulled in by a pocket this step, skips collisions, cushions and friction
+  BALL_CAPTURED = 1 << 0,
+  // pocketed and floating up to glorb
+  BALL_SINKING = 1 << 1,
+  // eaten by glorb, off the table for good
+  BALL_DEVOURED = 1 << 2,
+  // at rest until something touches it, skips integration, friction and the
+  // pair loop against other sleeping balls
+  BALL_SLEEPING = 1 << 3,
+};
+
+/**
+ * Every ball property lives in its own contiguous array so that the step
+ * kernels stream through exactly the components they touch. A ball with no
+ * flags but BALL_SLEEPING is free: on the table and subject to every rule,
+ * and awake as well if its flags are zero.
+ */
+struct BallArrays
+{
+  std::vector<int> id;
+  std::vector<float> posX, posY, posZ;
+  std::vector<float> velX, velY, velZ;
+  std::vector<float> rotX, rotY, rotZ;
+  std::vector<float> size;
+  std::vector<uint32_t> flags;
+
+  void resize(int n)
+  {
+    id.resize(n);
+    posX.resize(n); posY.resize(n); posZ.resize(n);
+    velX.resize(n); velY.resize(n); velZ.resize(n);
+    rotX.resize(n); rotY.resize(n); rotZ.resize(n);
+    size.resize(n);
+    flags.resize(n);
+  }
+
+  int count() const { return (int) id.size(); }
+  bool isFree(int i) const { return (flags[i] & ~BALL_SLEEPING) == 0; }
+  bool isAwake(int i) const { return flags[i] == 0; }
+
+  glm::vec3 pos(int i) const { return glm::vec3(posX[i], posY[i], posZ[i]); }
+  glm::vec3 vel(int i) const { return glm::vec3(velX[i], velY[i], velZ[i]); }
+  glm::vec3 rot(int i) const { return glm::vec3(rotX[i], rotY[i], rotZ[i]); }
+
+  void setPos(int i, const glm::vec3& p) { posX[i] = p.x; posY[i] = p.y; posZ[i] = p.z; }
+  void setVel(int i, const glm::vec3& v) { velX[i] = v.x; velY[i] = v.y; velZ[i] = v.z; }
+  void setRot(int i, const glm::vec3& r) { rotX[i] = r.x; rotY[i] = r.y; rotZ[i] = r.z; }
+
+  /**
+  * FNV-1a over the raw bits of the position, velocity, size and flags of
+  * the first n balls, so that any difference at all shows up.
+  */
+  uint64_t hash(int n) const
+  {
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const void* data, size_t bytes) {
+      const unsigned char* p = (const unsigned char*) data;
+      for (size_t b = 0; b < bytes; b++)
+      {
+        h ^= p[b];
+        h *= 1099511628211ull;
+      }
+    };
+    mix(posX.data(), n * sizeof(float));
+    mix(posY.data(), n * sizeof(float));
+    mix(posZ.data(), n * sizeof(float));
+    mix(velX.data(), n * sizeof(float));
+    mix(velY.data(), n * sizeof(float));
+    mix(velZ.data(), n * sizeof(float));
+    mix(size.data(), n * sizeof(float));
+    mix(flags.data(), n * sizeof(uint32_t));
+    return h;
+  }
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_BALLS_H_
@@ -0,0 +1,113 @@
+/**
+ * @file batch.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the multi-table batch runner
+ */
+
+#include "poolsim/batch.h"
+#include "poolsim/fixedpoint.h"
+#include "poolsim/lanes.h"
+#include <glm/gtc/constants.hpp>
+#include <cmath>
+
+using namespace std;
+using namespace glm;
+
+namespace poolsim {
+
+uint32_t tableSeed(uint32_t batchSeed, int index)
+{
+  uint64_t z = ((uint64_t) batchSeed << 32) + (uint64_t) index + 0x9e3779b97f4a7c15ull;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return (uint32_t) (z ^ (z >> 31));
+}
+
+BatchRunner::BatchRunner(const BatchConfig& config, ThreadPool& pool) :
+  _config(config), _pool(pool), _tables(pool.numThreads(), Table(config.table))
+{
+}
+
+void BatchRunner::run(vector<TableResult>& results)
+{
+  results.resize(_config.numTables);
+  // the lanes only know the rectangular cushions, so traced tables run one
+  // at a time
+  if (_config.lanes && !_config.table.geometry)
+  {
+    vector<LaneRunner> runners(_pool.numThreads(), LaneRunner(_config));
+    int width = runners[0].width();
+    int blocks = (_config.numTables + width - 1) / width;
+    _pool.parallelFor(blocks, [&](int block, int thread) {
+      runners[thread].runBlock(block * width, &results[block * width]);
+    });
+    return;
+  }
+  _pool.parallelFor(_config.numTables, [&](int index, int thread) {
+    results[index] = runTable(index, thread);
+  });
+}
+
+/**
+ * Launch velocity of a shot from two draws of its generator. Fixed-point
+ * tables take it from integers, since the library sine and a fused multiply
+ * and add would make it differ between machines.
+ */
+static vec3 shotVel(const BatchConfig& config, bool fixedPoint, uint32_t angleDraw, uint32_t speedDraw)
+{
+  if (fixedPoint)
+  {
+    // the top 24 bits, so that the products fit in 64 bits
+    int64_t range = Pcg32::max() >> 8;
+    fixed angle = (fixed) (fx::twoPi * (int64_t) (angleDraw >> 8) / range);
+    fixed minSpeed = fx::fromFloat(config.minSpeed);
+    fixed speed = minSpeed + (fixed) ((fx::fromFloat(config.maxSpeed) - minSpeed) * (int64_t) (speedDraw >> 8) / range);
+    return vec3(fx::toFloat(fx::mul(speed, fx::cos(angle))), fx::toFloat(fx::mul(speed, fx::sin(angle))), 0);
+  }
+  float angle = two_pi<float>() * (angleDraw / (float) Pcg32::max());
+  float speed = mix(config.minSpeed, config.maxSpeed, speedDraw / (float) Pcg32::max());
+  return speed * vec3(cos(angle), sin(angle), 0);
+}
+
+TableResult BatchRunner::runTable(int index, int thread)
+{
+  Table& table = _tables[thread];
+  TableResult result;
+  result.seed = tableSeed(_config.seed, index);
+  table.reset(result.seed);
+
+  // the shots draw from their own stream of the table's seed so that they
+  // do not shift the chaos effects' random choices
+  Pcg32 rng(result.seed, shotStream);
+  result.chaosEffect = rng() % NUM_CHAOS_EFFECTS;
+  table.setChaosEffect((ChaosEffect) result.chaosEffect);
+
+  int n = table.numBalls();
+  for (int s = 0; s < _config.shotsPerTable; s++)
+  {
+    // the first ball still in play from a random starting point
+    int start = rng() % n;
+    int ball = -1;
+    for (int k = 0; k < n && ball < 0; k++)
+    {
+      if (table.balls().isFree((start + k) % n)) ball = (start + k) % n;
+    }
+    if (ball < 0) break;
+    uint32_t angleDraw = rng();
+    uint32_t speedDraw = rng();
+    vec3 vel = shotVel(_config, table.config().solver == SOLVER_FIXED_POINT, angleDraw, speedDraw);
+
+    table.clearEvents();
+    table.launch(ball, vel);
+    result.simulatedTime += table.settle(_config.maxShotTime);
+    result.shots++;
+    result.pocketed += table.events().pocketed;
+    result.collisions += table.events().collisions;
+    result.boundaryHits += table.events().boundaryHits;
+  }
+  result.stateHash = table.stateHash();
+  return result;
+}
+
+}  // namespace poolsim
@@ -0,0 +1,97 @@
+/**
+ * @file batch.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Simulates many independent tables across all cores
+ */
+
+#ifndef POOLSIM_BATCH_H_
+#define POOLSIM_BATCH_H_
+
+#include "poolsim/table.h"
+#include "poolsim/threadpool.h"
+#include <cstdint>
+#include <vector>
+
+namespace poolsim {
+
+struct BatchConfig
+{
+  int numTables = 1000;
+  int shotsPerTable = 1;
+  // every table's seed, chaos effect and shots follow from this seed and the
+  // table's index alone
+  uint32_t seed = 1;
+  float minSpeed = 200.0f;
+  float maxSpeed = 3000.0f;
+  // longest a shot may run before the next one is taken anyway
+  float maxShotTime = 60.0f;
+  // play the tables a lane block at a time with the widest lane kernel (see
+  // lanes.h) instead of one per table; only the fixed-step solver has lanes,
+  // and tables with traced geometry always run one at a time
+  bool lanes = false;
+  TableConfig table;
+};
+
+/**
+ * What became of one table.
+ */
+struct TableResult
+{
+  uint32_t seed = 0;
+  int chaosEffect = 0;
+  int shots = 0;
+  int pocketed = 0;
+  int collisions = 0;
+  int boundaryHits = 0;
+  float simulatedTime = 0.0f;
+  uint64_t stateHash = 0;
+};
+
+/**
+ * Plays shots on many independent tables. Each table gets its own seed,
+ * one of the chaos effects and a run of random shots, each played until the
+ * table is at rest. Tables are shared out over a ThreadPool, and every
+ * thread reuses a single Table, so a run allocates nothing once the results
+ * are sized. Since a table's outcome depends only on its index, the results
+ * are the same whatever the number of threads.
+ */
+class BatchRunner
+{
+public:
+    BatchRunner(const BatchConfig& config, ThreadPool& pool);
+
+    /**
+    * Simulates every table.
+    *
+    * @param results Filled with one result per table, in table order.
+    */
+    void run(std::vector<TableResult>& results);
+
+    /**
+    * Simulates the table with the given index on the given thread's table.
+    */
+    TableResult runTable(int index, int thread);
+
+    const BatchConfig& config() const { return _config; }
+
+private:
+    BatchConfig _config;
+    ThreadPool& _pool;
+    std::vector<Table> _tables;
+};
+
+/**
+ * Seed of the table with the given index, a splitmix64 scramble of both.
+ */
+uint32_t tableSeed(uint32_t batchSeed, int index);
+
+/**
+ * Stream of a table's seed that the batch shots draw from. The table draws
+ * its chaos from stream 0.
+ */
+static const uint64_t shotStream = 1;
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_BATCH_H_
@@ -0,0 +1,109 @@
+/**
+ * @file bits.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Bit-packed writer and reader for network snapshots
+ */
+
+#ifndef POOLSIM_BITS_H_
+#define POOLSIM_BITS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace poolsim {
+
+/**
+ * Appends fields of any width up to 32 bits to a byte vector, lowest bit
+ * first, so that a snapshot spends a single bit on a ball that did not
+ * move. The last byte is padded with zeros.
+ */
+class BitWriter
+{
+public:
+    BitWriter(std::vector<uint8_t>& bytes) : _bytes(bytes) {}
+
+    void bits(uint32_t v, int count)
+    {
+      for (int b = 0; b < count; b++)
+      {
+        if (_used == 0) _bytes.push_back(0);
+        if ((v >> b) & 1) _bytes.back() |= (uint8_t) (1 << _used);
+        _used = (_used + 1) & 7;
+      }
+    }
+
+    void bit(bool v) { bits(v ? 1 : 0, 1); }
+
+    /**
+    * Writes a signed value in the smallest of four widths that holds it,
+    * zigzag encoded after a two bit width code, so that the small changes
+    * between snapshots take a few bits and a jump still fits.
+    */
+    void signedBits(int32_t v)
+    {
+      uint32_t z = ((uint32_t) v << 1) ^ (uint32_t) (v >> 31);
+      int code = 0;
+      while (code < 3 && z >= (1u << width(code))) code++;
+      bits(code, 2);
+      bits(z, width(code));
+    }
+
+    static int width(int code)
+    {
+      static const int widths[4] = {4, 9, 15, 32};
+      return widths[code];
+    }
+
+private:
+    std::vector<uint8_t>& _bytes;
+    // bits used in the last byte
+    int _used = 0;
+};
+
+/**
+ * Reads back what a BitWriter wrote. Reading past the end clears ok() and
+ * returns zeros from then on, as ByteReader does.
+ */
+class BitReader
+{
+public:
+    BitReader(const uint8_t* data, size_t size) : _data(data), _size(size) {}
+
+    bool ok() const { return _ok; }
+
+    uint32_t bits(int count)
+    {
+      if (_pos + count > 8 * _size)
+      {
+        _ok = false;
+        _pos = 8 * _size;
+        return 0;
+      }
+      uint32_t v = 0;
+      for (int b = 0; b < count; b++, _pos++)
+      {
+        v |= (uint32_t) ((_data[_pos >> 3] >> (_pos & 7)) & 1) << b;
+      }
+      return v;
+    }
+
+    bool bit() { return bits(1) != 0; }
+
+    int32_t signedBits()
+    {
+      uint32_t z = bits(BitWriter::width(bits(2)));
+      return (int32_t) (z >> 1) ^ -(int32_t) (z & 1);
+    }
+
+private:
+    const uint8_t* _data;
+    size_t _size;
+    size_t _pos = 0;
+    bool _ok = true;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_BITS_H_
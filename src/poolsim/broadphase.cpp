@@ -0,0 +1,143 @@
+/**
+ * @file broadphase.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the uniform grid broadphase
+ */
+
+#include "poolsim/broadphase.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace poolsim {
+
+void Broadphase::configure(float tableLength, float tableWidth, float cellSize, int numBalls)
+{
+  _cellSize = cellSize;
+  _numCellsX = max(1, (int) ceil(tableLength / cellSize));
+  _numCellsY = max(1, (int) ceil(tableWidth / cellSize));
+  _originX = -0.5f * _numCellsX * cellSize;
+  _originY = -0.5f * _numCellsY * cellSize;
+  _cellHeads.assign(_numCellsX * _numCellsY, -1);
+  _entries.clear();
+  _freeEntries = -1;
+  _ranges.assign(numBalls, CellRange());
+  _inGrid.assign(numBalls, false);
+  _pairs.clear();
+}
+
+Broadphase::CellRange Broadphase::footprint(float x, float y, float radius) const
+{
+  // balls pushed past the cushions land in the edge cells
+  CellRange r;
+  r.x0 = (int) floor((x - radius - _originX) / _cellSize);
+  r.y0 = (int) floor((y - radius - _originY) / _cellSize);
+  r.x1 = (int) floor((x + radius - _originX) / _cellSize);
+  r.y1 = (int) floor((y + radius - _originY) / _cellSize);
+  r.x0 = min(max(r.x0, 0), _numCellsX - 1);
+  r.y0 = min(max(r.y0, 0), _numCellsY - 1);
+  r.x1 = min(max(r.x1, 0), _numCellsX - 1);
+  r.y1 = min(max(r.y1, 0), _numCellsY - 1);
+  return r;
+}
+
+void Broadphase::insert(int i, const CellRange& r)
+{
+  for (int y = r.y0; y <= r.y1; y++)
+  {
+    for (int x = r.x0; x <= r.x1; x++)
+    {
+      int e = _freeEntries;
+      if (e >= 0) _freeEntries = _entries[e].next;
+      else
+      {
+        e = (int) _entries.size();
+        _entries.push_back(Entry());
+      }
+      int& head = _cellHeads[y * _numCellsX + x];
+      _entries[e].ball = i;
+      _entries[e].x0 = r.x0;
+      _entries[e].y0 = r.y0;
+      _entries[e].next = head;
+      head = e;
+    }
+  }
+}
+
+void Broadphase::remove(int i, const CellRange& r)
+{
+  for (int y = r.y0; y <= r.y1; y++)
+  {
+    for (int x = r.x0; x <= r.x1; x++)
+    {
+      int* link = &_cellHeads[y * _numCellsX + x];
+      while (_entries[*link].ball != i) link = &_entries[*link].next;
+      int e = *link;
+      *link = _entries[e].next;
+      _entries[e].next = _freeEntries;
+      _freeEntries = e;
+    }
+  }
+}
+
+void Broadphase::update(const BallArrays& balls, float sphereRadius, const float* margins)
+{
+  int n = (int) _ranges.size();
+  for (int i = 0; i < n; i++)
+  {
+    bool tracked = (balls.flags[i] & (BALL_SINKING | BALL_DEVOURED)) == 0;
+    if (!tracked)
+    {
+      if (_inGrid[i]) remove(i, _ranges[i]);
+      _inGrid[i] = false;
+      continue;
+    }
+
+    float radius = sphereRadius * balls.size[i];
+    if (margins != nullptr) radius += margins[i];
+    CellRange r = footprint(balls.posX[i], balls.posY[i], radius);
+    if (_inGrid[i])
+    {
+      const CellRange& old = _ranges[i];
+      if (r.x0 == old.x0 && r.y0 == old.y0 && r.x1 == old.x1 && r.y1 == old.y1) continue;
+      remove(i, old);
+    }
+    insert(i, r);
+    _ranges[i] = r;
+    _inGrid[i] = true;
+  }
+}
+
+const vector<pair<int, int> >& Broadphase::pairs()
+{
+  _pairs.clear();
+  int n = (int) _ranges.size();
+  for (int i = 0; i < n; i++)
+  {
+    if (!_inGrid[i]) continue;
+    const CellRange& a = _ranges[i];
+    size_t first = _pairs.size();
+    for (int y = a.y0; y <= a.y1; y++)
+    {
+      for (int x = a.x0; x <= a.x1; x++)
+      {
+        for (int e = _cellHeads[y * _numCellsX + x]; e >= 0; e = _entries[e].next)
+        {
+          const Entry& b = _entries[e];
+          if (b.ball <= i) continue;
+          // balls sharing several cells are reported from the first one only
+          if (x != max(a.x0, b.x0) || y != max(a.y0, b.y0)) continue;
+          _pairs.push_back(make_pair(i, b.ball));
+        }
+      }
+    }
+    // the order within a cell depends on the order balls entered it, so
+    // sort to make the pairs depend only on where the balls are now
+    sort(_pairs.begin() + first, _pairs.end());
+  }
+  return _pairs;
+}
+
+}  // namespace poolsim
@@ -0,0 +1,94 @@
+/**
+ * @file broadphase.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Uniform grid over the table that finds ball pairs worth testing
+ */
+
+#ifndef POOLSIM_BROADPHASE_H_
+#define POOLSIM_BROADPHASE_H_
+
+#include "poolsim/balls.h"
+#include <utility>
+#include <vector>
+
+namespace poolsim {
+
+/**
+ * Buckets balls into square cells one default ball across, covering the
+ * table. A ball is listed in every cell its footprint touches, so resized
+ * balls simply span more cells. Balls only move between cells when their
+ * footprint changes, which for most balls in most steps it does not.
+ *
+ * Each cell is a singly linked list threaded through one shared pool of
+ * entries, so the grid is two flat arrays no matter how many cells it has.
+ */
+class Broadphase
+{
+public:
+    /**
+    * Sizes the grid for a table and forgets all balls.
+    *
+    * @param tableLength The extent of the table along x, centered on 0.
+    * @param tableWidth The extent of the table along y, centered on 0.
+    * @param cellSize The side of a cell, normally one default ball diameter.
+    * @param numBalls The number of balls that will be tracked.
+    */
+    void configure(float tableLength, float tableWidth, float cellSize, int numBalls);
+
+    /**
+    * Moves each ball to the cells under its current footprint. Sinking and
+    * devoured balls are taken out of the grid.
+    *
+    * @param balls The balls to track.
+    * @param sphereRadius The radius of a ball of size 1.
+    * @param margins How much further each ball reaches than its radius, or
+    *        null for none.
+    */
+    void update(const BallArrays& balls, float sphereRadius, const float* margins = nullptr);
+
+    /**
+    * Lists each pair (i, j) with i < j that shares at least one cell, once,
+    * ordered by i and then j. The list is reused between calls.
+    */
+    const std::vector<std::pair<int, int> >& pairs();
+
+    int numCellsX() const { return _numCellsX; }
+    int numCellsY() const { return _numCellsY; }
+
+private:
+    struct CellRange
+    {
+        int x0, y0, x1, y1;
+    };
+
+    // one ball listed in one cell, carrying the corner of the ball's range
+    // so that pairs() need not look the other ball up
+    struct Entry
+    {
+        int ball;
+        int x0, y0;
+        int next;
+    };
+
+    CellRange footprint(float x, float y, float radius) const;
+    void insert(int i, const CellRange& r);
+    void remove(int i, const CellRange& r);
+
+    float _cellSize = 1.0f;
+    float _originX = 0.0f;
+    float _originY = 0.0f;
+    int _numCellsX = 0;
+    int _numCellsY = 0;
+
+    std::vector<int> _cellHeads;
+    std::vector<Entry> _entries;
+    int _freeEntries = -1;
+    std::vector<CellRange> _ranges;
+    std::vector<bool> _inGrid;
+    std::vector<std::pair<int, int> > _pairs;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_BROADPHASE_H_
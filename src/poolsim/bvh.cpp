@@ -0,0 +1,123 @@
+/**
+ * @file bvh.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the triangle bounding volume hierarchy
+ */
+
+#include "poolsim/bvh.h"
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+using namespace glm;
+
+namespace poolsim {
+
+// triangles per leaf
+static const int leafSize = 4;
+
+void TriangleBVH::build(const vector<vec3>& vertices, const vector<uint32_t>& indices)
+{
+  _vertices = vertices;
+  _indices = indices;
+  int numTriangles = (int) indices.size() / 3;
+  _triangles.resize(numTriangles);
+  _centroids.resize(numTriangles);
+  for (int t = 0; t < numTriangles; t++)
+  {
+    _triangles[t] = t;
+    _centroids[t] = (vertices[indices[3 * t]] + vertices[indices[3 * t + 1]] + vertices[indices[3 * t + 2]]) / 3.0f;
+  }
+  _nodes.clear();
+  _nodes.reserve(2 * numTriangles / leafSize + 1);
+  if (numTriangles > 0) buildNode(0, numTriangles);
+}
+
+int TriangleBVH::buildNode(int first, int count)
+{
+  Node node;
+  node.min = vec3(numeric_limits<float>::max());
+  node.max = -node.min;
+  for (int k = first; k < first + count; k++)
+  {
+    int t = _triangles[k];
+    for (int v = 0; v < 3; v++)
+    {
+      node.min = glm::min(node.min, _vertices[_indices[3 * t + v]]);
+      node.max = glm::max(node.max, _vertices[_indices[3 * t + v]]);
+    }
+  }
+  int index = (int) _nodes.size();
+  _nodes.push_back(node);
+  if (count <= leafSize)
+  {
+    _nodes[index].first = first;
+    _nodes[index].count = count;
+    _nodes[index].leaf = true;
+    return index;
+  }
+
+  vec3 extent = node.max - node.min;
+  int axis = 0;
+  if (extent.y > extent[axis]) axis = 1;
+  if (extent.z > extent[axis]) axis = 2;
+  int half = count / 2;
+  nth_element(_triangles.begin() + first, _triangles.begin() + first + half, _triangles.begin() + first + count,
+    [&](int a, int b) { return _centroids[a][axis] < _centroids[b][axis]; });
+
+  // the left child always directly follows its parent
+  buildNode(first, half);
+  int right = buildNode(first + half, count - half);
+  _nodes[index].first = right;
+  _nodes[index].count = 0;
+  _nodes[index].leaf = false;
+  return index;
+}
+
+int TriangleBVH::slice(float z, vector<vec2>& segments) const
+{
+  segments.clear();
+  if (_nodes.empty()) return 0;
+  int tested = 0;
+  int stack[64];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0)
+  {
+    const Node& node = _nodes[stack[--top]];
+    if (z < node.min.z || z > node.max.z) continue;
+    if (!node.leaf)
+    {
+      stack[top++] = node.first;
+      stack[top++] = &node - &_nodes[0] + 1;
+      continue;
+    }
+    for (int k = node.first; k < node.first + node.count; k++)
+    {
+      int t = _triangles[k];
+      tested++;
+      vec3 p[3];
+      for (int v = 0; v < 3; v++) p[v] = _vertices[_indices[3 * t + v]];
+      vec2 cut[2];
+      int numCut = 0;
+      for (int e = 0; e < 3; e++)
+      {
+        const vec3& a = p[e];
+        const vec3& b = p[(e + 1) % 3];
+        // half-open, so that a vertex exactly on the plane is counted once
+        if ((a.z < z) == (b.z < z)) continue;
+        float u = (z - a.z) / (b.z - a.z);
+        if (numCut < 2) cut[numCut++] = vec2(mix(a, b, u));
+      }
+      if (numCut == 2 && cut[0] != cut[1])
+      {
+        segments.push_back(cut[0]);
+        segments.push_back(cut[1]);
+      }
+    }
+  }
+  return tested;
+}
+
+}  // namespace poolsim
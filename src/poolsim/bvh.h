@@ -0,0 +1,67 @@
+/**
+ * @file bvh.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Bounding volume hierarchy over the triangles of a mesh
+ */
+
+#ifndef POOLSIM_BVH_H_
+#define POOLSIM_BVH_H_
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace poolsim {
+
+/**
+ * Binary tree of axis-aligned boxes over a triangle mesh, split at the
+ * median of the longest axis until a leaf holds a few triangles. Queries
+ * only visit the boxes they touch, so cutting the table mesh at one height
+ * looks at a small fraction of its triangles.
+ */
+class TriangleBVH
+{
+public:
+    /**
+    * Builds the tree, replacing any earlier one.
+    *
+    * @param vertices Vertex positions.
+    * @param indices Three vertex indices per triangle.
+    */
+    void build(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices);
+
+    /**
+    * Cuts the mesh with the plane at height z.
+    *
+    * @param z The height of the plane.
+    * @param segments Filled with the start and end point of every piece of
+    *   a triangle that lies in the plane, two entries per piece.
+    * @return The number of triangles tested.
+    */
+    int slice(float z, std::vector<glm::vec2>& segments) const;
+
+    int numTriangles() const { return (int) _triangles.size(); }
+    int numNodes() const { return (int) _nodes.size(); }
+
+private:
+    struct Node
+    {
+        glm::vec3 min, max;
+        // children for an inner node, a range of _triangles for a leaf
+        int first, count;
+        bool leaf;
+    };
+
+    int buildNode(int first, int count);
+
+    std::vector<glm::vec3> _vertices;
+    std::vector<uint32_t> _indices;
+    std::vector<int> _triangles;
+    std::vector<glm::vec3> _centroids;
+    std::vector<Node> _nodes;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_BVH_H_
@@ -0,0 +1,170 @@
+/**
+ * @file bytes.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Little byte writer and reader for compact binary logs
+ */
+
+#ifndef POOLSIM_BYTES_H_
+#define POOLSIM_BYTES_H_
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace poolsim {
+
+/**
+ * Appends to a byte vector. Integers are LEB128 varints, so the small step
+ * counts and indices that fill an input log take a byte each; floats keep
+ * their raw bits so that a replay sees exactly the values that were played.
+ */
+class ByteWriter
+{
+public:
+    ByteWriter(std::vector<uint8_t>& bytes) : _bytes(bytes) {}
+
+    void u8(uint8_t v) { _bytes.push_back(v); }
+
+    void varint(uint64_t v)
+    {
+      while (v >= 0x80)
+      {
+        _bytes.push_back((uint8_t) (v | 0x80));
+        v >>= 7;
+      }
+      _bytes.push_back((uint8_t) v);
+    }
+
+    /**
+    * Zigzag encodes so that small negative numbers stay short too.
+    */
+    void svarint(int64_t v) { varint(((uint64_t) v << 1) ^ (uint64_t) (v >> 63)); }
+
+    void f32(float v) { raw(&v, sizeof(v)); }
+    void vec3(const glm::vec3& v) { f32(v.x); f32(v.y); f32(v.z); }
+    void u64(uint64_t v) { raw(&v, sizeof(v)); }
+
+    void str(const std::string& s)
+    {
+      varint(s.size());
+      raw(s.data(), s.size());
+    }
+
+    void raw(const void* data, size_t size)
+    {
+      const uint8_t* p = (const uint8_t*) data;
+      _bytes.insert(_bytes.end(), p, p + size);
+    }
+
+    size_t size() const { return _bytes.size(); }
+
+private:
+    std::vector<uint8_t>& _bytes;
+};
+
+/**
+ * Reads back what a ByteWriter wrote. Reading past the end or a malformed
+ * varint clears ok() and returns zeros from then on, so a caller can read a
+ * whole record and check once.
+ */
+class ByteReader
+{
+public:
+    ByteReader(const uint8_t* data, size_t size) : _p(data), _end(data + size) {}
+    ByteReader(const std::vector<uint8_t>& bytes) : ByteReader(bytes.data(), bytes.size()) {}
+
+    bool ok() const { return _ok; }
+    bool atEnd() const { return _p == _end; }
+    const uint8_t* pos() const { return _p; }
+
+    uint8_t u8()
+    {
+      uint8_t v = 0;
+      raw(&v, 1);
+      return v;
+    }
+
+    uint64_t varint()
+    {
+      uint64_t v = 0;
+      for (int shift = 0; shift < 64; shift += 7)
+      {
+        if (_p == _end) break;
+        uint8_t b = *_p++;
+        v |= (uint64_t) (b & 0x7f) << shift;
+        if ((b & 0x80) == 0) return v;
+      }
+      _ok = false;
+      _p = _end;
+      return 0;
+    }
+
+    int64_t svarint()
+    {
+      uint64_t v = varint();
+      return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+    }
+
+    float f32()
+    {
+      float v = 0;
+      raw(&v, sizeof(v));
+      return v;
+    }
+
+    glm::vec3 vec3()
+    {
+      float x = f32();
+      float y = f32();
+      float z = f32();
+      return glm::vec3(x, y, z);
+    }
+
+    uint64_t u64()
+    {
+      uint64_t v = 0;
+      raw(&v, sizeof(v));
+      return v;
+    }
+
+    std::string str()
+    {
+      size_t size = (size_t) varint();
+      if (size > (size_t) (_end - _p)) fail();
+      if (!_ok) return std::string();
+      std::string s((const char*) _p, size);
+      _p += size;
+      return s;
+    }
+
+    void raw(void* data, size_t size)
+    {
+      if (!_ok || size > (size_t) (_end - _p))
+      {
+        fail();
+        memset(data, 0, size);
+        return;
+      }
+      memcpy(data, _p, size);
+      _p += size;
+    }
+
+private:
+    void fail()
+    {
+      _ok = false;
+      _p = _end;
+    }
+
+    const uint8_t* _p;
+    const uint8_t* _end;
+    bool _ok = true;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_BYTES_H_
@@ -0,0 +1,222 @@
+/**
+ * @file chaos.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Registry of the chaos effects and the hooks through which they act
+ */
+
+#ifndef POOLSIM_CHAOS_H_
+#define POOLSIM_CHAOS_H_
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+namespace poolsim {
+
+class Table;
+
+enum ChaosEffect
+{
+  CHAOS_PLAIN_JANE,
+  CHAOS_STICKY_SITUATION,
+  CHAOS_HOVER_HAVOC,
+  CHAOS_BIGGIE_SMALLS,
+  CHAOS_FRICTION_AFFLICTION,
+  CHAOS_TILT_A_TABLE,
+  CHAOS_GET_GASLIT,
+  NUM_CHAOS_EFFECTS
+};
+
+/**
+ * A set of chaos effects, with bit e set if effect e is in it.
+ */
+typedef uint32_t ChaosSet;
+
+constexpr ChaosSet chaosBit(ChaosEffect effect)
+{
+  return 1u << effect;
+}
+
+// velocity kept by a rolling ball each step
+static const float tableFriction = 0.95f;
+
+/**
+ * Hooks an effect that changes nothing has, which every effect inherits
+ * and hides the ones it needs.
+ */
+struct NoChaosHooks
+{
+    /**
+    * Runs when the effect starts and when it ends.
+    */
+    static void onActivate(Table&) {}
+    static void onDeactivate(Table&) {}
+
+    /**
+    * Runs on the velocity of every ball on the table each step, before
+    * friction. tilt is the x speed a tilted table adds, in the same units.
+    */
+    static const bool stepsBalls = false;
+    template <typename T>
+    static void step(T& /*velX*/, T& /*velY*/, T /*tilt*/) {}
+
+    /**
+    * Friction factor of a step, given the factor without this effect.
+    */
+    static float friction(float factor) { return factor; }
+
+    /**
+    * Runs on the velocity of a ball that just bounced off a cushion.
+    */
+    template <typename T>
+    static void onBoundary(T& /*velX*/, T& /*velY*/) {}
+
+    /**
+    * Runs on the velocity a ball is launched with.
+    */
+    static glm::vec3 onLaunch(const glm::vec3& vel) { return vel; }
+};
+
+/**
+ * What chaos effect E does. The hooks are static and inline, so that a step
+ * compiled for a set of effects, see ChaosRules, holds only the hooks of
+ * the effects in it.
+ */
+template <ChaosEffect E>
+struct ChaosHooks : NoChaosHooks {};
+
+template <>
+struct ChaosHooks<CHAOS_STICKY_SITUATION> : NoChaosHooks
+{
+    template <typename T>
+    static void onBoundary(T& velX, T& velY)
+    {
+      velX = 0;
+      velY = 0;
+    }
+};
+
+template <>
+struct ChaosHooks<CHAOS_HOVER_HAVOC> : NoChaosHooks
+{
+    static void onActivate(Table& table);
+    static void onDeactivate(Table& table);
+};
+
+template <>
+struct ChaosHooks<CHAOS_BIGGIE_SMALLS> : NoChaosHooks
+{
+    static void onActivate(Table& table);
+    static void onDeactivate(Table& table);
+};
+
+template <>
+struct ChaosHooks<CHAOS_FRICTION_AFFLICTION> : NoChaosHooks
+{
+    static float friction(float) { return 0.75f; }
+};
+
+template <>
+struct ChaosHooks<CHAOS_TILT_A_TABLE> : NoChaosHooks
+{
+    static void onActivate(Table& table);
+
+    static const bool stepsBalls = true;
+    template <typename T>
+    static void step(T& velX, T& /*velY*/, T tilt)
+    {
+      velX += tilt;
+    }
+};
+
+template <>
+struct ChaosHooks<CHAOS_GET_GASLIT> : NoChaosHooks
+{
+    static glm::vec3 onLaunch(const glm::vec3& vel) { return glm::vec3(vel.x, -vel.y, vel.z); }
+};
+
+/**
+ * The step hooks of every effect in Active, applied in effect order. Active
+ * is a template argument, so the tests of whether each effect is in it are
+ * constants and the hooks of the others compile away.
+ */
+template <ChaosSet Active, int E = 0>
+struct ChaosRules
+{
+    typedef ChaosHooks<(ChaosEffect) E> Hooks;
+    typedef ChaosRules<Active, E + 1> Next;
+    static const bool active = ((Active >> E) & 1) != 0;
+    static const bool stepsBalls = (active && Hooks::stepsBalls) || Next::stepsBalls;
+
+    template <typename T>
+    static void step(T& velX, T& velY, T tilt)
+    {
+      if (active) Hooks::step(velX, velY, tilt);
+      Next::step(velX, velY, tilt);
+    }
+
+    static float friction(float factor = tableFriction)
+    {
+      return Next::friction(active ? Hooks::friction(factor) : factor);
+    }
+
+    template <typename T>
+    static void onBoundary(T& velX, T& velY)
+    {
+      if (active) Hooks::onBoundary(velX, velY);
+      Next::onBoundary(velX, velY);
+    }
+};
+
+template <ChaosSet Active>
+struct ChaosRules<Active, NUM_CHAOS_EFFECTS>
+{
+    static const bool stepsBalls = false;
+    template <typename T>
+    static void step(T&, T&, T) {}
+    static float friction(float factor = tableFriction) { return factor; }
+    template <typename T>
+    static void onBoundary(T&, T&) {}
+};
+
+/**
+ * Friction factor of a step with the given effects, for solvers that look
+ * it up once instead of compiling it in.
+ */
+template <int E = 0>
+inline float chaosFriction(ChaosSet active, float factor = tableFriction)
+{
+  bool on = ((active >> E) & 1) != 0;
+  return chaosFriction<E + 1>(active, on ? ChaosHooks<(ChaosEffect) E>::friction(factor) : factor);
+}
+
+template <>
+inline float chaosFriction<NUM_CHAOS_EFFECTS>(ChaosSet, float factor)
+{
+  return factor;
+}
+
+/**
+ * The effects that change the rules of a step. A solver compiles its step
+ * once for each combination of them, numStepVariants in all, and picks the
+ * one for the active effects with stepVariant.
+ */
+static const int numStepVariants = 8;
+
+constexpr ChaosSet stepVariantSet(int variant)
+{
+  return ((variant & 1) ? chaosBit(CHAOS_STICKY_SITUATION) : 0)
+    | ((variant & 2) ? chaosBit(CHAOS_FRICTION_AFFLICTION) : 0)
+    | ((variant & 4) ? chaosBit(CHAOS_TILT_A_TABLE) : 0);
+}
+
+inline int stepVariant(ChaosSet active)
+{
+  return ((active & chaosBit(CHAOS_STICKY_SITUATION)) ? 1 : 0)
+    | ((active & chaosBit(CHAOS_FRICTION_AFFLICTION)) ? 2 : 0)
+    | ((active & chaosBit(CHAOS_TILT_A_TABLE)) ? 4 : 0);
+}
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_CHAOS_H_
@@ -0,0 +1,260 @@
+/**
+ * @file contactsolver.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the sequential-impulse contact solver
+ */
+
+#include "poolsim/contactsolver.h"
+#include "poolsim/table.h"
+#include "poolsim/threadpool.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace poolsim {
+
+constexpr float ContactSolver::slop;
+constexpr float ContactSolver::correction;
+
+void ContactSolver::resize(int n)
+{
+  _cacheOther.assign(n * cacheSlots, -1);
+  _cacheImpulse.assign(n * cacheSlots, 0.0f);
+  _contacts.clear();
+}
+
+int ContactSolver::arrays(void** data, size_t* bytes) const
+{
+  data[0] = (void*) _cacheOther.data();
+  bytes[0] = _cacheOther.size() * sizeof(int);
+  data[1] = (void*) _cacheImpulse.data();
+  bytes[1] = _cacheImpulse.size() * sizeof(float);
+  return numArrays;
+}
+
+int ContactSolver::find(int ball)
+{
+  while (_parent[ball] != ball)
+  {
+    // halve the path on the way up
+    _parent[ball] = _parent[_parent[ball]];
+    ball = _parent[ball];
+  }
+  return ball;
+}
+
+int ContactSolver::solve(Table& table, const vector<pair<int, int> >& pairs)
+{
+  BallArrays& b = table._balls;
+  const TableConfig& config = table._config;
+  int n = config.numBalls;
+  float sphereRadius = config.sphereRadius;
+  float restSpeed = config.restSpeed;
+
+  // touching pairs, in the order of the broadphase, which sorts them
+  _contacts.clear();
+  int tests = 0;
+  for (int p = 0; p < (int) pairs.size(); p++)
+  {
+    int i = pairs[p].first;
+    int j = pairs[p].second;
+    if (!b.isFree(i)) continue;
+    if (b.flags[i] & b.flags[j] & BALL_SLEEPING) continue;
+    tests++;
+    if (b.flags[j] & (BALL_SINKING | BALL_DEVOURED)) continue;
+
+    float dx = b.posX[i] - b.posX[j];
+    float dy = b.posY[i] - b.posY[j];
+    float dz = b.posZ[i] - b.posZ[j];
+    float reach = sphereRadius * (b.size[i] + b.size[j]);
+    if (dx * dx + dy * dy + dz * dz >= reach * reach) continue;
+
+    // normal between the balls as if both rested on the table, as in
+    // Table::collisionDetection
+    Contact c;
+    c.i = i;
+    c.j = j;
+    c.nx = dx;
+    c.ny = dy;
+    c.nz = dz - sphereRadius * (b.size[i] - b.size[j]);
+    float length = sqrt(c.nx * c.nx + c.ny * c.ny + c.nz * c.nz);
+    if (length > 0)
+    {
+      c.nx /= length;
+      c.ny /= length;
+      c.nz /= length;
+    }
+    else
+    {
+      c.nx = 1;
+      c.ny = c.nz = 0;
+    }
+    float approach = (b.velX[i] - b.velX[j]) * c.nx + (b.velY[i] - b.velY[j]) * c.ny + (b.velZ[i] - b.velZ[j]) * c.nz;
+    // balls bounce apart at the speed they met, and ones that barely touch
+    // come to rest against each other
+    c.bounce = approach < -restSpeed ? -approach : 0.0f;
+    c.impulse = 0.0f;
+    bool cached = false;
+    for (int s = 0; s < cacheSlots; s++)
+    {
+      if (_cacheOther[i * cacheSlots + s] != j) continue;
+      c.impulse = _cacheImpulse[i * cacheSlots + s];
+      cached = true;
+      break;
+    }
+    // a contact counts as a collision when the balls first meet
+    c.impact = !cached && approach < 0;
+    c.moved = false;
+    _contacts.push_back(c);
+  }
+
+  // islands, numbered in the order of their first contact
+  _parent.resize(n);
+  for (int i = 0; i < n; i++)
+  {
+    _parent[i] = i;
+  }
+  for (const Contact& c : _contacts)
+  {
+    int a = find(c.i);
+    int r = find(c.j);
+    if (a != r) _parent[max(a, r)] = min(a, r);
+  }
+  _islandOf.assign(n, -1);
+  _islandStart.assign(1, 0);
+  _contactIsland.resize(_contacts.size());
+  for (int k = 0; k < (int) _contacts.size(); k++)
+  {
+    int root = find(_contacts[k].i);
+    if (_islandOf[root] < 0)
+    {
+      _islandOf[root] = (int) _islandStart.size() - 1;
+      _islandStart.push_back(0);
+    }
+    _contactIsland[k] = _islandOf[root];
+    _islandStart[_contactIsland[k] + 1]++;
+  }
+  int numIslands = (int) _islandStart.size() - 1;
+  for (int island = 0; island < numIslands; island++)
+  {
+    _islandStart[island + 1] += _islandStart[island];
+  }
+  // each island's contacts keep their order
+  _next.assign(_islandStart.begin(), _islandStart.end() - 1);
+  _order.resize(_contacts.size());
+  for (int k = 0; k < (int) _contacts.size(); k++)
+  {
+    _order[_next[_contactIsland[k]]++] = k;
+  }
+
+  if (_pool && _pool->numThreads() > 1 && numIslands > 1 && (int) _contacts.size() >= parallelContacts)
+  {
+    _pool->parallelFor(numIslands, [&](int island, int) {
+      solveIsland(table, b, island);
+    });
+  }
+  else
+  {
+    for (int island = 0; island < numIslands; island++)
+    {
+      solveIsland(table, b, island);
+    }
+  }
+
+  // waking and counting touch the table, so they wait for every island
+  for (int k = 0; k < (int) _contacts.size(); k++)
+  {
+    const Contact& c = _contacts[k];
+    if (c.impulse > 0 || c.moved)
+    {
+      table.wake(c.i);
+      table.wake(c.j);
+    }
+    if (c.impact) table.recordCollision(c.i, c.j);
+  }
+
+  fill(_cacheOther.begin(), _cacheOther.end(), -1);
+  for (const Contact& c : _contacts)
+  {
+    if (c.impulse <= 0) continue;
+    for (int s = 0; s < cacheSlots; s++)
+    {
+      int slot = c.i * cacheSlots + s;
+      if (_cacheOther[slot] >= 0) continue;
+      _cacheOther[slot] = c.j;
+      _cacheImpulse[slot] = c.impulse;
+      break;
+    }
+  }
+  return tests;
+}
+
+/**
+ * Applies an impulse along the normal of a contact, to two balls of equal
+ * mass.
+ */
+static inline void applyImpulse(BallArrays& b, int i, int j, float nx, float ny, float nz, float impulse)
+{
+  float px = nx * impulse;
+  float py = ny * impulse;
+  float pz = nz * impulse;
+  b.velX[i] += px;
+  b.velY[i] += py;
+  b.velZ[i] += pz;
+  b.velX[j] -= px;
+  b.velY[j] -= py;
+  b.velZ[j] -= pz;
+}
+
+void ContactSolver::solveIsland(const Table& table, BallArrays& b, int island)
+{
+  float sphereRadius = table._config.sphereRadius;
+  int begin = _islandStart[island];
+  int end = _islandStart[island + 1];
+
+  for (int k = begin; k < end; k++)
+  {
+    Contact& c = _contacts[_order[k]];
+    if (c.impulse > 0) applyImpulse(b, c.i, c.j, c.nx, c.ny, c.nz, c.impulse);
+  }
+
+  for (int pass = 0; pass < velocityIterations; pass++)
+  {
+    for (int k = begin; k < end; k++)
+    {
+      Contact& c = _contacts[_order[k]];
+      float approach = (b.velX[c.i] - b.velX[c.j]) * c.nx + (b.velY[c.i] - b.velY[c.j]) * c.ny
+        + (b.velZ[c.i] - b.velZ[c.j]) * c.nz;
+      // each ball takes half of the change in their relative speed
+      float total = std::max(c.impulse + 0.5f * (c.bounce - approach), 0.0f);
+      float impulse = total - c.impulse;
+      c.impulse = total;
+      applyImpulse(b, c.i, c.j, c.nx, c.ny, c.nz, impulse);
+    }
+  }
+
+  for (int pass = 0; pass < positionIterations; pass++)
+  {
+    for (int k = begin; k < end; k++)
+    {
+      Contact& c = _contacts[_order[k]];
+      float dx = b.posX[c.i] - b.posX[c.j];
+      float dy = b.posY[c.i] - b.posY[c.j];
+      float dz = b.posZ[c.i] - b.posZ[c.j];
+      float overlap = sphereRadius * (b.size[c.i] + b.size[c.j]) - sqrt(dx * dx + dy * dy + dz * dz);
+      if (overlap <= slop) continue;
+      float push = 0.5f * correction * (overlap - slop);
+      b.posX[c.i] += c.nx * push;
+      b.posY[c.i] += c.ny * push;
+      b.posZ[c.i] += c.nz * push;
+      b.posX[c.j] -= c.nx * push;
+      b.posY[c.j] -= c.ny * push;
+      b.posZ[c.j] -= c.nz * push;
+      c.moved = true;
+    }
+  }
+}
+
+}  // namespace poolsim
@@ -0,0 +1,118 @@
+/**
+ * @file contactsolver.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Sequential-impulse solver for balls resting in groups
+ */
+
+#ifndef POOLSIM_CONTACTSOLVER_H_
+#define POOLSIM_CONTACTSOLVER_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace poolsim {
+
+class Table;
+class ThreadPool;
+struct BallArrays;
+
+/**
+ * Resolves every pair of touching balls together instead of one pair at a
+ * time, for the fixed-step rules of SOLVER_SEQUENTIAL_IMPULSE. Pushing
+ * each overlapping pair apart on its own, as Table::collisionDetection
+ * does, shoves the balls of a packed group into their other neighbours,
+ * so a group jitters and loses energy to the corrections.
+ *
+ * Each step the solver collects the touching pairs from the broadphase and
+ * applies impulses along their normals over several passes, keeping the
+ * total impulse of each contact non-negative, until the balls bounce apart
+ * at the speed they met or rest against each other. Balls have equal mass,
+ * so a single pair swaps its normal velocities exactly as before. The
+ * impulse of each contact is kept for the next step and applied up front,
+ * so a resting group starts out close to its answer. Overlaps left over are
+ * then taken out of the positions alone, which adds no energy.
+ *
+ * Balls linked by contacts form islands, found with a union-find, and no
+ * two islands share a ball, so they are solved independently and, on a
+ * table given a ThreadPool, in parallel. Within an island the contacts are
+ * always taken in the same order, so the result does not depend on the
+ * number of threads.
+ */
+class ContactSolver
+{
+public:
+    // passes over the contacts for velocities and then for positions
+    static const int velocityIterations = 8;
+    static const int positionIterations = 3;
+    // contacts cached per ball, with higher numbered balls, between steps
+    static const int cacheSlots = 6;
+    // overlap left in place, so that resting contacts stay in contact
+    static constexpr float slop = 0.5f;
+    // fraction of the remaining overlap removed in each position pass
+    static constexpr float correction = 0.5f;
+    // islands with at least this many contacts in all before they are
+    // worth handing to the threads
+    static const int parallelContacts = 256;
+
+    /**
+    * Sizes the contact cache for n balls and empties it.
+    */
+    void resize(int n);
+
+    /**
+    * Solves the touching pairs among the pairs from the broadphase.
+    *
+    * @return The number of pairs tested.
+    */
+    int solve(Table& table, const std::vector<std::pair<int, int> >& pairs);
+
+    void setThreadPool(ThreadPool* pool) { _pool = pool; }
+
+    int numContacts() const { return (int) _contacts.size(); }
+    int numIslands() const { return (int) _islandStart.size() - 1; }
+
+    /**
+    * Appends the contact cache to a table snapshot, see
+    * FixedPointSolver::arrays.
+    */
+    int arrays(void** data, size_t* bytes) const;
+    static const int numArrays = 2;
+
+private:
+    struct Contact
+    {
+      int i, j;
+      float nx, ny, nz;
+      // target separating speed along the normal
+      float bounce;
+      // total impulse applied this step
+      float impulse;
+      // true for a pair that met this step
+      bool impact;
+      // true if the positions were corrected
+      bool moved;
+    };
+
+    int find(int ball);
+    void solveIsland(const Table& table, BallArrays& balls, int island);
+
+    ThreadPool* _pool = nullptr;
+    std::vector<Contact> _contacts;
+    // ball each cached contact is with, -1 for a free slot, and its impulse
+    std::vector<int> _cacheOther;
+    std::vector<float> _cacheImpulse;
+    std::vector<int> _parent;
+    // island of each root ball and of each contact
+    std::vector<int> _islandOf;
+    std::vector<int> _contactIsland;
+    // contacts of island k are _order[_islandStart[k]] up to the next start
+    std::vector<int> _islandStart;
+    std::vector<int> _next;
+    std::vector<int> _order;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_CONTACTSOLVER_H_
@@ -0,0 +1,551 @@
+/**
+ * @file eventsolver.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the event-driven solver
+ */
+
+#include "poolsim/eventsolver.h"
+#include "poolsim/table.h"
+#include "poolsim/tablegeometry.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace poolsim {
+
+// guards against a cluster of balls trading impacts forever
+static const int maxEvents = 1 << 20;
+static const double never = numeric_limits<double>::infinity();
+
+int EventSolver::advance(Table& table, double duration)
+{
+  load(table, duration);
+  schedulePairs(table);
+  int processed = run(table, duration);
+  _now = duration;
+  store(table);
+  return processed;
+}
+
+double EventSolver::settle(Table& table, double maxTime)
+{
+  // settling stops early once the queue runs dry, so every event is kept
+  load(table, never);
+  for (int i = 0; i < _n; i++)
+  {
+    if (!_active[i]) continue;
+    for (int j = i + 1; j < _n; j++)
+    {
+      if (_active[j]) schedulePair(table, i, j);
+    }
+  }
+  run(table, maxTime);
+  // every moving ball has a rest event pending, so an empty queue means
+  // everything stopped at the last event
+  if (!_queue.empty()) _now = maxTime;
+  store(table);
+  return _now;
+}
+
+void EventSolver::load(Table& table, double end)
+{
+  const TableConfig& config = table._config;
+  const BallArrays& balls = table._balls;
+  _n = config.numBalls;
+  _now = 0.0;
+  _end = end;
+  float friction = chaosFriction(table.activeChaos());
+  _k = -log((double) friction) / config.fixedDt;
+  _restSpeed = config.restSpeed;
+  _xLimit = (config.tableLength - 75) / 2.0;
+  _yLimit = (config.tableWidth - 75) / 2.0;
+  _pocketRadius = config.viewVolumeSide / 50;
+  _sphereRadius = config.sphereRadius;
+  _rollScale = 1.0 / config.sphereRadius;
+  _sticky = table.chaosActive(CHAOS_STICKY_SITUATION);
+  _geometry = config.geometry.get();
+
+  _pocketX.resize(table._pockets.size());
+  _pocketY.resize(table._pockets.size());
+  for (int p = 0; p < (int) table._pockets.size(); p++)
+  {
+    _pocketX[p] = table._pockets[p].x;
+    _pocketY[p] = table._pockets[p].y;
+  }
+
+  _t.assign(_n, 0.0);
+  _px.resize(_n); _py.resize(_n); _pz.resize(_n);
+  _vx.resize(_n); _vy.resize(_n);
+  _rx.resize(_n); _ry.resize(_n);
+  _radius.resize(_n);
+  _version.resize(_n);
+  _active.resize(_n);
+  for (int i = 0; i < _n; i++)
+  {
+    _active[i] = balls.isFree(i);
+    _px[i] = balls.posX[i];
+    _py[i] = balls.posY[i];
+    _pz[i] = balls.posZ[i];
+    _vx[i] = balls.velX[i];
+    _vy[i] = balls.velY[i];
+    _rx[i] = balls.rotX[i];
+    _ry[i] = balls.rotY[i];
+    _radius[i] = _sphereRadius * balls.size[i];
+    stopIfSlow(i);
+  }
+
+  _queue.clear();
+  for (int i = 0; i < _n; i++)
+  {
+    if (_active[i]) scheduleBall(i);
+  }
+}
+
+void EventSolver::schedulePairs(Table& table)
+{
+  // a ball whose path changes is scheduled against every other ball there
+  // and then, so up front only pairs that can meet while both keep their
+  // current paths are needed: each ball is grown by how far it rolls in the
+  // step, plus a little for the grid's float footprints
+  double s = sOf(_end);
+  _margins.resize(_n);
+  for (int i = 0; i < _n; i++)
+  {
+    _margins[i] = (float) (speed(i) * s) + 0.01f * (float) _sphereRadius;
+  }
+  table._broadphase.update(table._balls, (float) _sphereRadius, _margins.data());
+  const vector<pair<int, int> >& pairs = table._broadphase.pairs();
+  for (int p = 0; p < (int) pairs.size(); p++)
+  {
+    int i = pairs[p].first;
+    int j = pairs[p].second;
+    if (_active[i] && _active[j]) schedulePair(table, i, j);
+  }
+}
+
+void EventSolver::schedulePair(const Table& table, int i, int j)
+{
+  // neither of two sleeping balls can move first
+  const BallArrays& balls = table._balls;
+  if (balls.flags[i] & balls.flags[j] & BALL_SLEEPING) return;
+  schedulePair(i, j);
+}
+
+void EventSolver::store(Table& table)
+{
+  BallArrays& balls = table._balls;
+  for (int i = 0; i < _n; i++)
+  {
+    if (!_active[i]) continue;
+    moveTo(i, _now);
+    balls.posX[i] = _px[i];
+    balls.posY[i] = _py[i];
+    balls.velX[i] = _vx[i];
+    balls.velY[i] = _vy[i];
+    balls.velZ[i] = 0;
+    balls.rotX[i] = _rx[i];
+    balls.rotY[i] = _ry[i];
+  }
+}
+
+int EventSolver::run(Table& table, double end)
+{
+  int processed = 0;
+  while (!_queue.empty() && _queue.front().time <= end && processed < maxEvents)
+  {
+    pop_heap(_queue.begin(), _queue.end(), greater<Event>());
+    Event e = _queue.back();
+    _queue.pop_back();
+    if (!_active[e.i] || _version[e.i] != e.vi) continue;
+    if (e.j >= 0 && (!_active[e.j] || _version[e.j] != e.vj)) continue;
+    _now = e.time;
+    resolve(table, e);
+    processed++;
+  }
+  return processed;
+}
+
+double EventSolver::sOf(double tau) const
+{
+  return -expm1(-_k * tau) / _k;
+}
+
+double EventSolver::tauOf(double s) const
+{
+  if (_k * s >= 1.0) return never;
+  return -log1p(-_k * s) / _k;
+}
+
+double EventSolver::speed(int i) const
+{
+  return sqrt(_vx[i] * _vx[i] + _vy[i] * _vy[i]);
+}
+
+double EventSolver::restTime(int i) const
+{
+  double v = speed(i);
+  if (v == 0) return never;
+  return _t[i] + std::max(0.0, log(v / _restSpeed) / _k);
+}
+
+void EventSolver::stopIfSlow(int i)
+{
+  // a ball nudged below the rest speed would otherwise trade ever smaller
+  // impacts with its neighbours without time moving on
+  if (_vx[i] * _vx[i] + _vy[i] * _vy[i] < _restSpeed * _restSpeed)
+  {
+    _vx[i] = 0;
+    _vy[i] = 0;
+  }
+}
+
+void EventSolver::moveTo(int i, double t)
+{
+  double tau = t - _t[i];
+  _t[i] = t;
+  if (tau <= 0 || (_vx[i] == 0 && _vy[i] == 0)) return;
+  double s = sOf(tau);
+  double dx = _vx[i] * s;
+  double dy = _vy[i] * s;
+  _px[i] += dx;
+  _py[i] += dy;
+  double decay = exp(-_k * tau);
+  _vx[i] *= decay;
+  _vy[i] *= decay;
+  double roll = _rollScale / (_radius[i] / _sphereRadius);
+  _rx[i] += -dy * roll;
+  _ry[i] += dx * roll;
+}
+
+void EventSolver::push(double time, int type, int i, int j, int part)
+{
+  if (time > _end) return;
+  Event e;
+  e.time = time;
+  e.type = type;
+  e.i = i;
+  e.j = j;
+  e.part = part;
+  e.vi = _version[i];
+  e.vj = j >= 0 ? _version[j] : 0;
+  _queue.push_back(e);
+  push_heap(_queue.begin(), _queue.end(), greater<Event>());
+}
+
+void EventSolver::schedule(int i, int skip)
+{
+  scheduleBall(i);
+  for (int j = 0; j < _n; j++)
+  {
+    if (j != i && j != skip && _active[j]) schedulePair(i, j);
+  }
+}
+
+void EventSolver::scheduleBall(int i)
+{
+  // only called once the ball has been moved to the present
+  double rest = restTime(i);
+  if (_geometry != nullptr)
+  {
+    scheduleSegments(i, rest);
+    return;
+  }
+  double a = _vx[i] * _vx[i] + _vy[i] * _vy[i];
+  for (int p = 0; p < (int) _pocketX.size(); p++)
+  {
+    double dx = _px[i] - _pocketX[p];
+    double dy = _py[i] - _pocketY[p];
+    double b = dx * _vx[i] + dy * _vy[i];
+    double c = dx * dx + dy * dy - _pocketRadius * _pocketRadius;
+    if (c < 0)
+    {
+      push(_now, EVENT_POCKET, i, -1);
+      return;
+    }
+    double disc = b * b - a * c;
+    if (b >= 0 || disc < 0) continue;
+    double tau = tauOf((-b - sqrt(disc)) / a);
+    if (_now + tau <= rest) push(_now + tau, EVENT_POCKET, i, -1);
+  }
+
+  if (rest == never) return;
+  push(rest, EVENT_REST, i, -1);
+
+  double xLimit = _xLimit - _radius[i];
+  double s = -1;
+  if (_vx[i] > 0) s = (xLimit - _px[i]) / _vx[i];
+  else if (_vx[i] < 0) s = (-xLimit - _px[i]) / _vx[i];
+  if (_vx[i] != 0 && _now + tauOf(std::max(s, 0.0)) <= rest)
+  {
+    push(_now + tauOf(std::max(s, 0.0)), EVENT_CUSHION_X, i, -1);
+  }
+
+  double yLimit = _yLimit - _radius[i];
+  if (_vy[i] > 0) s = (yLimit - _py[i]) / _vy[i];
+  else if (_vy[i] < 0) s = (-yLimit - _py[i]) / _vy[i];
+  if (_vy[i] != 0 && _now + tauOf(std::max(s, 0.0)) <= rest)
+  {
+    push(_now + tauOf(std::max(s, 0.0)), EVENT_CUSHION_Y, i, -1);
+  }
+}
+
+void EventSolver::scheduleSegments(int i, double rest)
+{
+  // touching a mouth pockets the ball, so the pull of the pocket is never
+  // needed
+  const SegmentArrays& mouths = _geometry->mouths;
+  for (int p = 0; p < mouths.count; p++)
+  {
+    double ex = _px[i] - mouths.ax[p];
+    double ey = _py[i] - mouths.ay[p];
+    double t = std::min(std::max((ex * mouths.dx[p] + ey * mouths.dy[p]) * mouths.invLengthSq[p], 0.0), 1.0);
+    ex -= t * mouths.dx[p];
+    ey -= t * mouths.dy[p];
+    if (ex * ex + ey * ey < _radius[i] * _radius[i])
+    {
+      push(_now, EVENT_POCKET, i, -1);
+      return;
+    }
+    double s = segmentContact(i, mouths, p);
+    if (s >= 0 && _now + tauOf(s) <= rest) push(_now + tauOf(s), EVENT_POCKET, i, -1);
+  }
+
+  if (rest == never) return;
+  push(rest, EVENT_REST, i, -1);
+
+  const SegmentArrays& cushions = _geometry->cushions;
+  for (int k = 0; k < cushions.count; k++)
+  {
+    double s = segmentContact(i, cushions, k);
+    if (s >= 0 && _now + tauOf(s) <= rest) push(_now + tauOf(s), EVENT_CUSHION, i, -1, k);
+  }
+}
+
+double EventSolver::segmentContact(int i, const SegmentArrays& segments, int k) const
+{
+  double r = _radius[i];
+  double vx = _vx[i];
+  double vy = _vy[i];
+  double a = vx * vx + vy * vy;
+  if (a == 0) return -1;
+  double ax = segments.ax[k];
+  double ay = segments.ay[k];
+  double dx = segments.dx[k];
+  double dy = segments.dy[k];
+  double best = never;
+
+  // the flat of the segment, from whichever side the ball is on
+  double len = sqrt(dx * dx + dy * dy);
+  if (len > 0)
+  {
+    double nx = dy / len;
+    double ny = -dx / len;
+    double d0 = (_px[i] - ax) * nx + (_py[i] - ay) * ny;
+    if (d0 < 0)
+    {
+      nx = -nx;
+      ny = -ny;
+      d0 = -d0;
+    }
+    double approach = vx * nx + vy * ny;
+    // as for pairs, an approach lost in rounding is no approach
+    if (approach < -1e-6 * sqrt(a))
+    {
+      double s = std::max(0.0, (r - d0) / approach);
+      double t = ((_px[i] + vx * s - ax) * dx + (_py[i] + vy * s - ay) * dy) / (len * len);
+      if (t >= 0 && t <= 1) best = s;
+    }
+  }
+
+  // either end, as a point the ball's centre must stay r away from
+  for (int end = 0; end < 2; end++)
+  {
+    double ex = _px[i] - (ax + end * dx);
+    double ey = _py[i] - (ay + end * dy);
+    double b = ex * vx + ey * vy;
+    if (b >= -1e-6 * sqrt(a * (ex * ex + ey * ey))) continue;
+    double c = ex * ex + ey * ey - r * r;
+    if (c < 0)
+    {
+      best = 0;
+      continue;
+    }
+    double disc = b * b - a * c;
+    if (disc < 0) continue;
+    best = std::min(best, (-b - sqrt(disc)) / a);
+  }
+  return best == never ? -1 : best;
+}
+
+void EventSolver::schedulePair(int i, int j)
+{
+  // friction only slows a ball, so it strays no further from where it was
+  // at _t than its speed then times the time since; a pair too far apart
+  // to meet before the end is passed over before the exps and logs below
+  if (_end != never)
+  {
+    double reach = _radius[i] + _radius[j] + speed(i) * (_end - _t[i]) + speed(j) * (_end - _t[j]);
+    double gapX = _px[i] - _px[j];
+    double gapY = _py[i] - _py[j];
+    if (gapX * gapX + gapY * gapY > reach * reach) return;
+  }
+
+  double end = std::min(restTime(i), restTime(j));
+  if (end == never) return;
+
+  // both balls as they are now, their paths valid until either stops
+  double si = sOf(_now - _t[i]);
+  double sj = sOf(_now - _t[j]);
+  double decayI = exp(-_k * (_now - _t[i]));
+  double decayJ = exp(-_k * (_now - _t[j]));
+  double dx = (_px[i] + _vx[i] * si) - (_px[j] + _vx[j] * sj);
+  double dy = (_py[i] + _vy[i] * si) - (_py[j] + _vy[j] * sj);
+  double dz = _pz[i] - _pz[j];
+  double dvx = _vx[i] * decayI - _vx[j] * decayJ;
+  double dvy = _vy[i] * decayI - _vy[j] * decayJ;
+
+  double contact = _radius[i] + _radius[j];
+  double a = dvx * dvx + dvy * dvy;
+  double b = dx * dvx + dy * dvy;
+  double c = dx * dx + dy * dy + dz * dz - contact * contact;
+  // separating or sliding past; a glancing pair whose approach is lost in
+  // rounding would otherwise collide again at the same instant forever
+  if (b >= -1e-6 * sqrt(dx * dx + dy * dy)) return;
+  if (c < 0)
+  {
+    push(_now, EVENT_BALL, i, j);
+    return;
+  }
+  double disc = b * b - a * c;
+  if (disc < 0) return;
+  double tau = tauOf((-b - sqrt(disc)) / a);
+  if (_now + tau <= end) push(_now + tau, EVENT_BALL, i, j);
+}
+
+void EventSolver::resolve(Table& table, const Event& e)
+{
+  int i = e.i;
+  int j = e.j;
+  moveTo(i, _now);
+  if (j >= 0) moveTo(j, _now);
+
+  if (e.type == EVENT_BALL)
+  {
+    // normal between the balls as if both rested on the table
+    double nx = _px[i] - _px[j];
+    double ny = _py[i] - _py[j];
+    double len = sqrt(nx * nx + ny * ny);
+    if (len > 0)
+    {
+      nx /= len;
+      ny /= len;
+      // balls that started out overlapping are separated, as in the fixed step
+      double dz = _pz[i] - _pz[j];
+      double contact = _radius[i] + _radius[j];
+      double overlap = sqrt(std::max(0.0, contact * contact - dz * dz)) - len;
+      if (overlap > 0)
+      {
+        _px[i] += nx * overlap / 2;
+        _py[i] += ny * overlap / 2;
+        _px[j] -= nx * overlap / 2;
+        _py[j] -= ny * overlap / 2;
+      }
+      double vi = _vx[i] * nx + _vy[i] * ny;
+      double vj = _vx[j] * nx + _vy[j] * ny;
+      _vx[i] += (vj - vi) * nx;
+      _vy[i] += (vj - vi) * ny;
+      _vx[j] += (vi - vj) * nx;
+      _vy[j] += (vi - vj) * ny;
+    }
+    stopIfSlow(i);
+    stopIfSlow(j);
+    table.recordCollision(i, j);
+    _version[i]++;
+    _version[j]++;
+    schedule(i, -1);
+    schedule(j, i);
+  }
+  else if (e.type == EVENT_CUSHION_X || e.type == EVENT_CUSHION_Y)
+  {
+    bool alongX = e.type == EVENT_CUSHION_X;
+    double limit = (alongX ? _xLimit : _yLimit) - _radius[i];
+    double& pos = alongX ? _px[i] : _py[i];
+    double& vel = alongX ? _vx[i] : _vy[i];
+    pos = std::min(std::max(pos, -limit), limit);
+    if (_sticky)
+    {
+      _vx[i] = 0;
+      _vy[i] = 0;
+    }
+    else
+    {
+      vel = -vel;
+    }
+    stopIfSlow(i);
+    table._events.boundaryHits += 1;
+    _version[i]++;
+    schedule(i, -1);
+  }
+  else if (e.type == EVENT_CUSHION)
+  {
+    const SegmentArrays& cushions = _geometry->cushions;
+    int k = e.part;
+    double ex = _px[i] - cushions.ax[k];
+    double ey = _py[i] - cushions.ay[k];
+    double dx = cushions.dx[k];
+    double dy = cushions.dy[k];
+    double t = std::min(std::max((ex * dx + ey * dy) * cushions.invLengthSq[k], 0.0), 1.0);
+    double nx = ex - t * dx;
+    double ny = ey - t * dy;
+    double len = sqrt(nx * nx + ny * ny);
+    if (len > 0)
+    {
+      nx /= len;
+      ny /= len;
+      // lift a ball that started out overlapping back to the edge
+      if (len < _radius[i])
+      {
+        _px[i] += nx * (_radius[i] - len);
+        _py[i] += ny * (_radius[i] - len);
+      }
+      double approach = _vx[i] * nx + _vy[i] * ny;
+      if (_sticky)
+      {
+        _vx[i] = 0;
+        _vy[i] = 0;
+      }
+      else if (approach < 0)
+      {
+        _vx[i] -= 2 * approach * nx;
+        _vy[i] -= 2 * approach * ny;
+      }
+    }
+    stopIfSlow(i);
+    table._events.boundaryHits += 1;
+    _version[i]++;
+    schedule(i, -1);
+  }
+  else if (e.type == EVENT_POCKET)
+  {
+    BallArrays& balls = table._balls;
+    balls.posX[i] = _px[i];
+    balls.posY[i] = _py[i];
+    balls.rotX[i] = _rx[i];
+    balls.rotY[i] = _ry[i];
+    table.sink(i);
+    _active[i] = false;
+    _version[i]++;
+  }
+  else
+  {
+    _vx[i] = 0;
+    _vy[i] = 0;
+    _version[i]++;
+    schedule(i, -1);
+  }
+}
+
+}  // namespace poolsim
@@ -0,0 +1,159 @@
+/**
+ * @file eventsolver.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Event-driven solver that jumps from one impact to the next
+ */
+
+#ifndef POOLSIM_EVENTSOLVER_H_
+#define POOLSIM_EVENTSOLVER_H_
+
+#include <vector>
+
+namespace poolsim {
+
+class Table;
+struct SegmentArrays;
+struct TableGeometry;
+
+/**
+ * Moves the balls of a table along their exact paths instead of in fixed
+ * steps, so that no ball can pass through another ball, a cushion or a
+ * pocket however fast it goes.
+ *
+ * Friction that scales velocity by f every fixed step dt is the continuous
+ * decay v(t) = v0 e^(-kt) with k = -ln(f) / dt, under which a ball covers
+ * v0 s(t) with s(t) = (1 - e^(-kt)) / k. Because every ball shares k, the
+ * gap between two balls is linear in s and the time at which they touch is
+ * the root of a quadratic, as are the times a ball reaches a cushion or a
+ * pocket. A ball that slows below TableConfig::restSpeed stops dead.
+ *
+ * Pending events sit in a priority queue ordered by time. Each ball carries
+ * a version that is bumped whenever its path changes, and events recorded
+ * against an older version are dropped when they reach the top. A fixed
+ * step only schedules the pairs the table's broadphase finds within reach
+ * of each other in the step, while settling schedules every pair.
+ *
+ * On a table with TableConfig::geometry the ball meets each cushion edge
+ * when its distance to the edge's line or to one of its ends reaches its
+ * radius, again a root in s, and it is pocketed when it touches a pocket
+ * mouth.
+ *
+ * Only free balls take part, moving in the plane of the table at their
+ * current heights. A ball that reaches the pull of a pocket is sunk at once
+ * rather than drawn in over several steps.
+ */
+class EventSolver
+{
+public:
+    /**
+    * Advances the table by the given time.
+    *
+    * @param table The table to advance.
+    * @param duration The time to advance by in seconds.
+    * @return The number of events processed.
+    */
+    int advance(Table& table, double duration);
+
+    /**
+    * Advances the table until every ball is at rest or the time limit is
+    * reached.
+    *
+    * @param table The table to advance.
+    * @param maxTime The most time to simulate in seconds.
+    * @return The time simulated in seconds.
+    */
+    double settle(Table& table, double maxTime);
+
+private:
+    enum EventType
+    {
+        EVENT_BALL,
+        EVENT_CUSHION_X,
+        EVENT_CUSHION_Y,
+        EVENT_POCKET,
+        // a traced cushion edge, given by part
+        EVENT_CUSHION,
+        EVENT_REST
+    };
+
+    struct Event
+    {
+        double time;
+        int type;
+        int i, j;
+        // the cushion edge of an EVENT_CUSHION
+        int part;
+        unsigned vi, vj;
+
+        bool operator>(const Event& e) const
+        {
+            if (time != e.time) return time > e.time;
+            if (type != e.type) return type > e.type;
+            if (i != e.i) return i > e.i;
+            if (j != e.j) return j > e.j;
+            return part > e.part;
+        }
+    };
+
+    // loads the balls and schedules their own events up to end
+    void load(Table& table, double end);
+    void store(Table& table);
+    int run(Table& table, double end);
+
+    void moveTo(int i, double t);
+    double sOf(double tau) const;
+    double tauOf(double s) const;
+    double speed(int i) const;
+    double restTime(int i) const;
+    void stopIfSlow(int i);
+
+    // schedules every event for ball i, leaving out its pair with skip
+    void schedule(int i, int skip);
+    void scheduleBall(int i);
+    void scheduleSegments(int i, double rest);
+    void schedulePair(int i, int j);
+    // schedules the pairs that can meet within the step, from the grid
+    void schedulePairs(Table& table);
+    // schedules a pair unless both balls are asleep
+    void schedulePair(const Table& table, int i, int j);
+
+    /**
+    * Distance ball i travels along its path, in units of s, before it
+    * touches segment k, or -1 if it never does. Zero if it already touches
+    * the segment and is moving towards it.
+    */
+    double segmentContact(int i, const SegmentArrays& segments, int k) const;
+
+    void push(double time, int type, int i, int j, int part = -1);
+    void resolve(Table& table, const Event& e);
+
+    int _n = 0;
+    double _now = 0.0;
+    // the time run() is going to stop at, past which no event matters
+    double _end = 0.0;
+    double _k = 1.0;
+    double _restSpeed = 1.0;
+    double _xLimit = 0.0;
+    double _yLimit = 0.0;
+    double _pocketRadius = 0.0;
+    double _sphereRadius = 0.5;
+    double _rollScale = 2.0;
+    bool _sticky = false;
+    const TableGeometry* _geometry = nullptr;
+
+    // each ball as it was at its own time _t, the last time its path changed
+    std::vector<double> _t, _px, _py, _pz, _vx, _vy, _rx, _ry, _radius;
+    std::vector<unsigned> _version;
+    std::vector<bool> _active;
+    std::vector<double> _pocketX, _pocketY;
+    // how far each ball can roll in the step, for the broadphase
+    std::vector<float> _margins;
+
+    // min-heap on time, kept as a plain vector so clearing it keeps capacity
+    std::vector<Event> _queue;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_EVENTSOLVER_H_
@@ -0,0 +1,143 @@
+/**
+ * @file fixedpoint.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Q16.16 fixed-point arithmetic that gives the same bits everywhere
+ */
+
+#ifndef POOLSIM_FIXEDPOINT_H_
+#define POOLSIM_FIXEDPOINT_H_
+
+#include <cmath>
+#include <cstdint>
+
+namespace poolsim {
+
+/**
+ * A Q16.16 number: 16 integer bits, sign included, and 16 fraction bits,
+ * so values up to +-32768 in steps of 1/65536. The table is 500 units
+ * across and balls go no faster than a few thousand units per second, so
+ * positions and velocities both fit. Products are taken in 64 bits, and
+ * every operation rounds towards zero, so that decaying values reach zero
+ * from either side.
+ */
+typedef int32_t fixed;
+
+namespace fx {
+
+static const int fractionBits = 16;
+static const fixed one = 1 << fractionBits;
+static const fixed halfPi = 102944;
+static const fixed pi = 205887;
+static const fixed twoPi = 411775;
+
+/**
+ * Nearest fixed-point value to a float. Scaling by a power of two is exact,
+ * so this gives the same result on any IEEE machine.
+ */
+inline fixed fromFloat(float f)
+{
+  double scaled = std::floor((double) f * one + 0.5);
+  if (scaled >= 2147483647.0) return INT32_MAX;
+  if (scaled <= -2147483648.0) return INT32_MIN;
+  return (fixed) scaled;
+}
+
+inline float toFloat(fixed v)
+{
+  return (float) v / (float) one;
+}
+
+inline fixed fromInt(int i)
+{
+  return (fixed) (i * one);
+}
+
+inline fixed mul(fixed a, fixed b)
+{
+  return (fixed) (((int64_t) a * b) / one);
+}
+
+inline fixed div(fixed a, fixed b)
+{
+  return b == 0 ? 0 : (fixed) (((int64_t) a * one) / b);
+}
+
+/**
+ * Product of two fixed-point values with 32 fraction bits, for sums of
+ * squares that would overflow as Q16.16.
+ */
+inline int64_t mulWide(fixed a, fixed b)
+{
+  return (int64_t) a * b;
+}
+
+/**
+ * Square root of an unsigned integer, rounded down, by the bit-by-bit
+ * method, which uses only shifts, adds and compares.
+ */
+inline uint32_t isqrt(uint64_t v)
+{
+  uint64_t root = 0;
+  uint64_t bit = (uint64_t) 1 << 62;
+  while (bit > v) bit >>= 2;
+  while (bit != 0)
+  {
+    if (v >= root + bit)
+    {
+      v -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+    {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t) root;
+}
+
+/**
+ * Square root of a value with 32 fraction bits, such as a mulWide sum of
+ * squares, as a fixed-point value.
+ */
+inline fixed sqrtWide(int64_t v)
+{
+  return v <= 0 ? 0 : (fixed) isqrt((uint64_t) v);
+}
+
+/**
+ * Sine of an angle in radians, to within about 1e-4, from a polynomial on
+ * a quarter turn.
+ */
+inline fixed sin(fixed x)
+{
+  x %= twoPi;
+  if (x < 0) x += twoPi;
+  // fold onto [-pi/2, pi/2], where sin(pi - x) = sin(x)
+  if (x > pi) x -= twoPi;
+  if (x > halfPi) x = pi - x;
+  else if (x < -halfPi) x = -pi - x;
+  // x - x^3/6 + x^5/120 - x^7/5040
+  fixed x2 = mul(x, x);
+  fixed term = x;
+  fixed sum = x;
+  term = mul(term, x2) / 6;
+  sum -= term;
+  term = mul(term, x2) / 20;
+  sum += term;
+  term = mul(term, x2) / 42;
+  sum -= term;
+  return sum;
+}
+
+inline fixed cos(fixed x)
+{
+  return sin(x % twoPi + halfPi);
+}
+
+}  // namespace fx
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_FIXEDPOINT_H_
@@ -0,0 +1,513 @@
+/**
+ * @file fixedsolver.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the Q16.16 fixed-step solver
+ */
+
+#include "poolsim/fixedsolver.h"
+#include "poolsim/table.h"
+#include "poolsim/tablegeometry.h"
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+using namespace glm;
+
+namespace poolsim {
+
+using fx::one;
+using fx::mul;
+using fx::mulWide;
+
+/**
+ * Point of the segment from (ax, ay) along (dx, dy) nearest to (px, py).
+ *
+ * @return The squared distance to it, see fx::mulWide.
+ */
+static int64_t closestOnSegment(fixed ax, fixed ay, fixed dx, fixed dy, fixed px, fixed py,
+  fixed& cx, fixed& cy)
+{
+  fixed t = 0;
+  // |d|^2 with 16 fraction bits, so that the quotient has 16 as well
+  int64_t lengthSq = (mulWide(dx, dx) + mulWide(dy, dy)) >> fx::fractionBits;
+  if (lengthSq > 0)
+  {
+    int64_t along = mulWide(px - ax, dx) + mulWide(py - ay, dy);
+    t = (fixed) std::min(std::max(along / lengthSq, (int64_t) 0), (int64_t) one);
+  }
+  cx = ax + mul(t, dx);
+  cy = ay + mul(t, dy);
+  fixed ex = px - cx;
+  fixed ey = py - cy;
+  return mulWide(ex, ex) + mulWide(ey, ey);
+}
+
+/**
+ * The integer value of a float that was last written as written, or the
+ * float itself if something else wrote it since.
+ */
+static fixed current(fixed value, float written, float f)
+{
+  return f == written ? value : fx::fromFloat(f);
+}
+
+void FixedPointSolver::resize(int n)
+{
+  // NaN equals nothing, so every ball is taken from the floats
+  float unknown = numeric_limits<float>::quiet_NaN();
+  for (vector<fixed>* values : {&_px, &_py, &_pz, &_vx, &_vy, &_vz})
+  {
+    values->assign(n, 0);
+  }
+  for (vector<float>* values : {&_fpx, &_fpy, &_fpz, &_fvx, &_fvy, &_fvz})
+  {
+    values->assign(n, unknown);
+  }
+}
+
+int FixedPointSolver::arrays(void** data, size_t* bytes) const
+{
+  const vector<fixed>* values[] = {&_px, &_py, &_pz, &_vx, &_vy, &_vz};
+  const vector<float>* written[] = {&_fpx, &_fpy, &_fpz, &_fvx, &_fvy, &_fvz};
+  int a = 0;
+  for (const vector<fixed>* v : values)
+  {
+    data[a] = (void*) v->data();
+    bytes[a++] = v->size() * sizeof(fixed);
+  }
+  for (const vector<float>* v : written)
+  {
+    data[a] = (void*) v->data();
+    bytes[a++] = v->size() * sizeof(float);
+  }
+  return a;
+}
+
+int64_t FixedPointSolver::speedSq(const Table& table, int i) const
+{
+  const BallArrays& b = table._balls;
+  fixed vx = current(_vx[i], _fvx[i], b.velX[i]);
+  fixed vy = current(_vy[i], _fvy[i], b.velY[i]);
+  fixed vz = current(_vz[i], _fvz[i], b.velZ[i]);
+  return mulWide(vx, vx) + mulWide(vy, vy) + mulWide(vz, vz);
+}
+
+void FixedPointSolver::adopt(Table& table)
+{
+  BallArrays& b = table._balls;
+  int n = table._config.numBalls;
+  for (int i = 0; i < n; i++)
+  {
+    _px[i] = current(_px[i], _fpx[i], b.posX[i]);
+    _py[i] = current(_py[i], _fpy[i], b.posY[i]);
+    _pz[i] = current(_pz[i], _fpz[i], b.posZ[i]);
+    _vx[i] = current(_vx[i], _fvx[i], b.velX[i]);
+    _vy[i] = current(_vy[i], _fvy[i], b.velY[i]);
+    _vz[i] = current(_vz[i], _fvz[i], b.velZ[i]);
+  }
+}
+
+void FixedPointSolver::publish(Table& table)
+{
+  BallArrays& b = table._balls;
+  int n = table._config.numBalls;
+  for (int i = 0; i < n; i++)
+  {
+    b.posX[i] = _fpx[i] = fx::toFloat(_px[i]);
+    b.posY[i] = _fpy[i] = fx::toFloat(_py[i]);
+    b.posZ[i] = _fpz[i] = fx::toFloat(_pz[i]);
+    b.velX[i] = _fvx[i] = fx::toFloat(_vx[i]);
+    b.velY[i] = _fvy[i] = fx::toFloat(_vy[i]);
+    b.velZ[i] = _fvz[i] = fx::toFloat(_vz[i]);
+  }
+}
+
+void FixedPointSolver::loadGeometry(const TableGeometry* geometry)
+{
+  if (geometry == _geometry) return;
+  _geometry = geometry;
+  for (vector<fixed>* values : {&_sax, &_say, &_sdx, &_sdy, &_jawAX, &_jawAY, &_jawBX, &_jawBY, &_holeX, &_holeY, &_reach})
+  {
+    values->clear();
+  }
+  if (!geometry) return;
+
+  const SegmentArrays& cushions = geometry->cushions;
+  for (int s = 0; s < cushions.count; s++)
+  {
+    _sax.push_back(fx::fromFloat(cushions.ax[s]));
+    _say.push_back(fx::fromFloat(cushions.ay[s]));
+    _sdx.push_back(fx::fromFloat(cushions.dx[s]));
+    _sdy.push_back(fx::fromFloat(cushions.dy[s]));
+  }
+  for (const PocketShape& pocket : geometry->pockets)
+  {
+    _jawAX.push_back(fx::fromFloat(pocket.jawA.x));
+    _jawAY.push_back(fx::fromFloat(pocket.jawA.y));
+    _jawBX.push_back(fx::fromFloat(pocket.jawB.x));
+    _jawBY.push_back(fx::fromFloat(pocket.jawB.y));
+    _holeX.push_back(fx::fromFloat(pocket.center.x));
+    _holeY.push_back(fx::fromFloat(pocket.center.y));
+    _reach.push_back(fx::fromFloat(pocket.reach));
+  }
+  _playX = fx::fromFloat(geometry->playExtent.x);
+  _playY = fx::fromFloat(geometry->playExtent.y);
+  _railX = fx::fromFloat(geometry->railExtent.x);
+  _railY = fx::fromFloat(geometry->railExtent.y);
+}
+
+void FixedPointSolver::step(Table& table)
+{
+  typedef void (FixedPointSolver::*Step)(Table&);
+  static const Step steps[numStepVariants] = {
+    &FixedPointSolver::stepWith<stepVariantSet(0)>, &FixedPointSolver::stepWith<stepVariantSet(1)>,
+    &FixedPointSolver::stepWith<stepVariantSet(2)>, &FixedPointSolver::stepWith<stepVariantSet(3)>,
+    &FixedPointSolver::stepWith<stepVariantSet(4)>, &FixedPointSolver::stepWith<stepVariantSet(5)>,
+    &FixedPointSolver::stepWith<stepVariantSet(6)>, &FixedPointSolver::stepWith<stepVariantSet(7)>
+  };
+  (this->*steps[stepVariant(table._chaosActive)])(table);
+}
+
+template <ChaosSet Active>
+void FixedPointSolver::stepWith(Table& table)
+{
+  typedef ChaosRules<Active> Rules;
+  BallArrays& b = table._balls;
+  int n = table._config.numBalls;
+  loadGeometry(table._config.geometry.get());
+  adopt(table);
+
+  // converted once a step rather than at every use; sizes only ever halve,
+  // triple or double, so the radii are exact
+  _radius.resize(n);
+  for (int i = 0; i < n; i++)
+  {
+    _radius[i] = fx::fromFloat(table._config.sphereRadius * b.size[i]);
+  }
+  int numPockets = (int) table._pockets.size();
+  _pocketX.resize(numPockets);
+  _pocketY.resize(numPockets);
+  _pocketZ.resize(numPockets);
+  for (int p = 0; p < numPockets; p++)
+  {
+    _pocketX[p] = fx::fromFloat(table._pockets[p].x);
+    _pocketY[p] = fx::fromFloat(table._pockets[p].y);
+    _pocketZ[p] = fx::fromFloat(table._pockets[p].z);
+  }
+  _glorbX = fx::fromFloat(table._glorbPos.x);
+  _glorbY = fx::fromFloat(table._glorbPos.y);
+  _glorbZ = fx::fromFloat(table._glorbPos.z);
+
+  // pockets and glorb first, as in Table::fixedStep
+  for (int i = 0; i < n; i++)
+  {
+    b.flags[i] &= ~BALL_CAPTURED;
+    if (table.isDevoured(i) || table.isSleeping(i)) continue;
+    if (table.isSinking(i)) glorb(table, i);
+    else pocket(table, i);
+  }
+
+  // the broadphase works on the rounded floats, but it only narrows down
+  // the pairs, which come out in the same order whatever it rounds to
+  publish(table);
+  table._broadphase.update(b, table._config.sphereRadius);
+  const vector<pair<int, int> >& pairs = table._broadphase.pairs();
+  table._pairTests = 0;
+  for (int p = 0; p < (int) pairs.size(); p++)
+  {
+    int i = pairs[p].first;
+    int j = pairs[p].second;
+    if (!b.isFree(i)) continue;
+    if (b.flags[i] & b.flags[j] & BALL_SLEEPING) continue;
+    collision(table, i, j);
+    table._pairTests++;
+  }
+
+  for (int i = 0; i < n; i++)
+  {
+    if (!b.isAwake(i)) continue;
+    if (_geometry) cushions<Active>(table, i);
+    else boundary<Active>(table, i);
+  }
+
+  fixed tilt = table._tiltDir.x < 0 ? -one : one;
+  fixed friction = fx::fromFloat(Rules::friction());
+  for (int i = 0; i < n; i++)
+  {
+    if (b.flags[i] != 0) continue;
+    if (Rules::stepsBalls) Rules::step(_vx[i], _vy[i], tilt);
+    _vx[i] = mul(_vx[i], friction);
+    _vy[i] = mul(_vy[i], friction);
+    _vz[i] = mul(_vz[i], friction);
+  }
+
+  fixed hoverFloor = fx::fromInt(40);
+  float ballDefaultSize = table._config.ballDefaultSize;
+  for (int i = 0; i < n; i++)
+  {
+    if (b.isFree(i) && _pz[i] < hoverFloor && b.size[i] == ballDefaultSize)
+    {
+      _pz[i] = 0;
+      _vz[i] = 0;
+    }
+  }
+
+  // the rotation is only drawn, so it stays in floats, one operation per
+  // statement so that no compiler fuses them
+  fixed dt = fx::fromFloat(table._config.fixedDt);
+  float rollScale = 1.0f / table._config.sphereRadius;
+  for (int i = 0; i < n; i++)
+  {
+    if (b.flags[i] & (BALL_DEVOURED | BALL_SLEEPING)) continue;
+    fixed dx = mul(_vx[i], dt);
+    fixed dy = mul(_vy[i], dt);
+    _px[i] += dx;
+    _py[i] += dy;
+    _pz[i] += mul(_vz[i], dt);
+    float roll = rollScale / b.size[i];
+    float turnX = -fx::toFloat(dy) * roll;
+    float turnY = fx::toFloat(dx) * roll;
+    b.rotX[i] += turnX;
+    b.rotY[i] += turnY;
+  }
+  publish(table);
+}
+
+bool FixedPointSolver::collision(Table& table, int i, int j)
+{
+  BallArrays& b = table._balls;
+  if (b.flags[j] & (BALL_SINKING | BALL_DEVOURED)) return false;
+
+  fixed dx = _px[i] - _px[j];
+  fixed dy = _py[i] - _py[j];
+  fixed dz = _pz[i] - _pz[j];
+  fixed ri = _radius[i];
+  fixed rj = _radius[j];
+  // the root is rounded down, so comparing squares first gives the same
+  // answer without taking it for every pair
+  fixed touching = ri + rj - one;
+  int64_t distSq = mulWide(dx, dx) + mulWide(dy, dy) + mulWide(dz, dz);
+  if (touching <= 0 || distSq >= mulWide(touching, touching)) return false;
+  fixed overlap = ri + rj - fx::sqrtWide(distSq);
+
+  table.wake(i);
+  table.wake(j);
+  // normal between the balls as if both rested on the table
+  fixed nz = dz - (ri - rj);
+  fixed length = fx::sqrtWide(mulWide(dx, dx) + mulWide(dy, dy) + mulWide(nz, nz));
+  fixed nx = one, ny = 0;
+  if (length > 0)
+  {
+    nx = fx::div(dx, length);
+    ny = fx::div(dy, length);
+    nz = fx::div(nz, length);
+  }
+  else
+  {
+    nz = 0;
+  }
+  fixed push = overlap / 2;
+  fixed pushX = mul(nx, push), pushY = mul(ny, push), pushZ = mul(nz, push);
+  _px[i] += pushX; _py[i] += pushY; _pz[i] += pushZ;
+  _px[j] -= pushX; _py[j] -= pushY; _pz[j] -= pushZ;
+
+  fixed along1 = (fixed) ((mulWide(_vx[i], nx) + mulWide(_vy[i], ny) + mulWide(_vz[i], nz)) / one);
+  fixed along2 = (fixed) ((mulWide(_vx[j], nx) + mulWide(_vy[j], ny) + mulWide(_vz[j], nz)) / one);
+  fixed exchange = along2 - along1;
+  fixed exX = mul(nx, exchange), exY = mul(ny, exchange), exZ = mul(nz, exchange);
+  _vx[i] += exX; _vy[i] += exY; _vz[i] += exZ;
+  _vx[j] -= exX; _vy[j] -= exY; _vz[j] -= exZ;
+  table.recordCollision(i, j);
+  return true;
+}
+
+template <ChaosSet Active>
+void FixedPointSolver::boundary(Table& table, int i)
+{
+  const TableConfig& config = table._config;
+  fixed ballRadius = _radius[i];
+  fixed& posX = _px[i];
+  fixed& posY = _py[i];
+  fixed& velX = _vx[i];
+  fixed& velY = _vy[i];
+  // the thresholds are whole or half units
+  fixed xThresh = fx::fromInt(config.tableLength - 75) / 2;
+  fixed ballLeft = posX - ballRadius;
+  fixed ballRight = posX + ballRadius;
+  if (ballLeft < -xThresh || ballRight > xThresh)
+  {
+    if (ballLeft < -xThresh) posX += -xThresh - ballLeft;
+    else if (ballRight > xThresh) posX -= ballRight - xThresh;
+    velX = -velX;
+    ChaosRules<Active>::onBoundary(velX, velY);
+    table._events.boundaryHits += 1;
+  }
+  fixed yThresh = fx::fromInt(config.tableWidth - 75) / 2;
+  fixed ballBottom = posY - ballRadius;
+  fixed ballTop = posY + ballRadius;
+  if (posY < -yThresh || posY > yThresh)
+  {
+    if (ballBottom < -yThresh) posY += -yThresh - ballBottom;
+    else if (ballTop > yThresh) posY -= ballTop - yThresh;
+    velY = -velY;
+    ChaosRules<Active>::onBoundary(velX, velY);
+    table._events.boundaryHits += 1;
+  }
+}
+
+template <ChaosSet Active>
+void FixedPointSolver::cushions(Table& table, int i)
+{
+  fixed ballRadius = _radius[i];
+  fixed pos[2] = {_px[i], _py[i]};
+  fixed vel[2] = {_vx[i], _vy[i]};
+
+  // a ball that went through a cushion in one step, see Table::cushionDetection
+  fixed play[2] = {_playX - ballRadius, _playY - ballRadius};
+  fixed rail[2] = {_railX, _railY};
+  for (int axis = 0; axis < 2; axis++)
+  {
+    if (std::abs(pos[axis]) <= rail[axis]) continue;
+    pos[axis] = pos[axis] < 0 ? -play[axis] : play[axis];
+    vel[axis] = -vel[axis];
+    ChaosRules<Active>::onBoundary(vel[0], vel[1]);
+    table._events.boundaryHits += 1;
+  }
+
+  bool nearCushion = std::abs(pos[0]) >= play[0] || std::abs(pos[1]) >= play[1];
+  int64_t radiusSq = mulWide(ballRadius, ballRadius);
+  for (int pass = 0; nearCushion && pass < 2; pass++)
+  {
+    int s = -1;
+    int64_t distSq = numeric_limits<int64_t>::max();
+    fixed closest[2] = {0, 0};
+    for (int k = 0; k < (int) _sax.size(); k++)
+    {
+      fixed cx, cy;
+      int64_t d = closestOnSegment(_sax[k], _say[k], _sdx[k], _sdy[k], pos[0], pos[1], cx, cy);
+      if (d < distSq)
+      {
+        distSq = d;
+        s = k;
+        closest[0] = cx;
+        closest[1] = cy;
+      }
+    }
+    if (s < 0 || distSq >= radiusSq) break;
+
+    fixed edge = fx::sqrtWide(mulWide(_sdx[s], _sdx[s]) + mulWide(_sdy[s], _sdy[s]));
+    fixed outside[2] = {fx::div(_sdy[s], edge), fx::div(-_sdx[s], edge)};
+    fixed away[2] = {pos[0] - closest[0], pos[1] - closest[1]};
+    fixed normal[2] = {outside[0], outside[1]};
+    fixed dist = fx::sqrtWide(distSq);
+    if (dist > 0 && mulWide(away[0], outside[0]) + mulWide(away[1], outside[1]) > 0)
+    {
+      normal[0] = fx::div(away[0], dist);
+      normal[1] = fx::div(away[1], dist);
+    }
+    pos[0] = closest[0] + mul(normal[0], ballRadius);
+    pos[1] = closest[1] + mul(normal[1], ballRadius);
+    fixed approach = (fixed) ((mulWide(vel[0], normal[0]) + mulWide(vel[1], normal[1])) / one);
+    if (approach < 0)
+    {
+      vel[0] -= 2 * mul(approach, normal[0]);
+      vel[1] -= 2 * mul(approach, normal[1]);
+    }
+    ChaosRules<Active>::onBoundary(vel[0], vel[1]);
+    table._events.boundaryHits += 1;
+  }
+
+  _px[i] = pos[0];
+  _py[i] = pos[1];
+  _vx[i] = vel[0];
+  _vy[i] = vel[1];
+}
+
+bool FixedPointSolver::inPocketMouth(const Table& table, int i, int p, int64_t distSq) const
+{
+  fixed ballRadius = _radius[i];
+  fixed range = _reach[p] + ballRadius;
+  if (_pz[i] >= fx::fromInt(40) || distSq >= mulWide(range, range)) return false;
+  int64_t radiusSq = mulWide(ballRadius, ballRadius);
+  fixed cx, cy;
+  if (closestOnSegment(_jawAX[p], _jawAY[p], _jawBX[p] - _jawAX[p], _jawBY[p] - _jawAY[p],
+    _px[i], _py[i], cx, cy) < radiusSq) return true;
+
+  // the throat runs from the middle of the mouth to the hole
+  fixed mouthX = _jawAX[p] + (_jawBX[p] - _jawAX[p]) / 2;
+  fixed mouthY = _jawAY[p] + (_jawBY[p] - _jawAY[p]) / 2;
+  return closestOnSegment(mouthX, mouthY, _holeX[p] - mouthX, _holeY[p] - mouthY,
+    _px[i], _py[i], cx, cy) < radiusSq;
+}
+
+bool FixedPointSolver::pocket(Table& table, int i)
+{
+  const TableConfig& config = table._config;
+  // the float rule compares with these integer quotients too; distances
+  // are compared squared, which is the same as comparing the rounded-down
+  // roots
+  fixed sinkRange = fx::fromInt(config.viewVolumeSide / 150);
+  fixed captureRange = fx::fromInt(config.viewVolumeSide / 50);
+  int64_t sinkRangeSq = mulWide(sinkRange, sinkRange);
+  int64_t captureRangeSq = mulWide(captureRange, captureRange);
+  for (int p = 0; p < (int) table._pockets.size(); p++)
+  {
+    fixed toX = _pocketX[p] - _px[i];
+    fixed toY = _pocketY[p] - _py[i];
+    fixed toZ = _pocketZ[p] - _pz[i];
+    int64_t distSq = mulWide(toX, toX) + mulWide(toY, toY) + mulWide(toZ, toZ);
+    if (distSq < sinkRangeSq)
+    {
+      sink(table, i);
+      return true;
+    }
+    else if (_geometry ? inPocketMouth(table, i, p, distSq) : distSq < captureRangeSq)
+    {
+      _vx[i] = 10 * toX;
+      _vy[i] = 10 * toY;
+      _vz[i] = 10 * toZ;
+      table._balls.flags[i] |= BALL_CAPTURED;
+      return true;
+    }
+  }
+  return false;
+}
+
+void FixedPointSolver::sink(Table& table, int i)
+{
+  BallArrays& b = table._balls;
+  table._events.pocketed += 1;
+  table._events.lastPocketedId = b.id[i];
+  _vx[i] = (_glorbX - _px[i]) / 2;
+  _vy[i] = (_glorbY - _py[i]) / 2;
+  _vz[i] = (_glorbZ - _pz[i]) / 2;
+  b.size[i] *= 2;
+  _radius[i] *= 2;
+  b.flags[i] |= BALL_SINKING;
+}
+
+void FixedPointSolver::glorb(Table& table, int i)
+{
+  BallArrays& b = table._balls;
+  fixed glorbRadius = fx::fromFloat(table._config.glorbScale * table._eyeDiameterModifier * 0.5);
+  fixed toX = _glorbX - _px[i];
+  fixed toY = _glorbY - _py[i];
+  fixed toZ = _glorbZ - _pz[i];
+  int64_t reach = (int64_t) glorbRadius + 1;
+  if (mulWide(toX, toX) + mulWide(toY, toY) + mulWide(toZ, toZ) < reach * reach)
+  {
+    _px[i] = 0;
+    _py[i] = fx::fromInt(1000);
+    _pz[i] = fx::fromInt(200);
+    _vx[i] = _vy[i] = _vz[i] = 0;
+    b.size[i] = 0;
+    _radius[i] = 0;
+    b.flags[i] = BALL_DEVOURED;
+    table._eyeDiameterModifier += 0.02;
+    table._numBallsSunk += 1;
+    table._events.devoured += 1;
+  }
+}
+
+}  // namespace poolsim
@@ -0,0 +1,115 @@
+/**
+ * @file fixedsolver.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Fixed-step solver in Q16.16 integers for bit-exact runs
+ */
+
+#ifndef POOLSIM_FIXEDSOLVER_H_
+#define POOLSIM_FIXEDSOLVER_H_
+
+#include "poolsim/chaos.h"
+#include "poolsim/fixedpoint.h"
+#include <cstdint>
+#include <vector>
+
+namespace poolsim {
+
+class Table;
+struct BallArrays;
+struct TableGeometry;
+
+/**
+ * Plays the fixed-step rules of Table::fixedStep with positions and
+ * velocities held as Q16.16 integers, see fixedpoint.h. Collisions,
+ * cushions, pockets, friction and integration use integer arithmetic only,
+ * down to the square roots, so the result depends on nothing but the
+ * inputs: not on the compiler, its flags, the kernels picked for the CPU or
+ * the thread a table runs on.
+ *
+ * The integers are the real state, and the float BallArrays of the table
+ * are rounded from them after every step for drawing and hashing. Anything
+ * that writes a float position or velocity from outside, such as a launch
+ * or a status effect, is noticed at the next step by comparing the floats
+ * with what was last written, and only the changed values are taken over.
+ */
+class FixedPointSolver
+{
+public:
+    /**
+    * Sizes the state for n balls, all of which are taken from the floats at
+    * the next step.
+    */
+    void resize(int n);
+
+    /**
+    * Runs one fixed step of the table.
+    */
+    void step(Table& table);
+
+    /**
+    * Squared speed of ball i with 32 fraction bits, see fx::mulWide,
+    * counting a velocity written since the last step.
+    */
+    int64_t speedSq(const Table& table, int i) const;
+
+    /**
+    * Appends the arrays a snapshot of the table must hold to restore the
+    * integers exactly.
+    *
+    * @param data Filled with a pointer to each array.
+    * @param bytes Filled with the size of each array.
+    * @return The number of arrays, at most numArrays.
+    */
+    int arrays(void** data, size_t* bytes) const;
+    static const int numArrays = 12;
+
+private:
+    /**
+    * Takes over every float that changed since it was last written.
+    */
+    void adopt(Table& table);
+
+    /**
+    * Rounds the integers to the floats of the table.
+    */
+    void publish(Table& table);
+
+    /**
+    * Converts the traced cushions and pockets, once per geometry.
+    */
+    void loadGeometry(const TableGeometry* geometry);
+
+    /**
+    * step for the given active effects, see ChaosRules.
+    */
+    template <ChaosSet Active>
+    void stepWith(Table& table);
+
+    bool collision(Table& table, int i, int j);
+    template <ChaosSet Active>
+    void boundary(Table& table, int i);
+    template <ChaosSet Active>
+    void cushions(Table& table, int i);
+    bool inPocketMouth(const Table& table, int i, int p, int64_t distSq) const;
+    bool pocket(Table& table, int i);
+    void glorb(Table& table, int i);
+    void sink(Table& table, int i);
+
+    std::vector<fixed> _px, _py, _pz, _vx, _vy, _vz;
+    // the floats as last written, to tell when something else wrote them
+    std::vector<float> _fpx, _fpy, _fpz, _fvx, _fvy, _fvz;
+
+    // per step copies of what the table holds in floats
+    std::vector<fixed> _radius, _pocketX, _pocketY, _pocketZ;
+    fixed _glorbX = 0, _glorbY = 0, _glorbZ = 0;
+
+    const TableGeometry* _geometry = nullptr;
+    std::vector<fixed> _sax, _say, _sdx, _sdy;
+    std::vector<fixed> _jawAX, _jawAY, _jawBX, _jawBY, _holeX, _holeY, _reach;
+    fixed _playX = 0, _playY = 0, _railX = 0, _railY = 0;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_FIXEDSOLVER_H_
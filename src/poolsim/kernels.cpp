@@ -0,0 +1,160 @@
+/**
+ * @file kernels.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Scalar step kernels and runtime kernel selection
+ */
+
+#include "poolsim/kernels.h"
+#include "poolsim/random.h"
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace poolsim {
+
+static void integrateScalar(BallArrays& b, int n, float dt, float rollScale)
+{
+  for (int i = 0; i < n; i++)
+  {
+    if (b.flags[i] & (BALL_DEVOURED | BALL_SLEEPING)) continue;
+    float dx = b.velX[i] * dt;
+    float dy = b.velY[i] * dt;
+    float dz = b.velZ[i] * dt;
+    b.posX[i] += dx;
+    b.posY[i] += dy;
+    b.posZ[i] += dz;
+    float roll = rollScale / b.size[i];
+    b.rotX[i] += -dy * roll;
+    b.rotY[i] += dx * roll;
+  }
+}
+
+static void frictionScalar(BallArrays& b, int n, float factor)
+{
+  for (int i = 0; i < n; i++)
+  {
+    if (b.flags[i] != 0) continue;
+    b.velX[i] *= factor;
+    b.velY[i] *= factor;
+    b.velZ[i] *= factor;
+  }
+}
+
+static void tiltScalar(BallArrays& b, int n, float tiltX)
+{
+  for (int i = 0; i < n; i++)
+  {
+    if (b.flags[i] != 0) continue;
+    b.velX[i] += tiltX;
+  }
+}
+
+static int nearestSegmentScalar(const SegmentArrays& s, float px, float py, float& distSq)
+{
+  int best = -1;
+  float bestSq = std::numeric_limits<float>::max();
+  for (int k = 0; k < s.count; k++)
+  {
+    float rx = px - s.ax[k];
+    float ry = py - s.ay[k];
+    float t = (rx * s.dx[k] + ry * s.dy[k]) * s.invLengthSq[k];
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+    float ex = rx - t * s.dx[k];
+    float ey = ry - t * s.dy[k];
+    float d = ex * ex + ey * ey;
+    if (d < bestSq)
+    {
+      bestSq = d;
+      best = k;
+    }
+  }
+  distSq = bestSq;
+  return best;
+}
+
+static uint64_t pcgFillScalar(uint64_t state, uint64_t inc, uint32_t* out, int count)
+{
+  for (int k = 0; k < count; k++)
+  {
+    out[k] = Pcg32::output(state);
+    state = state * Pcg32::multiplier + inc;
+  }
+  return state;
+}
+
+const KernelSet& scalarKernels()
+{
+  static const KernelSet set = {"scalar", integrateScalar, frictionScalar, tiltScalar, nearestSegmentScalar,
+    pcgFillScalar};
+  return set;
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) return false;
+  __cpuid(info, 1);
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx) return false;
+  // the OS must save the upper halves of the ymm registers
+  if ((_xgetbv(0) & 0x6) != 0x6) return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+bool cpuHasAvx512()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) return false;
+  __cpuid(info, 1);
+  if ((info[2] & (1 << 27)) == 0) return false;
+  // the OS must save the opmask and zmm registers as well as the ymm ones
+  if ((_xgetbv(0) & 0xe6) != 0xe6) return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 16)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f");
+#else
+  return false;
+#endif
+}
+
+static const KernelSet& selectKernels()
+{
+  const char* choice = getenv("POOLSIM_KERNELS");
+  if (choice != NULL)
+  {
+    if (strcmp(choice, "avx2") == 0 && avx2Kernels() && cpuHasAvx2()) return *avx2Kernels();
+    if (strcmp(choice, "sse") == 0 && sseKernels()) return *sseKernels();
+    return scalarKernels();
+  }
+  if (avx2Kernels() && cpuHasAvx2()) return *avx2Kernels();
+  if (sseKernels()) return *sseKernels();
+  return scalarKernels();
+}
+
+const KernelSet& kernels()
+{
+  static const KernelSet& set = selectKernels();
+  return set;
+}
+
+}  // namespace poolsim
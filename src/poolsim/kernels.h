@@ -0,0 +1,84 @@
+/**
+ * @file kernels.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Per-ball step and random kernels with scalar, SSE2 and AVX2 implementations
+ */
+
+#ifndef POOLSIM_KERNELS_H_
+#define POOLSIM_KERNELS_H_
+
+#include "poolsim/balls.h"
+#include "poolsim/segments.h"
+
+namespace poolsim {
+
+/**
+ * One implementation of each kernel. All kernels run over the first n balls
+ * and leave balls that are not awake (see BallFlag) untouched, except for
+ * integrate, which moves every ball that is neither devoured nor sleeping.
+ */
+struct KernelSet
+{
+  const char* name;
+
+  /**
+  * Moves each ball by vel * dt and rolls it by the distance travelled, one
+  * full turn per circumference.
+  *
+  * @param rollScale Radians per unit travelled for a ball of size 1.
+  */
+  void (*integrate)(BallArrays& balls, int n, float dt, float rollScale);
+
+  /**
+  * Scales the velocity of each free ball by the friction factor.
+  */
+  void (*friction)(BallArrays& balls, int n, float factor);
+
+  /**
+  * Adds the tilt to the x-velocity of each free ball.
+  */
+  void (*tilt)(BallArrays& balls, int n, float tiltX);
+
+  /**
+  * Finds the segment nearest to a point, ties going to the lower index.
+  *
+  * @param distSq Set to the squared distance to that segment.
+  * @return The segment's index, or -1 if there are no segments.
+  */
+  int (*nearestSegment)(const SegmentArrays& segments, float px, float py, float& distSq);
+
+  /**
+  * Writes the next count draws of a Pcg32 with the given state and
+  * increment, see Pcg32::generate. SSE2 has no per-lane shifts for the
+  * output rotation, so its set uses the scalar one.
+  *
+  * @return The state after the last draw.
+  */
+  uint64_t (*pcgFill)(uint64_t state, uint64_t inc, uint32_t* out, int count);
+};
+
+const KernelSet& scalarKernels();
+
+/**
+ * The SSE2 and AVX2 sets are null when not compiled in for this target.
+ */
+const KernelSet* sseKernels();
+const KernelSet* avx2Kernels();
+
+/**
+ * The fastest set the CPU supports, picked once on first use. Setting the
+ * POOLSIM_KERNELS environment variable to scalar, sse or avx2 overrides the
+ * choice, falling back to scalar if that set is unavailable.
+ */
+const KernelSet& kernels();
+
+/**
+ * Whether the CPU and OS support AVX2 and AVX-512F, checked at run time.
+ */
+bool cpuHasAvx2();
+bool cpuHasAvx512();
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_KERNELS_H_
@@ -0,0 +1,245 @@
+/**
+ * @file kernels_avx2.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief AVX2 step kernels, eight balls or random draws at a time
+ *
+ * This file is compiled with AVX2 enabled (see CMakeLists.txt) and is only
+ * called after kernels() has checked that the CPU supports it.
+ */
+
+#include "poolsim/kernels.h"
+#include "poolsim/random.h"
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace poolsim {
+
+#if defined(__AVX2__)
+
+// all ones in the lanes whose flags are zero
+static inline __m256 freeMask(const uint32_t* flags)
+{
+  __m256i f = _mm256_loadu_si256((const __m256i*) flags);
+  return _mm256_castsi256_ps(_mm256_cmpeq_epi32(f, _mm256_setzero_si256()));
+}
+
+static void integrateAvx2(BallArrays& b, int n, float dt, float rollScale)
+{
+  const __m256 vdt = _mm256_set1_ps(dt);
+  const __m256 vroll = _mm256_set1_ps(rollScale);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256i still = _mm256_set1_epi32(BALL_DEVOURED | BALL_SLEEPING);
+  int i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    __m256i f = _mm256_loadu_si256((const __m256i*) &b.flags[i]);
+    __m256 live = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(f, still), _mm256_setzero_si256()));
+    __m256 size = _mm256_loadu_ps(&b.size[i]);
+    // devoured balls have no size, so mask them after dividing; sleeping
+    // ones stay put
+    __m256 roll = _mm256_blendv_ps(zero, _mm256_div_ps(vroll, size), live);
+    __m256 dx = _mm256_and_ps(live, _mm256_mul_ps(_mm256_loadu_ps(&b.velX[i]), vdt));
+    __m256 dy = _mm256_and_ps(live, _mm256_mul_ps(_mm256_loadu_ps(&b.velY[i]), vdt));
+    __m256 dz = _mm256_and_ps(live, _mm256_mul_ps(_mm256_loadu_ps(&b.velZ[i]), vdt));
+    _mm256_storeu_ps(&b.posX[i], _mm256_add_ps(_mm256_loadu_ps(&b.posX[i]), dx));
+    _mm256_storeu_ps(&b.posY[i], _mm256_add_ps(_mm256_loadu_ps(&b.posY[i]), dy));
+    _mm256_storeu_ps(&b.posZ[i], _mm256_add_ps(_mm256_loadu_ps(&b.posZ[i]), dz));
+    _mm256_storeu_ps(&b.rotX[i], _mm256_sub_ps(_mm256_loadu_ps(&b.rotX[i]), _mm256_mul_ps(dy, roll)));
+    _mm256_storeu_ps(&b.rotY[i], _mm256_add_ps(_mm256_loadu_ps(&b.rotY[i]), _mm256_mul_ps(dx, roll)));
+  }
+  for (; i < n; i++)
+  {
+    if (b.flags[i] & (BALL_DEVOURED | BALL_SLEEPING)) continue;
+    float dx = b.velX[i] * dt;
+    float dy = b.velY[i] * dt;
+    b.posX[i] += dx;
+    b.posY[i] += dy;
+    b.posZ[i] += b.velZ[i] * dt;
+    float roll = rollScale / b.size[i];
+    b.rotX[i] += -dy * roll;
+    b.rotY[i] += dx * roll;
+  }
+}
+
+static void frictionAvx2(BallArrays& b, int n, float factor)
+{
+  const __m256 vf = _mm256_set1_ps(factor);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  int i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    __m256 f = _mm256_blendv_ps(one, vf, freeMask(&b.flags[i]));
+    _mm256_storeu_ps(&b.velX[i], _mm256_mul_ps(_mm256_loadu_ps(&b.velX[i]), f));
+    _mm256_storeu_ps(&b.velY[i], _mm256_mul_ps(_mm256_loadu_ps(&b.velY[i]), f));
+    _mm256_storeu_ps(&b.velZ[i], _mm256_mul_ps(_mm256_loadu_ps(&b.velZ[i]), f));
+  }
+  for (; i < n; i++)
+  {
+    if (b.flags[i] != 0) continue;
+    b.velX[i] *= factor;
+    b.velY[i] *= factor;
+    b.velZ[i] *= factor;
+  }
+}
+
+static void tiltAvx2(BallArrays& b, int n, float tiltX)
+{
+  const __m256 vt = _mm256_set1_ps(tiltX);
+  int i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    __m256 t = _mm256_and_ps(freeMask(&b.flags[i]), vt);
+    _mm256_storeu_ps(&b.velX[i], _mm256_add_ps(_mm256_loadu_ps(&b.velX[i]), t));
+  }
+  for (; i < n; i++)
+  {
+    if (b.flags[i] == 0) b.velX[i] += tiltX;
+  }
+}
+
+static int nearestSegmentAvx2(const SegmentArrays& s, float px, float py, float& distSq)
+{
+  if (s.count == 0)
+  {
+    distSq = std::numeric_limits<float>::max();
+    return -1;
+  }
+  const __m256 vpx = _mm256_set1_ps(px);
+  const __m256 vpy = _mm256_set1_ps(py);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+  __m256 bestSq = _mm256_set1_ps(std::numeric_limits<float>::max());
+  __m256i best = _mm256_set1_epi32(-1);
+  __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i eight = _mm256_set1_epi32(8);
+  // the arrays are padded to a multiple of eight, so whole vectors are safe
+  for (int k = 0; k < s.count; k += 8)
+  {
+    __m256 dx = _mm256_loadu_ps(&s.dx[k]);
+    __m256 dy = _mm256_loadu_ps(&s.dy[k]);
+    __m256 rx = _mm256_sub_ps(vpx, _mm256_loadu_ps(&s.ax[k]));
+    __m256 ry = _mm256_sub_ps(vpy, _mm256_loadu_ps(&s.ay[k]));
+    __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(rx, dx), _mm256_mul_ps(ry, dy)), _mm256_loadu_ps(&s.invLengthSq[k]));
+    t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+    __m256 ex = _mm256_sub_ps(rx, _mm256_mul_ps(t, dx));
+    __m256 ey = _mm256_sub_ps(ry, _mm256_mul_ps(t, dy));
+    __m256 d = _mm256_add_ps(_mm256_mul_ps(ex, ex), _mm256_mul_ps(ey, ey));
+    __m256 closer = _mm256_cmp_ps(d, bestSq, _CMP_LT_OQ);
+    bestSq = _mm256_blendv_ps(bestSq, d, closer);
+    best = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(best), _mm256_castsi256_ps(index), closer));
+    index = _mm256_add_epi32(index, eight);
+  }
+  // each lane saw its own indices in order, so taking the lowest index
+  // among the closest lanes gives the same answer as the scalar loop
+  float lanesSq[8];
+  int32_t lanes[8];
+  _mm256_storeu_ps(lanesSq, bestSq);
+  _mm256_storeu_si256((__m256i*) lanes, best);
+  int result = -1;
+  float resultSq = std::numeric_limits<float>::max();
+  for (int l = 0; l < 8; l++)
+  {
+    if (lanes[l] < 0 || lanes[l] >= s.count) continue;
+    if (lanesSq[l] < resultSq || (lanesSq[l] == resultSq && lanes[l] < result))
+    {
+      resultSq = lanesSq[l];
+      result = lanes[l];
+    }
+  }
+  distSq = resultSq;
+  return result;
+}
+
+// a * b for four 64-bit lanes, from 32-bit multiplies, with the high
+// halves of b already shifted down
+static inline __m256i mul64(__m256i a, __m256i b, __m256i bHigh)
+{
+  __m256i lo = _mm256_mul_epu32(a, b);
+  __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), _mm256_mul_epu32(a, bHigh));
+  return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+// Pcg32::output of the eight states in a and b, as a0 a1 b0 b1 a2 a3 b2 b3:
+// the xorshift is done in 64-bit lanes, then the low halves are packed
+// so that the rotate runs on all eight draws at once
+static inline __m256i pcgOutput(__m256i a, __m256i b)
+{
+  __m256i xa = _mm256_srli_epi64(_mm256_xor_si256(_mm256_srli_epi64(a, 18), a), 27);
+  __m256i xb = _mm256_srli_epi64(_mm256_xor_si256(_mm256_srli_epi64(b, 18), b), 27);
+  __m256i x = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(xa), _mm256_castsi256_ps(xb),
+    _MM_SHUFFLE(2, 0, 2, 0)));
+  // the top five bits of each state, from its high half
+  __m256i high = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b),
+    _MM_SHUFFLE(3, 1, 3, 1)));
+  __m256i rot = _mm256_srli_epi32(high, 27);
+  __m256i right = _mm256_srlv_epi32(x, rot);
+  __m256i left = _mm256_sllv_epi32(x, _mm256_sub_epi32(_mm256_set1_epi32(32), rot));
+  return _mm256_or_si256(right, left);
+}
+
+static uint64_t pcgFillAvx2(uint64_t state, uint64_t inc, uint32_t* out, int count)
+{
+  int k = 0;
+  if (count >= 32)
+  {
+    // four vectors hold sixteen consecutive states, and each pass takes
+    // all of them sixteen draws ahead; the four multiplies do not depend on
+    // each other, so their latency overlaps
+    uint64_t states[16];
+    for (int l = 0; l < 16; l++)
+    {
+      states[l] = state;
+      state = state * Pcg32::multiplier + inc;
+    }
+    uint64_t mult;
+    uint64_t add;
+    pcgJump(16, inc, mult, add);
+    const __m256i vmult = _mm256_set1_epi64x((long long) mult);
+    const __m256i vmultHigh = _mm256_srli_epi64(vmult, 32);
+    const __m256i vadd = _mm256_set1_epi64x((long long) add);
+    __m256i s0 = _mm256_loadu_si256((const __m256i*) &states[0]);
+    __m256i s1 = _mm256_loadu_si256((const __m256i*) &states[4]);
+    __m256i s2 = _mm256_loadu_si256((const __m256i*) &states[8]);
+    __m256i s3 = _mm256_loadu_si256((const __m256i*) &states[12]);
+    for (; k + 16 <= count; k += 16)
+    {
+      __m256i outA = _mm256_permute4x64_epi64(pcgOutput(s0, s1), _MM_SHUFFLE(3, 1, 2, 0));
+      __m256i outB = _mm256_permute4x64_epi64(pcgOutput(s2, s3), _MM_SHUFFLE(3, 1, 2, 0));
+      _mm256_storeu_si256((__m256i*) &out[k], outA);
+      _mm256_storeu_si256((__m256i*) &out[k + 8], outB);
+      s0 = _mm256_add_epi64(mul64(s0, vmult, vmultHigh), vadd);
+      s1 = _mm256_add_epi64(mul64(s1, vmult, vmultHigh), vadd);
+      s2 = _mm256_add_epi64(mul64(s2, vmult, vmultHigh), vadd);
+      s3 = _mm256_add_epi64(mul64(s3, vmult, vmultHigh), vadd);
+    }
+    _mm256_storeu_si256((__m256i*) &states[0], s0);
+    state = states[0];
+  }
+  for (; k < count; k++)
+  {
+    out[k] = Pcg32::output(state);
+    state = state * Pcg32::multiplier + inc;
+  }
+  return state;
+}
+
+const KernelSet* avx2Kernels()
+{
+  static const KernelSet set = {"avx2", integrateAvx2, frictionAvx2, tiltAvx2, nearestSegmentAvx2, pcgFillAvx2};
+  return &set;
+}
+
+#else
+
+const KernelSet* avx2Kernels()
+{
+  return nullptr;
+}
+
+#endif
+
+}  // namespace poolsim
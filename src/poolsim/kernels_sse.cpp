@@ -0,0 +1,175 @@
+/**
+ * @file kernels_sse.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief SSE2 step kernels, four balls at a time
+ */
+
+#include "poolsim/kernels.h"
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define POOLSIM_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace poolsim {
+
+#ifdef POOLSIM_HAVE_SSE2
+
+// all ones in the lanes whose flags are zero
+static inline __m128 freeMask(const uint32_t* flags)
+{
+  __m128i f = _mm_loadu_si128((const __m128i*) flags);
+  return _mm_castsi128_ps(_mm_cmpeq_epi32(f, _mm_setzero_si128()));
+}
+
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static void integrateSse(BallArrays& b, int n, float dt, float rollScale)
+{
+  const __m128 vdt = _mm_set1_ps(dt);
+  const __m128 vroll = _mm_set1_ps(rollScale);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128i still = _mm_set1_epi32(BALL_DEVOURED | BALL_SLEEPING);
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128i f = _mm_loadu_si128((const __m128i*) &b.flags[i]);
+    __m128 live = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(f, still), _mm_setzero_si128()));
+    __m128 size = _mm_loadu_ps(&b.size[i]);
+    // devoured balls have no size, so mask them after dividing; sleeping
+    // ones stay put
+    __m128 roll = select(live, _mm_div_ps(vroll, size), zero);
+    __m128 dx = _mm_and_ps(live, _mm_mul_ps(_mm_loadu_ps(&b.velX[i]), vdt));
+    __m128 dy = _mm_and_ps(live, _mm_mul_ps(_mm_loadu_ps(&b.velY[i]), vdt));
+    __m128 dz = _mm_and_ps(live, _mm_mul_ps(_mm_loadu_ps(&b.velZ[i]), vdt));
+    _mm_storeu_ps(&b.posX[i], _mm_add_ps(_mm_loadu_ps(&b.posX[i]), dx));
+    _mm_storeu_ps(&b.posY[i], _mm_add_ps(_mm_loadu_ps(&b.posY[i]), dy));
+    _mm_storeu_ps(&b.posZ[i], _mm_add_ps(_mm_loadu_ps(&b.posZ[i]), dz));
+    _mm_storeu_ps(&b.rotX[i], _mm_sub_ps(_mm_loadu_ps(&b.rotX[i]), _mm_mul_ps(dy, roll)));
+    _mm_storeu_ps(&b.rotY[i], _mm_add_ps(_mm_loadu_ps(&b.rotY[i]), _mm_mul_ps(dx, roll)));
+  }
+  for (; i < n; i++)
+  {
+    if (b.flags[i] & (BALL_DEVOURED | BALL_SLEEPING)) continue;
+    float dx = b.velX[i] * dt;
+    float dy = b.velY[i] * dt;
+    b.posX[i] += dx;
+    b.posY[i] += dy;
+    b.posZ[i] += b.velZ[i] * dt;
+    float roll = rollScale / b.size[i];
+    b.rotX[i] += -dy * roll;
+    b.rotY[i] += dx * roll;
+  }
+}
+
+static void frictionSse(BallArrays& b, int n, float factor)
+{
+  const __m128 vf = _mm_set1_ps(factor);
+  const __m128 one = _mm_set1_ps(1.0f);
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128 f = select(freeMask(&b.flags[i]), vf, one);
+    _mm_storeu_ps(&b.velX[i], _mm_mul_ps(_mm_loadu_ps(&b.velX[i]), f));
+    _mm_storeu_ps(&b.velY[i], _mm_mul_ps(_mm_loadu_ps(&b.velY[i]), f));
+    _mm_storeu_ps(&b.velZ[i], _mm_mul_ps(_mm_loadu_ps(&b.velZ[i]), f));
+  }
+  for (; i < n; i++)
+  {
+    if (b.flags[i] != 0) continue;
+    b.velX[i] *= factor;
+    b.velY[i] *= factor;
+    b.velZ[i] *= factor;
+  }
+}
+
+static void tiltSse(BallArrays& b, int n, float tiltX)
+{
+  const __m128 vt = _mm_set1_ps(tiltX);
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128 t = _mm_and_ps(freeMask(&b.flags[i]), vt);
+    _mm_storeu_ps(&b.velX[i], _mm_add_ps(_mm_loadu_ps(&b.velX[i]), t));
+  }
+  for (; i < n; i++)
+  {
+    if (b.flags[i] == 0) b.velX[i] += tiltX;
+  }
+}
+
+static int nearestSegmentSse(const SegmentArrays& s, float px, float py, float& distSq)
+{
+  if (s.count == 0)
+  {
+    distSq = std::numeric_limits<float>::max();
+    return -1;
+  }
+  const __m128 vpx = _mm_set1_ps(px);
+  const __m128 vpy = _mm_set1_ps(py);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  __m128 bestSq = _mm_set1_ps(std::numeric_limits<float>::max());
+  __m128i best = _mm_set1_epi32(-1);
+  __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+  const __m128i four = _mm_set1_epi32(4);
+  // the arrays are padded to a multiple of eight, so whole vectors are safe
+  for (int k = 0; k < s.count; k += 4)
+  {
+    __m128 dx = _mm_loadu_ps(&s.dx[k]);
+    __m128 dy = _mm_loadu_ps(&s.dy[k]);
+    __m128 rx = _mm_sub_ps(vpx, _mm_loadu_ps(&s.ax[k]));
+    __m128 ry = _mm_sub_ps(vpy, _mm_loadu_ps(&s.ay[k]));
+    __m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(rx, dx), _mm_mul_ps(ry, dy)), _mm_loadu_ps(&s.invLengthSq[k]));
+    t = _mm_min_ps(_mm_max_ps(t, zero), one);
+    __m128 ex = _mm_sub_ps(rx, _mm_mul_ps(t, dx));
+    __m128 ey = _mm_sub_ps(ry, _mm_mul_ps(t, dy));
+    __m128 d = _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+    __m128 closer = _mm_cmplt_ps(d, bestSq);
+    bestSq = select(closer, d, bestSq);
+    best = _mm_castps_si128(select(closer, _mm_castsi128_ps(index), _mm_castsi128_ps(best)));
+    index = _mm_add_epi32(index, four);
+  }
+  // each lane saw its own indices in order, so taking the lowest index
+  // among the closest lanes gives the same answer as the scalar loop
+  float lanesSq[4];
+  int32_t lanes[4];
+  _mm_storeu_ps(lanesSq, bestSq);
+  _mm_storeu_si128((__m128i*) lanes, best);
+  int result = -1;
+  float resultSq = std::numeric_limits<float>::max();
+  for (int l = 0; l < 4; l++)
+  {
+    if (lanes[l] < 0 || lanes[l] >= s.count) continue;
+    if (lanesSq[l] < resultSq || (lanesSq[l] == resultSq && lanes[l] < result))
+    {
+      resultSq = lanesSq[l];
+      result = lanes[l];
+    }
+  }
+  distSq = resultSq;
+  return result;
+}
+
+const KernelSet* sseKernels()
+{
+  static const KernelSet set = {"sse", integrateSse, frictionSse, tiltSse, nearestSegmentSse,
+    scalarKernels().pcgFill};
+  return &set;
+}
+
+#else
+
+const KernelSet* sseKernels()
+{
+  return nullptr;
+}
+
+#endif
+
+}  // namespace poolsim
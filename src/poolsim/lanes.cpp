@@ -0,0 +1,267 @@
+/**
+ * @file lanes.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Scalar lane kernel, kernel selection and the lane runner
+ */
+
+#include "poolsim/lanestep.h"
+#include "poolsim/kernels.h"
+#include <glm/gtc/constants.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+using namespace glm;
+
+namespace poolsim {
+
+void LaneBlock::resize(int w, int n)
+{
+  width = w;
+  numBalls = n;
+  int count = w * n;
+  posX.assign(count, 0); posY.assign(count, 0); posZ.assign(count, 0);
+  velX.assign(count, 0); velY.assign(count, 0); velZ.assign(count, 0);
+  rotX.assign(count, 0); rotY.assign(count, 0);
+  size.assign(count, 0);
+  captured.assign(count, 0); sinking.assign(count, 0); devoured.assign(count, 0);
+  friction.assign(w, 0);
+  sticky.assign(w, 0);
+  tilt.assign(w, 0);
+  hover.assign(w, 0);
+  hoverZ.assign(w, 0);
+  glorbRadius.assign(w, 0);
+  running.assign(w, 0);
+  collisions.assign(w, 0); boundaryHits.assign(w, 0);
+  pocketed.assign(w, 0); devouredCount.assign(w, 0);
+}
+
+// one table, for CPUs without wide vectors and as the reference
+struct ScalarLanes
+{
+  typedef float F;
+  typedef bool M;
+  static const int width = 1;
+
+  static F load(const float* p) { return *p; }
+  static void store(float* p, F v) { *p = v; }
+  static F set(float v) { return v; }
+  static F add(F a, F b) { return a + b; }
+  static F sub(F a, F b) { return a - b; }
+  static F mul(F a, F b) { return a * b; }
+  static F div(F a, F b) { return a / b; }
+  static F sqrt(F a) { return std::sqrt(a); }
+  static M lt(F a, F b) { return a < b; }
+  static M le(F a, F b) { return a <= b; }
+  static M gt(F a, F b) { return a > b; }
+  static M eq(F a, F b) { return a == b; }
+  static M mand(M a, M b) { return a && b; }
+  static M mor(M a, M b) { return a || b; }
+  static M mnot(M a) { return !a; }
+  static bool any(M a) { return a; }
+  static F select(M m, F a, F b) { return m ? a : b; }
+};
+
+const LaneKernel& scalarLaneKernel()
+{
+  static const LaneKernel kernel = {"scalar", 1, laneStep<ScalarLanes>};
+  return kernel;
+}
+
+static const LaneKernel& selectLaneKernel()
+{
+  const char* choice = getenv("POOLSIM_KERNELS");
+  if (choice != NULL)
+  {
+    if (strcmp(choice, "avx512") == 0 && avx512LaneKernel() && cpuHasAvx512()) return *avx512LaneKernel();
+    if (strcmp(choice, "avx2") == 0 && avx2LaneKernel() && cpuHasAvx2()) return *avx2LaneKernel();
+    return scalarLaneKernel();
+  }
+  if (avx512LaneKernel() && cpuHasAvx512()) return *avx512LaneKernel();
+  if (avx2LaneKernel() && cpuHasAvx2()) return *avx2LaneKernel();
+  return scalarLaneKernel();
+}
+
+const LaneKernel& laneKernel()
+{
+  static const LaneKernel& kernel = selectLaneKernel();
+  return kernel;
+}
+
+LaneRunner::LaneRunner(const BatchConfig& config) :
+  _config(config), _kernel(laneKernel()), _setup(config.table)
+{
+  const TableConfig& table = _config.table;
+  int w = _kernel.width;
+  _block.resize(w, table.numBalls);
+  _scratch.resize(table.numBalls);
+  _rngs.resize(w);
+  _time.resize(w);
+  _shotTime.resize(w);
+  _gaslit.resize(w);
+  _done.resize(w);
+
+  _constants.dt = table.fixedDt;
+  _constants.sphereRadius = table.sphereRadius;
+  _constants.ballDefaultSize = table.ballDefaultSize;
+  _constants.rollScale = 1.0f / table.sphereRadius;
+  _constants.restSpeed = table.restSpeed;
+  _constants.xThresh = (table.tableLength - 75) / 2.0f;
+  _constants.yThresh = (table.tableWidth - 75) / 2.0f;
+  _constants.pocketInner = table.viewVolumeSide / 150;
+  _constants.pocketOuter = table.viewVolumeSide / 50;
+  for (int p = 0; p < 6; p++)
+  {
+    _constants.pocketX[p] = _setup.pockets()[p].x;
+    _constants.pocketY[p] = _setup.pockets()[p].y;
+  }
+  _constants.glorbPos = _setup.glorbPos();
+  _constants.glorbGrowth = table.glorbScale * 0.02f * 0.5f;
+}
+
+void LaneRunner::load(int lane, const Table& table)
+{
+  int w = _kernel.width;
+  const BallArrays& balls = table.balls();
+  for (int i = 0; i < table.numBalls(); i++)
+  {
+    int k = i * w + lane;
+    _block.posX[k] = balls.posX[i];
+    _block.posY[k] = balls.posY[i];
+    _block.posZ[k] = balls.posZ[i];
+    _block.velX[k] = balls.velX[i];
+    _block.velY[k] = balls.velY[i];
+    _block.velZ[k] = balls.velZ[i];
+    _block.rotX[k] = balls.rotX[i];
+    _block.rotY[k] = balls.rotY[i];
+    _block.size[k] = balls.size[i];
+    _block.captured[k] = (balls.flags[i] & BALL_CAPTURED) ? 1.0f : 0.0f;
+    _block.sinking[k] = (balls.flags[i] & BALL_SINKING) ? 1.0f : 0.0f;
+    _block.devoured[k] = (balls.flags[i] & BALL_DEVOURED) ? 1.0f : 0.0f;
+  }
+  _block.friction[lane] = chaosFriction(table.activeChaos());
+  _block.sticky[lane] = table.chaosActive(CHAOS_STICKY_SITUATION) ? 1.0f : 0.0f;
+  _block.tilt[lane] = table.chaosActive(CHAOS_TILT_A_TABLE) ? table.tiltDir().x : 0.0f;
+  _block.hover[lane] = table.chaosActive(CHAOS_HOVER_HAVOC) ? 1.0f : 0.0f;
+  _block.glorbRadius[lane] = table.config().glorbScale * table.eyeDiameterModifier() * 0.5;
+  _block.running[lane] = 0;
+  _block.collisions[lane] = 0;
+  _block.boundaryHits[lane] = 0;
+  _block.pocketed[lane] = 0;
+  _block.devouredCount[lane] = 0;
+  _gaslit[lane] = table.chaosActive(CHAOS_GET_GASLIT);
+  _time[lane] = table.time();
+}
+
+void LaneRunner::launch(int lane, int ball, const vec3& vel)
+{
+  int k = ball * _kernel.width + lane;
+  _block.velX[k] = vel.x;
+  _block.velY[k] = _gaslit[lane] ? -vel.y : vel.y;
+  _block.velZ[k] = vel.z;
+}
+
+uint64_t LaneRunner::laneHash(int lane)
+{
+  int w = _kernel.width;
+  for (int i = 0; i < _block.numBalls; i++)
+  {
+    int k = i * w + lane;
+    _scratch.posX[i] = _block.posX[k];
+    _scratch.posY[i] = _block.posY[k];
+    _scratch.posZ[i] = _block.posZ[k];
+    _scratch.velX[i] = _block.velX[k];
+    _scratch.velY[i] = _block.velY[k];
+    _scratch.velZ[i] = _block.velZ[k];
+    _scratch.size[i] = _block.size[k];
+    _scratch.flags[i] = (_block.captured[k] > 0.5f ? BALL_CAPTURED : 0) |
+      (_block.sinking[k] > 0.5f ? BALL_SINKING : 0) |
+      (_block.devoured[k] > 0.5f ? BALL_DEVOURED : 0);
+  }
+  return _scratch.hash(_block.numBalls);
+}
+
+void LaneRunner::runBlock(int first, TableResult* results)
+{
+  int w = _kernel.width;
+  int n = _block.numBalls;
+  int count = std::min(w, _config.numTables - first);
+  float dt = _config.table.fixedDt;
+
+  // set each lane up exactly as BatchRunner::runTable sets up its table
+  for (int l = 0; l < w; l++)
+  {
+    uint32_t seed = tableSeed(_config.seed, first + l);
+    _setup.reset(seed);
+    _rngs[l].seed(seed, shotStream);
+    int effect = _rngs[l]() % NUM_CHAOS_EFFECTS;
+    _setup.setChaosEffect((ChaosEffect) effect);
+    load(l, _setup);
+    _done[l] = false;
+    if (l < count)
+    {
+      results[l] = TableResult();
+      results[l].seed = seed;
+      results[l].chaosEffect = effect;
+    }
+  }
+
+  for (int s = 0; s < _config.shotsPerTable; s++)
+  {
+    for (int l = 0; l < w; l++)
+    {
+      _shotTime[l] = 0.0f;
+      if (_done[l]) continue;
+      Pcg32& rng = _rngs[l];
+      int start = rng() % n;
+      int ball = -1;
+      for (int k = 0; k < n && ball < 0; k++)
+      {
+        int b = ((start + k) % n) * w + l;
+        if (_block.captured[b] + _block.sinking[b] + _block.devoured[b] == 0) ball = (start + k) % n;
+      }
+      if (ball < 0)
+      {
+        _done[l] = true;
+        continue;
+      }
+      float angle = two_pi<float>() * (rng() / (float) Pcg32::max());
+      float speed = mix(_config.minSpeed, _config.maxSpeed, rng() / (float) Pcg32::max());
+      launch(l, ball, speed * vec3(cos(angle), sin(angle), 0));
+      _block.running[l] = 1;
+      if (l < count) results[l].shots++;
+    }
+
+    while (true)
+    {
+      for (int l = 0; l < w; l++)
+      {
+        if (_shotTime[l] >= _config.maxShotTime) _block.running[l] = 0;
+        _block.hoverZ[l] = 50.0f + 10 * sin(_time[l] + dt);
+      }
+      if (!_kernel.step(_block, _constants)) break;
+      for (int l = 0; l < w; l++)
+      {
+        if (_block.running[l] == 0) continue;
+        _time[l] += dt;
+        _shotTime[l] += dt;
+      }
+    }
+    for (int l = 0; l < count; l++)
+    {
+      results[l].simulatedTime += _shotTime[l];
+    }
+  }
+
+  for (int l = 0; l < count; l++)
+  {
+    results[l].pocketed = (int) _block.pocketed[l];
+    results[l].collisions = (int) _block.collisions[l];
+    results[l].boundaryHits = (int) _block.boundaryHits[l];
+    results[l].stateHash = laneHash(l);
+  }
+}
+
+}  // namespace poolsim
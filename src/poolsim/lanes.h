@@ -0,0 +1,142 @@
+/**
+ * @file lanes.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Fixed-step physics for several tables at once, one per SIMD lane
+ */
+
+#ifndef POOLSIM_LANES_H_
+#define POOLSIM_LANES_H_
+
+#include "poolsim/batch.h"
+#include "poolsim/table.h"
+#include <vector>
+
+namespace poolsim {
+
+/**
+ * The balls of width tables that all have the same number of balls, laid
+ * out so that ball i of every table sits side by side: component k of ball
+ * i on lane l is at [i * width + l]. One vector register then holds the same
+ * ball from every table, and the fixed-step rules run on all tables at
+ * once, with masks standing in for the branches that differ between them.
+ */
+struct LaneBlock
+{
+  int width = 0;
+  int numBalls = 0;
+
+  std::vector<float> posX, posY, posZ;
+  std::vector<float> velX, velY, velZ;
+  std::vector<float> rotX, rotY;
+  std::vector<float> size;
+  // 1 when the flag of the same name in BallFlag is set, 0 otherwise
+  std::vector<float> captured, sinking, devoured;
+
+  // one entry per lane
+  std::vector<float> friction;
+  std::vector<float> sticky;
+  std::vector<float> tilt;
+  std::vector<float> hover;
+  std::vector<float> hoverZ;
+  std::vector<float> glorbRadius;
+  // 1 while the lane's shot is being played out
+  std::vector<float> running;
+  std::vector<float> collisions, boundaryHits, pocketed, devouredCount;
+
+  void resize(int width, int numBalls);
+};
+
+/**
+ * Everything the lane step needs that is the same on every lane.
+ */
+struct LaneConstants
+{
+  float dt;
+  float sphereRadius;
+  float ballDefaultSize;
+  float rollScale;
+  float restSpeed;
+  float xThresh, yThresh;
+  float pocketInner, pocketOuter;
+  float pocketX[6], pocketY[6];
+  glm::vec3 glorbPos;
+  // growth of Glorb's mouth radius per ball eaten
+  float glorbGrowth;
+};
+
+struct LaneKernel
+{
+  const char* name;
+  int width;
+
+  /**
+  * Runs one fixed step on every running lane, as Table::fixedStep and the
+  * Hover Havoc part of Table::chaos would. Lanes with no free ball faster
+  * than restSpeed stop running first, as Table::settle does.
+  *
+  * @return False if no lane was left running, in which case nothing moved.
+  */
+  bool (*step)(LaneBlock& block, const LaneConstants& constants);
+};
+
+const LaneKernel& scalarLaneKernel();
+
+/**
+ * The AVX2 (8 lanes) and AVX-512 (16 lanes) kernels are null when not
+ * compiled in for this target.
+ */
+const LaneKernel* avx2LaneKernel();
+const LaneKernel* avx512LaneKernel();
+
+/**
+ * The widest kernel the CPU supports, picked once on first use. Setting
+ * POOLSIM_KERNELS to scalar, avx2 or avx512 overrides the choice as for
+ * kernels().
+ */
+const LaneKernel& laneKernel();
+
+/**
+ * Plays the tables of a batch a lane block at a time, with the same seeds,
+ * chaos effects and shots as BatchRunner::runTable. Collisions are tested
+ * over every pair in index order rather than in broadphase order, so a
+ * table can end up slightly differently than when run on its own, but a
+ * block's results never depend on its neighbours or on the kernel width.
+ */
+class LaneRunner
+{
+public:
+    LaneRunner(const BatchConfig& config);
+
+    int width() const { return _kernel.width; }
+
+    /**
+    * Plays the tables [first, first + width()), skipping any at or past
+    * BatchConfig::numTables.
+    *
+    * @param results The first table's result, followed by the others.
+    */
+    void runBlock(int first, TableResult* results);
+
+private:
+    void load(int lane, const Table& table);
+    void launch(int lane, int ball, const glm::vec3& vel);
+    uint64_t laneHash(int lane);
+
+    BatchConfig _config;
+    const LaneKernel& _kernel;
+    LaneConstants _constants;
+    LaneBlock _block;
+    Table _setup;
+    BallArrays _scratch;
+    std::vector<Pcg32> _rngs;
+    std::vector<float> _time;
+    std::vector<float> _shotTime;
+    std::vector<bool> _gaslit;
+    // lanes whose table ran out of balls to shoot
+    std::vector<bool> _done;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_LANES_H_
@@ -0,0 +1,62 @@
+/**
+ * @file lanes_avx2.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief AVX2 lane kernel, eight tables at a time
+ *
+ * This file is compiled with AVX2 enabled (see CMakeLists.txt) and is only
+ * called after laneKernel() has checked that the CPU supports it.
+ */
+
+#include "poolsim/lanestep.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace poolsim {
+
+#if defined(__AVX2__)
+
+// masks are full vectors with all bits set in the selected lanes
+struct Avx2Lanes
+{
+  typedef __m256 F;
+  typedef __m256 M;
+  static const int width = 8;
+
+  static F load(const float* p) { return _mm256_loadu_ps(p); }
+  static void store(float* p, F v) { _mm256_storeu_ps(p, v); }
+  static F set(float v) { return _mm256_set1_ps(v); }
+  static F add(F a, F b) { return _mm256_add_ps(a, b); }
+  static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+  static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+  static F div(F a, F b) { return _mm256_div_ps(a, b); }
+  static F sqrt(F a) { return _mm256_sqrt_ps(a); }
+  static M lt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static M le(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+  static M gt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+  static M eq(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+  static M mand(M a, M b) { return _mm256_and_ps(a, b); }
+  static M mor(M a, M b) { return _mm256_or_ps(a, b); }
+  static M mnot(M a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+  static bool any(M a) { return _mm256_movemask_ps(a) != 0; }
+  static F select(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+};
+
+const LaneKernel* avx2LaneKernel()
+{
+  static const LaneKernel kernel = {"avx2", 8, laneStep<Avx2Lanes>};
+  return &kernel;
+}
+
+#else
+
+const LaneKernel* avx2LaneKernel()
+{
+  return NULL;
+}
+
+#endif
+
+}  // namespace poolsim
@@ -0,0 +1,64 @@
+/**
+ * @file lanes_avx512.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief AVX-512 lane kernel, sixteen tables at a time
+ *
+ * This file is compiled with AVX-512 enabled (see CMakeLists.txt) and is
+ * only called after laneKernel() has checked that the CPU supports it.
+ */
+
+#include "poolsim/lanestep.h"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace poolsim {
+
+#if defined(__AVX512F__)
+
+// masks are the k registers, one bit per lane
+struct Avx512Lanes
+{
+  typedef __m512 F;
+  typedef __mmask16 M;
+  static const int width = 16;
+
+  static F load(const float* p) { return _mm512_loadu_ps(p); }
+  static void store(float* p, F v) { _mm512_storeu_ps(p, v); }
+  static F set(float v) { return _mm512_set1_ps(v); }
+  static F add(F a, F b) { return _mm512_add_ps(a, b); }
+  static F sub(F a, F b) { return _mm512_sub_ps(a, b); }
+  static F mul(F a, F b) { return _mm512_mul_ps(a, b); }
+  static F div(F a, F b) { return _mm512_div_ps(a, b); }
+  // the masked form with every lane set is the same vsqrtps; GCC 12's
+  // _mm512_sqrt_ps passes an undefined vector that -O2 warns about
+  static F sqrt(F a) { return _mm512_mask_sqrt_ps(_mm512_setzero_ps(), 0xffff, a); }
+  static M lt(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+  static M le(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+  static M gt(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+  static M eq(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+  static M mand(M a, M b) { return a & b; }
+  static M mor(M a, M b) { return a | b; }
+  static M mnot(M a) { return (M) ~a; }
+  static bool any(M a) { return a != 0; }
+  static F select(M m, F a, F b) { return _mm512_mask_blend_ps(m, b, a); }
+};
+
+const LaneKernel* avx512LaneKernel()
+{
+  static const LaneKernel kernel = {"avx512", 16, laneStep<Avx512Lanes>};
+  return &kernel;
+}
+
+#else
+
+const LaneKernel* avx512LaneKernel()
+{
+  return NULL;
+}
+
+#endif
+
+}  // namespace poolsim
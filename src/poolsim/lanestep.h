@@ -0,0 +1,282 @@
+/**
+ * @file lanestep.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief The lane step, written once over a small vector interface
+ *
+ * Included by each lane kernel file after it defines its vector type V:
+ *
+ *   V::F, V::M   a vector of floats and a mask with one entry per lane
+ *   V::width     the number of lanes
+ *   load, store, set, add, sub, mul, div, sqrt
+ *   lt, le, gt, eq                 comparisons giving masks
+ *   mand, mor, mnot, any           mask logic
+ *   select(m, a, b)                a where m is set, b elsewhere
+ *
+ * Every kernel performs the same IEEE operations in the same order, so all
+ * widths give bit-identical tables.
+ */
+
+#ifndef POOLSIM_LANESTEP_H_
+#define POOLSIM_LANESTEP_H_
+
+#include "poolsim/lanes.h"
+
+namespace poolsim {
+
+template <class V>
+bool laneStep(LaneBlock& b, const LaneConstants& c)
+{
+  typedef typename V::F F;
+  typedef typename V::M M;
+  const int W = V::width;
+  const int n = b.numBalls;
+
+  const F zero = V::set(0.0f);
+  const F one = V::set(1.0f);
+  const F half = V::set(0.5f);
+
+  // lanes stop once no free ball is faster than the rest speed
+  M running = V::gt(V::load(&b.running[0]), half);
+  M moving = V::lt(one, zero);
+  const F restSpeed = V::set(c.restSpeed);
+  for (int i = 0; i < n; i++)
+  {
+    int k = i * W;
+    M taken = V::gt(V::add(V::add(V::load(&b.captured[k]), V::load(&b.sinking[k])), V::load(&b.devoured[k])), half);
+    F vx = V::load(&b.velX[k]);
+    F vy = V::load(&b.velY[k]);
+    F vz = V::load(&b.velZ[k]);
+    F speed = V::sqrt(V::add(V::add(V::mul(vx, vx), V::mul(vy, vy)), V::mul(vz, vz)));
+    moving = V::mor(moving, V::mand(V::mnot(taken), V::gt(speed, restSpeed)));
+  }
+  running = V::mand(running, moving);
+  V::store(&b.running[0], V::select(running, one, zero));
+  if (!V::any(running)) return false;
+
+  const F glorbX = V::set(c.glorbPos.x);
+  const F glorbY = V::set(c.glorbPos.y);
+  const F glorbZ = V::set(c.glorbPos.z);
+  const F pocketInner = V::set(c.pocketInner);
+  const F pocketOuter = V::set(c.pocketOuter);
+  F glorbRadius = V::load(&b.glorbRadius[0]);
+  F pocketed = V::load(&b.pocketed[0]);
+  F devouredCount = V::load(&b.devouredCount[0]);
+
+  // pockets and glorb first, so that captured balls sit out the rest
+  for (int i = 0; i < n; i++)
+  {
+    int k = i * W;
+    F px = V::load(&b.posX[k]);
+    F py = V::load(&b.posY[k]);
+    F pz = V::load(&b.posZ[k]);
+    F vx = V::load(&b.velX[k]);
+    F vy = V::load(&b.velY[k]);
+    F vz = V::load(&b.velZ[k]);
+    F size = V::load(&b.size[k]);
+    F captured = V::select(running, zero, V::load(&b.captured[k]));
+    F sinking = V::load(&b.sinking[k]);
+    F devoured = V::load(&b.devoured[k]);
+    M isSinking = V::mand(running, V::gt(sinking, half));
+    M isFree = V::mand(running, V::mnot(V::gt(V::add(sinking, devoured), half)));
+
+    F gx = V::sub(glorbX, px);
+    F gy = V::sub(glorbY, py);
+    F gz = V::sub(glorbZ, pz);
+    F glorbDist = V::sqrt(V::add(V::add(V::mul(gx, gx), V::mul(gy, gy)), V::mul(gz, gz)));
+    M eaten = V::mand(isSinking, V::le(glorbDist, glorbRadius));
+
+    M done = V::mnot(isFree);
+    for (int p = 0; p < 6; p++)
+    {
+      F dx = V::sub(V::set(c.pocketX[p]), px);
+      F dy = V::sub(V::set(c.pocketY[p]), py);
+      F dz = V::sub(zero, pz);
+      F dist = V::sqrt(V::add(V::add(V::mul(dx, dx), V::mul(dy, dy)), V::mul(dz, dz)));
+      M sunk = V::mand(V::mnot(done), V::lt(dist, pocketInner));
+      M pulled = V::mand(V::mand(V::mnot(done), V::mnot(sunk)), V::lt(dist, pocketOuter));
+      pocketed = V::add(pocketed, V::select(sunk, one, zero));
+      vx = V::select(sunk, V::mul(half, gx), V::select(pulled, V::mul(V::set(10.0f), dx), vx));
+      vy = V::select(sunk, V::mul(half, gy), V::select(pulled, V::mul(V::set(10.0f), dy), vy));
+      vz = V::select(sunk, V::mul(half, gz), V::select(pulled, V::mul(V::set(10.0f), dz), vz));
+      size = V::select(sunk, V::add(size, size), size);
+      sinking = V::select(sunk, one, sinking);
+      captured = V::select(pulled, one, captured);
+      done = V::mor(done, V::mor(sunk, pulled));
+    }
+
+    px = V::select(eaten, zero, px);
+    py = V::select(eaten, V::set(1000.0f), py);
+    pz = V::select(eaten, V::set(200.0f), pz);
+    vx = V::select(eaten, zero, vx);
+    vy = V::select(eaten, zero, vy);
+    vz = V::select(eaten, zero, vz);
+    size = V::select(eaten, zero, size);
+    sinking = V::select(eaten, zero, sinking);
+    devoured = V::select(eaten, one, devoured);
+    glorbRadius = V::select(eaten, V::add(glorbRadius, V::set(c.glorbGrowth)), glorbRadius);
+    devouredCount = V::add(devouredCount, V::select(eaten, one, zero));
+
+    V::store(&b.posX[k], px);
+    V::store(&b.posY[k], py);
+    V::store(&b.posZ[k], pz);
+    V::store(&b.velX[k], vx);
+    V::store(&b.velY[k], vy);
+    V::store(&b.velZ[k], vz);
+    V::store(&b.size[k], size);
+    V::store(&b.captured[k], captured);
+    V::store(&b.sinking[k], sinking);
+    V::store(&b.devoured[k], devoured);
+  }
+  V::store(&b.glorbRadius[0], glorbRadius);
+  V::store(&b.pocketed[0], pocketed);
+  V::store(&b.devouredCount[0], devouredCount);
+
+  // collisions, every pair in index order
+  const F sphereRadius = V::set(c.sphereRadius);
+  F collisions = V::load(&b.collisions[0]);
+  for (int i = 0; i < n; i++)
+  {
+    int ki = i * W;
+    M freeI = V::mand(running, V::mnot(V::gt(V::add(V::add(V::load(&b.captured[ki]), V::load(&b.sinking[ki])), V::load(&b.devoured[ki])), half)));
+    if (!V::any(freeI)) continue;
+    for (int j = i + 1; j < n; j++)
+    {
+      int kj = j * W;
+      M okJ = V::mnot(V::gt(V::add(V::load(&b.sinking[kj]), V::load(&b.devoured[kj])), half));
+      F sizeI = V::load(&b.size[ki]);
+      F sizeJ = V::load(&b.size[kj]);
+      F dx = V::sub(V::load(&b.posX[ki]), V::load(&b.posX[kj]));
+      F dy = V::sub(V::load(&b.posY[ki]), V::load(&b.posY[kj]));
+      F dz = V::sub(V::load(&b.posZ[ki]), V::load(&b.posZ[kj]));
+      F dist = V::sqrt(V::add(V::add(V::mul(dx, dx), V::mul(dy, dy)), V::mul(dz, dz)));
+      F overlap = V::sub(V::mul(sphereRadius, V::add(sizeI, sizeJ)), dist);
+      M hit = V::mand(V::mand(freeI, okJ), V::gt(overlap, one));
+      if (!V::any(hit)) continue;
+
+      // normal between the balls as if both rested on the table
+      F nz = V::sub(dz, V::mul(sphereRadius, V::sub(sizeI, sizeJ)));
+      F len = V::sqrt(V::add(V::add(V::mul(dx, dx), V::mul(dy, dy)), V::mul(nz, nz)));
+      F nx = V::div(dx, len);
+      F ny = V::div(dy, len);
+      nz = V::div(nz, len);
+      F push = V::div(overlap, V::set(2.0f));
+      F pushX = V::mul(nx, push);
+      F pushY = V::mul(ny, push);
+      F pushZ = V::mul(nz, push);
+      V::store(&b.posX[ki], V::select(hit, V::add(V::load(&b.posX[ki]), pushX), V::load(&b.posX[ki])));
+      V::store(&b.posY[ki], V::select(hit, V::add(V::load(&b.posY[ki]), pushY), V::load(&b.posY[ki])));
+      V::store(&b.posZ[ki], V::select(hit, V::add(V::load(&b.posZ[ki]), pushZ), V::load(&b.posZ[ki])));
+      V::store(&b.posX[kj], V::select(hit, V::sub(V::load(&b.posX[kj]), pushX), V::load(&b.posX[kj])));
+      V::store(&b.posY[kj], V::select(hit, V::sub(V::load(&b.posY[kj]), pushY), V::load(&b.posY[kj])));
+      V::store(&b.posZ[kj], V::select(hit, V::sub(V::load(&b.posZ[kj]), pushZ), V::load(&b.posZ[kj])));
+
+      F vxI = V::load(&b.velX[ki]);
+      F vyI = V::load(&b.velY[ki]);
+      F vzI = V::load(&b.velZ[ki]);
+      F vxJ = V::load(&b.velX[kj]);
+      F vyJ = V::load(&b.velY[kj]);
+      F vzJ = V::load(&b.velZ[kj]);
+      F dotI = V::add(V::add(V::mul(vxI, nx), V::mul(vyI, ny)), V::mul(vzI, nz));
+      F dotJ = V::add(V::add(V::mul(vxJ, nx), V::mul(vyJ, ny)), V::mul(vzJ, nz));
+      F nxI = V::mul(dotI, nx), nyI = V::mul(dotI, ny), nzI = V::mul(dotI, nz);
+      F nxJ = V::mul(dotJ, nx), nyJ = V::mul(dotJ, ny), nzJ = V::mul(dotJ, nz);
+      V::store(&b.velX[ki], V::select(hit, V::add(vxI, V::sub(nxJ, nxI)), vxI));
+      V::store(&b.velY[ki], V::select(hit, V::add(vyI, V::sub(nyJ, nyI)), vyI));
+      V::store(&b.velZ[ki], V::select(hit, V::add(vzI, V::sub(nzJ, nzI)), vzI));
+      V::store(&b.velX[kj], V::select(hit, V::add(vxJ, V::sub(nxI, nxJ)), vxJ));
+      V::store(&b.velY[kj], V::select(hit, V::add(vyJ, V::sub(nyI, nyJ)), vyJ));
+      V::store(&b.velZ[kj], V::select(hit, V::add(vzJ, V::sub(nzI, nzJ)), vzJ));
+      collisions = V::add(collisions, V::select(hit, one, zero));
+    }
+  }
+  V::store(&b.collisions[0], collisions);
+
+  // cushions, tilt, friction and the table surface
+  const F xThresh = V::set(c.xThresh);
+  const F yThresh = V::set(c.yThresh);
+  const F minusXThresh = V::set(-c.xThresh);
+  const F minusYThresh = V::set(-c.yThresh);
+  const F defaultSize = V::set(c.ballDefaultSize);
+  const F surface = V::set(40.0f);
+  const F dt = V::set(c.dt);
+  const F rollScale = V::set(c.rollScale);
+  M sticky = V::gt(V::load(&b.sticky[0]), half);
+  M hover = V::mand(running, V::gt(V::load(&b.hover[0]), half));
+  F tilt = V::load(&b.tilt[0]);
+  F friction = V::load(&b.friction[0]);
+  F hoverZ = V::load(&b.hoverZ[0]);
+  F boundaryHits = V::load(&b.boundaryHits[0]);
+  for (int i = 0; i < n; i++)
+  {
+    int k = i * W;
+    F px = V::load(&b.posX[k]);
+    F py = V::load(&b.posY[k]);
+    F pz = V::load(&b.posZ[k]);
+    F vx = V::load(&b.velX[k]);
+    F vy = V::load(&b.velY[k]);
+    F vz = V::load(&b.velZ[k]);
+    F size = V::load(&b.size[k]);
+    F devoured = V::load(&b.devoured[k]);
+    M isFree = V::mand(running, V::mnot(V::gt(V::add(V::add(V::load(&b.captured[k]), V::load(&b.sinking[k])), devoured), half)));
+
+    F radius = V::mul(sphereRadius, size);
+    F left = V::sub(px, radius);
+    F right = V::add(px, radius);
+    M pastLeft = V::lt(left, minusXThresh);
+    M pastRight = V::gt(right, xThresh);
+    M hitX = V::mand(isFree, V::mor(pastLeft, pastRight));
+    px = V::select(V::mand(hitX, pastLeft), V::add(px, V::sub(minusXThresh, left)),
+      V::select(V::mand(hitX, pastRight), V::sub(px, V::sub(right, xThresh)), px));
+    vx = V::select(hitX, V::select(sticky, zero, V::sub(zero, vx)), vx);
+    vy = V::select(V::mand(hitX, sticky), zero, vy);
+    boundaryHits = V::add(boundaryHits, V::select(hitX, one, zero));
+
+    F bottom = V::sub(py, radius);
+    F top = V::add(py, radius);
+    M hitY = V::mand(isFree, V::mor(V::lt(py, minusYThresh), V::gt(py, yThresh)));
+    M pastBottom = V::lt(bottom, minusYThresh);
+    M pastTop = V::gt(top, yThresh);
+    py = V::select(V::mand(hitY, pastBottom), V::add(py, V::sub(minusYThresh, bottom)),
+      V::select(V::mand(hitY, pastTop), V::sub(py, V::sub(top, yThresh)), py));
+    vy = V::select(hitY, V::select(sticky, zero, V::sub(zero, vy)), vy);
+    vx = V::select(V::mand(hitY, sticky), zero, vx);
+    boundaryHits = V::add(boundaryHits, V::select(hitY, one, zero));
+
+    vx = V::select(isFree, V::add(vx, tilt), vx);
+    vx = V::select(isFree, V::mul(vx, friction), vx);
+    vy = V::select(isFree, V::mul(vy, friction), vy);
+    vz = V::select(isFree, V::mul(vz, friction), vz);
+
+    // if not hovering, not enlarged or shrunk, and not floating up to glorb, null z-component
+    M onTable = V::mand(isFree, V::mand(V::lt(pz, surface), V::eq(size, defaultSize)));
+    pz = V::select(onTable, zero, pz);
+    vz = V::select(onTable, zero, vz);
+
+    M moves = V::mand(running, V::mnot(V::gt(devoured, half)));
+    F dx = V::mul(vx, dt);
+    F dy = V::mul(vy, dt);
+    F roll = V::div(rollScale, size);
+    px = V::select(moves, V::add(px, dx), px);
+    py = V::select(moves, V::add(py, dy), py);
+    pz = V::select(moves, V::add(pz, V::mul(vz, dt)), pz);
+    V::store(&b.rotX[k], V::select(moves, V::add(V::load(&b.rotX[k]), V::mul(V::sub(zero, dy), roll)), V::load(&b.rotX[k])));
+    V::store(&b.rotY[k], V::select(moves, V::add(V::load(&b.rotY[k]), V::mul(dx, roll)), V::load(&b.rotY[k])));
+
+    // Hover Havoc keeps floating balls bobbing
+    pz = V::select(V::mand(V::mand(hover, isFree), V::mnot(V::lt(pz, surface))), hoverZ, pz);
+
+    V::store(&b.posX[k], px);
+    V::store(&b.posY[k], py);
+    V::store(&b.posZ[k], pz);
+    V::store(&b.velX[k], vx);
+    V::store(&b.velY[k], vy);
+    V::store(&b.velZ[k], vz);
+  }
+  V::store(&b.boundaryHits[0], boundaryHits);
+  return true;
+}
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_LANESTEP_H_
@@ -0,0 +1,182 @@
+/**
+ * @file netstate.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements quantizing and delta encoding table snapshots
+ */
+
+#include "poolsim/netstate.h"
+#include "poolsim/bits.h"
+#include "poolsim/table.h"
+#include <glm/gtc/constants.hpp>
+#include <cmath>
+#include <cstring>
+
+using namespace glm;
+
+namespace poolsim {
+
+// ticks back a baseline may be
+static const int baselineAgeBits = 16;
+
+bool NetBall::operator==(const NetBall& other) const
+{
+  return memcmp(pos, other.pos, sizeof(pos)) == 0 && memcmp(rot, other.rot, sizeof(rot)) == 0 &&
+    size == other.size && flags == other.flags;
+}
+
+vec3 NetBall::position() const
+{
+  return vec3(pos[0], pos[1], pos[2]) * netPosQuantum;
+}
+
+vec3 NetBall::rotation() const
+{
+  return vec3(rot[0], rot[1], rot[2]) * (two_pi<float>() / netRotSteps);
+}
+
+bool NetSnapshot::operator==(const NetSnapshot& other) const
+{
+  return tick == other.tick && chaosEffect == other.chaosEffect && numBallsSunk == other.numBallsSunk &&
+    balls == other.balls;
+}
+
+static int32_t quantize(float v, float quantum)
+{
+  return (int32_t) std::lround(v / quantum);
+}
+
+static uint16_t quantizeAngle(float angle)
+{
+  float turns = angle / two_pi<float>();
+  turns -= std::floor(turns);
+  return (uint16_t) ((int32_t) std::lround(turns * netRotSteps) & (netRotSteps - 1));
+}
+
+void captureSnapshot(const Table& table, uint32_t tick, NetSnapshot& out)
+{
+  const BallArrays& balls = table.balls();
+  out.tick = tick;
+  out.chaosEffect = (uint8_t) table.chaosEffectId();
+  out.numBallsSunk = (uint16_t) table.numBallsSunk();
+  out.balls.resize(table.numBalls());
+  for (int i = 0; i < table.numBalls(); i++)
+  {
+    NetBall& b = out.balls[i];
+    b.pos[0] = quantize(balls.posX[i], netPosQuantum);
+    b.pos[1] = quantize(balls.posY[i], netPosQuantum);
+    b.pos[2] = quantize(balls.posZ[i], netPosQuantum);
+    b.rot[0] = quantizeAngle(balls.rotX[i]);
+    b.rot[1] = quantizeAngle(balls.rotY[i]);
+    b.rot[2] = quantizeAngle(balls.rotZ[i]);
+    b.size = (uint16_t) std::min(quantize(balls.size[i], netSizeQuantum), (int32_t) 0xffff);
+    b.flags = (uint8_t) balls.flags[i];
+  }
+}
+
+/**
+ * The shortest way round from one wrapped angle to another, in steps.
+ */
+static int32_t angleDelta(uint16_t from, uint16_t to)
+{
+  int32_t d = ((int32_t) to - from) & (netRotSteps - 1);
+  return d >= netRotSteps / 2 ? d - netRotSteps : d;
+}
+
+void encodeSnapshot(const NetSnapshot& snapshot, const NetSnapshot* baseline, std::vector<uint8_t>& out)
+{
+  if (baseline && (baseline->balls.size() != snapshot.balls.size() || snapshot.tick <= baseline->tick ||
+    snapshot.tick - baseline->tick >= (1u << baselineAgeBits)))
+  {
+    baseline = nullptr;
+  }
+  static const NetBall zero = {};
+  BitWriter w(out);
+  w.bits(snapshot.tick, 32);
+  w.bits(baseline ? snapshot.tick - baseline->tick : 0, baselineAgeBits);
+  w.bits((uint32_t) snapshot.balls.size(), 16);
+  uint8_t chaosEffect = baseline ? baseline->chaosEffect : 0;
+  uint16_t numBallsSunk = baseline ? baseline->numBallsSunk : 0;
+  w.bit(snapshot.chaosEffect != chaosEffect);
+  if (snapshot.chaosEffect != chaosEffect) w.bits(snapshot.chaosEffect, 8);
+  w.bit(snapshot.numBallsSunk != numBallsSunk);
+  if (snapshot.numBallsSunk != numBallsSunk) w.bits(snapshot.numBallsSunk, 16);
+
+  for (size_t i = 0; i < snapshot.balls.size(); i++)
+  {
+    const NetBall& b = snapshot.balls[i];
+    const NetBall& base = baseline ? baseline->balls[i] : zero;
+    bool moved = memcmp(b.pos, base.pos, sizeof(b.pos)) != 0;
+    bool turned = memcmp(b.rot, base.rot, sizeof(b.rot)) != 0;
+    bool resized = b.size != base.size;
+    bool flagged = b.flags != base.flags;
+    w.bit(moved || turned || resized || flagged);
+    if (!(moved || turned || resized || flagged)) continue;
+    w.bit(moved);
+    for (int k = 0; moved && k < 3; k++)
+    {
+      w.signedBits(b.pos[k] - base.pos[k]);
+    }
+    w.bit(turned);
+    for (int k = 0; turned && k < 3; k++)
+    {
+      w.signedBits(angleDelta(base.rot[k], b.rot[k]));
+    }
+    w.bit(resized);
+    if (resized) w.bits(b.size, 16);
+    w.bit(flagged);
+    if (flagged) w.bits(b.flags, 8);
+  }
+}
+
+bool snapshotTicks(const uint8_t* data, size_t size, uint32_t& tick, uint32_t& baselineTick)
+{
+  BitReader r(data, size);
+  tick = r.bits(32);
+  baselineTick = tick - r.bits(baselineAgeBits);
+  return r.ok();
+}
+
+bool decodeSnapshot(const uint8_t* data, size_t size, const NetSnapshot* baseline, NetSnapshot& out)
+{
+  static const NetBall zero = {};
+  BitReader r(data, size);
+  uint32_t tick = r.bits(32);
+  uint32_t age = r.bits(baselineAgeBits);
+  uint32_t numBalls = r.bits(16);
+  if (!r.ok()) return false;
+  if (age > 0 && (!baseline || baseline->tick != tick - age || baseline->balls.size() != numBalls)) return false;
+  if (age == 0) baseline = nullptr;
+
+  out.tick = tick;
+  out.chaosEffect = baseline ? baseline->chaosEffect : 0;
+  out.numBallsSunk = baseline ? baseline->numBallsSunk : 0;
+  if (r.bit()) out.chaosEffect = (uint8_t) r.bits(8);
+  if (r.bit()) out.numBallsSunk = (uint16_t) r.bits(16);
+  out.balls.resize(numBalls);
+  for (uint32_t i = 0; i < numBalls; i++)
+  {
+    NetBall& b = out.balls[i];
+    b = baseline ? baseline->balls[i] : zero;
+    if (!r.bit()) continue;
+    if (r.bit())
+    {
+      for (int k = 0; k < 3; k++)
+      {
+        b.pos[k] += r.signedBits();
+      }
+    }
+    if (r.bit())
+    {
+      for (int k = 0; k < 3; k++)
+      {
+        b.rot[k] = (uint16_t) ((b.rot[k] + r.signedBits()) & (netRotSteps - 1));
+      }
+    }
+    if (r.bit()) b.size = (uint16_t) r.bits(16);
+    if (r.bit()) b.flags = (uint8_t) r.bits(8);
+  }
+  return r.ok();
+}
+
+}  // namespace poolsim
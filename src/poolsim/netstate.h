@@ -0,0 +1,92 @@
+/**
+ * @file netstate.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Quantized table state and its delta encoding for mirrors
+ */
+
+#ifndef POOLSIM_NETSTATE_H_
+#define POOLSIM_NETSTATE_H_
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace poolsim {
+
+class Table;
+
+// units of position, turn and size one step of a quantized value stands for
+static const float netPosQuantum = 1.0f / 64;
+static const int netRotSteps = 4096;
+static const float netSizeQuantum = 1.0f / 16;
+
+/**
+ * What a mirror needs to draw a ball, quantized so that two snapshots can
+ * be compared exactly and the difference sent in a few bits.
+ */
+struct NetBall
+{
+  int32_t pos[3];
+  // Euler angles in netRotSteps steps per turn, wrapped
+  uint16_t rot[3];
+  uint16_t size;
+  // the table's BALL_ flags
+  uint8_t flags;
+
+  bool operator==(const NetBall& other) const;
+  bool operator!=(const NetBall& other) const { return !(*this == other); }
+
+  glm::vec3 position() const;
+  glm::vec3 rotation() const;
+  float drawSize() const { return size * netSizeQuantum; }
+};
+
+/**
+ * A table as the server sent it at a tick.
+ */
+struct NetSnapshot
+{
+  uint32_t tick = 0;
+  uint8_t chaosEffect = 0;
+  uint16_t numBallsSunk = 0;
+  std::vector<NetBall> balls;
+
+  bool operator==(const NetSnapshot& other) const;
+};
+
+/**
+ * Quantizes the state of a table after a fixed step.
+ */
+void captureSnapshot(const Table& table, uint32_t tick, NetSnapshot& out);
+
+/**
+ * Encodes a snapshot as the changes from a baseline the receiver holds:
+ * a bit for each ball that did not change, and for the others the changed
+ * fields, positions and rotations as bit-packed differences. Without a
+ * baseline every field is sent, as differences from zero.
+ *
+ * @param baseline An earlier snapshot of the same table, or null.
+ * @param out Appended to.
+ */
+void encodeSnapshot(const NetSnapshot& snapshot, const NetSnapshot* baseline, std::vector<uint8_t>& out);
+
+/**
+ * Reads the tick of an encoded snapshot and the tick of the baseline it
+ * needs, which is the tick itself if it needs none.
+ *
+ * @return False if the data is too short.
+ */
+bool snapshotTicks(const uint8_t* data, size_t size, uint32_t& tick, uint32_t& baselineTick);
+
+/**
+ * Decodes a snapshot against the baseline it was encoded with.
+ *
+ * @return False if the data is malformed or the baseline does not fit.
+ */
+bool decodeSnapshot(const uint8_t* data, size_t size, const NetSnapshot* baseline, NetSnapshot& out);
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_NETSTATE_H_
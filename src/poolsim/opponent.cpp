@@ -0,0 +1,127 @@
+/**
+ * @file opponent.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the computer opponent
+ */
+
+#include "poolsim/opponent.h"
+#include <glm/gtc/constants.hpp>
+#include <chrono>
+#include <cmath>
+
+using namespace std;
+using namespace glm;
+
+namespace poolsim {
+
+Opponent::Opponent(ThreadPool& pool, const OpponentConfig& config) : _config(config), _pool(pool)
+{
+}
+
+OpponentShot Opponent::chooseShot(const Table& table)
+{
+  auto start = chrono::steady_clock::now();
+  auto deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(
+    chrono::duration<double>(_config.timeBudget));
+  bool timed = _config.timeBudget > 0;
+  OpponentShot shot;
+
+  _balls.clear();
+  for (int i = 0; i < table.numBalls(); i++)
+  {
+    if (table.balls().isFree(i)) _balls.push_back(i);
+  }
+  if (_balls.empty()) return shot;
+
+  _snapshot.resize(table.snapshotSize());
+  table.snapshot(_snapshot.data(), _snapshot.size());
+  // assigning over the copies from the last search reuses their storage
+  int numThreads = _pool.numThreads();
+  _tables.assign(numThreads, table);
+  _best.assign(numThreads, Best());
+  for (Table& copy : _tables)
+  {
+    copy.setRecorder(nullptr);
+    // the copies already run on the pool's threads
+    copy.setThreadPool(nullptr);
+  }
+
+  float maxShotTime = table.chaosActive(CHAOS_TILT_A_TABLE) ? _config.maxTiltedShotTime : _config.maxShotTime;
+  int numBalls = (int) _balls.size();
+  int count = numBalls * _config.candidatesPerBall;
+  _pool.parallelFor(count, [&](int candidate, int thread) {
+    if (timed && chrono::steady_clock::now() > deadline) return;
+    Table& copy = _tables[thread];
+    copy.restore(_snapshot.data(), _snapshot.size());
+    copy.setChaosEnabled(false);
+    copy.clearEvents();
+    copy.launch(_balls[candidate % numBalls], candidateVel(candidate / numBalls));
+    copy.settle(maxShotTime);
+
+    float s = score(copy);
+    Best& best = _best[thread];
+    best.played++;
+    // ties go to the earliest candidate, so the choice does not depend on
+    // which thread played what
+    if (best.candidate < 0 || s > best.score || (s == best.score && candidate < best.candidate))
+    {
+      best.candidate = candidate;
+      best.score = s;
+      best.pocketed = copy.events().pocketed;
+    }
+  });
+
+  Best chosen;
+  for (const Best& best : _best)
+  {
+    shot.candidates += best.played;
+    if (best.candidate < 0) continue;
+    if (chosen.candidate < 0 || best.score > chosen.score
+      || (best.score == chosen.score && best.candidate < chosen.candidate))
+    {
+      chosen = best;
+    }
+  }
+  // a budget too small for even one candidate still gets a shot
+  if (chosen.candidate < 0) chosen.candidate = 0;
+  shot.ball = _balls[chosen.candidate % numBalls];
+  shot.vel = candidateVel(chosen.candidate / numBalls);
+  shot.score = chosen.score;
+  shot.pocketed = chosen.pocketed;
+  shot.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  return shot;
+}
+
+vec3 Opponent::candidateVel(int sample) const
+{
+  // the R2 sequence, whose points fill the square evenly however many are
+  // taken
+  double u = fmod(0.5 + sample * 0.7548776662466927, 1.0);
+  double v = fmod(0.5 + sample * 0.5698402909980532, 1.0);
+  float angle = two_pi<float>() * (float) u;
+  float speed = mix(_config.minSpeed, _config.maxSpeed, (float) v);
+  return speed * vec3(cos(angle), sin(angle), 0);
+}
+
+float Opponent::score(const Table& table) const
+{
+  const TableEvents& events = table.events();
+  float s = _config.pocketScore * events.pocketed;
+  if (events.firstHit == -1) s += _config.missScore;
+  const vector<vec3>& pockets = table.pockets();
+  for (int i = 0; i < table.numBalls(); i++)
+  {
+    if (!table.balls().isFree(i)) continue;
+    float nearest = _config.leaveRange;
+    vec2 pos(table.balls().posX[i], table.balls().posY[i]);
+    for (const vec3& pocket : pockets)
+    {
+      nearest = std::min(nearest, distance(pos, vec2(pocket)));
+    }
+    s += _config.leaveScore * (1.0f - nearest / _config.leaveRange);
+  }
+  return s;
+}
+
+}  // namespace poolsim
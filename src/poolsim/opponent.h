@@ -0,0 +1,116 @@
+/**
+ * @file opponent.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Computer opponent that picks its shot by playing out candidates
+ */
+
+#ifndef POOLSIM_OPPONENT_H_
+#define POOLSIM_OPPONENT_H_
+
+#include "poolsim/table.h"
+#include "poolsim/threadpool.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace poolsim {
+
+struct OpponentConfig
+{
+  // seconds to search for, after which the best shot so far is taken;
+  // zero plays every candidate
+  float timeBudget = 0.05f;
+  // launches tried for each ball still in play, spread evenly over the
+  // directions and speeds
+  int candidatesPerBall = 2000;
+  float minSpeed = 200.0f;
+  float maxSpeed = 3000.0f;
+  // longest a candidate may run before it is scored anyway
+  float maxShotTime = 20.0f;
+  // a tilted table never comes to rest and has to be played step by step,
+  // so candidates on one are scored this soon instead
+  float maxTiltedShotTime = 3.0f;
+  // score of each ball the shot pockets, all of which Glorb will devour
+  float pocketScore = 1.0f;
+  // score for leaving a ball next to a pocket, falling to nothing at
+  // leaveRange from it, so that shots that pocket nothing still differ
+  float leaveScore = 0.05f;
+  float leaveRange = 100.0f;
+  // score of a shot whose ball strikes no other ball
+  float missScore = -0.1f;
+};
+
+/**
+ * The shot the opponent settled on and what the search cost.
+ */
+struct OpponentShot
+{
+  // -1 if no ball is in play
+  int ball = -1;
+  // as passed to Table::launch
+  glm::vec3 vel = glm::vec3(0);
+  float score = 0.0f;
+  // balls the shot pocketed when it was played out
+  int pocketed = 0;
+  int candidates = 0;
+  double seconds = 0.0;
+
+  double shotsPerSecond() const { return seconds > 0 ? candidates / seconds : 0.0; }
+};
+
+/**
+ * Picks a shot by trying candidate launches on copies of the table. The
+ * table is snapshotted once, and each candidate restores a thread's copy
+ * from the snapshot, launches, plays out to rest with the table's own
+ * solver and is scored, so the active chaos effect bends the candidates
+ * just as it will bend the real shot. Random effect changes are switched
+ * off on the copies, as they would make the outcome a guess.
+ *
+ * Candidates alternate between the balls in play and follow a
+ * low-discrepancy sequence over direction and speed within each ball, so a
+ * search cut short by the time budget still covers every ball evenly.
+ * Without a time budget the choice depends only on the table.
+ */
+class Opponent
+{
+public:
+    Opponent(ThreadPool& pool, const OpponentConfig& config = OpponentConfig());
+
+    /**
+    * Searches for the best shot on the table as it is now.
+    */
+    OpponentShot chooseShot(const Table& table);
+
+    OpponentConfig& config() { return _config; }
+
+private:
+    // best candidate a thread has played
+    struct Best
+    {
+      int candidate = -1;
+      float score = 0.0f;
+      int pocketed = 0;
+      int played = 0;
+    };
+
+    /**
+    * Launch velocity of the given candidate of a ball, counting from zero.
+    */
+    glm::vec3 candidateVel(int sample) const;
+
+    /**
+    * Scores the table a candidate left behind.
+    */
+    float score(const Table& table) const;
+
+    OpponentConfig _config;
+    ThreadPool& _pool;
+    std::vector<Table> _tables;
+    std::vector<Best> _best;
+    std::vector<char> _snapshot;
+    std::vector<int> _balls;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_OPPONENT_H_
@@ -0,0 +1,126 @@
+/**
+ * @file preview.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the background trajectory preview
+ */
+
+#include "poolsim/preview.h"
+#include <utility>
+
+using namespace std;
+using namespace glm;
+
+namespace poolsim {
+
+TrajectoryPreview::TrajectoryPreview(float maxTime) :
+  _maxTime(maxTime), _latest(0)
+{
+  _thread = thread(&TrajectoryPreview::workerLoop, this);
+}
+
+TrajectoryPreview::~TrajectoryPreview()
+{
+  {
+    lock_guard<mutex> lock(_mutex);
+    _stop = true;
+    _latest++;
+  }
+  _wake.notify_one();
+  _thread.join();
+}
+
+void TrajectoryPreview::request(const Table& table, int ball, const vec3& vel)
+{
+  {
+    lock_guard<mutex> lock(_mutex);
+    // assigning over the last snapshot reuses its storage
+    _pending = table;
+    // the preview's steps are not part of the game's recording
+    _pending.setRecorder(nullptr);
+    // the preview steps it on its own thread
+    _pending.setThreadPool(nullptr);
+    _pendingBall = ball;
+    _pendingVel = vel;
+    _hasPending = true;
+    _latest++;
+  }
+  _wake.notify_one();
+}
+
+void TrajectoryPreview::cancel()
+{
+  lock_guard<mutex> lock(_mutex);
+  _hasPending = false;
+  _hasFinished = false;
+  _latest++;
+}
+
+bool TrajectoryPreview::poll(TrajectoryPath& path)
+{
+  // the worker only holds the lock briefly, but a frame should not wait on
+  // it at all; whatever is ready will still be there next frame
+  unique_lock<mutex> lock(_mutex, try_to_lock);
+  if (!lock.owns_lock() || !_hasFinished) return false;
+  swap(path, _finished);
+  _hasFinished = false;
+  return true;
+}
+
+void TrajectoryPreview::workerLoop()
+{
+  unique_lock<mutex> lock(_mutex);
+  while (true)
+  {
+    _wake.wait(lock, [this] { return _stop || _hasPending; });
+    if (_stop) return;
+
+    swap(_table, _pending);
+    int ball = _pendingBall;
+    vec3 vel = _pendingVel;
+    uint64_t request = _latest;
+    _hasPending = false;
+
+    lock.unlock();
+    bool finished = play(ball, vel, request);
+    lock.lock();
+
+    if (finished && request == _latest)
+    {
+      swap(_finished, _path);
+      _hasFinished = true;
+    }
+  }
+}
+
+bool TrajectoryPreview::play(int ball, const vec3& vel, uint64_t request)
+{
+  // a new effect picked partway through would make the path a guess
+  _table.setChaosEnabled(false);
+  _table.clearEvents();
+  _table.launch(ball, vel);
+
+  _path.points.clear();
+  _path.firstHit = -1;
+  _path.request = request;
+  _path.points.push_back(_table.pos(ball));
+
+  float dt = _table.config().fixedDt;
+  float restSpeed = _table.config().restSpeed;
+  for (float t = 0.0f; t < _maxTime; t += dt)
+  {
+    if (_latest != request) return false;
+    _table.step();
+    _path.points.push_back(_table.pos(ball));
+    if (_path.firstHit == -1 && _table.events().firstHit != -1)
+    {
+      _path.firstHit = _table.events().firstHit;
+      _path.firstHitPos = _table.pos(ball);
+    }
+    if (_table.isSinking(ball) || _table.isDevoured(ball)) break;
+    if (length(_table.vel(ball)) < restSpeed) break;
+  }
+  return true;
+}
+
+}  // namespace poolsim
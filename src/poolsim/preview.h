@@ -0,0 +1,110 @@
+/**
+ * @file preview.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Predicts where an aimed shot goes on a background thread
+ */
+
+#ifndef POOLSIM_PREVIEW_H_
+#define POOLSIM_PREVIEW_H_
+
+#include "poolsim/table.h"
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace poolsim {
+
+/**
+ * Where a launched ball went in a preview.
+ */
+struct TrajectoryPath
+{
+  // the launched ball's position before the shot and after every step
+  std::vector<glm::vec3> points;
+  // first ball the launched ball struck, -1 if it struck none
+  int firstHit = -1;
+  // the launched ball's position at the end of the step it struck firstHit
+  glm::vec3 firstHitPos = glm::vec3(0);
+  // the request() call this path answers, counting from 1
+  uint64_t request = 0;
+};
+
+/**
+ * Plays an aimed shot forward on a copy of the table, with the real physics
+ * and the active chaos effect, on a thread of its own. Only the newest
+ * request matters: a request that comes in while another is running cancels
+ * it within a step, and the worker holds the lock only to swap tables and
+ * paths, so neither request() nor poll() waits on the simulation.
+ */
+class TrajectoryPreview
+{
+public:
+    /**
+    * Starts the worker thread.
+    *
+    * @param maxTime The most time to play each shot for, in seconds.
+    */
+    explicit TrajectoryPreview(float maxTime = 3.0f);
+    ~TrajectoryPreview();
+
+    TrajectoryPreview(const TrajectoryPreview&) = delete;
+    TrajectoryPreview& operator=(const TrajectoryPreview&) = delete;
+
+    /**
+    * Asks for the path of a ball launched on a snapshot of the table,
+    * replacing any request not yet answered.
+    *
+    * @param table The table to copy.
+    * @param ball The index of the ball to launch.
+    * @param vel The launch velocity, as passed to Table::launch.
+    */
+    void request(const Table& table, int ball, const glm::vec3& vel);
+
+    /**
+    * Drops the pending request and any path not yet collected.
+    */
+    void cancel();
+
+    /**
+    * Collects the path of the newest request if it is ready.
+    *
+    * @param path Swapped with the finished path, so that its storage is
+    *   reused for the next one.
+    * @return True if path was replaced, false if nothing new was ready.
+    */
+    bool poll(TrajectoryPath& path);
+
+private:
+    void workerLoop();
+    bool play(int ball, const glm::vec3& vel, uint64_t request);
+
+    float _maxTime;
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    bool _stop = false;
+
+    // id of the newest request, read by the worker after every step
+    std::atomic<uint64_t> _latest;
+
+    // guarded by _mutex
+    Table _pending;
+    int _pendingBall = -1;
+    glm::vec3 _pendingVel = glm::vec3(0);
+    bool _hasPending = false;
+    TrajectoryPath _finished;
+    bool _hasFinished = false;
+
+    // owned by the worker
+    Table _table;
+    TrajectoryPath _path;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_PREVIEW_H_
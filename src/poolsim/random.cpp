@@ -0,0 +1,73 @@
+/**
+ * @file random.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the seeding, jump-ahead and batch draws of Pcg32
+ */
+
+#include "poolsim/random.h"
+#include "poolsim/kernels.h"
+
+namespace poolsim {
+
+void Pcg32::seed(uint64_t seed, uint64_t stream)
+{
+  // as pcg32_srandom_r does
+  _state = 0;
+  _inc = (stream << 1) | 1;
+  (*this)();
+  _state += seed;
+  (*this)();
+}
+
+void pcgJump(uint64_t delta, uint64_t inc, uint64_t& mult, uint64_t& add)
+{
+  // Brown, "Random Number Generation with Arbitrary Strides": square the
+  // one-step map for each bit of delta
+  uint64_t stepMult = Pcg32::multiplier;
+  uint64_t stepAdd = inc;
+  mult = 1;
+  add = 0;
+  while (delta > 0)
+  {
+    if (delta & 1)
+    {
+      mult *= stepMult;
+      add = add * stepMult + stepAdd;
+    }
+    stepAdd = (stepMult + 1) * stepAdd;
+    stepMult *= stepMult;
+    delta >>= 1;
+  }
+}
+
+void Pcg32::advance(uint64_t delta)
+{
+  uint64_t mult;
+  uint64_t add;
+  pcgJump(delta, _inc, mult, add);
+  _state = _state * mult + add;
+}
+
+void Pcg32::generate(uint32_t* out, int count)
+{
+  if (count <= 0) return;
+  _state = kernels().pcgFill(_state, _inc, out, count);
+}
+
+void Pcg32::generate(float* out, int count)
+{
+  uint32_t bits[64];
+  for (int first = 0; first < count; first += 64)
+  {
+    int chunk = count - first < 64 ? count - first : 64;
+    generate(bits, chunk);
+    for (int k = 0; k < chunk; k++)
+    {
+      // the top 24 bits, which a float holds exactly
+      out[first + k] = (bits[k] >> 8) * (1.0f / 16777216.0f);
+    }
+  }
+}
+
+}  // namespace poolsim
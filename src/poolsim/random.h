@@ -0,0 +1,94 @@
+/**
+ * @file random.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Small seeded generator with streams, jump-ahead and batch draws
+ */
+
+#ifndef POOLSIM_RANDOM_H_
+#define POOLSIM_RANDOM_H_
+
+#include <cstdint>
+
+namespace poolsim {
+
+/**
+ * PCG32 (O'Neill's pcg32, XSH RR output on a 64-bit LCG). Each table owns
+ * one, so runs repeat from their seed and tables on different threads share
+ * nothing. It is 16 plain bytes on every platform, so a snapshot can copy
+ * it as it lies.
+ *
+ * Generators with the same seed and different streams give unrelated
+ * sequences, and advance() skips ahead any number of draws in a handful of
+ * multiplies, so one seed can hand out independent streams or disjoint
+ * stretches of one stream. It meets the standard's uniform random bit
+ * generator requirements, so it works with the std distributions too.
+ */
+class Pcg32
+{
+public:
+    typedef uint32_t result_type;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xffffffffu; }
+
+    static const uint64_t multiplier = 6364136223846793005ull;
+
+    explicit Pcg32(uint64_t seed = 0, uint64_t stream = 0) { this->seed(seed, stream); }
+
+    void seed(uint64_t seed, uint64_t stream = 0);
+
+    result_type operator()()
+    {
+      uint64_t old = _state;
+      _state = old * multiplier + _inc;
+      return output(old);
+    }
+
+    /**
+    * Skips ahead as if operator() had been called delta times.
+    */
+    void advance(uint64_t delta);
+
+    /**
+    * Fills out with the next count draws, the same ones count calls to
+    * operator() would give, several at a time with the vector kernels,
+    * see KernelSet::random.
+    */
+    void generate(uint32_t* out, int count);
+
+    /**
+    * Fills out with the next count draws scaled into [0, 1).
+    */
+    void generate(float* out, int count);
+
+    /**
+    * The draw a generator gives in the given state.
+    */
+    static uint32_t output(uint64_t state)
+    {
+      uint32_t xorshifted = (uint32_t) (((state >> 18) ^ state) >> 27);
+      uint32_t rot = (uint32_t) (state >> 59);
+      return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    uint64_t state() const { return _state; }
+    uint64_t increment() const { return _inc; }
+
+    bool operator==(const Pcg32& other) const { return _state == other._state && _inc == other._inc; }
+    bool operator!=(const Pcg32& other) const { return !(*this == other); }
+
+private:
+    uint64_t _state;
+    // odd, picks the stream
+    uint64_t _inc;
+};
+
+/**
+ * The multiplier and increment that take the generator's state delta draws
+ * ahead in one step, state * mult + add, found by squaring.
+ */
+void pcgJump(uint64_t delta, uint64_t inc, uint64_t& mult, uint64_t& add);
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_RANDOM_H_
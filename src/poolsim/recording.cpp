@@ -0,0 +1,458 @@
+/**
+ * @file recording.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements input recordings of a table and their replay
+ */
+
+#include "poolsim/recording.h"
+#include "poolsim/bytes.h"
+#include "poolsim/tablegeometry.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+using namespace std;
+using namespace glm;
+
+namespace poolsim {
+
+static const char recordingMagic[4] = {'P', 'S', 'I', 'R'};
+// keyframes are table snapshots, so a recording is for builds that share
+// the snapshot layout and draw the same chaos from a seed
+static const uint64_t recordingVersion = 3;
+
+// steps since the last input share a varint with the type
+static const int inputTypeBits = 4;
+
+static void writeArray(ByteWriter& out, const vector<float>& values)
+{
+  out.varint(values.size());
+  out.raw(values.data(), values.size() * sizeof(float));
+}
+
+static bool readArray(ByteReader& in, vector<float>& values)
+{
+  uint64_t size = in.varint();
+  if (!in.ok() || size > (1 << 20)) return false;
+  values.resize((size_t) size);
+  in.raw(values.data(), values.size() * sizeof(float));
+  return in.ok();
+}
+
+// the arrays are written as they are, so that the replay collides with
+// bit for bit the same edges
+static void writeSegments(ByteWriter& out, const SegmentArrays& segments)
+{
+  out.varint(segments.count);
+  writeArray(out, segments.ax);
+  writeArray(out, segments.ay);
+  writeArray(out, segments.dx);
+  writeArray(out, segments.dy);
+  writeArray(out, segments.invLengthSq);
+}
+
+static bool readSegments(ByteReader& in, SegmentArrays& segments)
+{
+  segments.count = (int) in.varint();
+  bool ok = readArray(in, segments.ax) && readArray(in, segments.ay) && readArray(in, segments.dx)
+    && readArray(in, segments.dy) && readArray(in, segments.invLengthSq);
+  int padded = segments.padded();
+  return ok && segments.count <= padded && (int) segments.ay.size() == padded && (int) segments.dx.size() == padded
+    && (int) segments.dy.size() == padded && (int) segments.invLengthSq.size() == padded;
+}
+
+static void writeConfig(ByteWriter& out, const TableConfig& config)
+{
+  out.varint(config.numBalls);
+  out.varint(config.viewVolumeSide);
+  out.varint(config.tableLength);
+  out.varint(config.tableWidth);
+  out.f32(config.sphereRadius);
+  out.f32(config.ballDefaultSize);
+  out.f32(config.glorbScale);
+  out.f32(config.fixedDt);
+  out.varint(config.maxStepsPerFrame);
+  out.f32(config.chaosPeriod);
+  out.u8(config.solver);
+  out.varint(config.seed);
+  out.f32(config.restSpeed);
+  out.f32(config.sleepTime);
+
+  const TableGeometry* geometry = config.geometry.get();
+  out.u8(geometry != nullptr);
+  if (!geometry) return;
+  out.varint(geometry->pockets.size());
+  for (const PocketShape& pocket : geometry->pockets)
+  {
+    out.f32(pocket.jawA.x); out.f32(pocket.jawA.y);
+    out.f32(pocket.jawB.x); out.f32(pocket.jawB.y);
+    out.f32(pocket.center.x); out.f32(pocket.center.y);
+    out.f32(pocket.radius);
+    out.f32(pocket.reach);
+  }
+  writeSegments(out, geometry->cushions);
+  writeSegments(out, geometry->mouths);
+  out.f32(geometry->playExtent.x); out.f32(geometry->playExtent.y);
+  out.f32(geometry->railExtent.x); out.f32(geometry->railExtent.y);
+}
+
+static bool readConfig(ByteReader& in, TableConfig& config)
+{
+  config.numBalls = (int) in.varint();
+  config.viewVolumeSide = (int) in.varint();
+  config.tableLength = (int) in.varint();
+  config.tableWidth = (int) in.varint();
+  config.sphereRadius = in.f32();
+  config.ballDefaultSize = in.f32();
+  config.glorbScale = in.f32();
+  config.fixedDt = in.f32();
+  config.maxStepsPerFrame = (int) in.varint();
+  config.chaosPeriod = in.f32();
+  int solver = in.u8();
+  config.solver = solver <= SOLVER_SEQUENTIAL_IMPULSE ? (SolverMode) solver : SOLVER_FIXED_STEP;
+  config.seed = (uint32_t) in.varint();
+  config.restSpeed = in.f32();
+  config.sleepTime = in.f32();
+  if (!in.ok() || config.numBalls <= 0 || config.numBalls > (1 << 20) || !(config.fixedDt > 0)) return false;
+
+  config.geometry = nullptr;
+  if (in.u8() == 0) return in.ok();
+  shared_ptr<TableGeometry> geometry = make_shared<TableGeometry>();
+  uint64_t numPockets = in.varint();
+  if (numPockets > 64) return false;
+  for (uint64_t p = 0; p < numPockets; p++)
+  {
+    PocketShape pocket;
+    pocket.jawA.x = in.f32(); pocket.jawA.y = in.f32();
+    pocket.jawB.x = in.f32(); pocket.jawB.y = in.f32();
+    pocket.center.x = in.f32(); pocket.center.y = in.f32();
+    pocket.radius = in.f32();
+    pocket.reach = in.f32();
+    geometry->pockets.push_back(pocket);
+  }
+  if (!readSegments(in, geometry->cushions) || !readSegments(in, geometry->mouths)) return false;
+  if (geometry->mouths.count != (int) numPockets) return false;
+  geometry->playExtent.x = in.f32(); geometry->playExtent.y = in.f32();
+  geometry->railExtent.x = in.f32(); geometry->railExtent.y = in.f32();
+  config.geometry = geometry;
+  return in.ok();
+}
+
+void InputRecorder::start(Table& table)
+{
+  stop();
+  _table = &table;
+  _config = table.config();
+  _inputs.clear();
+  _keyframes.clear();
+  _steps = 0;
+  _lastInputStep = 0;
+  stepped();
+  table.setRecorder(this);
+}
+
+void InputRecorder::stop()
+{
+  if (!_table) return;
+  _finalHash = _table->stateHash();
+  if (_table->recorder() == this) _table->setRecorder(nullptr);
+  _table = nullptr;
+}
+
+void InputRecorder::begin(InputType type)
+{
+  ByteWriter out(_inputs);
+  out.varint(((uint64_t) (_steps - _lastInputStep) << inputTypeBits) | type);
+  _lastInputStep = _steps;
+}
+
+void InputRecorder::reset(uint32_t seed)
+{
+  begin(INPUT_RESET);
+  ByteWriter(_inputs).varint(seed);
+}
+
+void InputRecorder::launch(int i, const vec3& vel)
+{
+  begin(INPUT_LAUNCH);
+  ByteWriter out(_inputs);
+  out.varint(i);
+  out.vec3(vel);
+}
+
+void InputRecorder::setVel(int i, const vec3& vel)
+{
+  begin(INPUT_SET_VEL);
+  ByteWriter out(_inputs);
+  out.varint(i);
+  out.vec3(vel);
+}
+
+void InputRecorder::stopAll()
+{
+  begin(INPUT_STOP_ALL);
+}
+
+void InputRecorder::chaosEnabled(bool enabled)
+{
+  begin(INPUT_CHAOS_ENABLED);
+  ByteWriter(_inputs).u8(enabled);
+}
+
+void InputRecorder::chaosEffect(int effect)
+{
+  begin(INPUT_CHAOS_EFFECT);
+  ByteWriter(_inputs).varint(effect);
+}
+
+void InputRecorder::glorbPos(const vec3& pos)
+{
+  begin(INPUT_GLORB_POS);
+  ByteWriter(_inputs).vec3(pos);
+}
+
+void InputRecorder::eyeDiameter(float modifier)
+{
+  begin(INPUT_EYE_DIAMETER);
+  ByteWriter(_inputs).f32(modifier);
+}
+
+void InputRecorder::camera(float azimuth, float elevation)
+{
+  begin(INPUT_CAMERA);
+  ByteWriter out(_inputs);
+  out.f32(azimuth);
+  out.f32(elevation);
+}
+
+void InputRecorder::stepped()
+{
+  // start() takes the first keyframe before any step
+  if (!_keyframes.empty()) _steps++;
+  if (_steps % _keyframeInterval != 0) return;
+  Keyframe keyframe;
+  keyframe.step = _steps;
+  keyframe.inputOffset = _inputs.size();
+  keyframe.stateHash = _table->stateHash();
+  keyframe.state.resize(_table->snapshotSize());
+  _table->snapshot(keyframe.state.data(), keyframe.state.size());
+  _keyframes.push_back(move(keyframe));
+  // inputs after a keyframe count their steps from it, so that a seek can
+  // start reading there
+  _lastInputStep = _steps;
+}
+
+bool InputRecorder::save(const string& path) const
+{
+  vector<uint8_t> bytes;
+  ByteWriter out(bytes);
+  out.raw(recordingMagic, sizeof(recordingMagic));
+  out.varint(recordingVersion);
+  writeConfig(out, _config);
+  out.varint(_inputs.size());
+  out.raw(_inputs.data(), _inputs.size());
+  out.varint(_keyframes.size());
+  for (const Keyframe& keyframe : _keyframes)
+  {
+    out.varint(keyframe.step);
+    out.varint(keyframe.inputOffset);
+    out.u64(keyframe.stateHash);
+    out.varint(keyframe.state.size());
+    out.raw(keyframe.state.data(), keyframe.state.size());
+  }
+  out.varint(_steps);
+  out.u64(_table ? _table->stateHash() : _finalHash);
+
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == NULL) return false;
+  bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+  return fclose(file) == 0 && ok;
+}
+
+bool Replayer::load(const string& path, string& error)
+{
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == NULL)
+  {
+    error = "cannot open " + path;
+    return false;
+  }
+  vector<uint8_t> bytes;
+  uint8_t buffer[1 << 16];
+  size_t got;
+  while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0)
+  {
+    bytes.insert(bytes.end(), buffer, buffer + got);
+  }
+  fclose(file);
+
+  ByteReader in(bytes);
+  char magic[sizeof(recordingMagic)];
+  in.raw(magic, sizeof(magic));
+  if (!in.ok() || memcmp(magic, recordingMagic, sizeof(magic)) != 0 || in.varint() != recordingVersion)
+  {
+    error = path + " is not a recording this version can play";
+    return false;
+  }
+  TableConfig config;
+  if (!readConfig(in, config))
+  {
+    error = path + " has a malformed table config";
+    return false;
+  }
+
+  uint64_t inputBytes = in.varint();
+  if (!in.ok() || inputBytes > bytes.size())
+  {
+    error = path + " is truncated";
+    return false;
+  }
+  _inputs.resize((size_t) inputBytes);
+  in.raw(_inputs.data(), _inputs.size());
+  uint64_t numKeyframes = in.varint();
+  _keyframes.clear();
+  for (uint64_t k = 0; in.ok() && k < numKeyframes; k++)
+  {
+    Keyframe keyframe;
+    keyframe.step = (long) in.varint();
+    keyframe.inputOffset = (size_t) in.varint();
+    keyframe.stateHash = in.u64();
+    uint64_t stateBytes = in.varint();
+    if (stateBytes > bytes.size() || keyframe.inputOffset > _inputs.size()) break;
+    if (!_keyframes.empty() && (keyframe.step <= _keyframes.back().step
+      || keyframe.inputOffset < _keyframes.back().inputOffset)) break;
+    keyframe.state.resize((size_t) stateBytes);
+    in.raw(keyframe.state.data(), keyframe.state.size());
+    _keyframes.push_back(move(keyframe));
+  }
+  _steps = (long) in.varint();
+  _finalHash = in.u64();
+  if (!in.ok() || _keyframes.size() != numKeyframes || _keyframes.empty() || _keyframes[0].step != 0)
+  {
+    error = path + " is truncated";
+    return false;
+  }
+
+  _table = Table(config);
+  if (!_table.restore(_keyframes[0].state.data(), _keyframes[0].state.size()))
+  {
+    error = path + " was recorded by a build that lays out snapshots differently";
+    return false;
+  }
+  _mismatches = 0;
+  seek(0);
+  return true;
+}
+
+void Replayer::seek(long step)
+{
+  step = std::max(0L, std::min(step, _steps));
+  size_t k = 0;
+  while (k + 1 < _keyframes.size() && _keyframes[k + 1].step <= step) k++;
+  const Keyframe& keyframe = _keyframes[k];
+  if (!_table.restore(keyframe.state.data(), keyframe.state.size())) _table.reset();
+
+  _position = keyframe.step;
+  _cursor = keyframe.inputOffset;
+  _inputBase = keyframe.step;
+  _nextKeyframe = k + 1;
+  while (_position < step)
+  {
+    Replayer::step();
+  }
+}
+
+bool Replayer::step()
+{
+  applyInputs();
+  if (_position >= _steps) return false;
+  _table.step();
+  _position++;
+  if (_nextKeyframe < _keyframes.size() && _keyframes[_nextKeyframe].step == _position)
+  {
+    if (_table.stateHash() != _keyframes[_nextKeyframe].stateHash) _mismatches++;
+    // the inputs after a keyframe count their steps from it
+    _cursor = _keyframes[_nextKeyframe].inputOffset;
+    _inputBase = _position;
+    _nextKeyframe++;
+  }
+  return true;
+}
+
+bool Replayer::run()
+{
+  while (step()) {}
+  if (_table.stateHash() != _finalHash) _mismatches++;
+  return _mismatches == 0;
+}
+
+void Replayer::applyInputs()
+{
+  // the inputs after the next keyframe count from it, so wait until it is
+  // passed before reading them
+  size_t end = _nextKeyframe < _keyframes.size() ? _keyframes[_nextKeyframe].inputOffset : _inputs.size();
+  ByteReader in(_inputs.data() + _cursor, end - _cursor);
+  while (!in.atEnd())
+  {
+    const uint8_t* start = in.pos();
+    uint64_t header = in.varint();
+    long inputStep = _inputBase + (long) (header >> inputTypeBits);
+    if (!in.ok() || inputStep > _position)
+    {
+      // not due yet, read it again next step
+      in = ByteReader(start, _inputs.data() + end - start);
+      break;
+    }
+    _inputBase = inputStep;
+
+    int i;
+    vec3 v;
+    switch (header & ((1 << inputTypeBits) - 1))
+    {
+    case INPUT_RESET:
+      _table.reset((uint32_t) in.varint());
+      break;
+    case INPUT_LAUNCH:
+      i = (int) in.varint();
+      v = in.vec3();
+      if (in.ok() && i < _table.numBalls()) _table.launch(i, v);
+      break;
+    case INPUT_SET_VEL:
+      i = (int) in.varint();
+      v = in.vec3();
+      if (in.ok() && i < _table.numBalls()) _table.setVel(i, v);
+      break;
+    case INPUT_STOP_ALL:
+      _table.stopAll();
+      break;
+    case INPUT_CHAOS_ENABLED:
+      _table.setChaosEnabled(in.u8() != 0);
+      break;
+    case INPUT_CHAOS_EFFECT:
+      i = (int) in.varint();
+      if (in.ok() && i < NUM_CHAOS_EFFECTS) _table.setChaosEffect((ChaosEffect) i);
+      break;
+    case INPUT_GLORB_POS:
+      v = in.vec3();
+      if (in.ok()) _table.setGlorbPos(v);
+      break;
+    case INPUT_EYE_DIAMETER:
+      _table.setEyeDiameterModifier(in.f32());
+      break;
+    case INPUT_CAMERA:
+      _azimuth = in.f32();
+      _elevation = in.f32();
+      break;
+    default:
+      // an input this version does not know cannot be skipped, so the rest
+      // of the inputs up to the next keyframe are lost
+      in = ByteReader(start, 0);
+      break;
+    }
+  }
+  _cursor = in.pos() - _inputs.data();
+}
+
+}  // namespace poolsim
@@ -0,0 +1,196 @@
+/**
+ * @file recording.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Compact input recordings of a table and their replay
+ */
+
+#ifndef POOLSIM_RECORDING_H_
+#define POOLSIM_RECORDING_H_
+
+#include "poolsim/table.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace poolsim {
+
+/**
+ * Everything that reaches a table from outside. Chaos picks its effects
+ * from the table's own generator, seeded by TableConfig::seed, so they are
+ * replayed rather than recorded.
+ */
+enum InputType : uint8_t
+{
+  INPUT_RESET,
+  INPUT_LAUNCH,
+  INPUT_SET_VEL,
+  INPUT_STOP_ALL,
+  INPUT_CHAOS_ENABLED,
+  INPUT_CHAOS_EFFECT,
+  INPUT_GLORB_POS,
+  INPUT_EYE_DIAMETER,
+  // where the player looked from, which the table never sees but a viewer
+  // of the replay wants
+  INPUT_CAMERA,
+  NUM_INPUT_TYPES
+};
+
+/**
+ * The whole table state at a step, before the inputs made at that step.
+ */
+struct Keyframe
+{
+  long step = 0;
+  // where the inputs after the keyframe start in the input log
+  size_t inputOffset = 0;
+  uint64_t stateHash = 0;
+  // see Table::snapshot
+  std::vector<uint8_t> state;
+};
+
+/**
+ * Records a table as it is played. Each input is a varint holding the steps
+ * since the last input and its type, then its arguments, so that a launch
+ * takes 14 bytes and a toggle 2. Every keyframeInterval steps the whole
+ * table state is kept as a Keyframe, so that a replay can seek to any step
+ * by playing at most that many steps.
+ */
+class InputRecorder
+{
+public:
+    /**
+    * @param keyframeInterval Steps between keyframes, ten seconds of play
+    * by default.
+    */
+    InputRecorder(int keyframeInterval = 600) : _keyframeInterval(keyframeInterval) {}
+
+    /**
+    * Drops anything recorded so far, takes the first keyframe from the table
+    * and attaches to it. The table may be partway through a game.
+    */
+    void start(Table& table);
+
+    /**
+    * Detaches from the table, keeping what was recorded and the hash of the
+    * table as it ends.
+    */
+    void stop();
+
+    bool recording() const { return _table != nullptr; }
+
+    void reset(uint32_t seed);
+    void launch(int i, const glm::vec3& vel);
+    void setVel(int i, const glm::vec3& vel);
+    void stopAll();
+    void chaosEnabled(bool enabled);
+    void chaosEffect(int effect);
+    void glorbPos(const glm::vec3& pos);
+    void eyeDiameter(float modifier);
+    void camera(float azimuth, float elevation);
+
+    /**
+    * Counts a step of the table and takes a keyframe when one is due.
+    */
+    void stepped();
+
+    long steps() const { return _steps; }
+    size_t inputBytes() const { return _inputs.size(); }
+    const std::vector<Keyframe>& keyframes() const { return _keyframes; }
+
+    /**
+    * Writes the config with any traced geometry, the inputs and the
+    * keyframes, then the number of steps and the hash of the table as it is
+    * now.
+    *
+    * @return False if the file could not be written.
+    */
+    bool save(const std::string& path) const;
+
+private:
+    void begin(InputType type);
+
+    int _keyframeInterval;
+    Table* _table = nullptr;
+    TableConfig _config;
+    std::vector<uint8_t> _inputs;
+    std::vector<Keyframe> _keyframes;
+    long _steps = 0;
+    long _lastInputStep = 0;
+    uint64_t _finalHash = 0;
+};
+
+/**
+ * Plays a recording back on a table of its own, as fast as the solver
+ * allows, checking the table against the hash of every keyframe it passes
+ * and the final hash at the end.
+ */
+class Replayer
+{
+public:
+    /**
+    * Reads a recording and seeks to its first step. The traced cushions and
+    * pockets of the table are part of the recording, so the mesh they came
+    * from is not needed.
+    *
+    * @param error Set to what went wrong when loading fails.
+    * @return False if the file is missing or malformed.
+    */
+    bool load(const std::string& path, std::string& error);
+
+    /**
+    * Restores the keyframe at or before the given step and plays forward to
+    * it, leaving the inputs made at that step to come.
+    */
+    void seek(long step);
+
+    /**
+    * Applies the inputs made at the current step and, unless the recording
+    * has ended, runs the next step.
+    *
+    * @return False once the recording has ended.
+    */
+    bool step();
+
+    /**
+    * Plays to the end of the recording.
+    *
+    * @return True if every keyframe passed and the final state matched.
+    */
+    bool run();
+
+    Table& table() { return _table; }
+    long position() const { return _position; }
+    long steps() const { return _steps; }
+    const std::vector<Keyframe>& keyframes() const { return _keyframes; }
+    int mismatches() const { return _mismatches; }
+    uint64_t finalHash() const { return _finalHash; }
+    float azimuth() const { return _azimuth; }
+    float elevation() const { return _elevation; }
+
+private:
+    /**
+    * Applies every input made at the current step.
+    */
+    void applyInputs();
+
+    Table _table;
+    std::vector<uint8_t> _inputs;
+    std::vector<Keyframe> _keyframes;
+    long _steps = 0;
+    uint64_t _finalHash = 0;
+
+    long _position = 0;
+    size_t _cursor = 0;
+    // step the input under the cursor counts its steps from
+    long _inputBase = 0;
+    size_t _nextKeyframe = 0;
+    int _mismatches = 0;
+    float _azimuth = 0.0f;
+    float _elevation = 0.0f;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_RECORDING_H_
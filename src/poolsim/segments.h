@@ -0,0 +1,78 @@
+/**
+ * @file segments.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Structure-of-arrays storage for the cushion segments of a table
+ */
+
+#ifndef POOLSIM_SEGMENTS_H_
+#define POOLSIM_SEGMENTS_H_
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace poolsim {
+
+/**
+ * Line segments in the plane of the table, stored as a start point and the
+ * vector to the end point. The arrays are padded to a multiple of eight
+ * with segments far off the table, so that the nearest-segment kernels can
+ * always load full vectors and never pick one of them.
+ */
+struct SegmentArrays
+{
+  std::vector<float> ax, ay;
+  std::vector<float> dx, dy;
+  // 1 / |d|^2, to project onto a segment with a multiply
+  std::vector<float> invLengthSq;
+  // number of real segments, before the padding
+  int count = 0;
+
+  void clear()
+  {
+    ax.clear(); ay.clear(); dx.clear(); dy.clear(); invLengthSq.clear();
+    count = 0;
+  }
+
+  void add(const glm::vec2& a, const glm::vec2& b)
+  {
+    // drop the padding, append and pad again
+    resize(count);
+    glm::vec2 d = b - a;
+    ax.push_back(a.x); ay.push_back(a.y);
+    dx.push_back(d.x); dy.push_back(d.y);
+    invLengthSq.push_back(glm::dot(d, d) > 0 ? 1.0f / glm::dot(d, d) : 0.0f);
+    count++;
+    int padded = (count + 7) & ~7;
+    for (int s = count; s < padded; s++)
+    {
+      ax.push_back(1e9f); ay.push_back(1e9f);
+      dx.push_back(0); dy.push_back(0);
+      invLengthSq.push_back(0);
+    }
+  }
+
+  int padded() const { return (int) ax.size(); }
+  glm::vec2 start(int s) const { return glm::vec2(ax[s], ay[s]); }
+  glm::vec2 end(int s) const { return glm::vec2(ax[s] + dx[s], ay[s] + dy[s]); }
+
+  /**
+  * Point of segment s nearest to p.
+  */
+  glm::vec2 closestPoint(int s, const glm::vec2& p) const
+  {
+    float t = ((p.x - ax[s]) * dx[s] + (p.y - ay[s]) * dy[s]) * invLengthSq[s];
+    t = glm::clamp(t, 0.0f, 1.0f);
+    return glm::vec2(ax[s] + t * dx[s], ay[s] + t * dy[s]);
+  }
+
+private:
+  void resize(int n)
+  {
+    ax.resize(n); ay.resize(n); dx.resize(n); dy.resize(n); invLengthSq.resize(n);
+  }
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_SEGMENTS_H_
@@ -0,0 +1,74 @@
+/**
+ * @file snapshot.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Layout of the flat table snapshots taken by Table::snapshot
+ */
+
+#ifndef POOLSIM_SNAPSHOT_H_
+#define POOLSIM_SNAPSHOT_H_
+
+#include "poolsim/table.h"
+#include <cstdint>
+#include <type_traits>
+
+namespace poolsim {
+
+/**
+ * Start of a snapshot. It is followed by the bytes of the table's Pcg32,
+ * then by the per-ball arrays: id, the position, velocity and
+ * rotation components, size, flags, the previous positions and rotations
+ * and the steps spent slow, numBalls of each, and for the fixed-point solver
+ * its integer positions and velocities and the floats it last wrote, see
+ * FixedPointSolver::arrays, and for the sequential-impulse solver its
+ * contact cache, see ContactSolver::arrays. Nothing is padded, so fields
+ * must be read with memcpy.
+ *
+ * The generator is copied as it lies in memory, so a snapshot is only for
+ * builds that agree on version and rngSize.
+ */
+struct SnapshotHeader
+{
+  char magic[4];
+  uint32_t version;
+  // bytes in the whole snapshot, this header included
+  uint32_t size;
+  uint32_t numBalls;
+  uint32_t rngSize;
+
+  uint32_t seed;
+  int32_t numBallsSunk;
+  int32_t launchedBall;
+  uint8_t atRest;
+  uint8_t chaosEnabled;
+  // index into Table::chaosEffects()
+  uint8_t chaosEffect;
+  uint8_t unused;
+  // bit e is set if chaos effect e is active
+  uint32_t chaosActive;
+  float chaosTimer;
+  float tiltDir[3];
+  float glorbPos[3];
+  float eyeDiameterModifier;
+
+  float time;
+  float accumulator;
+  int64_t steps;
+
+  // TableEvents, field by field
+  int32_t collisions;
+  int32_t boundaryHits;
+  int32_t pocketed;
+  int32_t lastPocketedId;
+  int32_t devoured;
+  uint8_t chaosChanged;
+  uint8_t unused2[3];
+  int32_t firstHit;
+};
+
+static_assert(std::is_trivial<SnapshotHeader>::value, "snapshots are copied as bytes");
+static_assert(std::is_trivially_copyable<Pcg32>::value, "snapshots copy the generator as bytes");
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_SNAPSHOT_H_
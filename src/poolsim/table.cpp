@@ -0,0 +1,979 @@
+/**
+ * @file table.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the headless pool table simulation
+ */
+
+#include "poolsim/table.h"
+#include "poolsim/kernels.h"
+#include "poolsim/recording.h"
+#include "poolsim/snapshot.h"
+#include "poolsim/tablegeometry.h"
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using namespace glm;
+
+namespace poolsim {
+
+const string Table::plainJane = "Plain Jane";
+const string Table::stickySituation = "Sticky Situation";
+const string Table::hoverHavoc = "Hover Havoc";
+const string Table::biggieSmalls = "Biggie Smalls";
+const string Table::frictionAffliction = "Friction Affliction";
+const string Table::tiltATable = "Tilt-a-Table";
+const string Table::getGaslit = "Get Gaslit";
+
+/**
+ * The hooks of each effect that run outside the step, looked up by effect.
+ */
+struct ChaosEntry
+{
+  void (*onActivate)(Table&);
+  void (*onDeactivate)(Table&);
+  vec3 (*onLaunch)(const vec3&);
+};
+
+#define POOLSIM_CHAOS_ENTRY(effect) \
+  {&ChaosHooks<effect>::onActivate, &ChaosHooks<effect>::onDeactivate, &ChaosHooks<effect>::onLaunch}
+
+static const ChaosEntry chaosRegistry[NUM_CHAOS_EFFECTS] = {
+  POOLSIM_CHAOS_ENTRY(CHAOS_PLAIN_JANE),
+  POOLSIM_CHAOS_ENTRY(CHAOS_STICKY_SITUATION),
+  POOLSIM_CHAOS_ENTRY(CHAOS_HOVER_HAVOC),
+  POOLSIM_CHAOS_ENTRY(CHAOS_BIGGIE_SMALLS),
+  POOLSIM_CHAOS_ENTRY(CHAOS_FRICTION_AFFLICTION),
+  POOLSIM_CHAOS_ENTRY(CHAOS_TILT_A_TABLE),
+  POOLSIM_CHAOS_ENTRY(CHAOS_GET_GASLIT)
+};
+
+#undef POOLSIM_CHAOS_ENTRY
+
+void ChaosHooks<CHAOS_HOVER_HAVOC>::onActivate(Table& table)
+{
+  table.gravityChaos();
+}
+
+void ChaosHooks<CHAOS_HOVER_HAVOC>::onDeactivate(Table& table)
+{
+  table.resetGravity();
+}
+
+void ChaosHooks<CHAOS_BIGGIE_SMALLS>::onActivate(Table& table)
+{
+  table.sizeChaos();
+}
+
+void ChaosHooks<CHAOS_BIGGIE_SMALLS>::onDeactivate(Table& table)
+{
+  table.resetSize();
+}
+
+void ChaosHooks<CHAOS_TILT_A_TABLE>::onActivate(Table& table)
+{
+  table._tiltDir = float(pow(-1, table._rng() % 2)) * vec3(1, 0, 0);
+}
+
+const vector<string>& Table::chaosEffects()
+{
+  static const vector<string> names = {plainJane, stickySituation, hoverHavoc, biggieSmalls, frictionAffliction, tiltATable, getGaslit};
+  return names;
+}
+
+ChaosEffect Table::chaosEffectId(const string& effect)
+{
+  const vector<string>& names = chaosEffects();
+  for (int e = 0; e < NUM_CHAOS_EFFECTS; e++)
+  {
+    if (names[e] == effect) return (ChaosEffect) e;
+  }
+  return NUM_CHAOS_EFFECTS;
+}
+
+Table::Table(const TableConfig& config) : _config(config)
+{
+  reset();
+}
+
+void Table::reset()
+{
+  if (_recorder) _recorder->reset(_config.seed);
+  _pockets.clear();
+  createPoolBalls();
+  createPockets();
+  _broadphase.configure(_config.tableLength, _config.tableWidth,
+    2 * _config.sphereRadius * _config.ballDefaultSize, _config.numBalls);
+  _pairTests = 0;
+  _prevPos.resize(_config.numBalls);
+  _prevRot.resize(_config.numBalls);
+  _slowSteps.assign(_config.numBalls, 0);
+  _ballDraws.resize(2 * _config.numBalls);
+  _fixedSolver.resize(_config.numBalls);
+  _contactSolver.resize(_config.numBalls);
+  _atRest = false;
+  for (int i = 0; i < _config.numBalls; i++)
+  {
+    _prevPos[i] = _balls.pos(i);
+    _prevRot[i] = _balls.rot(i);
+  }
+
+  _chaosActive = 0;
+  _chaosEffect = CHAOS_PLAIN_JANE;
+  _chaosTimer = 0.0f;
+  _tiltDir = vec3(0);
+  _launchedBall = -1;
+  _rng.seed(_config.seed);
+
+  _numBallsSunk = 0;
+  _glorbPos = vec3(0, 0, 200);
+  _eyeDiameterModifier = 0.25;
+  _time = 0.0f;
+  _steps = 0;
+  _accumulator = 0.0f;
+  clearEvents();
+}
+
+void Table::reset(uint32_t seed)
+{
+  _config.seed = seed;
+  reset();
+}
+
+void Table::createPoolBalls()
+{
+  float k = (float) 3 / 1;
+  float a = (_config.tableWidth - 100) / 2;
+  _balls.resize(_config.numBalls);
+  for (int i = 0; i < _config.numBalls; i++)
+  {
+    _balls.id[i] = i + 1;
+    float theta = ((float) i / _config.numBalls) * pi<float>();
+    float r = a * cos(k * theta);
+    _balls.setPos(i, vec3(r * cos(theta), r * sin(theta), 0));
+    _balls.setVel(i, vec3(0));
+    _balls.setRot(i, vec3(0));
+    _balls.size[i] = _config.ballDefaultSize;
+    _balls.flags[i] = 0;
+  }
+}
+
+void Table::createPockets()
+{
+  if (_config.geometry)
+  {
+    for (const PocketShape& pocket : _config.geometry->pockets)
+    {
+      _pockets.push_back(vec3(pocket.center, 0));
+    }
+    return;
+  }
+  int tableLength = _config.tableLength;
+  int tableWidth = _config.tableWidth;
+  for (int i = 0; i < 6; i++)
+  {
+    vec3 pocket;
+    if ((i % 3) == 0) {
+      pocket.x =  -(tableLength / 2) + 50;
+    } else if ((i % 3) == 1) {
+      pocket.x =  0;
+    } else {
+      pocket.x =  (tableLength / 2) - 50;
+    }
+    pocket.y = (i < 3) ? (tableWidth / 2) - 50 : -(tableWidth / 2) + 50;
+    pocket.z = 0;
+    _pockets.push_back(pocket);
+  }
+}
+
+int Table::advance(float frameDt)
+{
+  float fixedDt = _config.fixedDt;
+  float maxFrameDt = _config.maxStepsPerFrame * fixedDt;
+  _accumulator += std::min(std::max(frameDt, 0.0f), maxFrameDt);
+  int numSteps = 0;
+  while (_accumulator >= fixedDt)
+  {
+    step();
+    _accumulator -= fixedDt;
+    numSteps++;
+  }
+  return numSteps;
+}
+
+float Table::alpha() const
+{
+  return _accumulator / _config.fixedDt;
+}
+
+vec3 Table::renderPos(int i) const
+{
+  return mix(_prevPos[i], _balls.pos(i), alpha());
+}
+
+vec3 Table::renderRot(int i) const
+{
+  return mix(_prevRot[i], _balls.rot(i), alpha());
+}
+
+void Table::step()
+{
+  int n = _config.numBalls;
+  for (int i = 0; i < n; i++)
+  {
+    _prevPos[i] = _balls.pos(i);
+    _prevRot[i] = _balls.rot(i);
+  }
+
+  // a table at rest has nothing to move until a ball is launched or woken
+  if (!_atRest)
+  {
+    int eventsBefore = eventCount();
+    if (_config.solver == SOLVER_EVENT)
+    {
+      // the event solver leaves sinking balls to us
+      float dt = _config.fixedDt;
+      for (int i = 0; i < n; i++)
+      {
+        if (!isSinking(i)) continue;
+        glorbDetection(i);
+        if (isSinking(i)) _balls.setPos(i, _balls.pos(i) + _balls.vel(i) * dt);
+      }
+      if (chaosActive(CHAOS_TILT_A_TABLE)) kernels().tilt(_balls, n, _tiltDir.x);
+      _eventSolver.advance(*this, dt);
+    }
+    else if (_config.solver == SOLVER_FIXED_POINT)
+    {
+      _fixedSolver.step(*this);
+    }
+    else
+    {
+      fixedStep();
+    }
+    updateSleep(eventsBefore);
+  }
+
+  _time += _config.fixedDt;
+  _steps++;
+  chaos();
+  if (_recorder) _recorder->stepped();
+}
+
+float Table::settle(float maxTime)
+{
+  float simulated = 0.0f;
+  // the event solver does not know about tilting, which keeps the balls
+  // rolling anyway
+  if (_config.solver == SOLVER_EVENT && !_recorder && !chaosActive(CHAOS_TILT_A_TABLE))
+  {
+    simulated = _eventSolver.settle(*this, maxTime);
+    _time += simulated;
+    for (int i = 0; i < _config.numBalls; i++)
+    {
+      _prevPos[i] = _balls.pos(i);
+      _prevRot[i] = _balls.rot(i);
+    }
+    return simulated;
+  }
+
+  while (simulated < maxTime && anyMoving())
+  {
+    step();
+    simulated += _config.fixedDt;
+  }
+  return simulated;
+}
+
+bool Table::anyMoving() const
+{
+  float restSpeed = _config.restSpeed;
+  bool fixedPoint = _config.solver == SOLVER_FIXED_POINT;
+  int64_t restSpeedSq = fx::mulWide(fx::fromFloat(restSpeed), fx::fromFloat(restSpeed));
+  for (int i = 0; i < _config.numBalls; i++)
+  {
+    if (!_balls.isFree(i)) continue;
+    if (fixedPoint ? _fixedSolver.speedSq(*this, i) > restSpeedSq : length(_balls.vel(i)) > restSpeed) return true;
+  }
+  return false;
+}
+
+void Table::fixedStep()
+{
+  typedef void (Table::*Step)();
+  static const Step steps[numStepVariants] = {
+    &Table::fixedStepWith<stepVariantSet(0)>, &Table::fixedStepWith<stepVariantSet(1)>,
+    &Table::fixedStepWith<stepVariantSet(2)>, &Table::fixedStepWith<stepVariantSet(3)>,
+    &Table::fixedStepWith<stepVariantSet(4)>, &Table::fixedStepWith<stepVariantSet(5)>,
+    &Table::fixedStepWith<stepVariantSet(6)>, &Table::fixedStepWith<stepVariantSet(7)>
+  };
+  (this->*steps[stepVariant(_chaosActive)])();
+}
+
+template <ChaosSet Active>
+void Table::fixedStepWith()
+{
+  typedef ChaosRules<Active> Rules;
+  int n = _config.numBalls;
+
+  // pockets and glorb first, so that captured balls sit out the rest;
+  // sleeping balls were checked when they came to rest
+  for (int i = 0; i < n; i++)
+  {
+    _balls.flags[i] &= ~BALL_CAPTURED;
+    if (isDevoured(i) || isSleeping(i)) continue;
+    if (isSinking(i)) glorbDetection(i);
+    else pocketDetection(i);
+  }
+
+  _broadphase.update(_balls, _config.sphereRadius);
+  const vector<pair<int, int> >& pairs = _broadphase.pairs();
+  _pairTests = 0;
+  if (_config.solver == SOLVER_SEQUENTIAL_IMPULSE)
+  {
+    _pairTests = _contactSolver.solve(*this, pairs);
+  }
+  else
+  {
+    for (int p = 0; p < (int) pairs.size(); p++)
+    {
+      int i = pairs[p].first;
+      int j = pairs[p].second;
+      if (!_balls.isFree(i)) continue;
+      // two sleeping balls stay exactly where they came to rest
+      if (_balls.flags[i] & _balls.flags[j] & BALL_SLEEPING) continue;
+      collisionDetection(i, j);
+      _pairTests++;
+    }
+  }
+
+  for (int i = 0; i < n; i++)
+  {
+    if (_balls.isAwake(i)) boundaryDetection<Active>(i);
+  }
+
+  if (Rules::stepsBalls)
+  {
+    float tilt = _tiltDir.x;
+    for (int i = 0; i < n; i++)
+    {
+      if (_balls.flags[i] == 0) Rules::step(_balls.velX[i], _balls.velY[i], tilt);
+    }
+  }
+  const KernelSet& k = kernels();
+  k.friction(_balls, n, Rules::friction());
+
+  // if not hovering, not enlarged or shrunk, and not floating up to glorb, null z-component
+  float ballDefaultSize = _config.ballDefaultSize;
+  for (int i = 0; i < n; i++)
+  {
+    if (_balls.isFree(i) && _balls.posZ[i] < 40 && _balls.size[i] == ballDefaultSize) {
+      _balls.posZ[i] = 0;
+      _balls.velZ[i] = 0;
+    }
+  }
+
+  k.integrate(_balls, n, _config.fixedDt, 1.0f / _config.sphereRadius);
+}
+
+bool Table::collisionDetection(int i, int j)
+{
+  float sphereRadius = _config.sphereRadius;
+  // if not floating up to glorb or devoured
+  if (_balls.flags[j] & (BALL_SINKING | BALL_DEVOURED)) return false;
+
+  float dx = _balls.posX[i] - _balls.posX[j];
+  float dy = _balls.posY[i] - _balls.posY[j];
+  float dz = _balls.posZ[i] - _balls.posZ[j];
+  float overlap = sphereRadius * (_balls.size[i] + _balls.size[j]) - sqrt(dx * dx + dy * dy + dz * dz);
+  if (overlap <= 1) return false;
+
+  wake(i);
+  wake(j);
+  // normal between the balls as if both rested on the table
+  vec3 normal = normalize(vec3(dx, dy, dz - sphereRadius * (_balls.size[i] - _balls.size[j])));
+  vec3 push = normal * overlap / 2.0f;
+  _balls.setPos(i, _balls.pos(i) + push);
+  _balls.setPos(j, _balls.pos(j) - push);
+  vec3 vel1 = _balls.vel(i);
+  vec3 vel2 = _balls.vel(j);
+  vec3 ball1NormalVel = dot(vel1, normal) * normal;
+  vec3 ball2NormalVel = dot(vel2, normal) * normal;
+  _balls.setVel(i, vel1 + ball2NormalVel - ball1NormalVel);
+  _balls.setVel(j, vel2 + ball1NormalVel - ball2NormalVel);
+  recordCollision(i, j);
+  return true;
+}
+
+void Table::wake(int i)
+{
+  if (!isSleeping(i)) return;
+  _balls.flags[i] &= ~BALL_SLEEPING;
+  _slowSteps[i] = 0;
+  _atRest = false;
+}
+
+void Table::wakeAll()
+{
+  for (int i = 0; i < _config.numBalls; i++)
+  {
+    wake(i);
+  }
+  _atRest = false;
+}
+
+void Table::updateSleep(int eventsBefore)
+{
+  int n = _config.numBalls;
+  float restSpeedSq = _config.restSpeed * _config.restSpeed;
+  bool fixedPoint = _config.solver == SOLVER_FIXED_POINT;
+  int64_t fixedRestSpeedSq = fx::mulWide(fx::fromFloat(_config.restSpeed), fx::fromFloat(_config.restSpeed));
+  int sleepSteps = (int) ceil(_config.sleepTime / _config.fixedDt);
+  // tilted balls pick up speed every step, so none may sleep
+  bool canSleep = _config.sleepTime >= 0 && !chaosActive(CHAOS_TILT_A_TABLE);
+  bool allAsleep = true;
+  for (int i = 0; i < n; i++)
+  {
+    if (isDevoured(i)) continue;
+    float speedSq = _balls.velX[i] * _balls.velX[i] + _balls.velY[i] * _balls.velY[i] + _balls.velZ[i] * _balls.velZ[i];
+    // a float sum of squares may be fused differently by another compiler
+    bool slow = fixedPoint ? _fixedSolver.speedSq(*this, i) < fixedRestSpeedSq : speedSq < restSpeedSq;
+    if (isSleeping(i))
+    {
+      // the event solver moves balls it hits without knowing about sleep
+      if (speedSq > 0) wake(i);
+    }
+    else if (_balls.isAwake(i) && canSleep && slow && _balls.posZ[i] < 40)
+    {
+      if (++_slowSteps[i] >= sleepSteps)
+      {
+        _balls.setVel(i, vec3(0));
+        _balls.flags[i] |= BALL_SLEEPING;
+      }
+    }
+    else
+    {
+      _slowSteps[i] = 0;
+    }
+    allAsleep = allAsleep && isSleeping(i);
+  }
+  // events from this step have yet to be seen, so rest starts next step
+  _atRest = allAsleep && eventCount() == eventsBefore;
+}
+
+int Table::eventCount() const
+{
+  return _events.collisions + _events.boundaryHits + _events.pocketed + _events.devoured;
+}
+
+void Table::recordCollision(int i, int j)
+{
+  _events.collisions += 1;
+  if (_events.firstHit == -1)
+  {
+    if (i == _launchedBall) _events.firstHit = j;
+    else if (j == _launchedBall) _events.firstHit = i;
+  }
+}
+
+template <ChaosSet Active>
+void Table::boundaryDetection(int i)
+{
+  if (_config.geometry)
+  {
+    cushionDetection<Active>(i);
+    return;
+  }
+  float ballRadius = _config.sphereRadius * _balls.size[i];
+  float& posX = _balls.posX[i];
+  float& posY = _balls.posY[i];
+  float& velX = _balls.velX[i];
+  float& velY = _balls.velY[i];
+  float xThresh = (_config.tableLength - 75) / 2.0f;
+  float ballLeft = posX - ballRadius;
+  float ballRight = posX + ballRadius;
+  if (ballLeft < -xThresh || ballRight > xThresh)
+  {
+    if (ballLeft < -xThresh) posX += -xThresh - ballLeft;
+    else if (ballRight > xThresh) posX -= ballRight - xThresh;
+    velX = -velX;
+    ChaosRules<Active>::onBoundary(velX, velY);
+    _events.boundaryHits += 1;
+  }
+  float yThresh = (_config.tableWidth - 75) / 2.0f;
+  float ballBottom = posY - ballRadius;
+  float ballTop = posY + ballRadius;
+  if (posY < -yThresh || posY > yThresh)
+  {
+    if (ballBottom < -yThresh) posY += -yThresh - ballBottom;
+    else if (ballTop > yThresh) posY -= ballTop - yThresh;
+    velY = -velY;
+    ChaosRules<Active>::onBoundary(velX, velY);
+    _events.boundaryHits += 1;
+  }
+}
+
+template <ChaosSet Active>
+void Table::cushionDetection(int i)
+{
+  const TableGeometry& geometry = *_config.geometry;
+  const SegmentArrays& cushions = geometry.cushions;
+  float ballRadius = _config.sphereRadius * _balls.size[i];
+  vec2 pos(_balls.posX[i], _balls.posY[i]);
+  vec2 vel(_balls.velX[i], _balls.velY[i]);
+
+  // a ball fast enough to go through a cushion in one step is put back on
+  // the cloth as if it had hit the rectangle the old cushions made
+  vec2 play = geometry.playExtent - ballRadius;
+  for (int axis = 0; axis < 2; axis++)
+  {
+    if (std::abs(pos[axis]) <= geometry.railExtent[axis]) continue;
+    pos[axis] = pos[axis] < 0 ? -play[axis] : play[axis];
+    vel[axis] = -vel[axis];
+    ChaosRules<Active>::onBoundary(vel.x, vel.y);
+    _events.boundaryHits += 1;
+  }
+
+  // in a jaw the ball can touch two edges at once, so resolve the nearest
+  // and look again; there is nothing to hit well inside the cushions
+  bool nearCushion = std::abs(pos.x) >= play.x || std::abs(pos.y) >= play.y;
+  const KernelSet& k = kernels();
+  for (int pass = 0; nearCushion && pass < 2; pass++)
+  {
+    float distSq;
+    int s = k.nearestSegment(cushions, pos.x, pos.y, distSq);
+    if (s < 0 || distSq >= ballRadius * ballRadius) break;
+    vec2 closest = cushions.closestPoint(s, pos);
+    vec2 outside = normalize(vec2(cushions.dy[s], -cushions.dx[s]));
+    vec2 away = pos - closest;
+    // a ball whose centre went past the edge is pushed back out the way it
+    // came in, not through the rubber
+    vec2 normal = (distSq > 0 && dot(away, outside) > 0) ? away / sqrt(distSq) : outside;
+    pos = closest + normal * ballRadius;
+    float approach = dot(vel, normal);
+    if (approach < 0) vel -= 2.0f * approach * normal;
+    ChaosRules<Active>::onBoundary(vel.x, vel.y);
+    _events.boundaryHits += 1;
+  }
+
+  _balls.posX[i] = pos.x;
+  _balls.posY[i] = pos.y;
+  _balls.velX[i] = vel.x;
+  _balls.velY[i] = vel.y;
+}
+
+// every step variant, so that poolsim-bench can time the cushions alone
+template void Table::boundaryDetection<stepVariantSet(0)>(int);
+template void Table::boundaryDetection<stepVariantSet(1)>(int);
+template void Table::boundaryDetection<stepVariantSet(2)>(int);
+template void Table::boundaryDetection<stepVariantSet(3)>(int);
+template void Table::boundaryDetection<stepVariantSet(4)>(int);
+template void Table::boundaryDetection<stepVariantSet(5)>(int);
+template void Table::boundaryDetection<stepVariantSet(6)>(int);
+template void Table::boundaryDetection<stepVariantSet(7)>(int);
+
+bool Table::inPocketMouth(int i, int p, float dist) const
+{
+  const PocketShape& pocket = _config.geometry->pockets[p];
+  float ballRadius = _config.sphereRadius * _balls.size[i];
+  // hovering balls pass over the pockets
+  if (_balls.posZ[i] >= 40 || dist >= pocket.reach + ballRadius) return false;
+  vec2 pos(_balls.posX[i], _balls.posY[i]);
+  if (distance(_config.geometry->mouths.closestPoint(p, pos), pos) < ballRadius) return true;
+
+  // the throat runs from the middle of the mouth to the hole
+  vec2 mouth = (pocket.jawA + pocket.jawB) * 0.5f;
+  vec2 throat = pocket.center - mouth;
+  float t = clamp(dot(pos - mouth, throat) / dot(throat, throat), 0.0f, 1.0f);
+  return distance(mouth + t * throat, pos) < ballRadius;
+}
+
+bool Table::pocketDetection(int i)
+{
+  vec3 pos = _balls.pos(i);
+  bool traced = _config.geometry != nullptr;
+  for (int p = 0; p < (int) _pockets.size(); p++)
+  {
+    float dist = length(_pockets[p] - pos);
+    if (dist < _config.viewVolumeSide / 150)
+    {
+      sink(i);
+      return true;
+    }
+    else if (traced ? inPocketMouth(i, p, dist) : dist < _config.viewVolumeSide / 50)
+    {
+      _balls.setVel(i, 10.0f * (_pockets[p] - pos));
+      _balls.flags[i] |= BALL_CAPTURED;
+      return true;
+    }
+  }
+  return false;
+}
+
+void Table::sink(int i)
+{
+  _events.pocketed += 1;
+  _events.lastPocketedId = _balls.id[i];
+  _balls.setVel(i, 0.5f * (_glorbPos - _balls.pos(i)));
+  _balls.size[i] *= 2;
+  _balls.flags[i] |= BALL_SINKING;
+}
+
+void Table::glorbDetection(int i)
+{
+  float glorbRadius = _config.glorbScale * _eyeDiameterModifier * 0.5;
+  if (length(_glorbPos - _balls.pos(i)) <= glorbRadius) {
+    _balls.setPos(i, vec3(0, 1000, 200));
+    _balls.setVel(i, vec3(0));
+    _balls.size[i] = 0;
+    _balls.flags[i] = BALL_DEVOURED;
+    _eyeDiameterModifier += 0.02;
+    _numBallsSunk += 1;
+    _events.devoured += 1;
+  }
+}
+
+void Table::setVel(int i, const vec3& vel)
+{
+  if (_recorder) _recorder->setVel(i, vel);
+  _balls.setVel(i, vel);
+  if (vel != vec3(0)) wake(i);
+}
+
+void Table::launch(int i, const vec3& vel)
+{
+  if (_recorder) _recorder->launch(i, vel);
+  _launchedBall = i;
+  wake(i);
+  vec3 launched = vel;
+  for (int e = 0; e < NUM_CHAOS_EFFECTS; e++)
+  {
+    if (_chaosActive & chaosBit((ChaosEffect) e)) launched = chaosRegistry[e].onLaunch(launched);
+  }
+  _balls.setVel(i, launched);
+}
+
+void Table::stopAll()
+{
+  if (_recorder) _recorder->stopAll();
+  for (int i = 0; i < _config.numBalls; i++)
+  {
+    _balls.setVel(i, vec3(0));
+  }
+}
+
+bool Table::chaosActive(const string& effect) const
+{
+  ChaosEffect e = chaosEffectId(effect);
+  return e != NUM_CHAOS_EFFECTS && chaosActive(e);
+}
+
+void Table::chaos()
+{
+  if (chaosActive(CHAOS_HOVER_HAVOC))
+  {
+    for (int i = 0; i < _config.numBalls; i++)
+    {
+      // if floating but not going up to glorb
+      if (_balls.isFree(i) && _balls.posZ[i] >= 40)
+      {
+        _balls.posZ[i] = hoverHeight();
+      }
+    }
+  }
+
+  if (!_chaosEnabled) return;
+  _chaosTimer += _config.fixedDt;
+  if (_chaosTimer < _config.chaosPeriod) return;
+  _chaosTimer -= _config.chaosPeriod;
+
+  int effect = _rng() % NUM_CHAOS_EFFECTS;
+  while (effect == _chaosEffect) {
+    effect = _rng() % NUM_CHAOS_EFFECTS;
+  }
+  applyChaosEffect((ChaosEffect) effect);
+}
+
+void Table::setChaosEnabled(bool enabled)
+{
+  // the game sets this every frame, so only changes are recorded
+  if (_recorder && enabled != _chaosEnabled) _recorder->chaosEnabled(enabled);
+  _chaosEnabled = enabled;
+}
+
+void Table::setChaosEffect(ChaosEffect effect)
+{
+  if (effect < 0 || effect >= NUM_CHAOS_EFFECTS) return;
+  if (_recorder) _recorder->chaosEffect(effect);
+  applyChaosEffect(effect);
+}
+
+void Table::setChaosEffect(const string& effect)
+{
+  setChaosEffect(chaosEffectId(effect));
+}
+
+void Table::applyChaosEffect(ChaosEffect effect)
+{
+  // the old effects end before the new one starts, so that a ball Biggie
+  // Smalls grows after Hover Havoc is not put back on the cloth
+  for (int e = 0; e < NUM_CHAOS_EFFECTS; e++)
+  {
+    ChaosSet bit = chaosBit((ChaosEffect) e);
+    if (e == effect || !(_chaosActive & bit)) continue;
+    _chaosActive &= ~bit;
+    chaosRegistry[e].onDeactivate(*this);
+  }
+  if (!(_chaosActive & chaosBit(effect)))
+  {
+    _chaosActive |= chaosBit(effect);
+    _chaosEffect = effect;
+    chaosRegistry[effect].onActivate(*this);
+  }
+  // balls change size, lift off or start to roll
+  wakeAll();
+  _events.chaosChanged = true;
+}
+
+void Table::gravityChaos()
+{
+  _rng.generate(_ballDraws.data(), _config.numBalls);
+  for (int i = 0; i < _config.numBalls; i++)
+  {
+    // if not floating up to glorb
+    if (_ballDraws[i] % 4 == 0 && _balls.isFree(i))
+    {
+      _balls.posZ[i] = hoverHeight();
+    }
+  }
+}
+
+float Table::hoverHeight() const
+{
+  // the library sine differs between machines
+  if (_config.solver == SOLVER_FIXED_POINT) return fx::toFloat(fx::fromInt(50) + 10 * fx::sin(fx::fromFloat(_time)));
+  return 50.0f + 10 * sin(_time);
+}
+
+void Table::resetGravity()
+{
+  for (int i = 0; i < _config.numBalls; i++)
+  {
+    // sinking and devoured balls are glorb's now
+    if (!_balls.isFree(i)) continue;
+    _balls.posZ[i] = 0;
+  }
+}
+
+void Table::sizeChaos()
+{
+  float sphereRadius = _config.sphereRadius;
+  // whether each ball changes and whether it grows or shrinks
+  _rng.generate(_ballDraws.data(), 2 * _config.numBalls);
+  for (int i = 0; i < _config.numBalls; i++)
+  {
+    if (_ballDraws[2 * i] % 4 == 0)
+    {
+      // if not floating up to glorb
+      if (_balls.isFree(i)) {
+        float prevSize = _balls.size[i];
+        (_ballDraws[2 * i + 1] % 2)? _balls.size[i] *= 3 : _balls.size[i] /= 2;
+        _balls.posZ[i] += sphereRadius * (_balls.size[i] - prevSize);
+      }
+    }
+  }
+}
+
+void Table::resetSize()
+{
+  float sphereRadius = _config.sphereRadius;
+  for (int i = 0; i < _config.numBalls; i++)
+  {
+    // sinking and devoured balls are glorb's now
+    if (!_balls.isFree(i)) continue;
+    float prevSize = _balls.size[i];
+    _balls.size[i] = _config.ballDefaultSize;
+    _balls.posZ[i] += sphereRadius * (_balls.size[i] - prevSize);
+  }
+}
+
+void Table::setGlorbPos(const vec3& pos)
+{
+  if (_recorder && pos != _glorbPos) _recorder->glorbPos(pos);
+  _glorbPos = pos;
+}
+
+void Table::setEyeDiameterModifier(float m)
+{
+  if (_recorder && m != _eyeDiameterModifier) _recorder->eyeDiameter(m);
+  _eyeDiameterModifier = m;
+}
+
+uint64_t Table::stateHash() const
+{
+  return _balls.hash(_config.numBalls);
+}
+
+static const char snapshotMagic[4] = {'P', 'S', 'S', 'N'};
+static const uint32_t snapshotVersion = 2;
+
+int Table::stateArrays(StateArray* arrays) const
+{
+  int n = _config.numBalls;
+  BallArrays& balls = const_cast<BallArrays&>(_balls);
+  vector<float>* floats[] = {&balls.posX, &balls.posY, &balls.posZ, &balls.velX, &balls.velY, &balls.velZ,
+    &balls.rotX, &balls.rotY, &balls.rotZ, &balls.size};
+  int a = 0;
+  arrays[a++] = {balls.id.data(), n * sizeof(int)};
+  for (vector<float>* values : floats)
+  {
+    arrays[a++] = {values->data(), n * sizeof(float)};
+  }
+  arrays[a++] = {balls.flags.data(), n * sizeof(uint32_t)};
+  arrays[a++] = {(void*) _prevPos.data(), n * sizeof(vec3)};
+  arrays[a++] = {(void*) _prevRot.data(), n * sizeof(vec3)};
+  arrays[a++] = {(void*) _slowSteps.data(), n * sizeof(int)};
+  if (_config.solver == SOLVER_FIXED_POINT)
+  {
+    // the floats are rounded from these, so they alone cannot restore them
+    void* data[FixedPointSolver::numArrays];
+    size_t bytes[FixedPointSolver::numArrays];
+    int count = _fixedSolver.arrays(data, bytes);
+    for (int f = 0; f < count; f++)
+    {
+      arrays[a++] = {data[f], bytes[f]};
+    }
+  }
+  else if (_config.solver == SOLVER_SEQUENTIAL_IMPULSE)
+  {
+    // the warm start, without which a restored table steps differently
+    void* data[ContactSolver::numArrays];
+    size_t bytes[ContactSolver::numArrays];
+    int count = _contactSolver.arrays(data, bytes);
+    for (int c = 0; c < count; c++)
+    {
+      arrays[a++] = {data[c], bytes[c]};
+    }
+  }
+  return a;
+}
+
+size_t Table::snapshotSize() const
+{
+  StateArray arrays[numStateArrays];
+  int count = stateArrays(arrays);
+  size_t size = sizeof(SnapshotHeader) + sizeof(_rng);
+  for (int a = 0; a < count; a++)
+  {
+    size += arrays[a].bytes;
+  }
+  return size;
+}
+
+size_t Table::snapshot(void* buffer, size_t size) const
+{
+  size_t needed = snapshotSize();
+  if (size < needed) return 0;
+
+  SnapshotHeader header = {};
+  memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+  header.version = snapshotVersion;
+  header.size = (uint32_t) needed;
+  header.numBalls = _config.numBalls;
+  header.rngSize = sizeof(_rng);
+  header.seed = _config.seed;
+  header.numBallsSunk = _numBallsSunk;
+  header.launchedBall = _launchedBall;
+  header.atRest = _atRest;
+  header.chaosEnabled = _chaosEnabled;
+  header.chaosEffect = (uint8_t) _chaosEffect;
+  header.chaosActive = _chaosActive;
+  header.chaosTimer = _chaosTimer;
+  memcpy(header.tiltDir, &_tiltDir[0], sizeof(header.tiltDir));
+  memcpy(header.glorbPos, &_glorbPos[0], sizeof(header.glorbPos));
+  header.eyeDiameterModifier = _eyeDiameterModifier;
+  header.time = _time;
+  header.accumulator = _accumulator;
+  header.steps = _steps;
+  header.collisions = _events.collisions;
+  header.boundaryHits = _events.boundaryHits;
+  header.pocketed = _events.pocketed;
+  header.lastPocketedId = _events.lastPocketedId;
+  header.devoured = _events.devoured;
+  header.chaosChanged = _events.chaosChanged;
+  header.firstHit = _events.firstHit;
+
+  char* p = (char*) buffer;
+  memcpy(p, &header, sizeof(header));
+  p += sizeof(header);
+  memcpy(p, &_rng, sizeof(_rng));
+  p += sizeof(_rng);
+  StateArray arrays[numStateArrays];
+  int count = stateArrays(arrays);
+  for (int a = 0; a < count; a++)
+  {
+    memcpy(p, arrays[a].data, arrays[a].bytes);
+    p += arrays[a].bytes;
+  }
+  return needed;
+}
+
+bool Table::restore(const void* buffer, size_t size)
+{
+  SnapshotHeader header;
+  if (size < sizeof(header)) return false;
+  memcpy(&header, buffer, sizeof(header));
+  if (memcmp(header.magic, snapshotMagic, sizeof(header.magic)) != 0 || header.version != snapshotVersion
+    || header.rngSize != sizeof(_rng) || header.numBalls != (uint32_t) _config.numBalls
+    || header.size != snapshotSize() || size < header.size || header.chaosEffect >= NUM_CHAOS_EFFECTS
+    || header.chaosActive >= (1u << NUM_CHAOS_EFFECTS))
+  {
+    return false;
+  }
+
+  const char* p = (const char*) buffer + sizeof(header);
+  memcpy((void*) &_rng, p, sizeof(_rng));
+  p += sizeof(_rng);
+  StateArray arrays[numStateArrays];
+  int count = stateArrays(arrays);
+  for (int a = 0; a < count; a++)
+  {
+    memcpy(arrays[a].data, p, arrays[a].bytes);
+    p += arrays[a].bytes;
+  }
+
+  _config.seed = header.seed;
+  _numBallsSunk = header.numBallsSunk;
+  _launchedBall = header.launchedBall;
+  _atRest = header.atRest != 0;
+  _chaosEnabled = header.chaosEnabled != 0;
+  _chaosEffect = (ChaosEffect) header.chaosEffect;
+  _chaosActive = header.chaosActive;
+  _chaosTimer = header.chaosTimer;
+  _tiltDir = glm::make_vec3(header.tiltDir);
+  _glorbPos = glm::make_vec3(header.glorbPos);
+  _eyeDiameterModifier = header.eyeDiameterModifier;
+  _time = header.time;
+  _accumulator = header.accumulator;
+  _steps = (long) header.steps;
+  _events.collisions = header.collisions;
+  _events.boundaryHits = header.boundaryHits;
+  _events.pocketed = header.pocketed;
+  _events.lastPocketedId = header.lastPocketedId;
+  _events.devoured = header.devoured;
+  _events.chaosChanged = header.chaosChanged != 0;
+  _events.firstHit = header.firstHit;
+
+  // the grid is rebuilt from the positions on the next step, and pairs()
+  // does not depend on the order balls entered it
+  _broadphase.configure(_config.tableLength, _config.tableWidth,
+    2 * _config.sphereRadius * _config.ballDefaultSize, _config.numBalls);
+  _pairTests = 0;
+  return true;
+}
+
+}  // namespace poolsim
@@ -0,0 +1,507 @@
+/**
+ * @file table.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Headless pool table simulation: balls, pockets, bounds and chaos
+ */
+
+#ifndef POOLSIM_TABLE_H_
+#define POOLSIM_TABLE_H_
+
+#include "poolsim/balls.h"
+#include "poolsim/broadphase.h"
+#include "poolsim/chaos.h"
+#include "poolsim/contactsolver.h"
+#include "poolsim/eventsolver.h"
+#include "poolsim/fixedsolver.h"
+#include "poolsim/random.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace poolsim {
+
+struct TableGeometry;
+class InputRecorder;
+
+enum SolverMode
+{
+  // moves every ball by vel * dt each step and then looks for overlaps
+  SOLVER_FIXED_STEP,
+  // follows each ball's exact path from one impact to the next, see EventSolver
+  SOLVER_EVENT,
+  // the fixed-step rules in integers, which give the same bits on every
+  // machine, see FixedPointSolver
+  SOLVER_FIXED_POINT,
+  // the fixed-step rules with the touching balls resolved together, which
+  // keeps packed groups still, see ContactSolver
+  SOLVER_SEQUENTIAL_IMPULSE
+};
+
+/**
+ * Dimensions and tuning of a table. The defaults match the table the game
+ * builds from models/pool-table.ply in a 500 unit view volume.
+ */
+struct TableConfig
+{
+  int numBalls = 16;
+  int viewVolumeSide = 500;
+  int tableLength = 500;
+  int tableWidth = 318;
+  float sphereRadius = 0.5f;
+  float ballDefaultSize = 500 / 20;
+  // scale applied to the eye mesh, used to size Glorb's mouth
+  float glorbScale = 123.27f;
+  // simulation runs at this fixed step regardless of frame rate
+  float fixedDt = 1.0f / 60.0f;
+  // frames slower than this many steps are dropped rather than caught up
+  int maxStepsPerFrame = 8;
+  // seconds between random chaos effect changes
+  float chaosPeriod = 5.0f;
+  SolverMode solver = SOLVER_FIXED_STEP;
+  // seeds every random choice the chaos effects make
+  uint32_t seed = 0;
+  // balls slower than this are treated as stopped by settle() and the event solver
+  float restSpeed = 0.5f;
+  // seconds a ball must stay slower than restSpeed before it falls asleep,
+  // negative to keep every ball awake
+  float sleepTime = 0.25f;
+  // cushions and pockets traced from the table mesh, see loadTableGeometry;
+  // without it the cushions are a rectangle and the pockets are circles
+  std::shared_ptr<const TableGeometry> geometry;
+};
+
+/**
+ * Things that happened since the events were last cleared, so that the
+ * caller can play sounds and show messages without the simulation knowing
+ * about either.
+ */
+struct TableEvents
+{
+  int collisions = 0;
+  int boundaryHits = 0;
+  int pocketed = 0;
+  int lastPocketedId = -1;
+  int devoured = 0;
+  bool chaosChanged = false;
+  // first ball the last launched ball struck, -1 if it struck none
+  int firstHit = -1;
+
+  // whether nothing was counted and the chaos did not change
+  bool none() const
+  {
+    return collisions == 0 && boundaryHits == 0 && pocketed == 0 && devoured == 0 && !chaosChanged;
+  }
+};
+
+class Table
+{
+public:
+    // names of the chaos effects, in ChaosEffect order
+    static const std::string plainJane;
+    static const std::string stickySituation;
+    static const std::string hoverHavoc;
+    static const std::string biggieSmalls;
+    static const std::string frictionAffliction;
+    static const std::string tiltATable;
+    static const std::string getGaslit;
+
+    Table(const TableConfig& config = TableConfig());
+
+    /**
+    * Racks the balls, places the pockets and clears all chaos effects.
+    */
+    void reset();
+
+    /**
+    * Resets the table with a new seed.
+    */
+    void reset(uint32_t seed);
+
+    /**
+    * Advances the simulation by a frame of variable length, running as many
+    * fixed steps as fit and keeping the remainder for the next frame.
+    *
+    * @param frameDt The frame time in seconds.
+    * @return The number of fixed steps that were run.
+    */
+    int advance(float frameDt);
+
+    /**
+    * Runs a single fixed step of the simulation.
+    */
+    void step();
+
+    /**
+    * Runs the simulation until every ball on the table has stopped, without
+    * changing chaos effect. The event solver gets there in one jump; the
+    * fixed-step solver steps until no ball is faster than restSpeed, as does
+    * the event solver while the table is tilted or an InputRecorder is
+    * attached, since a recording counts steps.
+    *
+    * @param maxTime The most time to simulate in seconds.
+    * @return The time simulated in seconds.
+    */
+    float settle(float maxTime = 60.0f);
+
+    /**
+    * Fraction of a fixed step left over in the accumulator, in [0, 1).
+    */
+    float alpha() const;
+
+    /**
+    * Ball position interpolated between the last two steps for drawing.
+    */
+    glm::vec3 renderPos(int i) const;
+
+    /**
+    * Ball rotation interpolated between the last two steps for drawing.
+    */
+    glm::vec3 renderRot(int i) const;
+
+    /**
+    * Launches a ball, applying any chaos effect that alters the launch.
+    *
+    * @param i The index of the ball.
+    * @param vel The launch velocity.
+    */
+    void launch(int i, const glm::vec3& vel);
+
+    /**
+    * Stops all balls in place.
+    */
+    void stopAll();
+
+    /**
+    * Activates the given chaos effect and deactivates all others.
+    */
+    void setChaosEffect(ChaosEffect effect);
+
+    /**
+    * Same as setChaosEffect(ChaosEffect), by name.
+    *
+    * @param effect The name of the effect, one of chaosEffects(); other
+    * names are ignored.
+    */
+    void setChaosEffect(const std::string& effect);
+
+    /**
+    * Enables or disables the periodic random change of chaos effect.
+    */
+    void setChaosEnabled(bool enabled);
+    bool chaosEnabled() const { return _chaosEnabled; }
+
+    /**
+    * The latest effect to be activated, which is Plain Jane after a reset.
+    */
+    ChaosEffect chaosEffectId() const { return _chaosEffect; }
+    const std::string& chaosEffect() const { return chaosEffects()[_chaosEffect]; }
+    bool chaosActive(ChaosEffect effect) const { return (_chaosActive & chaosBit(effect)) != 0; }
+    bool chaosActive(const std::string& effect) const;
+    ChaosSet activeChaos() const { return _chaosActive; }
+    const glm::vec3& tiltDir() const { return _tiltDir; }
+
+    /**
+    * Names of the chaos effects, indexed by ChaosEffect.
+    */
+    static const std::vector<std::string>& chaosEffects();
+
+    /**
+    * The effect with the given name, NUM_CHAOS_EFFECTS if there is none.
+    */
+    static ChaosEffect chaosEffectId(const std::string& effect);
+
+    /**
+    * Returns true if the ball is at rest and will stay put until a ball hits
+    * it, it is launched or a status effect changes.
+    */
+    bool isSleeping(int i) const { return (_balls.flags[i] & BALL_SLEEPING) != 0; }
+
+    /**
+    * Returns true once every ball is asleep or devoured and a whole step has
+    * passed without events. Until a ball is launched or woken, steps only
+    * advance the time and the status effects, so the caller can skip its
+    * own per-frame physics and sound work too.
+    */
+    bool atRest() const { return _atRest; }
+
+    /**
+    * Returns true if the ball was pocketed and is floating up to Glorb.
+    */
+    bool isSinking(int i) const { return (_balls.flags[i] & BALL_SINKING) != 0; }
+
+    /**
+    * Returns true if the ball was eaten by Glorb.
+    */
+    bool isDevoured(int i) const { return (_balls.flags[i] & BALL_DEVOURED) != 0; }
+
+    const TableConfig& config() const { return _config; }
+    int numBalls() const { return _config.numBalls; }
+    BallArrays& balls() { return _balls; }
+    const BallArrays& balls() const { return _balls; }
+    glm::vec3 pos(int i) const { return _balls.pos(i); }
+    glm::vec3 vel(int i) const { return _balls.vel(i); }
+    float size(int i) const { return _balls.size[i]; }
+    void setVel(int i, const glm::vec3& vel);
+    const std::vector<glm::vec3>& pockets() const { return _pockets; }
+
+    int numBallsSunk() const { return _numBallsSunk; }
+    bool allSunk() const { return _numBallsSunk == _config.numBalls; }
+
+    const glm::vec3& glorbPos() const { return _glorbPos; }
+    void setGlorbPos(const glm::vec3& pos);
+    float eyeDiameterModifier() const { return _eyeDiameterModifier; }
+    void setEyeDiameterModifier(float m);
+
+    /**
+    * Simulated time in seconds, advanced only by fixed steps.
+    */
+    float time() const { return _time; }
+    long steps() const { return _steps; }
+
+    /**
+    * Number of ball pairs the broadphase handed to collisionDetection in the
+    * last step.
+    */
+    int pairTests() const { return _pairTests; }
+
+    /**
+    * Hash of the ball state, see BallArrays::hash, for checking that two
+    * runs ended in exactly the same state.
+    */
+    uint64_t stateHash() const;
+
+    const TableEvents& events() const { return _events; }
+    void clearEvents() { _events = TableEvents(); }
+
+    /**
+    * Sends every call that changes the table from outside, and every step,
+    * to the recorder, see InputRecorder::start. Copies of the table share
+    * the recorder, so clear it on a copy that plays on its own.
+    */
+    void setRecorder(InputRecorder* recorder) { _recorder = recorder; }
+    InputRecorder* recorder() const { return _recorder; }
+
+    /**
+    * Lets the sequential-impulse solver spread its islands over the pool,
+    * which must outlive the table. Copies of the table share the pool, so
+    * clear it on a copy that is stepped from inside one of its threads.
+    */
+    void setThreadPool(ThreadPool* pool) { _contactSolver.setThreadPool(pool); }
+    const ContactSolver& contactSolver() const { return _contactSolver; }
+
+    /**
+    * Bytes snapshot() needs, which depend on the number of balls and on
+    * the state the active solver keeps between steps.
+    */
+    size_t snapshotSize() const;
+
+    /**
+    * Copies everything about the table that changes as it plays, which is
+    * all but the config, into a flat buffer without allocating, for
+    * rollback, undo, playing ahead and the keyframes of a recording. The
+    * snapshot is plain bytes that can be copied, or written to a file and
+    * mapped back in, but only a build with the same layout can restore it,
+    * see SnapshotHeader.
+    *
+    * @param buffer Where to write, at any alignment.
+    * @param size The size of the buffer.
+    * @return The bytes written, or 0 if the buffer is smaller than
+    * snapshotSize().
+    */
+    size_t snapshot(void* buffer, size_t size) const;
+
+    /**
+    * Puts the table back as it was when a table with the same config took
+    * the snapshot, without allocating.
+    *
+    * @param buffer The snapshot, at any alignment.
+    * @param size The size of the buffer.
+    * @return False, leaving the table as it was, if the snapshot is
+    * truncated, from another build or for another number of balls.
+    */
+    bool restore(const void* buffer, size_t size);
+
+protected:
+    friend class EventSolver;
+    friend class FixedPointSolver;
+    friend class ContactSolver;
+    template <ChaosEffect> friend struct ChaosHooks;
+
+    void createPoolBalls();
+    void createPockets();
+
+    /**
+    * Detects if two balls have collided and separates them if so.
+    *
+    * @param i The index of the first ball.
+    * @param j The index of the second ball.
+    * @return True if there is a collision, false otherwise.
+    */
+    bool collisionDetection(int i, int j);
+
+    /**
+    * Counts a collision between two balls in the events.
+    */
+    void recordCollision(int i, int j);
+
+    /**
+    * Detects if a ball has hit the boundary of the pool table and changes its
+    * velocity accordingly.
+    *
+    * @param i The index of the ball to check for a collision.
+    */
+    template <ChaosSet Active>
+    void boundaryDetection(int i);
+
+    /**
+    * Pushes a ball out of the traced cushions and reflects its velocity off
+    * the edge it hit, for tables with TableConfig::geometry.
+    *
+    * @param i The index of the ball to check for a collision.
+    */
+    template <ChaosSet Active>
+    void cushionDetection(int i);
+
+    /**
+    * Returns true if a ball touches the mouth of a traced pocket or the
+    * throat behind it, through which it is pulled into the hole.
+    *
+    * @param i The index of the ball.
+    * @param p The index of the pocket.
+    * @param dist The distance from the ball to the pocket.
+    */
+    bool inPocketMouth(int i, int p, float dist) const;
+
+    /**
+    * Detects if a ball is sufficiently close to a pocket and pulls it in,
+    * flagging it as captured or sinking.
+    *
+    * @param i The index of the ball to check.
+    * @return True if the ball is sunk or being pulled in, false otherwise.
+    */
+    bool pocketDetection(int i);
+
+    /**
+    * Detects if a sinking ball has reached Glorb and devours it.
+    *
+    * @param i The index of the sinking ball.
+    */
+    void glorbDetection(int i);
+
+    /**
+    * Sends a pocketed ball floating up to Glorb.
+    */
+    void sink(int i);
+
+    /**
+    * Moves the balls by one fixed step and resolves the overlaps that result.
+    */
+    void fixedStep();
+
+    /**
+    * fixedStep for the given active effects, see ChaosRules.
+    */
+    template <ChaosSet Active>
+    void fixedStepWith();
+
+    /**
+    * Wakes a sleeping ball.
+    */
+    void wake(int i);
+    void wakeAll();
+
+    /**
+    * Puts balls that have been slow for long enough to sleep, wakes the
+    * ones that something set moving, and works out whether the table is at
+    * rest.
+    *
+    * @param eventsBefore The number of events before the step.
+    */
+    void updateSleep(int eventsBefore);
+
+    int eventCount() const;
+
+    bool anyMoving() const;
+
+    struct StateArray
+    {
+      void* data;
+      size_t bytes;
+    };
+    static const int numStateArrays = 15 + (FixedPointSolver::numArrays > ContactSolver::numArrays
+      ? FixedPointSolver::numArrays : ContactSolver::numArrays);
+
+    /**
+    * Lists the per-ball arrays a snapshot holds, in the order it holds them.
+    *
+    * @return The number of arrays, which is larger for the fixed-point
+    * and sequential-impulse solvers.
+    */
+    int stateArrays(StateArray* arrays) const;
+
+    /**
+    * Height of a hovering ball at the current time.
+    */
+    float hoverHeight() const;
+
+    /**
+    * Updates hovering balls and picks a new random effect when it is time.
+    */
+    void chaos();
+
+    /**
+    * Switches effect without recording it, for the picks chaos() makes
+    * itself, which a replay makes again.
+    */
+    void applyChaosEffect(ChaosEffect effect);
+
+    void gravityChaos();
+    void resetGravity();
+    void sizeChaos();
+    void resetSize();
+
+protected:
+    TableConfig _config;
+
+    BallArrays _balls;
+    Broadphase _broadphase;
+    int _pairTests = 0;
+    EventSolver _eventSolver;
+    FixedPointSolver _fixedSolver;
+    ContactSolver _contactSolver;
+    std::vector<glm::vec3> _prevPos;
+    std::vector<glm::vec3> _prevRot;
+    // steps each ball has been slower than restSpeed
+    std::vector<int> _slowSteps;
+    bool _atRest = false;
+    std::vector<glm::vec3> _pockets;
+    int _numBallsSunk = 0;
+
+    glm::vec3 _glorbPos = glm::vec3(0, 0, 200);
+    float _eyeDiameterModifier = 0.25;
+
+    ChaosSet _chaosActive = 0;
+    ChaosEffect _chaosEffect = CHAOS_PLAIN_JANE;
+    bool _chaosEnabled = false;
+    float _chaosTimer = 0.0f;
+    glm::vec3 _tiltDir = glm::vec3(0);
+    Pcg32 _rng;
+    // draws for the balls, filled in one batch by the effects that roll
+    // for every ball
+    std::vector<uint32_t> _ballDraws;
+    int _launchedBall = -1;
+
+    float _time = 0.0f;
+    long _steps = 0;
+    float _accumulator = 0.0f;
+
+    TableEvents _events;
+    InputRecorder* _recorder = nullptr;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_TABLE_H_
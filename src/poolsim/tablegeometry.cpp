@@ -0,0 +1,562 @@
+/**
+ * @file tablegeometry.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Traces cushions and pockets from the table mesh, with a file cache
+ */
+
+#include "poolsim/tablegeometry.h"
+#include "poolsim/bvh.h"
+#include <sys/stat.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+using namespace std;
+using namespace glm;
+
+namespace poolsim {
+
+// bumped whenever tracing changes, so that stale caches are ignored
+static const uint32_t cacheVersion = 1;
+static const char cacheMagic[8] = {'P', 'S', 'G', 'E', 'O', 'M', '\n', '\0'};
+
+/**
+ * Reads the positions and faces of an ASCII PLY file, splitting polygons
+ * into triangle fans.
+ */
+static bool readPly(const string& path, vector<vec3>& vertices, vector<uint32_t>& indices)
+{
+  ifstream file(path);
+  if (!file) return false;
+  string line;
+  getline(file, line);
+  if (line.compare(0, 3, "ply") != 0) return false;
+
+  int numVertices = 0;
+  int numFaces = 0;
+  int numProperties = 0;
+  int xyz[3] = {-1, -1, -1};
+  bool inVertex = false;
+  while (getline(file, line))
+  {
+    istringstream words(line);
+    string word;
+    words >> word;
+    if (word == "format")
+    {
+      words >> word;
+      if (word != "ascii") return false;
+    }
+    else if (word == "element")
+    {
+      string name;
+      int count = 0;
+      words >> name >> count;
+      inVertex = name == "vertex";
+      if (inVertex) numVertices = count;
+      else if (name == "face") numFaces = count;
+    }
+    else if (word == "property" && inVertex)
+    {
+      string type, name;
+      words >> type >> name;
+      if (name == "x") xyz[0] = numProperties;
+      else if (name == "y") xyz[1] = numProperties;
+      else if (name == "z") xyz[2] = numProperties;
+      numProperties++;
+    }
+    else if (word == "end_header")
+    {
+      break;
+    }
+  }
+  if (xyz[0] < 0 || xyz[1] < 0 || xyz[2] < 0) return false;
+
+  vertices.resize(numVertices);
+  vector<float> values(numProperties);
+  for (int v = 0; v < numVertices; v++)
+  {
+    for (int p = 0; p < numProperties; p++) file >> values[p];
+    vertices[v] = vec3(values[xyz[0]], values[xyz[1]], values[xyz[2]]);
+  }
+  indices.clear();
+  for (int f = 0; f < numFaces; f++)
+  {
+    int count = 0;
+    file >> count;
+    uint32_t first = 0, previous = 0;
+    for (int k = 0; k < count; k++)
+    {
+      uint32_t index = 0;
+      file >> index;
+      if (index >= (uint32_t) numVertices) return false;
+      if (k == 0) first = index;
+      else if (k >= 2)
+      {
+        indices.push_back(first);
+        indices.push_back(previous);
+        indices.push_back(index);
+      }
+      previous = index;
+    }
+  }
+  return (bool) file;
+}
+
+/**
+ * Scales, rotates and centers the mesh as Game::scaleVector,
+ * Game::centerVector and Game::drawPoolTable do.
+ */
+static void placeMesh(vector<vec3>& vertices, int viewVolumeSide, float meshZ)
+{
+  vec3 minBounds(numeric_limits<float>::max());
+  vec3 maxBounds(-numeric_limits<float>::max());
+  for (const vec3& v : vertices)
+  {
+    minBounds = glm::min(minBounds, v);
+    maxBounds = glm::max(maxBounds, v);
+  }
+  vec3 window = abs(minBounds) + maxBounds;
+  float scale = viewVolumeSide / std::max(std::max(window.x, window.y), window.z);
+  vec3 center = -(minBounds + maxBounds) / 2.0f;
+  for (vec3& v : vertices)
+  {
+    vec3 p = (v + center) * scale;
+    // a quarter turn about z, as the game rotates the mesh
+    v = vec3(-p.y, p.x, p.z + meshZ);
+  }
+}
+
+/**
+ * Closed outlines and open chains made by joining the pieces of a cut end
+ * to end.
+ */
+struct Outlines
+{
+  std::vector<vec2> points;
+  // each outline's points, in order; a closed one does not repeat its first
+  std::vector<std::vector<int> > outlines;
+  std::vector<bool> closed;
+};
+
+/**
+ * Drops the points of a closed outline that lie on a straight line between
+ * their neighbours, as where a cut crosses a flat face made of several
+ * triangles.
+ */
+static void dropStraightPoints(const vector<vec2>& points, vector<int>& outline)
+{
+  bool dropped = true;
+  while (dropped && outline.size() > 3)
+  {
+    dropped = false;
+    int n = (int) outline.size();
+    for (int p = 0; p < n; p++)
+    {
+      vec2 a = points[outline[(p + n - 1) % n]];
+      vec2 b = points[outline[p]];
+      vec2 c = points[outline[(p + 1) % n]];
+      vec2 ab = b - a;
+      vec2 bc = c - b;
+      float cross = ab.x * bc.y - ab.y * bc.x;
+      if (std::abs(cross) < 1e-3f * length(ab) * length(bc) && dot(ab, bc) > 0)
+      {
+        outline.erase(outline.begin() + p);
+        dropped = true;
+        break;
+      }
+    }
+  }
+}
+
+static void joinPieces(const vector<vec2>& pieces, Outlines& out)
+{
+  // pieces from neighbouring triangles meet at points that differ by
+  // rounding, so weld points closer than this
+  const float weld = 1e-3f;
+  vector<int> pieceEnds(pieces.size());
+  for (int k = 0; k < (int) pieces.size(); k++)
+  {
+    int found = -1;
+    for (int p = 0; p < (int) out.points.size() && found < 0; p++)
+    {
+      if (distance(out.points[p], pieces[k]) < weld) found = p;
+    }
+    if (found < 0)
+    {
+      found = (int) out.points.size();
+      out.points.push_back(pieces[k]);
+    }
+    pieceEnds[k] = found;
+  }
+
+  int numPoints = (int) out.points.size();
+  vector<vector<int> > touching(numPoints);
+  int numPieces = (int) pieces.size() / 2;
+  for (int s = 0; s < numPieces; s++)
+  {
+    if (pieceEnds[2 * s] == pieceEnds[2 * s + 1]) continue;
+    touching[pieceEnds[2 * s]].push_back(s);
+    touching[pieceEnds[2 * s + 1]].push_back(s);
+  }
+
+  vector<bool> used(numPieces, false);
+  for (int s = 0; s < numPieces; s++)
+  {
+    if (used[s] || pieceEnds[2 * s] == pieceEnds[2 * s + 1]) continue;
+    used[s] = true;
+    vector<int> outline = {pieceEnds[2 * s], pieceEnds[2 * s + 1]};
+    bool closed = false;
+    while (true)
+    {
+      int at = outline.back();
+      int next = -1;
+      for (int t : touching[at])
+      {
+        if (!used[t]) { next = t; break; }
+      }
+      if (next < 0) break;
+      used[next] = true;
+      int other = pieceEnds[2 * next] == at ? pieceEnds[2 * next + 1] : pieceEnds[2 * next];
+      if (other == outline.front())
+      {
+        closed = true;
+        break;
+      }
+      outline.push_back(other);
+    }
+    closed = closed && outline.size() >= 3;
+    if (closed) dropStraightPoints(out.points, outline);
+    out.outlines.push_back(outline);
+    out.closed.push_back(closed);
+  }
+}
+
+static bool segmentsCross(const vec2& a, const vec2& b, const vec2& c, const vec2& d)
+{
+  vec2 r = b - a;
+  vec2 s = d - c;
+  float denom = r.x * s.y - r.y * s.x;
+  if (denom == 0) return false;
+  vec2 ac = c - a;
+  float t = (ac.x * s.y - ac.y * s.x) / denom;
+  float u = (ac.x * r.y - ac.y * r.x) / denom;
+  return t > 0 && t < 1 && u > 0 && u < 1;
+}
+
+static vec2 centroid(const Outlines& o, int k)
+{
+  vec2 sum(0);
+  for (int p : o.outlines[k]) sum += o.points[p];
+  return sum / (float) o.outlines[k].size();
+}
+
+/**
+ * Least-squares circle through the points (Kasa's method), solving
+ * x^2 + y^2 = a x + b y + c.
+ */
+static bool fitCircle(const vector<vec2>& points, vec2& center, float& radius)
+{
+  if (points.size() < 5) return false;
+  // work relative to the mean to keep the sums well conditioned
+  vec2 mean(0);
+  for (const vec2& p : points) mean += p;
+  mean /= (float) points.size();
+  double sxx = 0, sxy = 0, syy = 0, sx = 0, sy = 0, n = 0, sxz = 0, syz = 0, sz = 0;
+  for (const vec2& q : points)
+  {
+    double x = q.x - mean.x, y = q.y - mean.y, z = x * x + y * y;
+    sxx += x * x; sxy += x * y; syy += y * y;
+    sx += x; sy += y; n += 1;
+    sxz += x * z; syz += y * z; sz += z;
+  }
+  dmat3 m(sxx, sxy, sx, sxy, syy, sy, sx, sy, n);
+  if (std::abs(determinant(m)) < 1e-9) return false;
+  dvec3 abc = inverse(m) * dvec3(sxz, syz, sz);
+  dvec2 c(abc.x / 2, abc.y / 2);
+  double r2 = abc.z + c.x * c.x + c.y * c.y;
+  if (r2 <= 0) return false;
+  center = mean + vec2(c);
+  radius = (float) sqrt(r2);
+  return true;
+}
+
+shared_ptr<const TableGeometry> traceTableGeometry(const string& plyPath, int viewVolumeSide, const TraceOptions& options)
+{
+  vector<vec3> vertices;
+  vector<uint32_t> indices;
+  if (!readPly(plyPath, vertices, indices)) return nullptr;
+  placeMesh(vertices, viewVolumeSide, options.meshZ);
+
+  shared_ptr<TableGeometry> geometry = make_shared<TableGeometry>();
+  TriangleBVH bvh;
+  bvh.build(vertices, indices);
+  vector<vec2> pieces;
+  geometry->meshTriangles = bvh.numTriangles();
+  geometry->trianglesTested = bvh.slice(options.sliceZ, pieces);
+
+  Outlines o;
+  joinPieces(pieces, o);
+  int numOutlines = (int) o.outlines.size();
+
+  // the cushions are the closed outlines with nothing between them and the
+  // middle of the table; the rails behind them are hidden by them
+  vector<int> cushions;
+  for (int k = 0; k < numOutlines; k++)
+  {
+    if (!o.closed[k]) continue;
+    vec2 c = centroid(o, k);
+    bool hidden = false;
+    for (int other = 0; other < numOutlines && !hidden; other++)
+    {
+      if (other == k || !o.closed[other]) continue;
+      const vector<int>& ring = o.outlines[other];
+      for (int p = 0; p < (int) ring.size() && !hidden; p++)
+      {
+        vec2 a = o.points[ring[p]];
+        vec2 b = o.points[ring[(p + 1) % ring.size()]];
+        hidden = segmentsCross(vec2(0), c, a, b);
+      }
+    }
+    if (!hidden) cushions.push_back(k);
+  }
+  if (cushions.empty()) return nullptr;
+
+  // wind the cushions counter-clockwise, so that the right of each edge is
+  // outside the rubber
+  for (int k : cushions)
+  {
+    vector<int>& ring = o.outlines[k];
+    float area = 0;
+    for (int p = 0; p < (int) ring.size(); p++)
+    {
+      vec2 a = o.points[ring[p]];
+      vec2 b = o.points[ring[(p + 1) % ring.size()]];
+      area += a.x * b.y - b.x * a.y;
+    }
+    if (area < 0) reverse(ring.begin(), ring.end());
+  }
+
+  // every edge collides; the nose of each cushion is its longest edge on
+  // the side facing the middle, and the ends of the nose are the jaws
+  vector<vec2> jaws;
+  vector<int> jawCushion;
+  vec2 playExtent(numeric_limits<float>::max());
+  for (int k : cushions)
+  {
+    const vector<int>& ring = o.outlines[k];
+    float centerDistance = length(centroid(o, k));
+    int nose = 0;
+    float noseLength = 0;
+    for (int p = 0; p < (int) ring.size(); p++)
+    {
+      vec2 a = o.points[ring[p]];
+      vec2 b = o.points[ring[(p + 1) % ring.size()]];
+      geometry->cushions.add(a, b);
+      geometry->railExtent = glm::max(geometry->railExtent, abs(a));
+      if (length((a + b) * 0.5f) < centerDistance && distance(a, b) > noseLength)
+      {
+        noseLength = distance(a, b);
+        nose = p;
+      }
+    }
+    vec2 a = o.points[ring[nose]];
+    vec2 b = o.points[ring[(nose + 1) % ring.size()]];
+    // the end cushions bound the cloth in x and the others in y, so that
+    // no edge reaches into the box
+    int axis = std::abs(b.x - a.x) < std::abs(b.y - a.y) ? 0 : 1;
+    for (int p : ring)
+    {
+      playExtent[axis] = std::min(playExtent[axis], std::abs(o.points[p][axis]));
+    }
+    jaws.push_back(a);
+    jaws.push_back(b);
+    jawCushion.push_back(k);
+    jawCushion.push_back(k);
+  }
+
+  geometry->playExtent = playExtent;
+
+  // points on the open chains, which outline the pocket holes
+  vector<vec2> rim;
+  for (int k = 0; k < numOutlines; k++)
+  {
+    if (o.closed[k]) continue;
+    for (int p : o.outlines[k]) rim.push_back(o.points[p]);
+  }
+
+  // a pocket mouth joins two jaws of different cushions that are each
+  // other's nearest
+  int numJaws = (int) jaws.size();
+  vector<int> nearest(numJaws, -1);
+  for (int a = 0; a < numJaws; a++)
+  {
+    float best = numeric_limits<float>::max();
+    for (int b = 0; b < numJaws; b++)
+    {
+      if (jawCushion[b] == jawCushion[a]) continue;
+      float d = distance(jaws[a], jaws[b]);
+      if (d < best)
+      {
+        best = d;
+        nearest[a] = b;
+      }
+    }
+  }
+  vector<vec2> rimNear;
+  for (int a = 0; a < numJaws; a++)
+  {
+    int b = nearest[a];
+    if (b < a || nearest[b] != a) continue;
+    PocketShape pocket;
+    pocket.jawA = jaws[a];
+    pocket.jawB = jaws[b];
+    vec2 mouth = (pocket.jawA + pocket.jawB) * 0.5f;
+    float width = distance(pocket.jawA, pocket.jawB);
+    vec2 along = (pocket.jawB - pocket.jawA) / width;
+    vec2 outward(along.y, -along.x);
+    if (dot(outward, mouth) < 0) outward = -outward;
+
+    rimNear.clear();
+    for (const vec2& p : rim)
+    {
+      if (dot(p - mouth, outward) > 0 && distance(p, mouth) < 3 * width) rimNear.push_back(p);
+    }
+    if (!fitCircle(rimNear, pocket.center, pocket.radius) || dot(pocket.center - mouth, outward) <= 0)
+    {
+      pocket.center = mouth + outward * (width / 2);
+      pocket.radius = width / 2;
+    }
+    pocket.reach = std::max(distance(pocket.center, pocket.jawA), distance(pocket.center, pocket.jawB));
+    geometry->pockets.push_back(pocket);
+  }
+
+  // the top row from left to right, then the bottom row, as createPockets
+  sort(geometry->pockets.begin(), geometry->pockets.end(), [](const PocketShape& a, const PocketShape& b) {
+    if ((a.center.y < 0) != (b.center.y < 0)) return a.center.y >= 0;
+    return a.center.x < b.center.x;
+  });
+  for (const PocketShape& pocket : geometry->pockets)
+  {
+    geometry->mouths.add(pocket.jawA, pocket.jawB);
+  }
+  return geometry;
+}
+
+static void writeSegments(FILE* file, const SegmentArrays& segments)
+{
+  int32_t count = segments.count;
+  fwrite(&count, sizeof(count), 1, file);
+  for (int s = 0; s < count; s++)
+  {
+    vec2 ends[2] = {segments.start(s), segments.end(s)};
+    fwrite(ends, sizeof(ends), 1, file);
+  }
+}
+
+static bool readSegments(FILE* file, SegmentArrays& segments)
+{
+  int32_t count = 0;
+  if (fread(&count, sizeof(count), 1, file) != 1 || count < 0 || count > (1 << 20)) return false;
+  for (int s = 0; s < count; s++)
+  {
+    vec2 ends[2];
+    if (fread(ends, sizeof(ends), 1, file) != 1) return false;
+    segments.add(ends[0], ends[1]);
+  }
+  return true;
+}
+
+// identifies the mesh file and settings a cache was written for
+struct CacheKey
+{
+  char magic[8];
+  uint32_t version;
+  int32_t viewVolumeSide;
+  float meshZ, sliceZ;
+  int64_t fileSize, fileTime;
+};
+
+shared_ptr<const TableGeometry> loadTableGeometry(const string& plyPath, int viewVolumeSide,
+  const string& cachePath, const TraceOptions& options)
+{
+  string path = cachePath.empty() ? plyPath + ".geometry" : cachePath;
+  struct stat info;
+  if (stat(plyPath.c_str(), &info) != 0) return nullptr;
+  CacheKey key;
+  memset(&key, 0, sizeof(key));
+  memcpy(key.magic, cacheMagic, sizeof(key.magic));
+  key.version = cacheVersion;
+  key.viewVolumeSide = viewVolumeSide;
+  key.meshZ = options.meshZ;
+  key.sliceZ = options.sliceZ;
+  key.fileSize = info.st_size;
+  key.fileTime = info.st_mtime;
+
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file != NULL)
+  {
+    CacheKey stored;
+    shared_ptr<TableGeometry> geometry = make_shared<TableGeometry>();
+    bool ok = fread(&stored, sizeof(stored), 1, file) == 1 && memcmp(&stored, &key, sizeof(key)) == 0;
+    int32_t numPockets = 0;
+    ok = ok && fread(&numPockets, sizeof(numPockets), 1, file) == 1 && numPockets >= 0 && numPockets < 64;
+    for (int p = 0; ok && p < numPockets; p++)
+    {
+      PocketShape pocket;
+      float values[8];
+      ok = fread(values, sizeof(values), 1, file) == 1;
+      pocket.jawA = vec2(values[0], values[1]);
+      pocket.jawB = vec2(values[2], values[3]);
+      pocket.center = vec2(values[4], values[5]);
+      pocket.radius = values[6];
+      pocket.reach = values[7];
+      geometry->pockets.push_back(pocket);
+    }
+    ok = ok && readSegments(file, geometry->cushions) && readSegments(file, geometry->mouths);
+    float extents[4];
+    ok = ok && fread(extents, sizeof(extents), 1, file) == 1;
+    geometry->playExtent = vec2(extents[0], extents[1]);
+    geometry->railExtent = vec2(extents[2], extents[3]);
+    ok = ok && fread(&geometry->meshTriangles, sizeof(int32_t), 1, file) == 1;
+    fclose(file);
+    if (ok)
+    {
+      geometry->fromCache = true;
+      return geometry;
+    }
+  }
+
+  shared_ptr<const TableGeometry> geometry = traceTableGeometry(plyPath, viewVolumeSide, options);
+  if (!geometry) return nullptr;
+  // a cache that cannot be written only costs the next start a trace
+  file = fopen(path.c_str(), "wb");
+  if (file != NULL)
+  {
+    fwrite(&key, sizeof(key), 1, file);
+    int32_t numPockets = (int32_t) geometry->pockets.size();
+    fwrite(&numPockets, sizeof(numPockets), 1, file);
+    for (const PocketShape& pocket : geometry->pockets)
+    {
+      float values[8] = {pocket.jawA.x, pocket.jawA.y, pocket.jawB.x, pocket.jawB.y,
+        pocket.center.x, pocket.center.y, pocket.radius, pocket.reach};
+      fwrite(values, sizeof(values), 1, file);
+    }
+    writeSegments(file, geometry->cushions);
+    writeSegments(file, geometry->mouths);
+    float extents[4] = {geometry->playExtent.x, geometry->playExtent.y,
+      geometry->railExtent.x, geometry->railExtent.y};
+    fwrite(extents, sizeof(extents), 1, file);
+    int32_t meshTriangles = geometry->meshTriangles;
+    fwrite(&meshTriangles, sizeof(meshTriangles), 1, file);
+    fclose(file);
+  }
+  return geometry;
+}
+
+}  // namespace poolsim
@@ -0,0 +1,99 @@
+/**
+ * @file tablegeometry.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Cushions and pockets traced from the table mesh
+ */
+
+#ifndef POOLSIM_TABLEGEOMETRY_H_
+#define POOLSIM_TABLEGEOMETRY_H_
+
+#include "poolsim/segments.h"
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace poolsim {
+
+/**
+ * A pocket as the gap between the ends of two cushions and the hole behind
+ * it.
+ */
+struct PocketShape
+{
+  // cushion ends either side of the mouth
+  glm::vec2 jawA, jawB;
+  // circle fitted to the rim of the hole
+  glm::vec2 center;
+  float radius = 0.0f;
+  // distance from the center to the farther jaw, which bounds the mouth
+  float reach = 0.0f;
+};
+
+/**
+ * The outline of the cushions and pockets in table coordinates, where the
+ * balls rest at z = 0 and the table is centered on the origin.
+ */
+struct TableGeometry
+{
+  // every edge of the cushion rubber, jaws included, wound counter-clockwise
+  // around each cushion so that the outside of an edge is to its right
+  SegmentArrays cushions;
+  // the mouth of each pocket, from jawA to jawB, in the order of pockets
+  SegmentArrays mouths;
+  // ordered as Table::createPockets orders its pockets
+  std::vector<PocketShape> pockets;
+  // half the length and width of the largest box centered on the origin
+  // that no cushion edge reaches into
+  glm::vec2 playExtent = glm::vec2(0);
+  // half the length and width out to the back of the farthest cushion
+  glm::vec2 railExtent = glm::vec2(0);
+
+  // how the geometry was made, for reporting
+  int meshTriangles = 0;
+  int trianglesTested = 0;
+  bool fromCache = false;
+};
+
+/**
+ * Where the game draws the table mesh and where to cut it.
+ */
+struct TraceOptions
+{
+  // height the game moves the mesh to, see Game::drawPoolTable
+  float meshZ = -75.0f;
+  // height of the cut, halfway up the rubber of models/pool-table.ply,
+  // which runs from the cloth at z = -15 to the rail tops at z = -2
+  float sliceZ = -8.0f;
+};
+
+/**
+ * Traces the cushions and pockets of an ASCII PLY table mesh. The mesh is
+ * scaled, rotated and centered exactly as the game draws it, then cut with
+ * a plane through the cushions using a TriangleBVH. The pieces of the cut
+ * are joined into outlines; the closed outlines nearest the middle of the
+ * table are the cushions, the gaps between their noses are the pocket
+ * mouths, and a circle fitted to the rim behind each mouth is its hole.
+ *
+ * @param plyPath The table mesh.
+ * @param viewVolumeSide The size the game scales the mesh to fit.
+ * @return Null if the file could not be read or has no cushions.
+ */
+std::shared_ptr<const TableGeometry> traceTableGeometry(const std::string& plyPath,
+  int viewVolumeSide, const TraceOptions& options = TraceOptions());
+
+/**
+ * Same as traceTableGeometry, but reads the result from cachePath when the
+ * cache was written for the same mesh file and settings, and writes it
+ * there otherwise.
+ *
+ * @param cachePath The cache file, plyPath with ".geometry" appended if
+ *   empty.
+ */
+std::shared_ptr<const TableGeometry> loadTableGeometry(const std::string& plyPath,
+  int viewVolumeSide, const std::string& cachePath = "", const TraceOptions& options = TraceOptions());
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_TABLEGEOMETRY_H_
@@ -0,0 +1,353 @@
+/**
+ * @file tableserver.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the table server and its mirrors
+ */
+
+#include "poolsim/tableserver.h"
+#include "poolsim/bytes.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+using namespace std;
+using namespace glm;
+
+namespace poolsim {
+
+typedef chrono::steady_clock Clock;
+
+TableServer::TableServer(const TableConfig& config, int sendInterval)
+  : _table(config), _sendInterval(std::max(sendInterval, 1)), _history(historySize)
+{
+}
+
+bool TableServer::open(uint16_t port, string& error)
+{
+  return _socket.open(port, error);
+}
+
+void TableServer::run(double seconds, const atomic<bool>* stop)
+{
+  double dt = _table.config().fixedDt;
+  Clock::time_point start = Clock::now();
+  for (long k = 0; k * dt < seconds; k++)
+  {
+    if (stop && *stop) break;
+    this_thread::sleep_until(start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(k * dt)));
+    tick();
+  }
+}
+
+void TableServer::tick()
+{
+  Clock::time_point now = Clock::now();
+  if (_stats.ticks > 0)
+  {
+    double interval = chrono::duration<double>(now - _lastTick).count();
+    double jitter = std::abs(interval - _table.config().fixedDt);
+    _stats.jitterSum += jitter;
+    _stats.maxJitter = std::max(_stats.maxJitter, jitter);
+  }
+  _lastTick = now;
+
+  receive();
+  _table.step();
+  _tick++;
+  _stats.ticks++;
+
+  _mirrors.erase(remove_if(_mirrors.begin(), _mirrors.end(), [&](const Mirror& m)
+    {
+      return chrono::duration<double>(now - m.heard).count() > mirrorTimeout;
+    }), _mirrors.end());
+  if (_tick % _sendInterval == 0) send();
+}
+
+TableServer::Mirror* TableServer::mirror(const NetAddress& address)
+{
+  for (Mirror& m : _mirrors)
+  {
+    if (m.address == address) return &m;
+  }
+  return nullptr;
+}
+
+void TableServer::receive()
+{
+  _packet.resize(UdpSocket::maxDatagram);
+  NetAddress from;
+  int size;
+  while ((size = _socket.receive(from, _packet.data(), _packet.size())) >= 0)
+  {
+    ByteReader r(_packet.data(), size);
+    uint8_t type = r.u8();
+    Mirror* m = mirror(from);
+    if (type == NET_HELLO)
+    {
+      if (r.varint() != netProtocolVersion || !r.ok()) continue;
+      if (!m)
+      {
+        _mirrors.push_back(Mirror());
+        m = &_mirrors.back();
+        m->address = from;
+      }
+      // it has nothing to decode against yet
+      m->hasAck = false;
+      m->heard = Clock::now();
+      continue;
+    }
+    // commands only from mirrors that said hello
+    if (!m) continue;
+    m->heard = Clock::now();
+    if (type == NET_ACK)
+    {
+      uint32_t tick = (uint32_t) r.varint();
+      if (r.ok() && (!m->hasAck || tick > m->acked))
+      {
+        m->acked = tick;
+        m->hasAck = true;
+      }
+    }
+    else if (type == NET_LAUNCH)
+    {
+      int i = (int) r.varint();
+      vec3 vel = r.vec3();
+      if (!r.ok() || i < 0 || i >= _table.numBalls() || any(isnan(vel)) || any(isinf(vel))) continue;
+      float speed = length(vel);
+      if (speed > maxLaunchSpeed) vel *= maxLaunchSpeed / speed;
+      _table.launch(i, vel);
+      _stats.launches++;
+    }
+    else if (type == NET_STOP_ALL)
+    {
+      _table.stopAll();
+    }
+    else if (type == NET_RESET)
+    {
+      uint32_t seed = (uint32_t) r.varint();
+      if (r.ok()) _table.reset(seed);
+    }
+    else if (type == NET_BYE)
+    {
+      _mirrors.erase(_mirrors.begin() + (m - _mirrors.data()));
+    }
+  }
+}
+
+const NetSnapshot* TableServer::sent(uint32_t tick) const
+{
+  if (tick % _sendInterval != 0) return nullptr;
+  const NetSnapshot& snapshot = _history[(tick / _sendInterval) % historySize];
+  return snapshot.tick == tick && !snapshot.balls.empty() ? &snapshot : nullptr;
+}
+
+void TableServer::send()
+{
+  NetSnapshot& snapshot = _history[(_tick / _sendInterval) % historySize];
+  captureSnapshot(_table, _tick, snapshot);
+  _stats.snapshots++;
+  if (_mirrors.empty()) return;
+
+  _full.assign(1, NET_SNAPSHOT);
+  encodeSnapshot(snapshot, nullptr, _full);
+  for (const Mirror& m : _mirrors)
+  {
+    const NetSnapshot* baseline = m.hasAck ? sent(m.acked) : nullptr;
+    _packet.assign(1, NET_SNAPSHOT);
+    encodeSnapshot(snapshot, baseline, _packet);
+    if (!_socket.send(m.address, _packet.data(), _packet.size())) continue;
+    _stats.bytesSent += _packet.size();
+    _stats.fullBytes += _full.size();
+  }
+}
+
+bool TableMirror::connect(const string& host, uint16_t port, string& error)
+{
+  disconnect();
+  if (!NetAddress::resolve(host, port, _server))
+  {
+    error = "cannot find " + host;
+    return false;
+  }
+  if (!_socket.open(0, error)) return false;
+  _snapshots.assign(historySize, NetSnapshot());
+  _newest = 0;
+  _received = 0;
+  _undecodable = 0;
+  _bytesReceived = 0;
+  _start = Clock::now();
+  _lastHello = 0;
+  vector<uint8_t> hello;
+  ByteWriter w(hello);
+  w.u8(NET_HELLO);
+  w.varint(netProtocolVersion);
+  sendCommand(hello);
+  return true;
+}
+
+void TableMirror::disconnect()
+{
+  if (!_socket.isOpen()) return;
+  sendCommand(vector<uint8_t>(1, NET_BYE));
+  _socket.close();
+}
+
+double TableMirror::now() const
+{
+  return chrono::duration<double>(Clock::now() - _start).count();
+}
+
+void TableMirror::simulateLoss(float fraction, uint64_t seed)
+{
+  _loss = fraction;
+  _lossRng.seed(seed);
+}
+
+const NetSnapshot* TableMirror::find(uint32_t tick) const
+{
+  for (int k = 0; k < std::min((long) historySize, _received); k++)
+  {
+    if (_snapshots[k].tick == tick) return &_snapshots[k];
+  }
+  return nullptr;
+}
+
+void TableMirror::sendCommand(const vector<uint8_t>& message)
+{
+  _socket.send(_server, message.data(), message.size());
+}
+
+int TableMirror::poll()
+{
+  if (!_socket.isOpen()) return 0;
+  double time = now();
+  if (_received == 0 && time - _lastHello > 0.5)
+  {
+    vector<uint8_t> hello;
+    ByteWriter w(hello);
+    w.u8(NET_HELLO);
+    w.varint(netProtocolVersion);
+    sendCommand(hello);
+    _lastHello = time;
+  }
+
+  int decoded = 0;
+  _packet.resize(UdpSocket::maxDatagram);
+  NetAddress from;
+  int size;
+  while ((size = _socket.receive(from, _packet.data(), _packet.size())) >= 0)
+  {
+    if (from != _server || size < 1 || _packet[0] != NET_SNAPSHOT) continue;
+    if (_loss > 0 && _lossRng() < _loss * (float) Pcg32::max()) continue;
+    _bytesReceived += size;
+    uint32_t tick;
+    uint32_t baselineTick;
+    if (!snapshotTicks(_packet.data() + 1, size - 1, tick, baselineTick)) continue;
+    // late arrivals are of no more use
+    if (_received > 0 && tick <= _snapshots[_newest].tick) continue;
+    const NetSnapshot* baseline = nullptr;
+    if (baselineTick != tick)
+    {
+      baseline = find(baselineTick);
+      if (!baseline)
+      {
+        _undecodable++;
+        continue;
+      }
+    }
+    if (!decodeSnapshot(_packet.data() + 1, size - 1, baseline, _decoded))
+    {
+      _undecodable++;
+      continue;
+    }
+
+    // slowly later, quickly earlier, so that the offset follows the
+    // quickest arrivals rather than the delayed ones
+    double offset = time - tick * (double) _fixedDt;
+    if (_received == 0 || offset < _clockOffset) _clockOffset = offset;
+    else _clockOffset += 0.01 * (offset - _clockOffset);
+
+    _newest = _received == 0 ? 0 : (_newest + 1) % historySize;
+    swap(_snapshots[_newest], _decoded);
+    _received++;
+    decoded++;
+  }
+
+  if (decoded > 0)
+  {
+    vector<uint8_t> ack;
+    ByteWriter w(ack);
+    w.u8(NET_ACK);
+    w.varint(_snapshots[_newest].tick);
+    sendCommand(ack);
+  }
+  return decoded;
+}
+
+void TableMirror::interpolate()
+{
+  if (_received == 0) return;
+  _renderTick = (now() - _clockOffset - _delay) / _fixedDt;
+
+  // the snapshots on either side of the render tick, or the nearest one
+  const NetSnapshot* before = nullptr;
+  const NetSnapshot* after = nullptr;
+  for (int k = 0; k < std::min((long) historySize, _received); k++)
+  {
+    const NetSnapshot& s = _snapshots[k];
+    if (s.tick <= _renderTick && (!before || s.tick > before->tick)) before = &s;
+    if (s.tick > _renderTick && (!after || s.tick < after->tick)) after = &s;
+  }
+  if (!before) before = after;
+  if (!after) after = before;
+  float t = after->tick == before->tick ? 0.0f : (float) ((_renderTick - before->tick) / (after->tick - before->tick));
+
+  int n = (int) after->balls.size();
+  _pos.resize(n);
+  _rot.resize(n);
+  _size.resize(n);
+  _flags.resize(n);
+  bool sameBalls = before->balls.size() == after->balls.size();
+  for (int i = 0; i < n; i++)
+  {
+    const NetBall& b = after->balls[i];
+    const NetBall& a = sameBalls ? before->balls[i] : b;
+    _pos[i] = mix(a.position(), b.position(), t);
+    // the short way round
+    vec3 turn = b.rotation() - a.rotation();
+    turn -= two_pi<float>() * round(turn / two_pi<float>());
+    _rot[i] = a.rotation() + t * turn;
+    _size[i] = mix(a.drawSize(), b.drawSize(), t);
+    _flags[i] = a.flags;
+  }
+  _chaosEffect = before->chaosEffect;
+  _numBallsSunk = before->numBallsSunk;
+}
+
+void TableMirror::launch(int i, const vec3& vel)
+{
+  vector<uint8_t> message;
+  ByteWriter w(message);
+  w.u8(NET_LAUNCH);
+  w.varint(i);
+  w.vec3(vel);
+  sendCommand(message);
+}
+
+void TableMirror::stopAll()
+{
+  sendCommand(vector<uint8_t>(1, NET_STOP_ALL));
+}
+
+void TableMirror::reset(uint32_t seed)
+{
+  vector<uint8_t> message;
+  ByteWriter w(message);
+  w.u8(NET_RESET);
+  w.varint(seed);
+  sendCommand(message);
+}
+
+}  // namespace poolsim
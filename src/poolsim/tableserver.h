@@ -0,0 +1,260 @@
+/**
+ * @file tableserver.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Headless table server and the mirrors that follow it
+ */
+
+#ifndef POOLSIM_TABLESERVER_H_
+#define POOLSIM_TABLESERVER_H_
+
+#include "poolsim/netstate.h"
+#include "poolsim/table.h"
+#include "poolsim/udp.h"
+#include <glm/glm.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace poolsim {
+
+/**
+ * The first byte of every datagram between a server and its mirrors. The
+ * rest of a snapshot is bit-packed, see encodeSnapshot; the rest of the
+ * others is a ByteWriter record.
+ */
+enum NetMessage : uint8_t
+{
+  // mirror to server: protocol version; sent until snapshots arrive
+  NET_HELLO,
+  // mirror to server: the newest snapshot tick received
+  NET_ACK,
+  // mirror to server: ball and velocity, as Table::launch
+  NET_LAUNCH,
+  NET_STOP_ALL,
+  // mirror to server: the seed to rack the table with
+  NET_RESET,
+  NET_BYE,
+  // server to mirror
+  NET_SNAPSHOT,
+  NUM_NET_MESSAGES
+};
+
+static const uint32_t netProtocolVersion = 1;
+static const uint16_t netDefaultPort = 27960;
+
+/**
+ * Totals a server keeps while it runs.
+ */
+struct ServerStats
+{
+  long ticks = 0;
+  long snapshots = 0;
+  // bytes of snapshots sent, and what they would have been without deltas
+  uint64_t bytesSent = 0;
+  uint64_t fullBytes = 0;
+  // how far the time between ticks strayed from the fixed step, in seconds
+  double jitterSum = 0;
+  double maxJitter = 0;
+  long launches = 0;
+};
+
+/**
+ * Plays the one authoritative table, without drawing it, at its fixed step
+ * rate. Mirrors say hello over UDP and are sent a snapshot every few ticks,
+ * delta encoded against the last snapshot each of them acknowledged, so a
+ * table at rest costs a few bytes a tick and a lost datagram costs nothing
+ * but that snapshot. Any mirror can launch a ball, stop the table or rack
+ * it again; the server applies these before its next step. A launch that
+ * is not finite is dropped, so one bad datagram cannot spoil the table for
+ * every mirror.
+ *
+ * The server keeps the snapshots it sent for a while so that it can encode
+ * against any recent one. A mirror whose last acknowledged snapshot has
+ * been dropped, or who is new, gets a full one.
+ */
+class TableServer
+{
+public:
+    /**
+    * @param config The table to play.
+    * @param sendInterval Ticks between snapshots, 2 for 30 a second.
+    */
+    TableServer(const TableConfig& config, int sendInterval = 2);
+
+    /**
+    * Starts listening, on any free port for 0.
+    *
+    * @param error Set to what went wrong when the port cannot be opened.
+    */
+    bool open(uint16_t port, std::string& error);
+    uint16_t port() const { return _socket.port(); }
+
+    /**
+    * Ticks in real time, at the table's fixed step rate, for the given time
+    * or until stop is set.
+    */
+    void run(double seconds, const std::atomic<bool>* stop = nullptr);
+
+    /**
+    * Takes the waiting commands, runs a fixed step and sends a snapshot to
+    * every mirror if one is due. The time between calls counts towards the
+    * jitter.
+    */
+    void tick();
+
+    Table& table() { return _table; }
+    uint32_t tickCount() const { return _tick; }
+    int numMirrors() const { return (int) _mirrors.size(); }
+    const ServerStats& stats() const { return _stats; }
+
+    /**
+    * The snapshot sent at a tick, if it is still kept.
+    */
+    const NetSnapshot* sent(uint32_t tick) const;
+
+    // snapshots kept to encode against
+    static const int historySize = 64;
+    // seconds of silence after which a mirror is dropped
+    static constexpr double mirrorTimeout = 5.0;
+    // launches are slowed to this, the fastest shot the batch, the opponent
+    // and the environments play
+    static constexpr float maxLaunchSpeed = 3000.0f;
+
+private:
+    struct Mirror
+    {
+      NetAddress address;
+      uint32_t acked = 0;
+      bool hasAck = false;
+      std::chrono::steady_clock::time_point heard;
+    };
+
+    void receive();
+    Mirror* mirror(const NetAddress& address);
+    void send();
+
+    Table _table;
+    int _sendInterval;
+    UdpSocket _socket;
+    std::vector<Mirror> _mirrors;
+    std::vector<NetSnapshot> _history;
+    uint32_t _tick = 0;
+    std::chrono::steady_clock::time_point _lastTick;
+    ServerStats _stats;
+    std::vector<uint8_t> _packet;
+    std::vector<uint8_t> _full;
+};
+
+/**
+ * Follows a TableServer: receives its snapshots, acknowledges them and
+ * interpolates between them for drawing, a few snapshots behind the newest
+ * so that there is nearly always a later one to move towards. Commands sent
+ * through it are played on the server and come back with the snapshots.
+ */
+class TableMirror
+{
+public:
+    /**
+    * @param delay Seconds the drawn table runs behind the newest snapshot.
+    * @param fixedDt The server table's fixed step.
+    */
+    TableMirror(double delay = 0.1, float fixedDt = TableConfig().fixedDt) : _delay(delay), _fixedDt(fixedDt) {}
+
+    /**
+    * Opens a socket on any free port and says hello to the server.
+    *
+    * @param error Set to what went wrong when it cannot.
+    */
+    bool connect(const std::string& host, uint16_t port, std::string& error);
+    void disconnect();
+
+    /**
+    * Takes every waiting snapshot, acknowledges the newest and, until the
+    * first arrives, says hello again every half second.
+    *
+    * @return The number of snapshots decoded.
+    */
+    int poll();
+
+    /**
+    * Sets the drawn state to the server's table as of delay seconds before
+    * now, interpolating between the snapshots on either side.
+    */
+    void interpolate();
+
+    void launch(int i, const glm::vec3& vel);
+    void stopAll();
+    void reset(uint32_t seed);
+
+    bool connected() const { return _received > 0; }
+    int numBalls() const { return (int) _pos.size(); }
+    glm::vec3 pos(int i) const { return _pos[i]; }
+    glm::vec3 rot(int i) const { return _rot[i]; }
+    float size(int i) const { return _size[i]; }
+    uint8_t flags(int i) const { return _flags[i]; }
+    int chaosEffect() const { return _chaosEffect; }
+    int numBallsSunk() const { return _numBallsSunk; }
+
+    /**
+    * The server tick the drawn state stands for, with a fraction.
+    */
+    double renderTick() const { return _renderTick; }
+
+    /**
+    * The newest snapshot decoded, for checks.
+    */
+    const NetSnapshot* latest() const { return _received > 0 ? &_snapshots[_newest] : nullptr; }
+
+    long received() const { return _received; }
+    // snapshots that could not be decoded, for want of their baseline
+    long undecodable() const { return _undecodable; }
+    uint64_t bytesReceived() const { return _bytesReceived; }
+
+    /**
+    * Drops the given fraction of incoming snapshots, as a lossy network
+    * would, for testing over loopback.
+    */
+    void simulateLoss(float fraction, uint64_t seed = 1);
+
+    // snapshots kept to interpolate and decode against
+    static const int historySize = 32;
+
+private:
+    const NetSnapshot* find(uint32_t tick) const;
+    double now() const;
+    void sendCommand(const std::vector<uint8_t>& message);
+
+    double _delay;
+    float _fixedDt;
+    UdpSocket _socket;
+    NetAddress _server;
+    // a ring of the snapshots decoded, the newest at _newest
+    std::vector<NetSnapshot> _snapshots;
+    int _newest = 0;
+    NetSnapshot _decoded;
+    std::chrono::steady_clock::time_point _start;
+    double _lastHello = 0;
+    // local time minus server time, smoothed over the arrivals
+    double _clockOffset = 0;
+    double _renderTick = 0;
+    long _received = 0;
+    long _undecodable = 0;
+    uint64_t _bytesReceived = 0;
+    float _loss = 0;
+    Pcg32 _lossRng;
+
+    std::vector<glm::vec3> _pos;
+    std::vector<glm::vec3> _rot;
+    std::vector<float> _size;
+    std::vector<uint8_t> _flags;
+    int _chaosEffect = 0;
+    int _numBallsSunk = 0;
+    std::vector<uint8_t> _packet;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_TABLESERVER_H_
@@ -0,0 +1,130 @@
+/**
+ * @file threadpool.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the work-stealing thread pool
+ */
+
+#include "poolsim/threadpool.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace poolsim {
+
+ThreadPool::ThreadPool(int numThreads) : _ranges(max(1, numThreads > 0 ? numThreads : (int) thread::hardware_concurrency()))
+{
+  _numThreads = (int) _ranges.size();
+  for (int t = 1; t < _numThreads; t++)
+  {
+    _threads.push_back(thread(&ThreadPool::workerLoop, this, t));
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    lock_guard<mutex> lock(_mutex);
+    _stop = true;
+  }
+  _wake.notify_all();
+  for (thread& t : _threads)
+  {
+    t.join();
+  }
+}
+
+void ThreadPool::parallelFor(int count, const function<void(int, int)>& body)
+{
+  if (count <= 0) return;
+  if (_numThreads == 1)
+  {
+    for (int i = 0; i < count; i++) body(i, 0);
+    return;
+  }
+
+  for (int t = 0; t < _numThreads; t++)
+  {
+    lock_guard<mutex> lock(_ranges[t].mutex);
+    _ranges[t].begin = (int) ((long) count * t / _numThreads);
+    _ranges[t].end = (int) ((long) count * (t + 1) / _numThreads);
+  }
+  {
+    lock_guard<mutex> lock(_mutex);
+    _body = &body;
+    _busy = _numThreads - 1;
+    _generation++;
+  }
+  _wake.notify_all();
+
+  work(0);
+
+  unique_lock<mutex> lock(_mutex);
+  _done.wait(lock, [this] { return _busy == 0; });
+  _body = nullptr;
+}
+
+void ThreadPool::workerLoop(int thread)
+{
+  long seen = 0;
+  while (true)
+  {
+    {
+      unique_lock<mutex> lock(_mutex);
+      _wake.wait(lock, [&] { return _stop || _generation != seen; });
+      if (_stop) return;
+      seen = _generation;
+    }
+    work(thread);
+    {
+      lock_guard<mutex> lock(_mutex);
+      _busy--;
+    }
+    _done.notify_one();
+  }
+}
+
+void ThreadPool::work(int thread)
+{
+  int index;
+  while (take(thread, index) || steal(thread, index))
+  {
+    (*_body)(index, thread);
+  }
+}
+
+bool ThreadPool::take(int thread, int& index)
+{
+  Range& own = _ranges[thread];
+  lock_guard<mutex> lock(own.mutex);
+  if (own.begin >= own.end) return false;
+  index = own.begin++;
+  return true;
+}
+
+bool ThreadPool::steal(int thread, int& index)
+{
+  for (int k = 1; k < _numThreads; k++)
+  {
+    Range& victim = _ranges[(thread + k) % _numThreads];
+    int begin, end;
+    {
+      lock_guard<mutex> lock(victim.mutex);
+      int left = victim.end - victim.begin;
+      if (left <= 0) continue;
+      end = victim.end;
+      begin = end - (left + 1) / 2;
+      victim.end = begin;
+    }
+    // only this thread ever adds to its own range, and it is empty
+    Range& own = _ranges[thread];
+    lock_guard<mutex> lock(own.mutex);
+    own.begin = begin + 1;
+    own.end = end;
+    index = begin;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace poolsim
@@ -0,0 +1,80 @@
+/**
+ * @file threadpool.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Fixed set of worker threads that share loops by work stealing
+ */
+
+#ifndef POOLSIM_THREADPOOL_H_
+#define POOLSIM_THREADPOOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace poolsim {
+
+/**
+ * Runs the iterations of a loop on a fixed set of threads. Each thread is
+ * handed an equal, contiguous share of the iterations up front and works
+ * through it from the front. A thread that runs out steals the back half of
+ * whatever another thread has left, so a few slow iterations do not hold
+ * the whole loop up. Handing out work allocates nothing.
+ */
+class ThreadPool
+{
+public:
+    /**
+    * Starts the worker threads.
+    *
+    * @param numThreads The number of threads that run iterations, counting
+    *   the thread that calls parallelFor. Zero picks one per hardware thread.
+    */
+    explicit ThreadPool(int numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int numThreads() const { return _numThreads; }
+
+    /**
+    * Calls body(index, thread) for every index in [0, count) and returns once
+    * all calls have finished. The thread number is in [0, numThreads()) and
+    * no two calls with the same thread number run at once, so it can index
+    * per-thread state. The calling thread is thread 0.
+    */
+    void parallelFor(int count, const std::function<void(int index, int thread)>& body);
+
+private:
+    // the iterations a thread has yet to run
+    struct Range
+    {
+        std::mutex mutex;
+        int begin = 0;
+        int end = 0;
+    };
+
+    void workerLoop(int thread);
+    void work(int thread);
+    bool take(int thread, int& index);
+    bool steal(int thread, int& index);
+
+    int _numThreads;
+    std::vector<std::thread> _threads;
+    std::vector<Range> _ranges;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    const std::function<void(int, int)>* _body = nullptr;
+    long _generation = 0;
+    int _busy = 0;
+    bool _stop = false;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_THREADPOOL_H_
@@ -0,0 +1,151 @@
+/**
+ * @file udp.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the UDP socket on BSD sockets and Winsock
+ */
+
+#include "poolsim/udp.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+
+namespace poolsim {
+
+/**
+ * Starts Winsock once for the process; nothing to do elsewhere.
+ */
+static bool startSockets()
+{
+#ifdef _WIN32
+  static bool started = false;
+  if (!started)
+  {
+    WSADATA data;
+    started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+  }
+  return started;
+#else
+  return true;
+#endif
+}
+
+static sockaddr_in toSockaddr(const NetAddress& address)
+{
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(address.ip);
+  addr.sin_port = htons(address.port);
+  return addr;
+}
+
+bool NetAddress::resolve(const std::string& host, uint16_t port, NetAddress& out)
+{
+  if (!startSockets()) return false;
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  addrinfo* result = nullptr;
+  if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result) return false;
+  out.ip = ntohl(((const sockaddr_in*) result->ai_addr)->sin_addr.s_addr);
+  out.port = port;
+  freeaddrinfo(result);
+  return true;
+}
+
+std::string NetAddress::str() const
+{
+  return std::to_string(ip >> 24) + "." + std::to_string((ip >> 16) & 0xff) + "." +
+    std::to_string((ip >> 8) & 0xff) + "." + std::to_string(ip & 0xff) + ":" + std::to_string(port);
+}
+
+bool UdpSocket::open(uint16_t port, std::string& error)
+{
+  close();
+  if (!startSockets())
+  {
+    error = "cannot start Winsock";
+    return false;
+  }
+  _socket = (Handle) socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (_socket == invalidSocket)
+  {
+    error = "cannot create a socket";
+    return false;
+  }
+  NetAddress any;
+  any.port = port;
+  sockaddr_in addr = toSockaddr(any);
+  if (bind(_socket, (const sockaddr*) &addr, sizeof(addr)) != 0)
+  {
+    error = "cannot bind to port " + std::to_string(port);
+    close();
+    return false;
+  }
+#ifdef _WIN32
+  u_long nonBlocking = 1;
+  bool ok = ioctlsocket(_socket, FIONBIO, &nonBlocking) == 0;
+#else
+  bool ok = fcntl(_socket, F_SETFL, fcntl(_socket, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+  if (!ok)
+  {
+    error = "cannot make the socket non-blocking";
+    close();
+    return false;
+  }
+  return true;
+}
+
+void UdpSocket::close()
+{
+  if (_socket == invalidSocket) return;
+#ifdef _WIN32
+  closesocket(_socket);
+#else
+  ::close(_socket);
+#endif
+  _socket = invalidSocket;
+}
+
+uint16_t UdpSocket::port() const
+{
+  sockaddr_in addr;
+  socklen_t length = sizeof(addr);
+  if (getsockname(_socket, (sockaddr*) &addr, &length) != 0) return 0;
+  return ntohs(addr.sin_port);
+}
+
+bool UdpSocket::send(const NetAddress& to, const void* data, size_t size)
+{
+  if (_socket == invalidSocket) return false;
+  sockaddr_in addr = toSockaddr(to);
+  return sendto(_socket, (const char*) data, (int) size, 0, (const sockaddr*) &addr, sizeof(addr)) == (int) size;
+}
+
+int UdpSocket::receive(NetAddress& from, void* buffer, size_t size)
+{
+  if (_socket == invalidSocket) return -1;
+  sockaddr_in addr;
+  socklen_t length = sizeof(addr);
+  int received = (int) recvfrom(_socket, (char*) buffer, (int) size, 0, (sockaddr*) &addr, &length);
+  if (received < 0) return -1;
+  from.ip = ntohl(addr.sin_addr.s_addr);
+  from.port = ntohs(addr.sin_port);
+  return received;
+}
+
+}  // namespace poolsim
@@ -0,0 +1,90 @@
+/**
+ * @file udp.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Non-blocking UDP socket for the table server and its mirrors
+ */
+
+#ifndef POOLSIM_UDP_H_
+#define POOLSIM_UDP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace poolsim {
+
+/**
+ * An IPv4 address and port, in host byte order.
+ */
+struct NetAddress
+{
+  uint32_t ip = 0;
+  uint16_t port = 0;
+
+  bool operator==(const NetAddress& other) const { return ip == other.ip && port == other.port; }
+  bool operator!=(const NetAddress& other) const { return !(*this == other); }
+
+  /**
+  * Looks up a host name or dotted address.
+  *
+  * @return False if the host is unknown.
+  */
+  static bool resolve(const std::string& host, uint16_t port, NetAddress& out);
+
+  std::string str() const;
+};
+
+/**
+ * A UDP socket that never blocks, with BSD sockets or Winsock underneath.
+ * Datagrams arrive whole or not at all, which is what snapshots want: a
+ * lost one is simply superseded by the next.
+ */
+class UdpSocket
+{
+public:
+    UdpSocket() {}
+    ~UdpSocket() { close(); }
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    /**
+    * Binds to a port on every interface, any free port for 0.
+    *
+    * @param error Set to what went wrong when the socket cannot be opened.
+    */
+    bool open(uint16_t port, std::string& error);
+    void close();
+    bool isOpen() const { return _socket != invalidSocket; }
+
+    /**
+    * The port the socket is bound to.
+    */
+    uint16_t port() const;
+
+    bool send(const NetAddress& to, const void* data, size_t size);
+
+    /**
+    * Takes the next waiting datagram.
+    *
+    * @return Its size, or -1 if none is waiting.
+    */
+    int receive(NetAddress& from, void* buffer, size_t size);
+
+    // larger than any snapshot of a table that fits in a datagram
+    static const size_t maxDatagram = 65507;
+
+private:
+#ifdef _WIN32
+    typedef uintptr_t Handle;
+#else
+    typedef int Handle;
+#endif
+    static const Handle invalidSocket = (Handle) -1;
+
+    Handle _socket = invalidSocket;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_UDP_H_
@@ -0,0 +1,114 @@
+/**
+ * @file vecenv.cpp
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Implements the vectorized reinforcement learning environment
+ */
+
+#include "poolsim/vecenv.h"
+#include "poolsim/batch.h"
+#include <cmath>
+
+using namespace std;
+using namespace glm;
+
+namespace poolsim {
+
+VecEnv::VecEnv(const EnvConfig& config, ThreadPool* pool) :
+  _config(config), _pool(pool), _tables(config.numEnvs, Table(config.table)), _episodes(config.numEnvs, 0),
+  _actions(config.numEnvs, 0)
+{
+}
+
+void VecEnv::resetEnv(int env)
+{
+  Table& table = _tables[env];
+  uint32_t seed = tableSeed(tableSeed(_config.seed, env), (int) _episodes[env]);
+  table.reset(seed);
+  // each episode starts on a random effect, drawn apart from the chaos draws
+  Pcg32 rng(seed, shotStream);
+  table.setChaosEffect((ChaosEffect) (rng() % NUM_CHAOS_EFFECTS));
+  table.setChaosEnabled(_config.chaos);
+  table.clearEvents();
+  _episodes[env]++;
+  _actions[env] = 0;
+}
+
+void VecEnv::observe(int env, float* observation) const
+{
+  const Table& table = _tables[env];
+  const BallArrays& balls = table.balls();
+  const TableConfig& config = table.config();
+  int n = config.numBalls;
+  float sx = 2.0f / config.tableLength;
+  float sy = 2.0f / config.tableWidth;
+  float sz = 1.0f / config.viewVolumeSide;
+  for (int i = 0; i < n; i++)
+  {
+    observation[3 * i] = balls.posX[i] * sx;
+    observation[3 * i + 1] = balls.posY[i] * sy;
+    observation[3 * i + 2] = balls.posZ[i] * sz;
+    observation[3 * n + i] = balls.isFree(i) ? 0.0f : 1.0f;
+  }
+  float* effect = observation + 4 * n;
+  for (int k = 0; k < NUM_CHAOS_EFFECTS; k++)
+  {
+    effect[k] = 0.0f;
+  }
+  effect[table.chaosEffectId()] = 1.0f;
+}
+
+void VecEnv::reset(float* observations)
+{
+  int size = observationSize();
+  auto body = [&](int env, int) {
+    resetEnv(env);
+    observe(env, observations + (size_t) env * size);
+  };
+  if (_pool) _pool->parallelFor(_config.numEnvs, body);
+  else for (int env = 0; env < _config.numEnvs; env++) body(env, 0);
+}
+
+void VecEnv::stepEnv(int env, const float* action, float* observation, float& reward, uint8_t& done)
+{
+  Table& table = _tables[env];
+  table.clearEvents();
+  bool finite = std::isfinite(action[0]) && std::isfinite(action[1]) && std::isfinite(action[2])
+    && std::isfinite(action[3]);
+  int ball = finite ? (int) lround(action[0]) : -1;
+  vec2 dir(action[1], action[2]);
+  float power = std::min(std::max(action[3], 0.0f), 1.0f);
+  bool launched = ball >= 0 && ball < table.numBalls() && table.balls().isFree(ball) && dot(dir, dir) > 0;
+  if (launched) table.launch(ball, vec3(normalize(dir) * (power * _config.maxSpeed), 0));
+
+  if (_config.stepsPerAction > 0)
+  {
+    for (int s = 0; s < _config.stepsPerAction; s++)
+    {
+      table.step();
+    }
+  }
+  else
+  {
+    table.settle(_config.maxShotTime);
+  }
+  _actions[env]++;
+
+  const TableEvents& events = table.events();
+  reward = _config.pocketReward * events.pocketed + _config.devourReward * events.devoured;
+  done = table.allSunk() ? ENV_TERMINATED : _actions[env] >= _config.maxActions ? ENV_TRUNCATED : ENV_RUNNING;
+  if (done != ENV_RUNNING) resetEnv(env);
+  observe(env, observation);
+}
+
+void VecEnv::step(const float* actions, float* observations, float* rewards, uint8_t* dones)
+{
+  int size = observationSize();
+  auto body = [&](int env, int) {
+    stepEnv(env, actions + (size_t) env * actionSize, observations + (size_t) env * size, rewards[env], dones[env]);
+  };
+  if (_pool) _pool->parallelFor(_config.numEnvs, body);
+  else for (int env = 0; env < _config.numEnvs; env++) body(env, 0);
+}
+
+}  // namespace poolsim
@@ -0,0 +1,127 @@
+/**
+ * @file vecenv.h
+ * @author Keith Mburu
+ * @date 2026-10-17
+ * @brief Many tables stepped together as a reinforcement learning environment
+ */
+
+#ifndef POOLSIM_VECENV_H_
+#define POOLSIM_VECENV_H_
+
+#include "poolsim/table.h"
+#include "poolsim/threadpool.h"
+#include <cstdint>
+#include <vector>
+
+namespace poolsim {
+
+struct EnvConfig
+{
+  int numEnvs = 64;
+  // every episode's seed follows from this seed, the environment's index
+  // and the number of episodes it has played
+  uint32_t seed = 1;
+  // fixed steps each action lasts; 0 plays each shot until the table rests
+  int stepsPerAction = 4;
+  // longest a shot may run when stepsPerAction is 0, in seconds
+  float maxShotTime = 60.0f;
+  // actions after which an episode is cut short
+  int maxActions = 1000;
+  // launch speed of an action at full power
+  float maxSpeed = 3000.0f;
+  // a pocketed ball is devoured by Glorb a little later, so by default
+  // only the pocketing pays
+  float pocketReward = 1.0f;
+  float devourReward = 0.0f;
+  // let the chaos effects change on their timer, rather than keeping the
+  // effect each episode starts with
+  bool chaos = true;
+  TableConfig table;
+};
+
+/**
+ * Why an episode ended, as written to the dones array.
+ */
+enum EnvDone : uint8_t
+{
+  ENV_RUNNING,
+  // every ball is sunk
+  ENV_TERMINATED,
+  // maxActions ran out
+  ENV_TRUNCATED
+};
+
+/**
+ * Runs numEnvs tables side by side for reinforcement learning, in the
+ * usual vectorized shape: step() takes one action per table and writes the
+ * observations, rewards and dones of all of them into arrays the caller
+ * owns, straight from the table state. A table whose episode ends is reset
+ * at once, so its observation is the first of the next episode.
+ *
+ * An action is actionSize floats: the ball to launch (rounded, and any ball
+ * not in play means no launch), the x and y of the direction, and the power
+ * in [0, 1] of maxSpeed. An action with a float that is not finite does not
+ * launch either. An observation is observationSize() floats: x, y
+ * and z of every ball, x and y scaled to [-1, 1] over the table and z over
+ * the view volume, then 1 for every ball that is sunk and 0 for the rest,
+ * then the active chaos effect, one-hot. The reward of an action counts the
+ * pocket and devour events while it played out.
+ *
+ * With a ThreadPool the tables are shared out over its threads. Each table
+ * depends only on its own actions, so the results do not depend on the
+ * number of threads.
+ */
+class VecEnv
+{
+public:
+    VecEnv(const EnvConfig& config, ThreadPool* pool = nullptr);
+
+    static const int actionSize = 4;
+    int observationSize() const { return 4 * _config.table.numBalls + NUM_CHAOS_EFFECTS; }
+    int numEnvs() const { return _config.numEnvs; }
+
+    /**
+    * Starts a new episode on every table.
+    *
+    * @param observations numEnvs() * observationSize() floats, filled in.
+    */
+    void reset(float* observations);
+
+    /**
+    * Applies an action to every table and plays it out.
+    *
+    * @param actions numEnvs() * actionSize floats.
+    * @param observations numEnvs() * observationSize() floats, filled in.
+    * @param rewards numEnvs() floats, filled in.
+    * @param dones numEnvs() EnvDone bytes, filled in.
+    */
+    void step(const float* actions, float* observations, float* rewards, uint8_t* dones);
+
+    /**
+    * Sets the weights of the pocket and devour events in the reward.
+    */
+    void setRewards(float pocket, float devour)
+    {
+      _config.pocketReward = pocket;
+      _config.devourReward = devour;
+    }
+
+    const Table& table(int env) const { return _tables[env]; }
+    long episodes(int env) const { return _episodes[env]; }
+    const EnvConfig& config() const { return _config; }
+
+private:
+    void resetEnv(int env);
+    void stepEnv(int env, const float* action, float* observation, float& reward, uint8_t& done);
+    void observe(int env, float* observation) const;
+
+    EnvConfig _config;
+    ThreadPool* _pool;
+    std::vector<Table> _tables;
+    std::vector<long> _episodes;
+    std::vector<int> _actions;
+};
+
+}  // namespace poolsim
+
+#endif  // POOLSIM_VECENV_H_